@@ -37,6 +37,10 @@
 #include "itkAdvancedCombinationTransform.h"
 
 #include "itkPlatformMultiThreader.h"
+#include "itkThreadPoolJobs.h"
+
+#include <atomic>
+#include <chrono>
 
 namespace itk
 {
@@ -129,6 +133,7 @@ public:
   typedef typename Superclass::MeasureType                  MeasureType;
   typedef typename Superclass::DerivativeType               DerivativeType;
   typedef typename DerivativeType::ValueType                DerivativeValueType;
+  typedef std::atomic< DerivativeValueType >                AtomicDerivativeValueType;
   typedef typename Superclass::ParametersType               ParametersType;
 
   typedef ImageMaskSpatialObject< itkGetStaticConstMacro( FixedImageDimension ) > FixedImageMaskSpatialObject2Type;
@@ -144,6 +149,7 @@ public:
   typedef typename ImageSamplerType::Pointer                      ImageSamplerPointer;
   typedef typename ImageSamplerType::OutputVectorContainerType    ImageSampleContainerType;
   typedef typename ImageSamplerType::OutputVectorContainerPointer ImageSampleContainerPointer;
+  typedef typename ImageSamplerType::ImageSampleType              ImageSampleType;
 
   /** Typedefs for Limiter support. */
   typedef LimiterFunctionBase< RealType, FixedImageDimension >  FixedImageLimiterType;
@@ -283,6 +289,113 @@ public:
   itkGetConstReferenceMacro( UseMultiThread, bool );
   itkBooleanMacro( UseMultiThread );
 
+  /** Select the computation and storage of the per-sample image Jacobians in
+   * single precision, see EvaluateImageJacobians(). The metric value and
+   * derivative are always accumulated in double. Default: true when elastix is built with
+   * ELASTIX_USE_MIXED_PRECISION, and false otherwise.
+   */
+  itkSetMacro( UseMixedPrecision, bool );
+  itkGetConstReferenceMacro( UseMixedPrecision, bool );
+  itkBooleanMacro( UseMixedPrecision );
+
+  /** Select the use of the persistent thread pool, instead of the
+   * PlatformMultiThreader, which creates new threads at every call.
+   * When the thread pool is used, the samples are distributed over the
+   * threads in small interleaved chunks, see GetNextSampleRange().
+   */
+  itkSetMacro( UseThreadPool, bool );
+  itkGetConstReferenceMacro( UseThreadPool, bool );
+  itkBooleanMacro( UseThreadPool );
+
+  /** Select the atomic derivative accumulation mode. By default each thread
+   * accumulates its contributions in its own dense derivative vector, and these
+   * vectors are summed afterwards. In the atomic mode all threads add their
+   * contributions to a single shared derivative, using atomic operations. This
+   * saves (NumberOfWorkUnits - 1) derivative vectors of memory, and the pass over
+   * all of them after each iteration, at the cost of an atomic add per nonzero
+   * Jacobian element. Only used by metrics that support it, see
+   * m_SupportsAtomicDerivativeAccumulation, and only when multi-threading.
+   * Currently AdvancedMeanSquares is the only metric that supports it; metrics
+   * with several derivative terms per thread, like AdvancedNormalizedCorrelation,
+   * keep their per thread derivatives. See GetDerivativeAccumulationMemorySize()
+   * for the resulting memory use.
+   */
+  itkSetMacro( UseAtomicDerivativeAccumulation, bool );
+  itkGetConstReferenceMacro( UseAtomicDerivativeAccumulation, bool );
+  itkBooleanMacro( UseAtomicDerivativeAccumulation );
+
+  /** Select the use of pre-computed transform weights for the samples. When
+   * the sampler returns the same samples in every iteration, such as the Full
+   * and Grid samplers, or any sampler without NewSamplesEveryIteration, the
+   * transform can pre-compute per sample the data that does not depend on its
+   * parameters, see AdvancedTransform::PrecomputeSampleWeights(). This is done
+   * once per resolution. When the samples turn out to change, the weights are
+   * released and not used anymore during this resolution. Only used by
+   * metrics that call AdvancedTransform::TransformSamples(). Default: false.
+   */
+  itkSetMacro( UseSampleWeightsCache, bool );
+  itkGetConstReferenceMacro( UseSampleWeightsCache, bool );
+  itkBooleanMacro( UseSampleWeightsCache );
+
+  /** The phases of GetValueAndDerivative() that are timed when
+   * UseHotPathTimers is on:
+   * - SamplerTimer: updating the image sampler and its sample arrays,
+   * - TransformTimer: setting the transform parameters and the sample weights cache,
+   * - ThreadedTimer: the multi-threaded loop over the samples, which interleaves
+   *   the transform, interpolation and per-sample derivative computations,
+   * - AccumulateTimer: gathering the values and derivatives of all threads.
+   */
+  typedef enum {
+    SamplerTimer = 0,
+    TransformTimer,
+    ThreadedTimer,
+    AccumulateTimer,
+    NumberOfHotPathTimers
+  } HotPathTimerType;
+
+  /** Select the timing of the phases of GetValueAndDerivative(), see
+   * HotPathTimerType. The phases are timed as a whole, by the calling thread,
+   * so the overhead is a few clock reads per iteration. Default: false.
+   */
+  itkSetMacro( UseHotPathTimers, bool );
+  itkGetConstReferenceMacro( UseHotPathTimers, bool );
+  itkBooleanMacro( UseHotPathTimers );
+
+  /** Get the time in seconds spent in a phase since the last call of
+   * ResetHotPathTimes().
+   */
+  double GetHotPathTime( const HotPathTimerType timer ) const
+  {
+    return this->m_HotPathTimes[ timer ];
+  }
+
+
+  /** Set the accumulated times of all phases to zero. */
+  void ResetHotPathTimes( void ) const
+  {
+    for( unsigned int i = 0; i < NumberOfHotPathTimers; ++i )
+    {
+      this->m_HotPathTimes[ i ] = 0.0;
+    }
+  }
+
+
+  /** Get the memory in bytes of the buffers in which the threads accumulate
+   * their derivative contributions: the derivatives per thread, or the single
+   * shared derivative of the atomic mode. Valid after Initialize().
+   */
+  SizeValueType GetDerivativeAccumulationMemorySize( void ) const
+  {
+    SizeValueType size = this->m_AtomicDerivativeSize * sizeof( AtomicDerivativeValueType );
+    for( ThreadIdType i = 0; i < this->m_GetValueAndDerivativePerThreadVariablesSize; ++i )
+    {
+      size += this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Derivative.GetSize()
+        * sizeof( DerivativeValueType );
+    }
+    return size;
+  }
+
+
   /** Contains calls from GetValueAndDerivative that are thread-unsafe,
    * together with preparation for multi-threading.
    * Note that the only reason why this function is not protected, is
@@ -291,6 +404,25 @@ public:
   virtual void BeforeThreadedGetValueAndDerivative(
     const TransformParametersType & parameters ) const;
 
+  /** Pointer to a copy of this metric, see CreateClone(). */
+  typedef SmartPointer< Self > AdvancedMetricPointer;
+
+  /** Create an independent copy of this metric, which can be evaluated
+   * concurrently with this metric and with other copies, for example as one
+   * of the cost function clones of the FullSearchOptimizer. The copy shares the
+   * images, masks, interpolator, limiters and image sampler with this metric,
+   * and gets its own copy of the transform. It does not update the shared image
+   * sampler, so the samples may not change while the copy is in use. The copy
+   * is single-threaded, because the copies are meant to run in parallel, and is
+   * initialized. Returns null when the metric does not support copies, which
+   * is the default, or when the transform can not be copied exactly.
+   */
+  virtual AdvancedMetricPointer CreateClone( void ) const
+  {
+    return nullptr;
+  }
+
+
 protected:
 
   /** Constructor. */
@@ -333,6 +465,14 @@ protected:
   /** Typedefs for support of sparse Jacobians and compact support of transformations. */
   typedef typename
     AdvancedTransformType::NonZeroJacobianIndicesType NonZeroJacobianIndicesType;
+  typedef typename
+    AdvancedTransformType::MovingImageGradientType TransformMovingImageGradientType;
+
+  /** The single-precision type of the image Jacobians (dM/dx)^T (dT/dmu) that
+   * are buffered per sample when m_UseMixedPrecision is true, see
+   * AdvancedTransform::EvaluateFloatJacobianWithImageGradientProducts().
+   */
+  typedef typename AdvancedTransformType::FloatDerivativeType FloatImageJacobianType;
 
   /** Protected Variables **************/
 
@@ -401,10 +541,117 @@ protected:
   /** AccumulateDerivatives threader callback function. */
   static ITK_THREAD_RETURN_TYPE AccumulateDerivativesThreaderCallback( void * arg );
 
+  /** Execute a threader callback for all work units, and wait until all are finished.
+   * Depending on m_UseThreadPool the work is executed by the PlatformMultiThreader,
+   * or by the threads of the persistent thread pool, see ThreadPoolJobs. In the
+   * latter case the calling thread executes work unit 0 itself.
+   */
+  void ExecuteThreaderCallback( ThreadFunctionType callback, void * arg ) const;
+
+  /** Get the next range [pos_begin, pos_end) of samples to be processed by thread threadId.
+   * Returns false when there is no work left for this thread. Initialize pos_begin
+   * and pos_end to zero before the first call, and call it in a loop:
+   *   while( this->GetNextSampleRange( threadId, size, pos_begin, pos_end ) ) { ... }
+   * Without the thread pool each thread receives a single contiguous block of
+   * samples, as before. With the thread pool each thread receives every
+   * numberOfThreads-th chunk of samples. In both cases the assignment is fixed,
+   * so that the results do not depend on the timing of the threads.
+   */
+  bool GetNextSampleRange( ThreadIdType threadId, unsigned long numberOfSamples,
+    unsigned long & pos_begin, unsigned long & pos_end ) const;
+
   /** Variables for multi-threading. */
   bool m_UseMetricSingleThreaded;
   bool m_UseMultiThread;
   bool m_UseOpenMP;
+  bool m_UseThreadPool;
+
+  /** Whether the per-sample image Jacobians are computed and stored in float. */
+  bool m_UseMixedPrecision;
+
+  /** Variables for the atomic derivative accumulation mode. Subclasses that
+   * support this mode set m_SupportsAtomicDerivativeAccumulation to true in their
+   * constructor. The shared derivative is allocated in InitializeThreadingParameters(),
+   * and is a null pointer when the mode is not active.
+   */
+  bool                                m_UseAtomicDerivativeAccumulation;
+  bool                                m_SupportsAtomicDerivativeAccumulation;
+  mutable AtomicDerivativeValueType * m_AtomicDerivative;
+  mutable NumberOfParametersType      m_AtomicDerivativeSize;
+
+  /** Variables for the sample weights cache, see SetUseSampleWeightsCache().
+   * m_SampleWeightsCacheIsAvailable tells the threads whether they can use
+   * AdvancedTransform::TransformSamples() in the current iteration. It is set
+   * by UpdateSampleWeightsCache() in BeforeThreadedGetValueAndDerivative().
+   */
+  bool                     m_UseSampleWeightsCache;
+  mutable bool             m_SampleWeightsCacheIsAvailable;
+  mutable bool             m_SampleWeightsCacheIsDisabled;
+  mutable ModifiedTimeType m_SampleWeightsCacheSamplesUpdateTime;
+  mutable ModifiedTimeType m_SampleWeightsCacheTransformMTime;
+  mutable SizeValueType    m_SampleWeightsCacheNumberOfSamples;
+
+  /** Variables for the hot path timers, see SetUseHotPathTimers(). */
+  bool           m_UseHotPathTimers;
+  mutable double m_HotPathTimes[ NumberOfHotPathTimers ];
+
+  /** Adds the time between its construction and destruction to one of the
+   * hot path times, if the timers are used. Usage:
+   *   {
+   *     ScopedHotPathTimer timer( this, Self::SamplerTimer );
+   *     ...
+   *   }
+   */
+  class ScopedHotPathTimer
+  {
+public:
+
+    ScopedHotPathTimer( const Self * metric, const HotPathTimerType timer ) :
+      m_Time( metric->m_UseHotPathTimers ? &metric->m_HotPathTimes[ timer ] : 0 )
+    {
+      if( this->m_Time )
+      {
+        this->m_Start = std::chrono::steady_clock::now();
+      }
+    }
+
+
+    ~ScopedHotPathTimer()
+    {
+      if( this->m_Time )
+      {
+        *this->m_Time += std::chrono::duration< double >(
+          std::chrono::steady_clock::now() - this->m_Start ).count();
+      }
+    }
+
+
+private:
+
+    ScopedHotPathTimer( const ScopedHotPathTimer & ); // purposely not implemented
+    void operator=( const ScopedHotPathTimer & );     // purposely not implemented
+
+    double *                              m_Time;
+    std::chrono::steady_clock::time_point m_Start;
+  };
+
+  /** Pre-compute the transform weights of the samples once per resolution,
+   * and check in later iterations whether they are still valid.
+   */
+  virtual void UpdateSampleWeightsCache( void ) const;
+
+  /** Atomically add a value to an element of the shared derivative. */
+  static inline void AtomicAdd( AtomicDerivativeValueType & target, const DerivativeValueType value )
+  {
+    DerivativeValueType expected = target.load( std::memory_order_relaxed );
+    while( !target.compare_exchange_weak( expected, expected + value, std::memory_order_relaxed ) )
+    {
+    }
+  }
+
+
+  /** Copy the shared derivative to the output derivative, and reset it. */
+  static ITK_THREAD_RETURN_TYPE AccumulateAtomicDerivativeThreaderCallback( void * arg );
 
   /** Helper structs that multi-threads the computation of
    * the metric derivative using ITK threads.
@@ -469,6 +716,27 @@ protected:
    * Make sure to set it before calling Initialize; default: false. */
   itkSetMacro( UseImageSampler, bool );
 
+  /** Whether BeforeThreadedGetValueAndDerivative() updates the image sampler.
+   * False for the copies made by CreateClone(), which share the image sampler
+   * of the original metric. */
+  bool m_UpdateImageSampler;
+
+  /** Methods for the copies of CreateClone() **********/
+
+  /** Copy the data and the settings of this metric to a new clone, and give
+   * the clone its own copy of the transform. Metrics that support clones call
+   * this in CreateClone(), and copy their own settings afterwards. */
+  void CopyToClone( Self * clone ) const;
+
+  /** Initialize a clone, after all settings are copied. Returns false when
+   * the clone can not be used, because the transform could not be copied. */
+  bool InitializeClone( Self * clone ) const;
+
+  /** Create a copy of the transform, with its own parameters. Returns null when
+   * the copy does not map a set of test points, or their Jacobians, exactly like
+   * the original. The original transform is not modified. */
+  typename AdvancedTransformType::Pointer CreateTransformClone( void ) const;
+
   /** Check if enough samples have been found to compute a reliable
    * estimate of the value/derivative; throws an exception if not. */
   virtual void CheckNumberOfSamples(
@@ -502,6 +770,30 @@ protected:
     const MovingImageDerivativeType & movingImageDerivative,
     DerivativeType & imageJacobian ) const;
 
+  /** Computes the image Jacobians of a batch of samples, i.e. the inner products
+   * of the transform Jacobian dT/dmu and the moving image gradient dM/dx. When
+   * sampleIndices is nonzero, the transform uses the sample weights, see
+   * UpdateSampleWeightsCache().
+   */
+  void EvaluateImageJacobians(
+    const SizeValueType * sampleIndices,
+    const FixedImagePointType * fixedPoints,
+    const TransformMovingImageGradientType * movingImageGradients,
+    DerivativeType * imageJacobians,
+    NonZeroJacobianIndicesType * nzjis,
+    const SizeValueType numberOfPoints ) const;
+
+  /** Single-precision version of EvaluateImageJacobians(), used when
+   * m_UseMixedPrecision is true.
+   */
+  void EvaluateImageJacobians(
+    const SizeValueType * sampleIndices,
+    const FixedImagePointType * fixedPoints,
+    const TransformMovingImageGradientType * movingImageGradients,
+    FloatImageJacobianType * imageJacobians,
+    NonZeroJacobianIndicesType * nzjis,
+    const SizeValueType numberOfPoints ) const;
+
   /** Methods to support transforms with sparse Jacobians, like the BSplineTransform **********/
 
   /** Check if the transform is an AdvancedTransform. Called by Initialize.
@@ -29,6 +29,9 @@
 
 #include "itkTimeProbe.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace itk
 {
 
@@ -50,7 +53,13 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 
   this->m_ImageSampler                = 0;
   this->m_UseImageSampler             = false;
+  this->m_UpdateImageSampler          = true;
   this->m_RequiredRatioOfValidSamples = 0.25;
+#ifdef ELASTIX_USE_MIXED_PRECISION
+  this->m_UseMixedPrecision = true;
+#else
+  this->m_UseMixedPrecision = false;
+#endif
 
   this->m_LinearInterpolator              = 0;
   this->m_BSplineInterpolator             = 0;
@@ -87,6 +96,7 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
   /** Threading related variables. */
   this->m_UseMetricSingleThreaded = true;
   this->m_UseMultiThread = false;
+  this->m_UseThreadPool = false;
 
   /** OpenMP related. Switch to on when available */
 #ifdef ELASTIX_USE_OPENMP
@@ -107,6 +117,24 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
   this->m_GetValueAndDerivativePerThreadVariables     = nullptr;
   this->m_GetValueAndDerivativePerThreadVariablesSize = 0;
 
+  // Atomic derivative accumulation
+  this->m_UseAtomicDerivativeAccumulation      = false;
+  this->m_SupportsAtomicDerivativeAccumulation = false;
+  this->m_AtomicDerivative                     = nullptr;
+  this->m_AtomicDerivativeSize                 = 0;
+
+  // Sample weights cache
+  this->m_UseSampleWeightsCache               = false;
+  this->m_SampleWeightsCacheIsAvailable       = false;
+  this->m_SampleWeightsCacheIsDisabled        = false;
+  this->m_SampleWeightsCacheSamplesUpdateTime = 0;
+  this->m_SampleWeightsCacheTransformMTime    = 0;
+  this->m_SampleWeightsCacheNumberOfSamples   = 0;
+
+  // Hot path timers
+  this->m_UseHotPathTimers = false;
+  this->ResetHotPathTimes();
+
 } // end Constructor
 
 
@@ -120,6 +148,7 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 {
   delete[] this->m_GetValuePerThreadVariables;
   delete[] this->m_GetValueAndDerivativePerThreadVariables;
+  delete[] this->m_AtomicDerivative;
 } // end Destructor
 
 
@@ -170,6 +199,20 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
   /** Check if the transform is a B-spline transform. */
   this->CheckForBSplineTransform();
 
+  /** The sample weights are pre-computed again in this resolution. */
+  this->m_SampleWeightsCacheIsAvailable       = false;
+  this->m_SampleWeightsCacheIsDisabled        = false;
+  this->m_SampleWeightsCacheSamplesUpdateTime = 0;
+  this->m_SampleWeightsCacheTransformMTime    = 0;
+  this->m_SampleWeightsCacheNumberOfSamples   = 0;
+  if( this->m_UseSampleWeightsCache && this->m_TransformIsAdvanced )
+  {
+    this->m_AdvancedTransform->ReleaseSampleWeights();
+  }
+
+  /** The hot path times are accumulated per resolution. */
+  this->ResetHotPathTimes();
+
   /** Initialize some threading related parameters. */
   if( this->m_UseMultiThread )
   {
@@ -216,6 +259,33 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
     this->m_GetValueAndDerivativePerThreadVariablesSize = numberOfThreads;
   }
 
+  /** In the atomic derivative accumulation mode a single shared derivative
+   * replaces the per thread derivatives.
+   */
+  const NumberOfParametersType numberOfParameters = this->GetNumberOfParameters();
+  const bool                   useAtomicDerivative
+    = this->m_UseAtomicDerivativeAccumulation && this->m_SupportsAtomicDerivativeAccumulation;
+  if( useAtomicDerivative )
+  {
+    if( this->m_AtomicDerivativeSize != numberOfParameters )
+    {
+      delete[] this->m_AtomicDerivative;
+      this->m_AtomicDerivative     = new AtomicDerivativeValueType[ numberOfParameters ];
+      this->m_AtomicDerivativeSize = numberOfParameters;
+    }
+    for( NumberOfParametersType j = 0; j < numberOfParameters; ++j )
+    {
+      this->m_AtomicDerivative[ j ].store( NumericTraits< DerivativeValueType >::ZeroValue(), std::memory_order_relaxed );
+    }
+  }
+  else
+  {
+    delete[] this->m_AtomicDerivative;
+    this->m_AtomicDerivative     = nullptr;
+    this->m_AtomicDerivativeSize = 0;
+  }
+  const NumberOfParametersType perThreadDerivativeSize = useAtomicDerivative ? 0 : numberOfParameters;
+
   /** Some initialization. */
   for( ThreadIdType i = 0; i < numberOfThreads; ++i )
   {
@@ -224,7 +294,7 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 
     this->m_GetValueAndDerivativePerThreadVariables[ i ].st_NumberOfPixelsCounted = NumericTraits< SizeValueType >::Zero;
     this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Value                 = NumericTraits< MeasureType >::Zero;
-    this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Derivative.SetSize( this->GetNumberOfParameters() );
+    this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Derivative.SetSize( perThreadDerivativeSize );
     this->m_GetValueAndDerivativePerThreadVariables[ i ].st_Derivative.Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
   }
 
@@ -749,6 +819,59 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 } // end EvaluateTransformJacobianInnerProduct()
 
 
+/**
+ * *************** EvaluateImageJacobians ****************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::EvaluateImageJacobians(
+  const SizeValueType * sampleIndices,
+  const FixedImagePointType * fixedPoints,
+  const TransformMovingImageGradientType * movingImageGradients,
+  DerivativeType * imageJacobians,
+  NonZeroJacobianIndicesType * nzjis,
+  const SizeValueType numberOfPoints ) const
+{
+  if( sampleIndices )
+  {
+    this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProductsOfSamples(
+      sampleIndices, fixedPoints, movingImageGradients,
+      imageJacobians, nzjis, numberOfPoints );
+  }
+  else
+  {
+    this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProducts(
+      fixedPoints, movingImageGradients,
+      imageJacobians, nzjis, numberOfPoints );
+  }
+
+} // end EvaluateImageJacobians()
+
+
+/**
+ * *************** EvaluateImageJacobians ****************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::EvaluateImageJacobians(
+  const SizeValueType * sampleIndices,
+  const FixedImagePointType * fixedPoints,
+  const TransformMovingImageGradientType * movingImageGradients,
+  FloatImageJacobianType * imageJacobians,
+  NonZeroJacobianIndicesType * nzjis,
+  const SizeValueType numberOfPoints ) const
+{
+  this->m_AdvancedTransform->EvaluateFloatJacobianWithImageGradientProducts(
+    sampleIndices, fixedPoints, movingImageGradients,
+    imageJacobians, nzjis, numberOfPoints );
+
+} // end EvaluateImageJacobians()
+
+
 /**
  * ********************** TransformPoint ************************
  */
@@ -851,16 +974,96 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
   /** In this function do all stuff that cannot be multi-threaded. */
   if( this->m_UseMetricSingleThreaded )
   {
-    this->SetTransformParameters( parameters );
-    if( this->m_UseImageSampler )
     {
-      this->GetImageSampler()->Update();
+      ScopedHotPathTimer timer( this, Self::TransformTimer );
+      this->SetTransformParameters( parameters );
+    }
+
+    {
+      ScopedHotPathTimer timer( this, Self::SamplerTimer );
+      if( this->m_UseImageSampler && this->m_UpdateImageSampler )
+      {
+        this->GetImageSampler()->Update();
+      }
     }
+
+    /** Pre-compute or check the transform weights of the samples, if desired. */
+    ScopedHotPathTimer timer( this, Self::TransformTimer );
+    this->UpdateSampleWeightsCache();
   }
 
 } // end BeforeThreadedGetValueAndDerivative()
 
 
+/**
+ * *********************** UpdateSampleWeightsCache ***********************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::UpdateSampleWeightsCache( void ) const
+{
+  this->m_SampleWeightsCacheIsAvailable = false;
+  if( !this->m_UseSampleWeightsCache || this->m_SampleWeightsCacheIsDisabled
+    || !this->m_UseImageSampler || !this->m_TransformIsAdvanced )
+  {
+    return;
+  }
+
+  const ImageSampleContainerType * sampleContainer  = this->GetImageSampler()->GetOutput();
+  const ModifiedTimeType           samplesUpdateTime = sampleContainer->GetUpdateMTime();
+
+  /** After the first iteration of this resolution only check the weights.
+   * If the samples changed, or another metric replaced the weights of the
+   * shared transform, the weights would have to be computed in every
+   * iteration, which does not pay off. The number of samples is checked as
+   * well, because the threads pass the positions in the sample container
+   * to the transform as sample indices.
+   */
+  if( this->m_SampleWeightsCacheSamplesUpdateTime != 0 )
+  {
+    if( samplesUpdateTime == this->m_SampleWeightsCacheSamplesUpdateTime
+      && sampleContainer->Size() == this->m_SampleWeightsCacheNumberOfSamples
+      && this->m_AdvancedTransform->GetSampleWeightsMTime() == this->m_SampleWeightsCacheTransformMTime )
+    {
+      this->m_SampleWeightsCacheIsAvailable = true;
+    }
+    else
+    {
+      this->m_SampleWeightsCacheIsDisabled = true;
+      if( this->m_AdvancedTransform->GetSampleWeightsMTime() == this->m_SampleWeightsCacheTransformMTime )
+      {
+        this->m_AdvancedTransform->ReleaseSampleWeights();
+      }
+    }
+    return;
+  }
+
+  /** Pre-compute the weights of all samples. */
+  const SizeValueType                numberOfSamples = sampleContainer->Size();
+  std::vector< FixedImagePointType > samplePoints( numberOfSamples );
+  for( SizeValueType i = 0; i < numberOfSamples; ++i )
+  {
+    samplePoints[ i ] = sampleContainer->ElementAt( i ).m_ImageCoordinates;
+  }
+
+  if( numberOfSamples > 0
+    && this->m_AdvancedTransform->PrecomputeSampleWeights( &samplePoints[ 0 ], numberOfSamples ) )
+  {
+    this->m_SampleWeightsCacheSamplesUpdateTime = samplesUpdateTime;
+    this->m_SampleWeightsCacheTransformMTime    = this->m_AdvancedTransform->GetSampleWeightsMTime();
+    this->m_SampleWeightsCacheNumberOfSamples   = numberOfSamples;
+    this->m_SampleWeightsCacheIsAvailable       = true;
+  }
+  else
+  {
+    this->m_SampleWeightsCacheIsDisabled = true;
+  }
+
+} // end UpdateSampleWeightsCache()
+
+
 /**
  * **************** GetValueThreaderCallback *******
  */
@@ -892,12 +1095,9 @@ void
 AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 ::LaunchGetValueThreaderCallback( void ) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod( this->GetValueThreaderCallback,
-    const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
-
   /** Launch. */
-  this->m_Threader->SingleMethodExecute();
+  this->ExecuteThreaderCallback( this->GetValueThreaderCallback,
+    const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
 
 } // end LaunchGetValueThreaderCallback()
 
@@ -933,12 +1133,10 @@ void
 AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 ::LaunchGetValueAndDerivativeThreaderCallback( void ) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod( this->GetValueAndDerivativeThreaderCallback,
-    const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
-
   /** Launch. */
-  this->m_Threader->SingleMethodExecute();
+  ScopedHotPathTimer timer( this, Self::ThreadedTimer );
+  this->ExecuteThreaderCallback( this->GetValueAndDerivativeThreaderCallback,
+    const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
 
 } // end LaunchGetValueAndDerivativeThreaderCallback()
 
@@ -990,6 +1188,147 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 } // end AccumulateDerivativesThreaderCallback()
 
 
+/**
+ *********** AccumulateAtomicDerivativeThreaderCallback *************
+ */
+
+template< class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::AccumulateAtomicDerivativeThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct  = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadID    = infoStruct->WorkUnitID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfWorkUnits;
+
+  MultiThreaderParameterType * temp
+    = static_cast< MultiThreaderParameterType * >( infoStruct->UserData );
+
+  const unsigned int numPar  = temp->st_Metric->GetNumberOfParameters();
+  const unsigned int subSize = static_cast< unsigned int >(
+    std::ceil( static_cast< double >( numPar )
+    / static_cast< double >( nrOfThreads ) ) );
+  const unsigned int jmin = threadID * subSize;
+  unsigned int       jmax = ( threadID + 1 ) * subSize;
+  jmax = ( jmax > numPar ) ? numPar : jmax;
+
+  /** This thread copies the shared derivative for the range [ jmin, jmax [,
+   * and resets it for the next iteration.
+   */
+  const DerivativeValueType   zero             = NumericTraits< DerivativeValueType >::Zero;
+  const DerivativeValueType   normalization    = 1.0 / temp->st_NormalizationFactor;
+  AtomicDerivativeValueType * atomicDerivative = temp->st_Metric->m_AtomicDerivative;
+  for( unsigned int j = jmin; j < jmax; ++j )
+  {
+    temp->st_DerivativePointer[ j ] = atomicDerivative[ j ].load( std::memory_order_relaxed ) * normalization;
+    atomicDerivative[ j ].store( zero, std::memory_order_relaxed );
+  }
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end AccumulateAtomicDerivativeThreaderCallback()
+
+
+/**
+ * *********************** ExecuteThreaderCallback ***********************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::ExecuteThreaderCallback( ThreadFunctionType callback, void * arg ) const
+{
+  /** The default: let the PlatformMultiThreader spawn and join the threads. */
+  if( !this->m_UseThreadPool )
+  {
+    this->m_Threader->SetSingleMethod( callback, arg );
+    this->m_Threader->SingleMethodExecute();
+    return;
+  }
+
+  /** Setup the work unit info, as the PlatformMultiThreader would do. */
+  const ThreadIdType            numberOfWorkUnits = Self::GetNumberOfWorkUnits();
+  std::vector< ThreadInfoType > workUnitInfo( numberOfWorkUnits );
+  for( ThreadIdType i = 0; i < numberOfWorkUnits; ++i )
+  {
+    workUnitInfo[ i ].WorkUnitID        = i;
+    workUnitInfo[ i ].NumberOfWorkUnits = numberOfWorkUnits;
+    workUnitInfo[ i ].UserData          = arg;
+  }
+
+  /** Hand the work units over to the persistent threads of the pool. When this
+   * metric is itself evaluated by a thread of the pool, for example on a cost
+   * function clone of an optimizer, the work units are executed one after the
+   * other by the calling thread, to prevent a deadlock of the pool.
+   * Exceptions are propagated.
+   */
+  ThreadPoolJobs::RunJobs( numberOfWorkUnits,
+    [ callback, &workUnitInfo ]( const std::size_t i ) { callback( &workUnitInfo[ i ] ); } );
+
+} // end ExecuteThreaderCallback()
+
+
+/**
+ * *********************** GetNextSampleRange ***********************
+ */
+
+template< class TFixedImage, class TMovingImage >
+bool
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::GetNextSampleRange( ThreadIdType threadId, unsigned long numberOfSamples,
+  unsigned long & pos_begin, unsigned long & pos_end ) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+
+  if( this->m_UseThreadPool )
+  {
+    /** Cyclic scheduling: the samples are divided in chunks, about 8 per thread,
+     * and thread t processes the chunks t, t + numberOfThreads, etc. Compared to
+     * a single block per thread this evens out differences in the cost of the
+     * samples over the image. The assignment of the chunks to the threads does
+     * not depend on the timing, so the per-thread partial sums, and therefore the
+     * metric value and derivative, are the same in every run.
+     */
+    const unsigned long chunkSize = std::max( 1ul, static_cast< unsigned long >(
+      std::ceil( static_cast< double >( numberOfSamples )
+      / static_cast< double >( 8 * numberOfThreads ) ) ) );
+
+    /** The first chunk of this thread, or the chunk after the previous one. */
+    const unsigned long chunk = ( pos_end == 0 )
+      ? threadId : pos_begin / chunkSize + numberOfThreads;
+    pos_begin = chunk * chunkSize;
+    if( pos_begin >= numberOfSamples )
+    {
+      pos_begin = pos_end = numberOfSamples;
+      return false;
+    }
+    pos_end = std::min( pos_begin + chunkSize, numberOfSamples );
+    return true;
+  }
+
+  /** Static scheduling: every thread gets a single block of samples. */
+  const unsigned long nrOfSamplesPerThreads
+    = static_cast< unsigned long >( std::ceil( static_cast< double >( numberOfSamples )
+    / static_cast< double >( numberOfThreads ) ) );
+
+  unsigned long block_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long block_end   = nrOfSamplesPerThreads * ( threadId + 1 );
+  block_begin = ( block_begin > numberOfSamples ) ? numberOfSamples : block_begin;
+  block_end   = ( block_end > numberOfSamples ) ? numberOfSamples : block_end;
+
+  /** Empty block, or the block was already handed out at the previous call. */
+  if( block_begin >= block_end || ( pos_begin == block_begin && pos_end == block_end ) )
+  {
+    return false;
+  }
+
+  pos_begin = block_begin;
+  pos_end   = block_end;
+  return true;
+
+} // end GetNextSampleRange()
+
+
 /**
  * *********************** CheckNumberOfSamples ***********************
  */
@@ -1010,6 +1349,189 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
 } // end CheckNumberOfSamples()
 
 
+/**
+ * ********************* CopyToClone ****************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::CopyToClone( Self * clone ) const
+{
+  /** The data, which the clone only reads, is shared. */
+  clone->SetFixedImage( this->GetFixedImage() );
+  clone->SetMovingImage( this->GetMovingImage() );
+  clone->SetFixedImageMask( this->GetFixedImageMask() );
+  clone->SetMovingImageMask( this->GetMovingImageMask() );
+  clone->SetFixedImageRegion( this->GetFixedImageRegion() );
+  clone->SetInterpolator( this->m_Interpolator );
+  clone->SetComputeGradient( this->GetComputeGradient() );
+  clone->m_FixedImageLimiter  = this->m_FixedImageLimiter;
+  clone->m_MovingImageLimiter = this->m_MovingImageLimiter;
+  clone->m_ImageSampler       = this->m_ImageSampler;
+  clone->m_UpdateImageSampler = false;
+
+  /** The settings. */
+  clone->m_RequiredRatioOfValidSamples                      = this->m_RequiredRatioOfValidSamples;
+  clone->m_FixedLimitRangeRatio                             = this->m_FixedLimitRangeRatio;
+  clone->m_MovingLimitRangeRatio                            = this->m_MovingLimitRangeRatio;
+  clone->m_UseMovingImageDerivativeScales                   = this->m_UseMovingImageDerivativeScales;
+  clone->m_ScaleGradientWithRespectToMovingImageOrientation = this->m_ScaleGradientWithRespectToMovingImageOrientation;
+  clone->m_MovingImageDerivativeScales                      = this->m_MovingImageDerivativeScales;
+  clone->m_UseMetricSingleThreaded                          = this->m_UseMetricSingleThreaded;
+  clone->m_UseMixedPrecision                                = this->m_UseMixedPrecision;
+  clone->m_UseSampleWeightsCache                            = this->m_UseSampleWeightsCache;
+
+  /** The clones are evaluated in parallel, each on its own thread, so they
+   * are single-threaded themselves. Otherwise every clone would start its own
+   * threads in every evaluation. */
+  clone->m_UseMultiThread                  = false;
+  clone->m_UseOpenMP                       = false;
+  clone->m_UseThreadPool                   = false;
+  clone->m_UseAtomicDerivativeAccumulation = false;
+  clone->SetNumberOfWorkUnits( 1 );
+
+  /** The transform is set to new parameters in every evaluation,
+   * so each clone needs its own. */
+  clone->SetTransform( this->CreateTransformClone() );
+
+} // end CopyToClone()
+
+
+/**
+ * ********************* InitializeClone ****************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+bool
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::InitializeClone( Self * clone ) const
+{
+  if( clone->m_AdvancedTransform.IsNull() )
+  {
+    return false;
+  }
+  clone->Initialize();
+
+  /** The clones do not update the shared image sampler, so select the samples
+   * now, which the clones then only read. */
+  if( this->m_UseImageSampler )
+  {
+    this->m_ImageSampler->Update();
+  }
+
+  return true;
+
+} // end InitializeClone()
+
+
+/**
+ * ********************* CreateTransformClone ****************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename AdvancedImageToImageMetric< TFixedImage, TMovingImage >::AdvancedTransformType::Pointer
+AdvancedImageToImageMetric< TFixedImage, TMovingImage >
+::CreateTransformClone( void ) const
+{
+  typedef typename AdvancedTransformType::Pointer AdvancedTransformPointer;
+
+  /** Copy a transform with its fixed parameters and its parameters. */
+  auto copyTransform = []( const AdvancedTransformType * transform ) -> AdvancedTransformPointer
+  {
+    AdvancedTransformPointer copy;
+    if( transform != nullptr )
+    {
+      LightObject::Pointer another = transform->CreateAnother();
+      copy = dynamic_cast< AdvancedTransformType * >( another.GetPointer() );
+    }
+    if( copy.IsNotNull() )
+    {
+      copy->SetFixedParameters( transform->GetFixedParameters() );
+      copy->SetParametersByValue( transform->GetParameters() );
+    }
+    return copy;
+  };
+
+  /** The initial transform of a combination transform is not optimized, and
+   * can be shared. Only the current transform is copied.
+   */
+  AdvancedTransformType *    original    = this->m_AdvancedTransform.GetPointer();
+  CombinationTransformType * combination = dynamic_cast< CombinationTransformType * >( original );
+  AdvancedTransformPointer   clone;
+  if( combination != nullptr )
+  {
+    AdvancedTransformPointer currentTransform = copyTransform( combination->GetCurrentTransform() );
+    if( currentTransform.IsNull() )
+    {
+      return nullptr;
+    }
+    typename CombinationTransformType::Pointer combinationClone = CombinationTransformType::New();
+    combinationClone->SetUseComposition( combination->GetUseComposition() );
+    combinationClone->SetInitialTransform( combination->GetModifiableInitialTransform() );
+    combinationClone->SetCurrentTransform( currentTransform );
+    clone = combinationClone.GetPointer();
+  }
+  else
+  {
+    clone = copyTransform( original );
+  }
+  if( clone.IsNull() || this->m_FixedImage.IsNull() )
+  {
+    return nullptr;
+  }
+
+  /** The copy may miss settings that are not stored in the (fixed) parameters.
+   * Compare it with the original at the corners and the center of the fixed
+   * image region: the mapped points, and the Jacobians with respect to the
+   * parameters, which show whether the copy responds to other parameters like
+   * the original as well. This only reads the original, which is shared with
+   * the registration.
+   */
+  const AdvancedTransformType * reference       = original;
+  const unsigned int            dimension       = FixedImageDimension;
+  const FixedImageRegionType &  region          = this->GetFixedImageRegion();
+  const unsigned int            numberOfCorners = 1u << dimension;
+  TransformJacobianType         referenceJacobian;
+  TransformJacobianType         cloneJacobian;
+  NonZeroJacobianIndicesType    referenceIndices;
+  NonZeroJacobianIndicesType    cloneIndices;
+  for( unsigned int corner = 0; corner <= numberOfCorners; ++corner )
+  {
+    /** The last "corner" is the center. */
+    FixedImageIndexType index = region.GetIndex();
+    for( unsigned int d = 0; d < dimension; ++d )
+    {
+      const FixedImageIndexValueType last = static_cast< FixedImageIndexValueType >( region.GetSize()[ d ] ) - 1;
+      if( corner == numberOfCorners )
+      {
+        index[ d ] += last / 2;
+      }
+      else if( ( corner >> d ) & 1u )
+      {
+        index[ d ] += last;
+      }
+    }
+    FixedImagePointType point;
+    this->m_FixedImage->TransformIndexToPhysicalPoint( index, point );
+
+    if( reference->TransformPoint( point ) != clone->TransformPoint( point ) )
+    {
+      return nullptr;
+    }
+    reference->GetJacobian( point, referenceJacobian, referenceIndices );
+    clone->GetJacobian( point, cloneJacobian, cloneIndices );
+    if( referenceIndices != cloneIndices || referenceJacobian != cloneJacobian )
+    {
+      return nullptr;
+    }
+  }
+
+  return clone;
+
+} // end CreateTransformClone()
+
+
 /**
  * ********************* PrintSelf ****************************
  */
@@ -1027,6 +1549,8 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
      << this->m_ImageSampler.GetPointer() << std::endl;
   os << indent.GetNextIndent() << "UseImageSampler: "
      << this->m_UseImageSampler << std::endl;
+  os << indent.GetNextIndent() << "UseMixedPrecision: "
+     << this->m_UseMixedPrecision << std::endl;
 
   /** Variables for the Limiters. */
   os << indent << "Variables related to the Limiters: " << std::endl;
@@ -1087,6 +1611,14 @@ AdvancedImageToImageMetric< TFixedImage, TMovingImage >
      << this->m_UseMovingImageDerivativeScales << std::endl;
   os << indent.GetNextIndent() << "MovingImageDerivativeScales: "
      << this->m_MovingImageDerivativeScales << std::endl;
+  os << indent.GetNextIndent() << "UseMultiThread: "
+     << this->m_UseMultiThread << std::endl;
+  os << indent.GetNextIndent() << "UseThreadPool: "
+     << this->m_UseThreadPool << std::endl;
+  os << indent.GetNextIndent() << "UseAtomicDerivativeAccumulation: "
+     << this->m_UseAtomicDerivativeAccumulation << std::endl;
+  os << indent.GetNextIndent() << "UseSampleWeightsCache: "
+     << this->m_UseSampleWeightsCache << std::endl;
 
 } // end PrintSelf()
 
@@ -226,10 +226,14 @@ protected:
   /** Print Self. */
   void PrintSelf( std::ostream & os, Indent indent ) const override;
 
+  /** Copy the histogram settings as well, see AdvancedImageToImageMetric::CopyToClone(). */
+  void CopyToClone( Self * clone ) const;
+
   /** Protected Typedefs ******************/
 
   /** Typedefs inherited from superclass. */
   typedef typename Superclass::FixedImageIndexType                 FixedImageIndexType;
+  typedef typename Superclass::ScopedHotPathTimer                  ScopedHotPathTimer;
   typedef typename Superclass::FixedImageIndexValueType            FixedImageIndexValueType;
   typedef typename FixedImageType::OffsetValueType                 OffsetValueType;
   typedef typename Superclass::MovingImageIndexType                MovingImageIndexType;
@@ -309,10 +313,32 @@ protected:
   };
   ParzenWindowHistogramMultiThreaderParameterType m_ParzenWindowHistogramThreaderParameters;
 
+  /** The buffers of a batch of pixel pairs, see UpdateJointPDF(). Each thread
+   * has its own, which is allocated once per resolution in Initialize().
+   */
+  struct JointPDFBatchType
+  {
+    std::vector< RealType >        st_FixedImageValues;
+    std::vector< RealType >        st_MovingImageValues;
+    std::vector< OffsetValueType > st_FixedIndices;
+    std::vector< OffsetValueType > st_MovingIndices;
+    std::vector< double >          st_FixedArguments;
+    std::vector< double >          st_MovingArguments;
+    std::vector< double >          st_FixedParzenValues;
+    std::vector< double >          st_MovingParzenValues;
+  };
+
+  /** The number of pixel pairs in a batch. */
+  itkStaticConstMacro( JointPDFBatchSize, unsigned int, 64 );
+
+  /** Allocate the buffers of a batch, for the current Parzen window sizes. */
+  void InitializeJointPDFBatch( JointPDFBatchType & batch ) const;
+
   struct ParzenWindowHistogramGetValueAndDerivativePerThreadStruct
   {
-    SizeValueType   st_NumberOfPixelsCounted;
-    JointPDFPointer st_JointPDF;
+    SizeValueType     st_NumberOfPixelsCounted;
+    JointPDFPointer   st_JointPDF;
+    JointPDFBatchType st_JointPDFBatch;
   };
   itkPadStruct( ITK_CACHE_LINE_ALIGNMENT, ParzenWindowHistogramGetValueAndDerivativePerThreadStruct,
     PaddedParzenWindowHistogramGetValueAndDerivativePerThreadStruct );
@@ -327,12 +353,22 @@ protected:
   /** Multi-threaded versions of the ComputePDF function. */
   inline void ThreadedComputePDFs( ThreadIdType threadId );
 
-  /** Single-threadedly accumulate results. */
+  /** Accumulate results. The per-thread joint PDFs are merged multi-threadedly,
+   * each thread summing a part of the bins.
+   */
   inline void AfterThreadedComputePDFs( void ) const;
 
   /** Helper function to launch the threads. */
   static ITK_THREAD_RETURN_TYPE ComputePDFsThreaderCallback( void * arg );
 
+  /** Sum the per-thread joint PDFs into m_JointPDF, for the part of the
+   * bins that is assigned to this thread.
+   */
+  void ThreadedAccumulateJointPDFs( ThreadIdType threadId, ThreadIdType numberOfThreads ) const;
+
+  /** Helper function to launch the threads. */
+  static ITK_THREAD_RETURN_TYPE AccumulateJointPDFsThreaderCallback( void * arg );
+
   /** Helper function to launch the threads. */
   void LaunchComputePDFsThreaderCallback( void ) const;
 
@@ -357,6 +393,19 @@ protected:
     const NonZeroJacobianIndicesType * nzji,
     JointPDFType * jointPDF ) const;
 
+  /** Update the joint PDF with the first numberOfPairs pixel pairs of a batch.
+   * The Parzen window arguments and kernel weights of all pairs are computed
+   * first, in tight loops that the compiler can vectorize, after which the
+   * weights are scattered into the histogram. The result equals that of calling
+   * UpdateJointPDFAndDerivatives() without Jacobian for each pair in turn.
+   * The intermediate results are stored in the buffers of the batch, so that
+   * nothing is allocated here.
+   */
+  void UpdateJointPDF(
+    const SizeValueType numberOfPairs,
+    JointPDFBatchType & batch,
+    JointPDFType * jointPDF ) const;
+
   /** Update the joint PDF and the incremental pdfs.
    * The input is a pixel pair (fixed, moving, moving mask) and
    * a set of moving image/mask values when using mu+delta*e_k, for
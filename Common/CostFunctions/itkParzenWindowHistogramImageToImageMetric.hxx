@@ -26,6 +26,8 @@
 #include "itkImageScanlineIterator.h"
 #include "vnl/vnl_math.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -147,6 +149,16 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
   /** Set up the Parzen windows. */
   this->InitializeKernels();
 
+  /** Allocate the buffers of the pixel pair batches of each thread, now that
+   * the sizes of the Parzen windows are known. The per thread variables are
+   * created by the superclass, in InitializeThreadingParameters().
+   */
+  for( ThreadIdType i = 0; i < this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariablesSize; ++i )
+  {
+    this->InitializeJointPDFBatch(
+      this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ i ].st_JointPDFBatch );
+  }
+
   /** If the user plans to use a finite difference derivative,
    * allocate some memory for the perturbed alpha variables.
    */
@@ -164,6 +176,29 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
 } // end Initialize()
 
 
+/**
+ * ********************* CopyToClone *****************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::CopyToClone( Self * clone ) const
+{
+  this->Superclass::CopyToClone( clone );
+
+  clone->m_NumberOfFixedHistogramBins    = this->m_NumberOfFixedHistogramBins;
+  clone->m_NumberOfMovingHistogramBins   = this->m_NumberOfMovingHistogramBins;
+  clone->m_FixedKernelBSplineOrder       = this->m_FixedKernelBSplineOrder;
+  clone->m_MovingKernelBSplineOrder      = this->m_MovingKernelBSplineOrder;
+  clone->m_UseDerivative                 = this->m_UseDerivative;
+  clone->m_UseExplicitPDFDerivatives     = this->m_UseExplicitPDFDerivatives;
+  clone->m_UseFiniteDifferenceDerivative = this->m_UseFiniteDifferenceDerivative;
+  clone->m_FiniteDifferencePerturbation  = this->m_FiniteDifferencePerturbation;
+
+} // end CopyToClone()
+
+
 /**
  * ****************** InitializeHistograms *****************************
  */
@@ -653,6 +688,107 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
 } // end UpdateJointPDFAndDerivatives()
 
 
+/**
+ * ********************** UpdateJointPDF ***************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::UpdateJointPDF(
+  const SizeValueType numberOfPairs,
+  JointPDFBatchType & batch,
+  JointPDFType * jointPDF ) const
+{
+  if( numberOfPairs == 0 ) { return; }
+
+  const unsigned int fixedWindowSize  = this->m_JointPDFWindow.GetSize()[ 1 ];
+  const unsigned int movingWindowSize = this->m_JointPDFWindow.GetSize()[ 0 ];
+
+  /** Get handles to the buffers of the batch. */
+  const RealType *  fixedImageValues   = &batch.st_FixedImageValues[ 0 ];
+  const RealType *  movingImageValues  = &batch.st_MovingImageValues[ 0 ];
+  OffsetValueType * fixedIndices       = &batch.st_FixedIndices[ 0 ];
+  OffsetValueType * movingIndices      = &batch.st_MovingIndices[ 0 ];
+  double *          fixedArguments     = &batch.st_FixedArguments[ 0 ];
+  double *          movingArguments    = &batch.st_MovingArguments[ 0 ];
+  double *          fixedParzenValues  = &batch.st_FixedParzenValues[ 0 ];
+  double *          movingParzenValues = &batch.st_MovingParzenValues[ 0 ];
+
+  /** Determine the Parzen window arguments and the lowest bin numbers
+   * affected by each pixel pair (see eq. 6 of Mattes paper [2]).
+   */
+  for( SizeValueType i = 0; i < numberOfPairs; ++i )
+  {
+    const double fixedTerm
+      = fixedImageValues[ i ] / this->m_FixedImageBinSize - this->m_FixedImageNormalizedMin;
+    const double movingTerm
+      = movingImageValues[ i ] / this->m_MovingImageBinSize - this->m_MovingImageNormalizedMin;
+    fixedIndices[ i ] = static_cast< OffsetValueType >( std::floor(
+      fixedTerm + this->m_FixedParzenTermToIndexOffset ) );
+    movingIndices[ i ] = static_cast< OffsetValueType >( std::floor(
+      movingTerm + this->m_MovingParzenTermToIndexOffset ) );
+    fixedArguments[ i ]  = static_cast< double >( fixedIndices[ i ] ) - fixedTerm;
+    movingArguments[ i ] = static_cast< double >( movingIndices[ i ] ) - movingTerm;
+  }
+
+  /** Evaluate the Parzen values of all pairs at once. */
+  this->m_FixedKernel->EvaluateBatch( fixedArguments,
+    fixedParzenValues, fixedWindowSize, numberOfPairs );
+  this->m_MovingKernel->EvaluateBatch( movingArguments,
+    movingParzenValues, movingWindowSize, numberOfPairs );
+
+  /** Scatter the Parzen values into the joint PDF, directly in its buffer.
+   * The moving image bins are the fastest running dimension.
+   */
+  PDFValueType *        buffer    = jointPDF->GetBufferPointer();
+  const OffsetValueType rowStride = jointPDF->GetOffsetTable()[ 1 ];
+  JointPDFIndexType     pdfWindowIndex;
+  for( SizeValueType i = 0; i < numberOfPairs; ++i )
+  {
+    pdfWindowIndex[ 0 ] = movingIndices[ i ];
+    pdfWindowIndex[ 1 ] = fixedIndices[ i ];
+    PDFValueType *       row = buffer + jointPDF->ComputeOffset( pdfWindowIndex );
+    const double *       fv  = fixedParzenValues + i * fixedWindowSize;
+    const double * const mv  = movingParzenValues + i * movingWindowSize;
+    for( unsigned int f = 0; f < fixedWindowSize; ++f )
+    {
+      for( unsigned int m = 0; m < movingWindowSize; ++m )
+      {
+        row[ m ] += static_cast< PDFValueType >( fv[ f ] * mv[ m ] );
+      }
+      row += rowStride;
+    }
+  }
+
+} // end UpdateJointPDF()
+
+
+/**
+ * ********************** InitializeJointPDFBatch ***************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::InitializeJointPDFBatch( JointPDFBatchType & batch ) const
+{
+  const unsigned int batchSize        = Self::JointPDFBatchSize;
+  const unsigned int fixedWindowSize  = this->m_JointPDFWindow.GetSize()[ 1 ];
+  const unsigned int movingWindowSize = this->m_JointPDFWindow.GetSize()[ 0 ];
+
+  batch.st_FixedImageValues.resize( batchSize );
+  batch.st_MovingImageValues.resize( batchSize );
+  batch.st_FixedIndices.resize( batchSize );
+  batch.st_MovingIndices.resize( batchSize );
+  batch.st_FixedArguments.resize( batchSize );
+  batch.st_MovingArguments.resize( batchSize );
+  batch.st_FixedParzenValues.resize( batchSize * fixedWindowSize );
+  batch.st_MovingParzenValues.resize( batchSize * movingWindowSize );
+
+} // end InitializeJointPDFBatch()
+
+
 /**
  * *************** UpdateJointPDFDerivatives ***************************
  */
@@ -1139,9 +1275,13 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
   this->BeforeThreadedGetValueAndDerivative( parameters );
 
   /** Launch multi-threading JointPDF computation. */
-  this->LaunchComputePDFsThreaderCallback();
+  {
+    ScopedHotPathTimer timer( this, Self::ThreadedTimer );
+    this->LaunchComputePDFsThreaderCallback();
+  }
 
   /** Gather the results from all threads. */
+  ScopedHotPathTimer timer( this, Self::AccumulateTimer );
   this->AfterThreadedComputePDFs();
 
 } // end ComputePDFs()
@@ -1167,69 +1307,83 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
   ImageSampleContainerPointer sampleContainer     = this->GetImageSampler()->GetOutput();
   const unsigned long         sampleContainerSize = sampleContainer->Size();
 
-  /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads
-    = static_cast< unsigned long >( std::ceil( static_cast< double >( sampleContainerSize )
-    / static_cast< double >( Self::GetNumberOfWorkUnits() ) ) );
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
-  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
-  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
-
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend   = sampleContainer->Begin();
-  fbegin                                                 += (int)pos_begin;
-  fend                                                   += (int)pos_end;
-
   /** Create variables to store intermediate results. circumvent false sharing */
   unsigned long numberOfPixelsCounted = 0;
 
-  /** Loop over sample container and compute contribution of each sample to pdfs. */
-  for( fiter = fbegin; fiter != fend; ++fiter )
+  /** The valid pixel pairs are collected in batches, which are added to the
+   * joint PDF at once, see UpdateJointPDF(). The buffers of the batch are
+   * allocated in Initialize().
+   */
+  JointPDFBatchType & batch             = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ threadId ].st_JointPDFBatch;
+  RealType *          fixedImageValues  = &batch.st_FixedImageValues[ 0 ];
+  RealType *          movingImageValues = &batch.st_MovingImageValues[ 0 ];
+  const unsigned int  batchSize         = Self::JointPDFBatchSize;
+  unsigned int        numberOfPairs     = 0;
+
+  /** Loop over the ranges of samples that are assigned to this thread. */
+  unsigned long pos_begin = 0;
+  unsigned long pos_end   = 0;
+  while( this->GetNextSampleRange( threadId, sampleContainerSize, pos_begin, pos_end ) )
   {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = ( *fiter ).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImagePointType        mappedPoint;
+    /** Create iterator over the sample container. */
+    typename ImageSampleContainerType::ConstIterator fiter;
+    typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
+    typename ImageSampleContainerType::ConstIterator fend   = sampleContainer->Begin();
+    fbegin                                                 += (int)pos_begin;
+    fend                                                   += (int)pos_end;
+
+    /** Loop over sample container and compute contribution of each sample to pdfs. */
+    for( fiter = fbegin; fiter != fend; ++fiter )
+    {
+      /** Read fixed coordinates and initialize some variables. */
+      const FixedImagePointType & fixedPoint = ( *fiter ).Value().m_ImageCoordinates;
+      RealType                    movingImageValue;
+      MovingImagePointType        mappedPoint;
 
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+      /** Transform point and check if it is inside the B-spline support region. */
+      bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
 
-    /** Check if point is inside mask. */
-    if( sampleOk )
-    {
-      sampleOk = this->IsInsideMovingMask( mappedPoint );
-    }
+      /** Check if point is inside mask. */
+      if( sampleOk )
+      {
+        sampleOk = this->IsInsideMovingMask( mappedPoint );
+      }
 
-    /** Compute the moving image value and check if the point is
-     * inside the moving image buffer.
-     */
-    if( sampleOk )
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(
-        mappedPoint, movingImageValue, 0 );
-    }
+      /** Compute the moving image value and check if the point is
+       * inside the moving image buffer.
+       */
+      if( sampleOk )
+      {
+        sampleOk = this->EvaluateMovingImageValueAndDerivative(
+          mappedPoint, movingImageValue, 0 );
+      }
 
-    if( sampleOk )
-    {
-      numberOfPixelsCounted++;
+      if( sampleOk )
+      {
+        numberOfPixelsCounted++;
 
-      /** Get the fixed image value. */
-      RealType fixedImageValue = static_cast< RealType >( ( *fiter ).Value().m_ImageValue );
+        /** Get the fixed image value. */
+        RealType fixedImageValue = static_cast< RealType >( ( *fiter ).Value().m_ImageValue );
 
-      /** Make sure the values fall within the histogram range. */
-      fixedImageValue  = this->GetFixedImageLimiter()->Evaluate( fixedImageValue );
-      movingImageValue = this->GetMovingImageLimiter()->Evaluate( movingImageValue );
+        /** Make sure the values fall within the histogram range. */
+        fixedImageValue  = this->GetFixedImageLimiter()->Evaluate( fixedImageValue );
+        movingImageValue = this->GetMovingImageLimiter()->Evaluate( movingImageValue );
 
-      /** Compute this sample's contribution to the joint distributions. */
-      this->UpdateJointPDFAndDerivatives(
-        fixedImageValue, movingImageValue, 0, 0,
-        jointPDF.GetPointer() );
-    }
-  } // end iterating over fixed image spatial sample container for loop
+        /** Store this sample's contribution to the joint distributions. */
+        fixedImageValues[ numberOfPairs ]  = fixedImageValue;
+        movingImageValues[ numberOfPairs ] = movingImageValue;
+        if( ++numberOfPairs == batchSize )
+        {
+          this->UpdateJointPDF( numberOfPairs, batch, jointPDF.GetPointer() );
+          numberOfPairs = 0;
+        }
+      }
+    } // end iterating over fixed image spatial sample container for loop
+
+  } // end while over the sample ranges
+
+  /** Add the remaining pixel pairs. */
+  this->UpdateJointPDF( numberOfPairs, batch, jointPDF.GetPointer() );
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
   this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = numberOfPixelsCounted;
@@ -1268,38 +1422,10 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
   /** Compute alpha. */
   this->m_Alpha = 1.0 / static_cast< double >( this->m_NumberOfPixelsCounted );
 
-  /** Accumulate joint histogram. */
-  // could be multi-threaded too, by each thread updating only a part of the JointPDF.
-  typedef ImageScanlineIterator< JointPDFType > JointPDFIteratorType;
-  JointPDFIteratorType                it( this->m_JointPDF, this->m_JointPDF->GetBufferedRegion() );
-  std::vector< JointPDFIteratorType > itT( numberOfThreads );
-  for( ThreadIdType i = 0; i < numberOfThreads; ++i )
-  {
-    itT[ i ] = JointPDFIteratorType(
-      this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ i ].st_JointPDF,
-      this->m_JointPDF->GetBufferedRegion() );
-  }
-
-  PDFValueType sum;
-  while( !it.IsAtEnd() )
-  {
-    while( !it.IsAtEndOfLine() )
-    {
-      sum = NumericTraits< PDFValueType >::Zero;
-      for( ThreadIdType i = 0; i < numberOfThreads; ++i )
-      {
-        sum += itT[ i ].Value();
-        ++itT[ i ];
-      }
-      it.Set( sum );
-      ++it;
-    }
-    it.NextLine();
-    for( ThreadIdType i = 0; i < numberOfThreads; ++i )
-    {
-      itT[ i ].NextLine();
-    }
-  }
+  /** Accumulate joint histogram, multi-threadedly. */
+  this->ExecuteThreaderCallback( this->AccumulateJointPDFsThreaderCallback,
+    const_cast< void * >( static_cast< const void * >(
+      &this->m_ParzenWindowHistogramThreaderParameters ) ) );
 
 } // end AfterThreadedComputePDFs()
 
@@ -1326,6 +1452,72 @@ ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
 } // end ComputePDFsThreaderCallback()
 
 
+/**
+ * ******************* ThreadedAccumulateJointPDFs *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+void
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedAccumulateJointPDFs( ThreadIdType threadId, ThreadIdType numberOfThreads ) const
+{
+  /** The per-thread joint PDFs have the same buffered region as m_JointPDF,
+   * so that the bins can be partitioned over the threads by buffer offset.
+   * The per-thread contributions are summed in the order of the threads,
+   * as before, so that the result does not depend on the partitioning.
+   */
+  const ThreadIdType  numberOfPDFs = Self::GetNumberOfWorkUnits();
+  const SizeValueType numberOfBins
+    = this->m_JointPDF->GetBufferedRegion().GetNumberOfPixels();
+  const SizeValueType subSize = static_cast< SizeValueType >(
+    std::ceil( static_cast< double >( numberOfBins )
+    / static_cast< double >( numberOfThreads ) ) );
+  const SizeValueType jmin = std::min( threadId * subSize, numberOfBins );
+  const SizeValueType jmax = std::min( ( threadId + 1 ) * subSize, numberOfBins );
+
+  PDFValueType * jointPDF = this->m_JointPDF->GetBufferPointer();
+  const PDFValueType * threadJointPDF
+    = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ 0 ].st_JointPDF->GetBufferPointer();
+  for( SizeValueType j = jmin; j < jmax; ++j )
+  {
+    jointPDF[ j ] = threadJointPDF[ j ];
+  }
+  for( ThreadIdType i = 1; i < numberOfPDFs; ++i )
+  {
+    threadJointPDF
+      = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[ i ].st_JointPDF->GetBufferPointer();
+    for( SizeValueType j = jmin; j < jmax; ++j )
+    {
+      jointPDF[ j ] += threadJointPDF[ j ];
+    }
+  }
+
+} // end ThreadedAccumulateJointPDFs()
+
+
+/**
+ * **************** AccumulateJointPDFsThreaderCallback *******
+ */
+
+template< class TFixedImage, class TMovingImage >
+ITK_THREAD_RETURN_TYPE
+ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
+::AccumulateJointPDFsThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct  = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadId    = infoStruct->WorkUnitID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfWorkUnits;
+
+  ParzenWindowHistogramMultiThreaderParameterType * temp
+    = static_cast< ParzenWindowHistogramMultiThreaderParameterType * >( infoStruct->UserData );
+
+  temp->m_Metric->ThreadedAccumulateJointPDFs( threadId, nrOfThreads );
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end AccumulateJointPDFsThreaderCallback()
+
+
 /**
  * *********************** LaunchComputePDFsThreaderCallback***************
  */
@@ -1335,14 +1527,11 @@ void
 ParzenWindowHistogramImageToImageMetric< TFixedImage, TMovingImage >
 ::LaunchComputePDFsThreaderCallback( void ) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod( this->ComputePDFsThreaderCallback,
+  /** Launch. */
+  this->ExecuteThreaderCallback( this->ComputePDFsThreaderCallback,
     const_cast< void * >( static_cast< const void * >(
       &this->m_ParzenWindowHistogramThreaderParameters ) ) );
 
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
-
 } // end LaunchComputePDFsThreaderCallback()
 
 
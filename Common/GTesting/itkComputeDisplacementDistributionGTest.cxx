@@ -0,0 +1,69 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+ // First include the header file to be tested:
+#include "itkComputeDisplacementDistribution.h"
+
+#include <itkImage.h>
+#include <itkTransform.h>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+  using ImageType = itk::Image<float, 2>;
+  using ComputeDisplacementDistributionType
+    = itk::ComputeDisplacementDistribution<ImageType, itk::Transform<double, 2, 2>>;
+
+  ImageType::Pointer CreateImage()
+  {
+    ImageType::SizeType size;
+    size.Fill(8);
+    const auto image = ImageType::New();
+    image->SetRegions(size);
+    image->Allocate();
+    for (unsigned int i = 0; i < image->GetBufferedRegion().GetNumberOfPixels(); ++i)
+    {
+      image->GetBufferPointer()[i] = 0.5f * i;
+    }
+    return image;
+  }
+}
+
+
+GTEST_TEST(ComputeDisplacementDistribution, ImageHashDependsOnContents)
+{
+  const ImageType::Pointer image = CreateImage();
+  const ImageType::Pointer copy  = CreateImage();
+
+  const auto hash = ComputeDisplacementDistributionType::ComputeImageHash(image.GetPointer());
+  EXPECT_EQ(ComputeDisplacementDistributionType::ComputeImageHash(image.GetPointer()), hash);
+  EXPECT_EQ(ComputeDisplacementDistributionType::ComputeImageHash(copy.GetPointer()), hash);
+
+  // Another pixel value.
+  image->GetBufferPointer()[5] += 1.0f;
+  image->Modified();
+  EXPECT_NE(ComputeDisplacementDistributionType::ComputeImageHash(image.GetPointer()), hash);
+
+  // Another geometry.
+  ImageType::SpacingType spacing;
+  spacing.Fill(2.0);
+  copy->SetSpacing(spacing);
+  EXPECT_NE(ComputeDisplacementDistributionType::ComputeImageHash(copy.GetPointer()), hash);
+}
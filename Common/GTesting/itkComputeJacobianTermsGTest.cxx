@@ -0,0 +1,112 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+ // First include the header file to be tested:
+#include "itkComputeJacobianTerms.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include <itkImage.h>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+  using ImageType                = itk::Image<float, 2>;
+  using TransformType            = itk::AdvancedTransform<double, 2, 2>;
+  using BSplineTransformType     = itk::AdvancedBSplineDeformableTransform<double, 2, 3>;
+  using ComputeJacobianTermsType = itk::ComputeJacobianTerms<ImageType, TransformType>;
+
+  struct JacobianTerms
+  {
+    double TrC;
+    double TrCC;
+    double maxJJ;
+    double maxJCJ;
+  };
+
+  // Computes the Jacobian terms of a B-spline transform on a 40 x 30 image.
+  JacobianTerms Compute(const bool useMultiThread, const unsigned int numberOfWorkUnits)
+  {
+    ImageType::SizeType size;
+    size[0] = 40;
+    size[1] = 30;
+    const auto image = ImageType::New();
+    image->SetRegions(size);
+    image->Allocate();
+    image->FillBuffer(0.0f);
+
+    BSplineTransformType::SizeType gridSize;
+    gridSize.Fill(9);
+    BSplineTransformType::SpacingType gridSpacing;
+    gridSpacing[0] = 40.0 / 6.0;
+    gridSpacing[1] = 30.0 / 6.0;
+    BSplineTransformType::OriginType gridOrigin;
+    gridOrigin[0] = -gridSpacing[0];
+    gridOrigin[1] = -gridSpacing[1];
+    const auto transform = BSplineTransformType::New();
+    transform->SetGridRegion(BSplineTransformType::RegionType(gridSize));
+    transform->SetGridSpacing(gridSpacing);
+    transform->SetGridOrigin(gridOrigin);
+
+    ComputeJacobianTermsType::ScalesType scales(transform->GetNumberOfParameters());
+    for (unsigned int i = 0; i < scales.GetSize(); ++i)
+    {
+      scales[i] = 1.0 + 0.01 * (i % 13);
+    }
+
+    const auto computeJacobianTerms = ComputeJacobianTermsType::New();
+    computeJacobianTerms->SetFixedImage(image);
+    computeJacobianTerms->SetFixedImageRegion(image->GetBufferedRegion());
+    computeJacobianTerms->SetTransform(transform);
+    computeJacobianTerms->SetScales(scales);
+    computeJacobianTerms->SetUseScales(true);
+    computeJacobianTerms->SetMaxBandCovSize(48);
+    computeJacobianTerms->SetNumberOfBandStructureSamples(10);
+    computeJacobianTerms->SetNumberOfJacobianMeasurements(600);
+    computeJacobianTerms->SetUseMultiThread(useMultiThread);
+    computeJacobianTerms->SetNumberOfWorkUnits(numberOfWorkUnits);
+
+    JacobianTerms terms;
+    computeJacobianTerms->Compute(terms.TrC, terms.TrCC, terms.maxJJ, terms.maxJCJ);
+    return terms;
+  }
+}
+
+
+GTEST_TEST(ComputeJacobianTerms, ResultsDoNotDependOnThreads)
+{
+  const JacobianTerms expected = Compute(false, 1);
+  EXPECT_GT(expected.TrC, 0.0);
+  EXPECT_GT(expected.TrCC, 0.0);
+  EXPECT_GT(expected.maxJJ, 0.0);
+  EXPECT_GT(expected.maxJCJ, 0.0);
+
+  // Bit-identical, for any number of threads, and in every run.
+  for (unsigned int numberOfWorkUnits = 1; numberOfWorkUnits <= 7; numberOfWorkUnits += 2)
+  {
+    for (unsigned int run = 0; run < 2; ++run)
+    {
+      const JacobianTerms actual = Compute(true, numberOfWorkUnits);
+      EXPECT_EQ(actual.TrC, expected.TrC);
+      EXPECT_EQ(actual.TrCC, expected.TrCC);
+      EXPECT_EQ(actual.maxJJ, expected.maxJJ);
+      EXPECT_EQ(actual.maxJCJ, expected.maxJCJ);
+    }
+  }
+}
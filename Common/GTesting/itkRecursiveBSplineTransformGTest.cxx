@@ -0,0 +1,113 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+ // First include the header file to be tested:
+#include "itkRecursiveBSplineTransform.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+  using TransformType = itk::RecursiveBSplineTransform<double, 3, 3>;
+
+  TransformType::Pointer CreateTransform()
+  {
+    TransformType::SizeType gridSize;
+    gridSize.Fill(8);
+    TransformType::SpacingType gridSpacing;
+    TransformType::OriginType  gridOrigin;
+    for (unsigned int d = 0; d < 3; ++d)
+    {
+      gridSpacing[d] = 4.0 + d;
+      gridOrigin[d]  = -gridSpacing[d];
+    }
+    const auto transform = TransformType::New();
+    transform->SetGridRegion(TransformType::RegionType(gridSize));
+    transform->SetGridSpacing(gridSpacing);
+    transform->SetGridOrigin(gridOrigin);
+
+    TransformType::ParametersType parameters(transform->GetNumberOfParameters());
+    for (unsigned int i = 0; i < parameters.GetSize(); ++i)
+    {
+      parameters[i] = std::sin(0.37 * i);
+    }
+    transform->SetParametersByValue(parameters);
+    return transform;
+  }
+}
+
+
+GTEST_TEST(RecursiveBSplineTransform, FloatImageJacobiansMatchDoubleImageJacobians)
+{
+  const TransformType::Pointer transform = CreateTransform();
+  const unsigned int           nnzji     = transform->GetNumberOfNonZeroJacobianIndices();
+
+  // Points inside the valid region, and one outside of it.
+  const unsigned int                        numberOfPoints = 20;
+  std::vector<TransformType::InputPointType> points(numberOfPoints);
+  std::vector<TransformType::MovingImageGradientType> gradients(numberOfPoints);
+  std::vector<itk::SizeValueType>            sampleIndices(numberOfPoints);
+  for (unsigned int i = 0; i < numberOfPoints; ++i)
+  {
+    for (unsigned int d = 0; d < 3; ++d)
+    {
+      points[i][d]    = 0.5 + std::fmod(1.7 * i + 3.1 * d, 18.0);
+      gradients[i][d] = 10.0 * std::cos(0.9 * i + d);
+    }
+    sampleIndices[i] = i;
+  }
+  points[numberOfPoints - 1].Fill(1000.0);
+
+  std::vector<TransformType::DerivativeType> expected(numberOfPoints, TransformType::DerivativeType(nnzji));
+  std::vector<TransformType::NonZeroJacobianIndicesType> expectedIndices(numberOfPoints);
+  transform->EvaluateJacobianWithImageGradientProducts(
+    &points[0], &gradients[0], &expected[0], &expectedIndices[0], numberOfPoints);
+
+  // Without and with the pre-computed sample weights.
+  for (unsigned int useSampleWeights = 0; useSampleWeights < 2; ++useSampleWeights)
+  {
+    if (useSampleWeights)
+    {
+      ASSERT_TRUE(transform->PrecomputeSampleWeights(&points[0], numberOfPoints));
+    }
+
+    std::vector<TransformType::FloatDerivativeType> actual(numberOfPoints, TransformType::FloatDerivativeType(nnzji));
+    std::vector<TransformType::NonZeroJacobianIndicesType> actualIndices(numberOfPoints);
+    transform->EvaluateFloatJacobianWithImageGradientProducts(useSampleWeights ? &sampleIndices[0] : nullptr,
+      &points[0], &gradients[0], &actual[0], &actualIndices[0], numberOfPoints);
+
+    for (unsigned int i = 0; i < numberOfPoints; ++i)
+    {
+      EXPECT_EQ(actualIndices[i], expectedIndices[i]);
+      double maxValue = 0.0;
+      for (unsigned int k = 0; k < nnzji; ++k)
+      {
+        maxValue = std::max(maxValue, std::abs(expected[i][k]));
+      }
+      for (unsigned int k = 0; k < nnzji; ++k)
+      {
+        EXPECT_LE(std::abs(actual[i][k] - expected[i][k]), 1e-6 * maxValue);
+      }
+    }
+  }
+}
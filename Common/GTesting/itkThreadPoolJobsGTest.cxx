@@ -0,0 +1,116 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+ // First include the header file to be tested:
+#include "itkThreadPoolJobs.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using itk::ThreadPoolJobs;
+
+namespace
+{
+  // More jobs than threads in the pool, so that nested jobs would deadlock
+  // if they waited for the pool.
+  std::size_t NumberOfManyJobs()
+  {
+    return 4 * itk::ThreadPool::GetInstance()->GetMaximumNumberOfThreads() + 1;
+  }
+}
+
+
+GTEST_TEST(ThreadPoolJobs, RunsEachJobOnce)
+{
+  const std::size_t numberOfJobs = NumberOfManyJobs();
+  std::vector< std::atomic< int > > counts(numberOfJobs);
+  for (auto & count : counts)
+  {
+    count = 0;
+  }
+
+  ThreadPoolJobs::RunJobs(numberOfJobs, [&counts](const std::size_t i) { ++counts[i]; });
+
+  for (const auto & count : counts)
+  {
+    EXPECT_EQ(count, 1);
+  }
+  EXPECT_FALSE(ThreadPoolJobs::IsPoolJob());
+}
+
+
+GTEST_TEST(ThreadPoolJobs, EveryJobIsPoolJob)
+{
+  const std::size_t numberOfJobs = NumberOfManyJobs();
+  std::vector< std::atomic< int > > poolJobs(numberOfJobs);
+
+  // Including job 0, which is executed by the calling thread.
+  ThreadPoolJobs::RunJobs(numberOfJobs, [&poolJobs](const std::size_t i) { poolJobs[i] = ThreadPoolJobs::IsPoolJob(); });
+
+  for (const auto & poolJob : poolJobs)
+  {
+    EXPECT_EQ(poolJob, 1);
+  }
+  EXPECT_FALSE(ThreadPoolJobs::IsPoolJob());
+}
+
+
+GTEST_TEST(ThreadPoolJobs, NestedJobsDoNotDeadlock)
+{
+  const std::size_t numberOfJobs = NumberOfManyJobs();
+  std::atomic< std::size_t > total(0);
+
+  ThreadPoolJobs::RunJobs(numberOfJobs, [&total, numberOfJobs](std::size_t)
+  {
+    ThreadPoolJobs::RunJobs(numberOfJobs, [&total](std::size_t) { ++total; });
+  });
+
+  EXPECT_EQ(total, numberOfJobs * numberOfJobs);
+}
+
+
+GTEST_TEST(ThreadPoolJobs, RethrowsExceptionOfLowestJob)
+{
+  const std::size_t numberOfJobs = NumberOfManyJobs();
+  std::atomic< std::size_t > finished(0);
+
+  try
+  {
+    ThreadPoolJobs::RunJobs(numberOfJobs, [&finished](const std::size_t i)
+    {
+      ++finished;
+      if (i % 3 == 1)
+      {
+        throw std::runtime_error(std::to_string(i));
+      }
+    });
+    FAIL() << "No exception thrown";
+  }
+  catch (const std::runtime_error & exception)
+  {
+    EXPECT_EQ(std::string(exception.what()), "1");
+  }
+
+  // All jobs were finished before the exception was rethrown.
+  EXPECT_EQ(finished, numberOfJobs);
+}
@@ -0,0 +1,177 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+ // First include the header file to be tested:
+#include "itkTransformParametersBinaryFile.h"
+
+#include <itkByteSwapper.h>
+#include <itkOptimizerParameters.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using itk::TransformParametersBinaryFile;
+
+namespace
+{
+  using ParametersType = itk::OptimizerParameters<double>;
+
+  // Parameters that are not exactly representable as float.
+  ParametersType MakeParameters()
+  {
+    ParametersType parameters(7);
+    for (unsigned int i = 0; i < parameters.GetSize(); ++i)
+    {
+      parameters[i] = (i % 2 == 0 ? 1.0 : -1.0) * (0.1 + 1000.0 * i / 3.0);
+    }
+    return parameters;
+  }
+
+  std::vector<char> ReadBytes(const std::string & fileName)
+  {
+    std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  template <typename T>
+  T ReadLittleEndian(const std::vector<char> & bytes, const std::size_t offset)
+  {
+    T value;
+    std::copy(bytes.begin() + offset, bytes.begin() + offset + sizeof(T), reinterpret_cast<char *>(&value));
+    itk::ByteSwapper<T>::SwapFromSystemToLittleEndian(&value);
+    return value;
+  }
+
+  // Checks the 24 byte header: magic, version, bytes per value, number of values.
+  void ExpectHeader(const std::vector<char> & bytes, const std::uint32_t expectedBytesPerValue,
+    const std::uint64_t expectedNumberOfValues)
+  {
+    const std::size_t   headerSize = TransformParametersBinaryFile::HeaderSize;
+    const std::uint32_t version    = TransformParametersBinaryFile::Version;
+
+    ASSERT_EQ(bytes.size(), headerSize + expectedBytesPerValue * expectedNumberOfValues);
+    EXPECT_EQ(std::string(bytes.data(), 8), "ELXTPBIN");
+    EXPECT_EQ(ReadLittleEndian<std::uint32_t>(bytes, 8), version);
+    EXPECT_EQ(ReadLittleEndian<std::uint32_t>(bytes, 12), expectedBytesPerValue);
+    EXPECT_EQ(ReadLittleEndian<std::uint64_t>(bytes, 16), expectedNumberOfValues);
+  }
+}
+
+
+GTEST_TEST(TransformParametersBinaryFile, DoubleRoundTripIsExact)
+{
+  const std::string    fileName = "TransformParametersBinaryFileGTest_double.dat";
+  const ParametersType expected = MakeParameters();
+
+  TransformParametersBinaryFile::Write(fileName, expected, false);
+  ExpectHeader(ReadBytes(fileName), 8, expected.GetSize());
+
+  ParametersType actual(expected.GetSize());
+  actual.Fill(0.0);
+  EXPECT_EQ(TransformParametersBinaryFile::Read(fileName, actual), expected.GetSize());
+  EXPECT_EQ(actual, expected);
+
+  std::remove(fileName.c_str());
+}
+
+
+GTEST_TEST(TransformParametersBinaryFile, FloatRoundTripRoundsToFloat)
+{
+  const std::string    fileName = "TransformParametersBinaryFileGTest_float.dat";
+  const ParametersType expected = MakeParameters();
+
+  TransformParametersBinaryFile::Write(fileName, expected, true);
+  ExpectHeader(ReadBytes(fileName), 4, expected.GetSize());
+
+  ParametersType actual(expected.GetSize());
+  actual.Fill(0.0);
+  EXPECT_EQ(TransformParametersBinaryFile::Read(fileName, actual), expected.GetSize());
+  for (unsigned int i = 0; i < expected.GetSize(); ++i)
+  {
+    EXPECT_EQ(actual[i], static_cast<double>(static_cast<float>(expected[i])));
+  }
+
+  std::remove(fileName.c_str());
+}
+
+
+GTEST_TEST(TransformParametersBinaryFile, ReadsFileWithoutHeader)
+{
+  const std::string    fileName = "TransformParametersBinaryFileGTest_raw.dat";
+  const ParametersType expected = MakeParameters();
+  {
+    std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+    file.write(reinterpret_cast<const char *>(expected.data_block()), sizeof(double) * expected.GetSize());
+  }
+
+  ParametersType actual(expected.GetSize());
+  actual.Fill(0.0);
+  EXPECT_EQ(TransformParametersBinaryFile::Read(fileName, actual), expected.GetSize());
+  EXPECT_EQ(actual, expected);
+
+  std::remove(fileName.c_str());
+}
+
+
+GTEST_TEST(TransformParametersBinaryFile, ReportsNumberOfValuesOnMismatch)
+{
+  const std::string    fileName = "TransformParametersBinaryFileGTest_mismatch.dat";
+  const ParametersType written = MakeParameters();
+
+  TransformParametersBinaryFile::Write(fileName, written, false);
+
+  ParametersType actual(written.GetSize() + 1);
+  EXPECT_EQ(TransformParametersBinaryFile::Read(fileName, actual), written.GetSize());
+
+  std::remove(fileName.c_str());
+}
+
+
+GTEST_TEST(TransformParametersBinaryFile, ThrowsOnInvalidHeader)
+{
+  const std::string fileName = "TransformParametersBinaryFileGTest_invalid.dat";
+  {
+    // A valid magic, followed by an unsupported version.
+    std::vector<char> bytes(TransformParametersBinaryFile::HeaderSize + 8, 0);
+    std::copy_n("ELXTPBIN", 8, bytes.begin());
+    bytes[8] = 99;
+    std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+    file.write(bytes.data(), bytes.size());
+  }
+
+  ParametersType actual(1);
+  EXPECT_THROW(TransformParametersBinaryFile::Read(fileName, actual), itk::ExceptionObject);
+
+  std::remove(fileName.c_str());
+}
+
+
+GTEST_TEST(TransformParametersBinaryFile, ThrowsOnMissingFile)
+{
+  ParametersType actual(1);
+  EXPECT_THROW(TransformParametersBinaryFile::Read("TransformParametersBinaryFileGTest_missing.dat", actual),
+    itk::ExceptionObject);
+}
@@ -93,6 +93,9 @@ public:
   /** Set the parameter map. */
   void SetParameterMap( const ParameterMapType & parMap );
 
+  /** Get the parameter map. */
+  itkGetConstReferenceMacro( ParameterMap, ParameterMapType );
+
   /** Option to print error and warning messages to a stream.
    * The default is true. If set to false no messages are printed.
    */
@@ -267,6 +267,41 @@ public:
     DerivativeType & imageJacobian,
     NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const override;
 
+  /** Pre-compute the support index and the interpolation weights of a fixed
+   * set of sample points. The weights are stored in single precision, to
+   * limit the memory use, which is for a third order 3D B-spline still
+   * 64 floats per sample. They remain in use until the grid changes.
+   */
+  bool PrecomputeSampleWeights(
+    const InputPointType * points,
+    const SizeValueType numberOfPoints ) override;
+
+  /** Release the pre-computed sample weights. */
+  void ReleaseSampleWeights( void ) override;
+
+  /** The time at which the sample weights were pre-computed. */
+  ModifiedTimeType GetSampleWeightsMTime( void ) const override
+  {
+    return this->m_SampleWeightsTimeStamp.GetMTime();
+  }
+
+
+  /** Transform a batch of samples, using the pre-computed weights. */
+  void TransformSamples(
+    const SizeValueType * sampleIndices,
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    const SizeValueType numberOfPoints ) const override;
+
+  /** Batched EvaluateJacobianWithImageGradientProduct(), using the pre-computed weights. */
+  void EvaluateJacobianWithImageGradientProductsOfSamples(
+    const SizeValueType * sampleIndices,
+    const InputPointType * ipps,
+    const MovingImageGradientType * movingImageGradients,
+    DerivativeType * imageJacobians,
+    NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+    const SizeValueType numberOfPoints ) const override;
+
   /** Compute the spatial Jacobian of the transformation. */
   void GetSpatialJacobian(
     const InputPointType & ipp,
@@ -330,6 +365,32 @@ protected:
   typedef typename Superclass::JacobianImageType JacobianImageType;
   typedef typename Superclass::JacobianPixelType JacobianPixelType;
 
+  /** The type in which the pre-computed sample weights are stored. */
+  typedef float SampleWeightValueType;
+
+  /** The number of interpolation weights that is stored per sample. */
+  virtual unsigned int GetNumberOfSampleWeights( void ) const;
+
+  /** Compute the support index and the interpolation weights that are
+   * stored per sample. Subclasses that use other weights override both.
+   */
+  virtual void ComputeSampleWeights(
+    const ContinuousIndexType & cindex,
+    typename WeightsType::ValueType * weights,
+    IndexType & supportIndex ) const;
+
+  /** Returns whether the pre-computed sample weights belong to the current grid,
+   * and whether they were computed for all of the given sample indices.
+   */
+  bool SampleWeightsAreValid(
+    const SizeValueType * sampleIndices,
+    const SizeValueType numberOfPoints ) const;
+
+  /** Compute the offsets in the coefficient images of the points in a support region,
+   * relative to its start, in the order of the weights of the WeightsFunctionType.
+   */
+  void ComputeSupportRegionOffsets( typename GridOffsetType::OffsetValueType * supportOffsets ) const;
+
   /** Pointer to function used to compute B-spline interpolation weights.
    * For each direction we create a different weights function for thread-
    * safety.
@@ -338,6 +399,19 @@ protected:
   std::vector< DerivativeWeightsFunctionPointer >                  m_DerivativeWeightsFunctions;
   std::vector< std::vector< SODerivativeWeightsFunctionPointer > > m_SODerivativeWeightsFunctions;
 
+  /** The pre-computed sample weights, see PrecomputeSampleWeights(), and the
+   * grid for which they were computed.
+   */
+  std::vector< SampleWeightValueType > m_SampleWeights;
+  std::vector< IndexType >             m_SampleSupportIndices;
+  std::vector< unsigned char >         m_SampleIsInside;
+  unsigned int                         m_NumberOfSampleWeights;
+  RegionType                           m_SampleWeightsGridRegion;
+  OriginType                           m_SampleWeightsGridOrigin;
+  SpacingType                          m_SampleWeightsGridSpacing;
+  DirectionType                        m_SampleWeightsGridDirection;
+  TimeStamp                            m_SampleWeightsTimeStamp;
+
 private:
 
   AdvancedBSplineDeformableTransform( const Self & ); // purposely not implemented
@@ -68,6 +68,7 @@ AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
     }
   }
   this->m_SupportSize = this->m_WeightsFunction->GetSupportSize();
+  this->m_NumberOfSampleWeights = 0;
 
   // Default grid size is zero
   typename RegionType::SizeType size;
@@ -517,6 +518,316 @@ AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ********************* PrecomputeSampleWeights ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+bool
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::PrecomputeSampleWeights(
+  const InputPointType * points,
+  const SizeValueType numberOfPoints )
+{
+  /** Allocate memory for all samples. */
+  const unsigned int numberOfWeights = this->GetNumberOfSampleWeights();
+  this->m_SampleWeights.resize( numberOfPoints * numberOfWeights );
+  this->m_SampleSupportIndices.resize( numberOfPoints );
+  this->m_SampleIsInside.resize( numberOfPoints );
+
+  /** Compute and store the support index and the weights of each sample. */
+  std::vector< typename WeightsType::ValueType > weights( numberOfWeights );
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    ContinuousIndexType cindex;
+    this->TransformPointToContinuousGridIndex( points[ i ], cindex );
+
+    const bool inside = this->InsideValidRegion( cindex );
+    this->m_SampleIsInside[ i ] = inside;
+    if( !inside )
+    {
+      continue;
+    }
+
+    this->ComputeSampleWeights( cindex, &weights[ 0 ], this->m_SampleSupportIndices[ i ] );
+    SampleWeightValueType * sampleWeights = &this->m_SampleWeights[ i * numberOfWeights ];
+    for( unsigned int k = 0; k < numberOfWeights; ++k )
+    {
+      sampleWeights[ k ] = static_cast< SampleWeightValueType >( weights[ k ] );
+    }
+  }
+
+  /** Remember the grid, to detect when the weights become invalid. */
+  this->m_NumberOfSampleWeights      = numberOfWeights;
+  this->m_SampleWeightsGridRegion    = this->m_GridRegion;
+  this->m_SampleWeightsGridOrigin    = this->m_GridOrigin;
+  this->m_SampleWeightsGridSpacing   = this->m_GridSpacing;
+  this->m_SampleWeightsGridDirection = this->m_GridDirection;
+  this->m_SampleWeightsTimeStamp.Modified();
+
+  return numberOfPoints > 0;
+
+} // end PrecomputeSampleWeights()
+
+
+/**
+ * ********************* ReleaseSampleWeights ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::ReleaseSampleWeights( void )
+{
+  std::vector< SampleWeightValueType >().swap( this->m_SampleWeights );
+  std::vector< IndexType >().swap( this->m_SampleSupportIndices );
+  std::vector< unsigned char >().swap( this->m_SampleIsInside );
+  this->m_NumberOfSampleWeights = 0;
+
+} // end ReleaseSampleWeights()
+
+
+/**
+ * ********************* TransformSamples ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::TransformSamples(
+  const SizeValueType * sampleIndices,
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  const SizeValueType numberOfPoints ) const
+{
+  /** Without valid pre-computed weights, compute everything. */
+  if( !this->m_CoefficientImages[ 0 ] || !this->SampleWeightsAreValid( sampleIndices, numberOfPoints ) )
+  {
+    this->TransformPoints( inputPoints, outputPoints, numberOfPoints );
+    return;
+  }
+
+  /** Get the things that are the same for all points. */
+  typedef typename GridOffsetType::OffsetValueType OffsetValueType;
+  const unsigned int numberOfWeights = WeightsFunctionType::NumberOfWeights;
+  OffsetValueType    supportOffsets[ numberOfWeights ];
+  this->ComputeSupportRegionOffsets( supportOffsets );
+
+  const PixelType * bufferPointers[ SpaceDimension ];
+  for( unsigned int j = 0; j < SpaceDimension; ++j )
+  {
+    bufferPointers[ j ] = this->m_CoefficientImages[ j ]->GetBufferPointer();
+  }
+
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    const SizeValueType    sample = sampleIndices[ i ];
+    const InputPointType & point  = inputPoints[ i ];
+
+    // NOTE: if the support region does not lie totally within the grid
+    // we assume zero displacement and return the input point
+    if( !this->m_SampleIsInside[ sample ] )
+    {
+      outputPoints[ i ] = point;
+      continue;
+    }
+
+    /** Correlate the coefficients in the support region with the weights. */
+    const IndexType & supportIndex    = this->m_SampleSupportIndices[ sample ];
+    OffsetValueType   offsetToSupport = 0;
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      offsetToSupport += supportIndex[ j ] * this->m_GridOffsetTable[ j ];
+    }
+    const SampleWeightValueType * weights = &this->m_SampleWeights[ sample * numberOfWeights ];
+
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      const PixelType * coefficients = bufferPointers[ j ] + offsetToSupport;
+      ScalarType        displacement = NumericTraits< ScalarType >::ZeroValue();
+      for( unsigned int k = 0; k < numberOfWeights; ++k )
+      {
+        displacement += weights[ k ] * coefficients[ supportOffsets[ k ] ];
+      }
+
+      // The output point is the start point + displacement.
+      outputPoints[ i ][ j ] = point[ j ] + displacement;
+    }
+  }
+
+} // end TransformSamples()
+
+
+/**
+ * ********************* EvaluateJacobianWithImageGradientProductsOfSamples ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::EvaluateJacobianWithImageGradientProductsOfSamples(
+  const SizeValueType * sampleIndices,
+  const InputPointType * ipps,
+  const MovingImageGradientType * movingImageGradients,
+  DerivativeType * imageJacobians,
+  NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+  const SizeValueType numberOfPoints ) const
+{
+  /** Without valid pre-computed weights, compute everything. */
+  if( !this->SampleWeightsAreValid( sampleIndices, numberOfPoints ) )
+  {
+    this->EvaluateJacobianWithImageGradientProducts(
+      ipps, movingImageGradients, imageJacobians, nonZeroJacobianIndices, numberOfPoints );
+    return;
+  }
+
+  /** Get the things that are the same for all points. */
+  typedef typename GridOffsetType::OffsetValueType OffsetValueType;
+  const unsigned int           numberOfWeights  = WeightsFunctionType::NumberOfWeights;
+  const NumberOfParametersType nnzji            = this->GetNumberOfNonZeroJacobianIndices();
+  const unsigned long          parametersPerDim = this->GetNumberOfParametersPerDimension();
+  OffsetValueType              supportOffsets[ numberOfWeights ];
+  this->ComputeSupportRegionOffsets( supportOffsets );
+
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    const SizeValueType          sample        = sampleIndices[ i ];
+    DerivativeType &             imageJacobian = imageJacobians[ i ];
+    NonZeroJacobianIndicesType & nzji          = nonZeroJacobianIndices[ i ];
+    nzji.resize( nnzji );
+
+    /** NOTE: if the support region does not lie totally within the grid
+     * we assume zero displacement and zero Jacobian.
+     */
+    if( !this->m_SampleIsInside[ sample ] )
+    {
+      imageJacobian.Fill( 0.0 );
+      for( NumberOfParametersType k = 0; k < nnzji; ++k )
+      {
+        nzji[ k ] = k;
+      }
+      continue;
+    }
+
+    const IndexType & supportIndex    = this->m_SampleSupportIndices[ sample ];
+    OffsetValueType   offsetToSupport = 0;
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      offsetToSupport += supportIndex[ j ] * this->m_GridOffsetTable[ j ];
+    }
+    const SampleWeightValueType * weights = &this->m_SampleWeights[ sample * numberOfWeights ];
+
+    /** Compute the inner product, and the nonzero Jacobian indices. */
+    NumberOfParametersType counter = 0;
+    for( unsigned int d = 0; d < SpaceDimension; ++d )
+    {
+      const MovingImageGradientValueType mig = movingImageGradients[ i ][ d ];
+      for( unsigned int k = 0; k < numberOfWeights; ++k )
+      {
+        imageJacobian[ counter ] = weights[ k ] * mig;
+        nzji[ counter ]          = offsetToSupport + supportOffsets[ k ] + d * parametersPerDim;
+        ++counter;
+      }
+    }
+  }
+
+} // end EvaluateJacobianWithImageGradientProductsOfSamples()
+
+
+/**
+ * ********************* GetNumberOfSampleWeights ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+unsigned int
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::GetNumberOfSampleWeights( void ) const
+{
+  return WeightsFunctionType::NumberOfWeights;
+
+} // end GetNumberOfSampleWeights()
+
+
+/**
+ * ********************* ComputeSampleWeights ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::ComputeSampleWeights(
+  const ContinuousIndexType & cindex,
+  typename WeightsType::ValueType * weights,
+  IndexType & supportIndex ) const
+{
+  WeightsType weightsArray( weights, WeightsFunctionType::NumberOfWeights, false );
+  this->m_WeightsFunction->ComputeStartIndex( cindex, supportIndex );
+  this->m_WeightsFunction->Evaluate( cindex, supportIndex, weightsArray );
+
+} // end ComputeSampleWeights()
+
+
+/**
+ * ********************* SampleWeightsAreValid ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+bool
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::SampleWeightsAreValid(
+  const SizeValueType * sampleIndices,
+  const SizeValueType numberOfPoints ) const
+{
+  const bool gridIsValid = !this->m_SampleIsInside.empty()
+    && this->m_NumberOfSampleWeights == this->GetNumberOfSampleWeights()
+    && this->m_SampleWeightsGridRegion == this->m_GridRegion
+    && this->m_SampleWeightsGridOrigin == this->m_GridOrigin
+    && this->m_SampleWeightsGridSpacing == this->m_GridSpacing
+    && this->m_SampleWeightsGridDirection == this->m_GridDirection;
+  if( !gridIsValid )
+  {
+    return false;
+  }
+
+  /** The sample indices refer to the points given to PrecomputeSampleWeights(). */
+  const SizeValueType numberOfSamples = this->m_SampleIsInside.size();
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    if( sampleIndices[ i ] >= numberOfSamples )
+    {
+      return false;
+    }
+  }
+  return true;
+
+} // end SampleWeightsAreValid()
+
+
+/**
+ * ********************* ComputeSupportRegionOffsets ****************************
+ */
+
+template< class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+AdvancedBSplineDeformableTransform< TScalarType, NDimensions, VSplineOrder >
+::ComputeSupportRegionOffsets( typename GridOffsetType::OffsetValueType * supportOffsets ) const
+{
+  /** The first dimension runs fastest, as in ComputeNonZeroJacobianIndices(). */
+  const unsigned int numberOfWeights = WeightsFunctionType::NumberOfWeights;
+  for( unsigned int k = 0; k < numberOfWeights; ++k )
+  {
+    unsigned int remainder = k;
+    supportOffsets[ k ] = 0;
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      supportOffsets[ k ] += ( remainder % this->m_SupportSize[ j ] ) * this->m_GridOffsetTable[ j ];
+      remainder           /= this->m_SupportSize[ j ];
+    }
+  }
+
+} // end ComputeSupportRegionOffsets()
+
+
 /**
  * ********************* GetSpatialJacobian ****************************
  */
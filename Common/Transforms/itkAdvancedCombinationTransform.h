@@ -74,6 +74,11 @@ public:
   /** Input and Output space dimension. */
   itkStaticConstMacro( SpaceDimension, unsigned int, NDimensions );
 
+  /** The number of points that the batched functions pass on to the initial
+   * and current transform at once, see TransformPoints().
+   */
+  itkStaticConstMacro( ChunkSize, unsigned int, 64 );
+
   /** Typedefs inherited from Superclass.*/
   typedef typename Superclass::ScalarType                    ScalarType;
   typedef typename Superclass::ParametersType                ParametersType;
@@ -81,6 +86,7 @@ public:
   typedef typename Superclass::ParametersValueType           ParametersValueType;
   typedef typename Superclass::NumberOfParametersType        NumberOfParametersType;
   typedef typename Superclass::DerivativeType                DerivativeType;
+  typedef typename Superclass::FloatDerivativeType           FloatDerivativeType;
   typedef typename Superclass::JacobianType                  JacobianType;
   typedef typename Superclass::InputVectorType               InputVectorType;
   typedef typename Superclass::OutputVectorType              OutputVectorType;
@@ -160,6 +166,16 @@ public:
   /**  Method to transform a point. */
   OutputPointType TransformPoint( const InputPointType  & point ) const override;
 
+  /** Method to transform a batch of points. The initial and the current
+   * transform each transform the batch at once, in chunks of ChunkSize points.
+   * The intermediate points T_0(x) of a chunk are kept on the stack, so that
+   * the batched functions of this class do not allocate memory.
+   */
+  void TransformPoints(
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    const SizeValueType numberOfPoints ) const override;
+
   /** ITK4 change:
    * The following pure virtual functions must be overloaded.
    * For now just throw an exception, since these are not used in elastix.
@@ -251,11 +267,71 @@ public:
     DerivativeType & imageJacobian,
     NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const override;
 
+  /** Batched version of EvaluateJacobianWithImageGradientProduct(). */
+  void EvaluateJacobianWithImageGradientProducts(
+    const InputPointType * ipps,
+    const MovingImageGradientType * movingImageGradients,
+    DerivativeType * imageJacobians,
+    NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+    const SizeValueType numberOfPoints ) const override;
+
+  /** Pre-compute the sample weights of the current transform. In case of
+   * composition, the points are first mapped by the initial transform.
+   */
+  bool PrecomputeSampleWeights(
+    const InputPointType * points,
+    const SizeValueType numberOfPoints ) override;
+
+  /** Release the sample weights of the current transform. */
+  void ReleaseSampleWeights( void ) override;
+
+  /** The time at which the sample weights of the current transform were computed. */
+  ModifiedTimeType GetSampleWeightsMTime( void ) const override
+  {
+    return this->m_CurrentTransform.IsNull() ? 0 : this->m_CurrentTransform->GetSampleWeightsMTime();
+  }
+
+
+  /** Batched transformation of samples with pre-computed weights. */
+  void TransformSamples(
+    const SizeValueType * sampleIndices,
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    const SizeValueType numberOfPoints ) const override;
+
+  /** Batched EvaluateJacobianWithImageGradientProduct() for samples with pre-computed weights. */
+  void EvaluateJacobianWithImageGradientProductsOfSamples(
+    const SizeValueType * sampleIndices,
+    const InputPointType * ipps,
+    const MovingImageGradientType * movingImageGradients,
+    DerivativeType * imageJacobians,
+    NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+    const SizeValueType numberOfPoints ) const override;
+
+  /** Single-precision version of EvaluateJacobianWithImageGradientProducts(),
+   * forwarded to the current transform like the double-precision version.
+   */
+  void EvaluateFloatJacobianWithImageGradientProducts(
+    const SizeValueType * sampleIndices,
+    const InputPointType * ipps,
+    const MovingImageGradientType * movingImageGradients,
+    FloatDerivativeType * imageJacobians,
+    NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+    const SizeValueType numberOfPoints ) const override;
+
   /** Compute the spatial Jacobian of the transformation. */
   void GetSpatialJacobian(
     const InputPointType & ipp,
     SpatialJacobianType & sj ) const override;
 
+  /** Compute the transformed point and the spatial Jacobian of the
+   * transformation, by the same call on the initial and current transforms.
+   */
+  void TransformPointAndSpatialJacobian(
+    const InputPointType & ipp,
+    OutputPointType & opp,
+    SpatialJacobianType & sj ) const override;
+
   /** Compute the spatial Hessian of the transformation. */
   void GetSpatialHessian(
     const InputPointType & ipp,
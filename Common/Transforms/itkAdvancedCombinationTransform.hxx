@@ -20,6 +20,9 @@
 
 #include "itkAdvancedCombinationTransform.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace itk
 {
 
@@ -1613,6 +1616,66 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
 } // end TransformPoint()
 
 
+/**
+ * ****************** TransformPoints ****************************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  const SizeValueType numberOfPoints ) const
+{
+  if( numberOfPoints == 0 )
+  {
+    return;
+  }
+
+  if( this->m_CurrentTransform.IsNull() )
+  {
+    /** Throw an exception. */
+    this->NoCurrentTransformSet();
+  }
+  else if( this->m_InitialTransform.IsNull() )
+  {
+    /** CURRENT ONLY: T(x) = T_1(x) */
+    this->m_CurrentTransform->TransformPoints( inputPoints, outputPoints, numberOfPoints );
+  }
+  else if( this->m_UseAddition )
+  {
+    /** ADDITION: T(x) = T_0(x) + T_1(x) - x */
+    OutputPointType initialPoints[ ChunkSize ];
+    for( SizeValueType begin = 0; begin < numberOfPoints; begin += ChunkSize )
+    {
+      const SizeValueType n = std::min< SizeValueType >( ChunkSize, numberOfPoints - begin );
+      this->m_InitialTransform->TransformPoints( inputPoints + begin, initialPoints, n );
+      this->m_CurrentTransform->TransformPoints( inputPoints + begin, outputPoints + begin, n );
+      for( SizeValueType i = 0; i < n; ++i )
+      {
+        for( unsigned int j = 0; j < SpaceDimension; ++j )
+        {
+          outputPoints[ begin + i ][ j ] += ( initialPoints[ i ][ j ] - inputPoints[ begin + i ][ j ] );
+        }
+      }
+    }
+  }
+  else
+  {
+    /** COMPOSITION: T(x) = T_1( T_0(x) ) */
+    OutputPointType initialPoints[ ChunkSize ];
+    for( SizeValueType begin = 0; begin < numberOfPoints; begin += ChunkSize )
+    {
+      const SizeValueType n = std::min< SizeValueType >( ChunkSize, numberOfPoints - begin );
+      this->m_InitialTransform->TransformPoints( inputPoints + begin, initialPoints, n );
+      this->m_CurrentTransform->TransformPoints( initialPoints, outputPoints + begin, n );
+    }
+  }
+
+} // end TransformPoints()
+
+
 /**
  * ****************** GetJacobian ****************************
  */
@@ -1652,6 +1715,255 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ****************** EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType * ipps,
+  const MovingImageGradientType * movingImageGradients,
+  DerivativeType * imageJacobians,
+  NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+  const SizeValueType numberOfPoints ) const
+{
+  if( numberOfPoints == 0 )
+  {
+    return;
+  }
+
+  if( this->m_CurrentTransform.IsNull() )
+  {
+    /** Throw an exception. */
+    this->NoCurrentTransformSet();
+  }
+  else if( this->m_InitialTransform.IsNull() || this->m_UseAddition )
+  {
+    /** CURRENT ONLY or ADDITION: J(x) = J_1(x) */
+    this->m_CurrentTransform->EvaluateJacobianWithImageGradientProducts(
+      ipps, movingImageGradients, imageJacobians, nonZeroJacobianIndices, numberOfPoints );
+  }
+  else
+  {
+    /** COMPOSITION: J(x) = J_1( T_0(x) ) */
+    OutputPointType initialPoints[ ChunkSize ];
+    for( SizeValueType begin = 0; begin < numberOfPoints; begin += ChunkSize )
+    {
+      const SizeValueType n = std::min< SizeValueType >( ChunkSize, numberOfPoints - begin );
+      this->m_InitialTransform->TransformPoints( ipps + begin, initialPoints, n );
+      this->m_CurrentTransform->EvaluateJacobianWithImageGradientProducts( initialPoints,
+        movingImageGradients + begin, imageJacobians + begin, nonZeroJacobianIndices + begin, n );
+    }
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
+/**
+ * ****************** PrecomputeSampleWeights ****************************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+bool
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::PrecomputeSampleWeights(
+  const InputPointType * points,
+  const SizeValueType numberOfPoints )
+{
+  if( this->m_CurrentTransform.IsNull() || numberOfPoints == 0 )
+  {
+    return false;
+  }
+  else if( this->m_InitialTransform.IsNull() || this->m_UseAddition )
+  {
+    /** CURRENT ONLY or ADDITION: the current transform is evaluated at x. */
+    return this->m_CurrentTransform->PrecomputeSampleWeights( points, numberOfPoints );
+  }
+
+  /** COMPOSITION: the current transform is evaluated at T_0(x). */
+  std::vector< OutputPointType > initialPoints( numberOfPoints );
+  this->m_InitialTransform->TransformPoints( points, &initialPoints[ 0 ], numberOfPoints );
+  return this->m_CurrentTransform->PrecomputeSampleWeights( &initialPoints[ 0 ], numberOfPoints );
+
+} // end PrecomputeSampleWeights()
+
+
+/**
+ * ****************** ReleaseSampleWeights ****************************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::ReleaseSampleWeights( void )
+{
+  if( this->m_CurrentTransform.IsNotNull() )
+  {
+    this->m_CurrentTransform->ReleaseSampleWeights();
+  }
+
+} // end ReleaseSampleWeights()
+
+
+/**
+ * ****************** TransformSamples ****************************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::TransformSamples(
+  const SizeValueType * sampleIndices,
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  const SizeValueType numberOfPoints ) const
+{
+  if( numberOfPoints == 0 )
+  {
+    return;
+  }
+
+  if( this->m_CurrentTransform.IsNull() )
+  {
+    /** Throw an exception. */
+    this->NoCurrentTransformSet();
+  }
+  else if( this->m_InitialTransform.IsNull() )
+  {
+    /** CURRENT ONLY: T(x) = T_1(x) */
+    this->m_CurrentTransform->TransformSamples( sampleIndices, inputPoints, outputPoints, numberOfPoints );
+  }
+  else if( this->m_UseAddition )
+  {
+    /** ADDITION: T(x) = T_0(x) + T_1(x) - x */
+    OutputPointType initialPoints[ ChunkSize ];
+    for( SizeValueType begin = 0; begin < numberOfPoints; begin += ChunkSize )
+    {
+      const SizeValueType n = std::min< SizeValueType >( ChunkSize, numberOfPoints - begin );
+      this->m_InitialTransform->TransformPoints( inputPoints + begin, initialPoints, n );
+      this->m_CurrentTransform->TransformSamples( sampleIndices + begin,
+        inputPoints + begin, outputPoints + begin, n );
+      for( SizeValueType i = 0; i < n; ++i )
+      {
+        for( unsigned int j = 0; j < SpaceDimension; ++j )
+        {
+          outputPoints[ begin + i ][ j ] += ( initialPoints[ i ][ j ] - inputPoints[ begin + i ][ j ] );
+        }
+      }
+    }
+  }
+  else
+  {
+    /** COMPOSITION: T(x) = T_1( T_0(x) ) */
+    OutputPointType initialPoints[ ChunkSize ];
+    for( SizeValueType begin = 0; begin < numberOfPoints; begin += ChunkSize )
+    {
+      const SizeValueType n = std::min< SizeValueType >( ChunkSize, numberOfPoints - begin );
+      this->m_InitialTransform->TransformPoints( inputPoints + begin, initialPoints, n );
+      this->m_CurrentTransform->TransformSamples( sampleIndices + begin, initialPoints, outputPoints + begin, n );
+    }
+  }
+
+} // end TransformSamples()
+
+
+/**
+ * ****************** EvaluateJacobianWithImageGradientProductsOfSamples ****************************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::EvaluateJacobianWithImageGradientProductsOfSamples(
+  const SizeValueType * sampleIndices,
+  const InputPointType * ipps,
+  const MovingImageGradientType * movingImageGradients,
+  DerivativeType * imageJacobians,
+  NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+  const SizeValueType numberOfPoints ) const
+{
+  if( numberOfPoints == 0 )
+  {
+    return;
+  }
+
+  if( this->m_CurrentTransform.IsNull() )
+  {
+    /** Throw an exception. */
+    this->NoCurrentTransformSet();
+  }
+  else if( this->m_InitialTransform.IsNull() || this->m_UseAddition )
+  {
+    /** CURRENT ONLY or ADDITION: J(x) = J_1(x) */
+    this->m_CurrentTransform->EvaluateJacobianWithImageGradientProductsOfSamples( sampleIndices,
+      ipps, movingImageGradients, imageJacobians, nonZeroJacobianIndices, numberOfPoints );
+  }
+  else
+  {
+    /** COMPOSITION: J(x) = J_1( T_0(x) ) */
+    OutputPointType initialPoints[ ChunkSize ];
+    for( SizeValueType begin = 0; begin < numberOfPoints; begin += ChunkSize )
+    {
+      const SizeValueType n = std::min< SizeValueType >( ChunkSize, numberOfPoints - begin );
+      this->m_InitialTransform->TransformPoints( ipps + begin, initialPoints, n );
+      this->m_CurrentTransform->EvaluateJacobianWithImageGradientProductsOfSamples( sampleIndices + begin,
+        initialPoints, movingImageGradients + begin, imageJacobians + begin, nonZeroJacobianIndices + begin, n );
+    }
+  }
+
+} // end EvaluateJacobianWithImageGradientProductsOfSamples()
+
+
+/**
+ * ****************** EvaluateFloatJacobianWithImageGradientProducts ****************************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::EvaluateFloatJacobianWithImageGradientProducts(
+  const SizeValueType * sampleIndices,
+  const InputPointType * ipps,
+  const MovingImageGradientType * movingImageGradients,
+  FloatDerivativeType * imageJacobians,
+  NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+  const SizeValueType numberOfPoints ) const
+{
+  if( numberOfPoints == 0 )
+  {
+    return;
+  }
+
+  if( this->m_CurrentTransform.IsNull() )
+  {
+    /** Throw an exception. */
+    this->NoCurrentTransformSet();
+  }
+  else if( this->m_InitialTransform.IsNull() || this->m_UseAddition )
+  {
+    /** CURRENT ONLY or ADDITION: J(x) = J_1(x) */
+    this->m_CurrentTransform->EvaluateFloatJacobianWithImageGradientProducts( sampleIndices,
+      ipps, movingImageGradients, imageJacobians, nonZeroJacobianIndices, numberOfPoints );
+  }
+  else
+  {
+    /** COMPOSITION: J(x) = J_1( T_0(x) ) */
+    OutputPointType initialPoints[ ChunkSize ];
+    for( SizeValueType begin = 0; begin < numberOfPoints; begin += ChunkSize )
+    {
+      const SizeValueType n = std::min< SizeValueType >( ChunkSize, numberOfPoints - begin );
+      this->m_InitialTransform->TransformPoints( ipps + begin, initialPoints, n );
+      this->m_CurrentTransform->EvaluateFloatJacobianWithImageGradientProducts(
+        sampleIndices ? sampleIndices + begin : 0, initialPoints, movingImageGradients + begin,
+        imageJacobians + begin, nonZeroJacobianIndices + begin, n );
+    }
+  }
+
+} // end EvaluateFloatJacobianWithImageGradientProducts()
+
+
 /**
  * ****************** GetSpatialJacobian ****************************
  */
@@ -1670,6 +1982,55 @@ AdvancedCombinationTransform< TScalarType, NDimensions >
 } // end GetSpatialJacobian()
 
 
+/**
+ * ****************** TransformPointAndSpatialJacobian ****************************
+ */
+
+template< typename TScalarType, unsigned int NDimensions >
+void
+AdvancedCombinationTransform< TScalarType, NDimensions >
+::TransformPointAndSpatialJacobian(
+  const InputPointType & ipp,
+  OutputPointType & opp,
+  SpatialJacobianType & sj ) const
+{
+  if( this->m_CurrentTransform.IsNull() )
+  {
+    /** Throw an exception. */
+    this->NoCurrentTransformSet();
+  }
+  else if( this->m_InitialTransform.IsNull() )
+  {
+    /** CURRENT ONLY: T(x) = T_1(x) */
+    this->m_CurrentTransform->TransformPointAndSpatialJacobian( ipp, opp, sj );
+  }
+  else if( this->m_UseAddition )
+  {
+    /** ADDITION: T(x) = T_0(x) + T_1(x) - x */
+    OutputPointType     opp0;
+    SpatialJacobianType sj0, identity;
+    this->m_InitialTransform->TransformPointAndSpatialJacobian( ipp, opp0, sj0 );
+    this->m_CurrentTransform->TransformPointAndSpatialJacobian( ipp, opp, sj );
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      opp[ j ] += opp0[ j ] - ipp[ j ];
+    }
+    identity.SetIdentity();
+    sj = sj0 + sj - identity;
+  }
+  else
+  {
+    /** COMPOSITION: T(x) = T_1( T_0(x) ) */
+    OutputPointType     opp0;
+    SpatialJacobianType sj0, sj1;
+    this->m_InitialTransform->TransformPointAndSpatialJacobian( ipp, opp0, sj0 );
+    this->m_CurrentTransform->TransformPointAndSpatialJacobian( opp0, opp, sj1 );
+    sj = sj1 * sj0;
+  }
+
+} // end TransformPointAndSpatialJacobian()
+
+
 /**
  * ****************** GetSpatialHessian ****************************
  */
@@ -125,6 +125,7 @@ public:
 
   typedef typename Superclass::NumberOfParametersType NumberOfParametersType;
   typedef typename Superclass::JacobianType           JacobianType;
+  typedef typename Superclass::DerivativeType         DerivativeType;
   typedef typename Superclass::InputVectorType        InputVectorType;
   typedef typename Superclass::OutputVectorType       OutputVectorType;
   typedef typename Superclass
@@ -146,6 +147,7 @@ public:
   typedef typename Superclass
     ::JacobianOfSpatialHessianType JacobianOfSpatialHessianType;
   typedef typename Superclass::InternalMatrixType InternalMatrixType;
+  typedef typename Superclass::MovingImageGradientType MovingImageGradientType;
 
   /** Standard matrix type for this class. */
   typedef Matrix< TScalarType,
@@ -343,6 +345,12 @@ public:
    */
   OutputPointType     TransformPoint( const InputPointType & point ) const override;
 
+  /** Transform a batch of points, without a virtual call per point. */
+  void TransformPoints(
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    const SizeValueType numberOfPoints ) const override;
+
   OutputVectorType    TransformVector( const InputVectorType & vector ) const override;
 
   OutputVnlVectorType TransformVector( const InputVnlVectorType & vector ) const override;
@@ -400,6 +408,16 @@ public:
     JacobianType &,
     NonZeroJacobianIndicesType & ) const override;
 
+  /** Batched version of EvaluateJacobianWithImageGradientProduct().
+   * A single Jacobian matrix is reused for all points of the batch.
+   */
+  void EvaluateJacobianWithImageGradientProducts(
+    const InputPointType * ipps,
+    const MovingImageGradientType * movingImageGradients,
+    DerivativeType * imageJacobians,
+    NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+    const SizeValueType numberOfPoints ) const override;
+
   /** Compute the spatial Jacobian of the transformation. */
   void GetSpatialJacobian(
     const InputPointType &,
@@ -264,6 +264,37 @@ AdvancedMatrixOffsetTransformBase< TScalarType, NInputDimensions, NOutputDimensi
 }
 
 
+// Transform a batch of points
+template< class TScalarType, unsigned int NInputDimensions,
+unsigned int NOutputDimensions >
+void
+AdvancedMatrixOffsetTransformBase< TScalarType, NInputDimensions, NOutputDimensions >
+::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  const SizeValueType numberOfPoints ) const
+{
+  const MatrixType &       matrix = this->m_Matrix;
+  const OutputVectorType & offset = this->m_Offset;
+
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    const InputPointType & point = inputPoints[ i ];
+    OutputPointType        outputPoint;
+    for( unsigned int r = 0; r < NOutputDimensions; ++r )
+    {
+      ScalarType value = offset[ r ];
+      for( unsigned int c = 0; c < NInputDimensions; ++c )
+      {
+        value += matrix( r, c ) * point[ c ];
+      }
+      outputPoint[ r ] = value;
+    }
+    outputPoints[ i ] = outputPoint;
+  }
+}
+
+
 // Transform a vector
 template< class TScalarType, unsigned int NInputDimensions,
 unsigned int NOutputDimensions >
@@ -607,6 +638,47 @@ AdvancedMatrixOffsetTransformBase< TScalarType, NInputDimensions, NOutputDimensi
 } // end GetJacobian()
 
 
+/**
+ * ********************* EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions,
+unsigned int NOutputDimensions >
+void
+AdvancedMatrixOffsetTransformBase< TScalarType, NInputDimensions, NOutputDimensions >
+::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType * ipps,
+  const MovingImageGradientType * movingImageGradients,
+  DerivativeType * imageJacobians,
+  NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+  const SizeValueType numberOfPoints ) const
+{
+  /** GetJacobian() is virtual, since subclasses have their own parameterization,
+   * but the Jacobian matrix is allocated only once for the whole batch.
+   */
+  JacobianType jacobian;
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    this->GetJacobian( ipps[ i ], jacobian, nonZeroJacobianIndices[ i ] );
+
+    /** Perform a full multiplication. */
+    const MovingImageGradientType & movingImageGradient = movingImageGradients[ i ];
+    DerivativeType &                imageJacobian       = imageJacobians[ i ];
+    const unsigned int              numberOfColumns     = jacobian.cols();
+    for( unsigned int mu = 0; mu < numberOfColumns; ++mu )
+    {
+      double sum = 0.0;
+      for( unsigned int dim = 0; dim < NOutputDimensions; ++dim )
+      {
+        sum += jacobian( dim, mu ) * movingImageGradient[ dim ];
+      }
+      imageJacobian[ mu ] = sum;
+    }
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
 /**
  * ********************* GetSpatialJacobian ****************************
  */
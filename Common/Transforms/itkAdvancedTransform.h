@@ -158,6 +158,11 @@ public:
   typedef OutputCovariantVectorType                   MovingImageGradientType;
   typedef typename MovingImageGradientType::ValueType MovingImageGradientValueType;
 
+  /** A single-precision version of the DerivativeType, used to store image
+   * Jacobians in the mixed-precision metric path.
+   */
+  typedef Array< float > FloatDerivativeType;
+
   /** Get the number of nonzero Jacobian indices. By default all. */
   virtual NumberOfParametersType GetNumberOfNonZeroJacobianIndices( void ) const;
 
@@ -205,6 +210,97 @@ public:
     DerivativeType & imageJacobian,
     NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const;
 
+  /** Transform a batch of points.
+   * The default implementation simply calls TransformPoint() for each point.
+   * Subclasses may override it, to do the per-call work only once for the
+   * whole batch, and to avoid the virtual call per point.
+   * The output array should be allocated by the caller.
+   */
+  virtual void TransformPoints(
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    const SizeValueType numberOfPoints ) const;
+
+  /** Batched version of EvaluateJacobianWithImageGradientProduct().
+   * For each point i, the inner product of the Jacobian at ipps[ i ] with
+   * movingImageGradients[ i ] is stored in imageJacobians[ i ], and the
+   * corresponding nonzero Jacobian indices in nonZeroJacobianIndices[ i ].
+   * The output arrays should be allocated by the caller, and the elements of
+   * imageJacobians should have size GetNumberOfNonZeroJacobianIndices().
+   * The default implementation calls EvaluateJacobianWithImageGradientProduct()
+   * for each point.
+   */
+  virtual void EvaluateJacobianWithImageGradientProducts(
+    const InputPointType * ipps,
+    const MovingImageGradientType * movingImageGradients,
+    DerivativeType * imageJacobians,
+    NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+    const SizeValueType numberOfPoints ) const;
+
+  /** Pre-compute, for a fixed set of sample points, the data that does not
+   * depend on the parameters, such as the B-spline interpolation weights.
+   * It is used by TransformSamples() and by
+   * EvaluateJacobianWithImageGradientProductsOfSamples(), as long as the
+   * fixed parameters do not change. Returns whether the transform supports
+   * this; the default implementation does not, and returns false.
+   */
+  virtual bool PrecomputeSampleWeights(
+    const InputPointType * points,
+    const SizeValueType numberOfPoints );
+
+  /** Release the data stored by PrecomputeSampleWeights(). */
+  virtual void ReleaseSampleWeights( void ) {}
+
+  /** The time of the last call of PrecomputeSampleWeights(), such that a
+   * caller can detect that someone else replaced its sample weights.
+   * Zero when the transform does not support sample weights.
+   */
+  virtual ModifiedTimeType GetSampleWeightsMTime( void ) const
+  {
+    return 0;
+  }
+
+
+  /** Version of TransformPoints() for points from the set that was passed to
+   * PrecomputeSampleWeights(): sampleIndices[ i ] is the position of
+   * inputPoints[ i ] in that set. The default implementation ignores the
+   * sample indices and calls TransformPoints().
+   */
+  virtual void TransformSamples(
+    const SizeValueType * sampleIndices,
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    const SizeValueType numberOfPoints ) const;
+
+  /** Version of EvaluateJacobianWithImageGradientProducts() for points from
+   * the set that was passed to PrecomputeSampleWeights(), see TransformSamples().
+   * The default implementation ignores the sample indices.
+   */
+  virtual void EvaluateJacobianWithImageGradientProductsOfSamples(
+    const SizeValueType * sampleIndices,
+    const InputPointType * ipps,
+    const MovingImageGradientType * movingImageGradients,
+    DerivativeType * imageJacobians,
+    NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+    const SizeValueType numberOfPoints ) const;
+
+  /** Single-precision version of EvaluateJacobianWithImageGradientProducts(),
+   * which halves the memory needed for a batch of image Jacobians.
+   * When sampleIndices is nonzero, the points are from the set that was
+   * passed to PrecomputeSampleWeights(), see TransformSamples().
+   * The RecursiveBSplineTransform computes the products in float. The default
+   * implementation is only a fallback for the other transforms: it computes
+   * the image Jacobians one by one in a temporary double array, and rounds
+   * them to float, so that it saves memory but no arithmetic.
+   */
+  virtual void EvaluateFloatJacobianWithImageGradientProducts(
+    const SizeValueType * sampleIndices,
+    const InputPointType * ipps,
+    const MovingImageGradientType * movingImageGradients,
+    FloatDerivativeType * imageJacobians,
+    NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+    const SizeValueType numberOfPoints ) const;
+
   /** Compute the spatial Jacobian of the transformation.
    *
    * The spatial Jacobian is expressed as a vector of partial derivatives of the
@@ -235,6 +331,17 @@ public:
     const InputPointType & ipp,
     SpatialJacobianType & sj ) const = 0;
 
+  /** Compute the transformed point and the spatial Jacobian in one call, which
+   * is used when both are needed for every voxel of an image. Transforms that
+   * obtain the transformed point as a by-product of the spatial Jacobian can
+   * override this. The default implementation calls TransformPoint() and
+   * GetSpatialJacobian().
+   */
+  virtual void TransformPointAndSpatialJacobian(
+    const InputPointType & ipp,
+    OutputPointType & opp,
+    SpatialJacobianType & sj ) const;
+
   /** Override some pure virtual ITK4 functions. */
   void ComputeJacobianWithRespectToParameters(
     const InputPointType & itkNotUsed( p ), JacobianType & itkNotUsed( j ) ) const override
@@ -107,6 +107,162 @@ AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ********************* TransformPoints ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  const SizeValueType numberOfPoints ) const
+{
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    outputPoints[ i ] = this->TransformPoint( inputPoints[ i ] );
+  }
+
+} // end TransformPoints()
+
+
+/**
+ * ********************* TransformPointAndSpatialJacobian ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::TransformPointAndSpatialJacobian(
+  const InputPointType & ipp,
+  OutputPointType & opp,
+  SpatialJacobianType & sj ) const
+{
+  opp = this->TransformPoint( ipp );
+  this->GetSpatialJacobian( ipp, sj );
+
+} // end TransformPointAndSpatialJacobian()
+
+
+/**
+ * ********************* EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType * ipps,
+  const MovingImageGradientType * movingImageGradients,
+  DerivativeType * imageJacobians,
+  NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+  const SizeValueType numberOfPoints ) const
+{
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    this->EvaluateJacobianWithImageGradientProduct(
+      ipps[ i ], movingImageGradients[ i ], imageJacobians[ i ], nonZeroJacobianIndices[ i ] );
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
+/**
+ * ********************* PrecomputeSampleWeights ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+bool
+AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::PrecomputeSampleWeights(
+  const InputPointType * itkNotUsed( points ),
+  const SizeValueType itkNotUsed( numberOfPoints ) )
+{
+  return false;
+
+} // end PrecomputeSampleWeights()
+
+
+/**
+ * ********************* TransformSamples ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::TransformSamples(
+  const SizeValueType * itkNotUsed( sampleIndices ),
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  const SizeValueType numberOfPoints ) const
+{
+  this->TransformPoints( inputPoints, outputPoints, numberOfPoints );
+
+} // end TransformSamples()
+
+
+/**
+ * ********************* EvaluateJacobianWithImageGradientProductsOfSamples ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::EvaluateJacobianWithImageGradientProductsOfSamples(
+  const SizeValueType * itkNotUsed( sampleIndices ),
+  const InputPointType * ipps,
+  const MovingImageGradientType * movingImageGradients,
+  DerivativeType * imageJacobians,
+  NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+  const SizeValueType numberOfPoints ) const
+{
+  this->EvaluateJacobianWithImageGradientProducts(
+    ipps, movingImageGradients, imageJacobians, nonZeroJacobianIndices, numberOfPoints );
+
+} // end EvaluateJacobianWithImageGradientProductsOfSamples()
+
+
+/**
+ * ********************* EvaluateFloatJacobianWithImageGradientProducts ****************************
+ */
+
+template< class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions >
+void
+AdvancedTransform< TScalarType, NInputDimensions, NOutputDimensions >
+::EvaluateFloatJacobianWithImageGradientProducts(
+  const SizeValueType * sampleIndices,
+  const InputPointType * ipps,
+  const MovingImageGradientType * movingImageGradients,
+  FloatDerivativeType * imageJacobians,
+  NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+  const SizeValueType numberOfPoints ) const
+{
+  /** The temporary double array is small enough to stay in cache. */
+  DerivativeType imageJacobian( this->GetNumberOfNonZeroJacobianIndices() );
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    if( sampleIndices )
+    {
+      this->EvaluateJacobianWithImageGradientProductsOfSamples( sampleIndices + i,
+        ipps + i, movingImageGradients + i, &imageJacobian, nonZeroJacobianIndices + i, 1 );
+    }
+    else
+    {
+      this->EvaluateJacobianWithImageGradientProduct( ipps[ i ], movingImageGradients[ i ],
+        imageJacobian, nonZeroJacobianIndices[ i ] );
+    }
+
+    FloatDerivativeType & floatImageJacobian = imageJacobians[ i ];
+    for( unsigned int j = 0; j < imageJacobian.GetSize(); ++j )
+    {
+      floatImageJacobian[ j ] = static_cast< float >( imageJacobian[ j ] );
+    }
+  }
+
+} // end EvaluateFloatJacobianWithImageGradientProducts()
+
+
 /**
  * ********************* GetNumberOfNonZeroJacobianIndices ****************************
  */
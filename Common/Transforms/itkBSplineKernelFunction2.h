@@ -94,6 +94,20 @@ public:
   }
 
 
+  /** Evaluate the function at the entire support, for a batch of values.
+   * The loop calls the inlined, branch-free (for order 1 to 3) evaluation,
+   * so that the compiler can vectorize it over the values.
+   */
+  void EvaluateBatch( const double * u, double * weights,
+    const unsigned int supportSize, const SizeValueType numberOfValues ) const override
+  {
+    for( SizeValueType i = 0; i < numberOfValues; ++i )
+    {
+      this->Evaluate( Dispatch< VSplineOrder >(), u[ i ], weights + i * supportSize );
+    }
+  }
+
+
 protected:
 
   BSplineKernelFunction2(){}
@@ -57,6 +57,22 @@ public:
   /** Evaluate the function. Subclasses must implement this. */
   virtual void Evaluate( const TRealValueType & u, TRealValueType * weights ) const = 0;
 
+  /** Evaluate the function at the entire support, for a batch of values.
+   * The weights of u[ i ] are written to weights[ i * supportSize ], ...,
+   * weights[ ( i + 1 ) * supportSize - 1 ]. The default implementation calls
+   * the virtual Evaluate() for each value; subclasses can override it with a
+   * loop that the compiler can inline and vectorize.
+   */
+  virtual void EvaluateBatch( const TRealValueType * u, TRealValueType * weights,
+    const unsigned int supportSize, const SizeValueType numberOfValues ) const
+  {
+    for( SizeValueType i = 0; i < numberOfValues; ++i )
+    {
+      this->Evaluate( u[ i ], weights + i * supportSize );
+    }
+  }
+
+
 protected:
   KernelFunctionBase2() {};
   ~KernelFunctionBase2() override {};
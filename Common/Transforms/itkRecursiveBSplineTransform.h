@@ -66,6 +66,7 @@ public:
   typedef typename Superclass::ParametersValueType       ParametersValueType;
   typedef typename Superclass::NumberOfParametersType    NumberOfParametersType;
   typedef typename Superclass::DerivativeType            DerivativeType;
+  typedef typename Superclass::FloatDerivativeType       FloatDerivativeType;
   typedef typename Superclass::JacobianType              JacobianType;
   typedef typename Superclass::InputVectorType           InputVectorType;
   typedef typename Superclass::OutputVectorType          OutputVectorType;
@@ -133,6 +134,14 @@ public:
    */
   OutputPointType TransformPoint( const InputPointType & point ) const override;
 
+  /** Transform a batch of points. The coefficient pointers and offset table
+   * are looked up only once for the whole batch.
+   */
+  void TransformPoints(
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    const SizeValueType numberOfPoints ) const override;
+
   /** Compute the Jacobian of the transformation. */
   void GetJacobian(
     const InputPointType & ipp,
@@ -148,11 +157,57 @@ public:
     DerivativeType & imageJacobian,
     NonZeroJacobianIndicesType & nonZeroJacobianIndices ) const override;
 
+  /** Batched version of EvaluateJacobianWithImageGradientProduct(). */
+  void EvaluateJacobianWithImageGradientProducts(
+    const InputPointType * ipps,
+    const MovingImageGradientType * movingImageGradients,
+    DerivativeType * imageJacobians,
+    NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+    const SizeValueType numberOfPoints ) const override;
+
+  /** Transform a batch of samples, using the pre-computed 1D weights. */
+  void TransformSamples(
+    const SizeValueType * sampleIndices,
+    const InputPointType * inputPoints,
+    OutputPointType * outputPoints,
+    const SizeValueType numberOfPoints ) const override;
+
+  /** Batched EvaluateJacobianWithImageGradientProduct(), using the pre-computed 1D weights. */
+  void EvaluateJacobianWithImageGradientProductsOfSamples(
+    const SizeValueType * sampleIndices,
+    const InputPointType * ipps,
+    const MovingImageGradientType * movingImageGradients,
+    DerivativeType * imageJacobians,
+    NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+    const SizeValueType numberOfPoints ) const override;
+
+  /** Single-precision version of EvaluateJacobianWithImageGradientProducts().
+   * The products of the 1D weights and the moving image gradient are computed
+   * in float, directly into the image Jacobians. Uses the pre-computed 1D
+   * weights, which are stored in float, when sampleIndices is nonzero.
+   */
+  void EvaluateFloatJacobianWithImageGradientProducts(
+    const SizeValueType * sampleIndices,
+    const InputPointType * ipps,
+    const MovingImageGradientType * movingImageGradients,
+    FloatDerivativeType * imageJacobians,
+    NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+    const SizeValueType numberOfPoints ) const override;
+
   /** Compute the spatial Jacobian of the transformation. */
   void GetSpatialJacobian(
     const InputPointType & ipp,
     SpatialJacobianType & sj ) const override;
 
+  /** Compute the transformed point and the spatial Jacobian of the
+   * transformation. The recursive spatial Jacobian computation yields the
+   * displacement for free, so the weights are evaluated only once.
+   */
+  void TransformPointAndSpatialJacobian(
+    const InputPointType & ipp,
+    OutputPointType & opp,
+    SpatialJacobianType & sj ) const override;
+
   /** Compute the spatial Hessian of the transformation. */
   void GetSpatialHessian(
     const InputPointType & ipp,
@@ -198,6 +253,17 @@ protected:
 
   typename RecursiveBSplineWeightFunctionType::Pointer m_RecursiveBSplineWeightFunction;
 
+  /** The recursive implementation stores the individual 1D weights per
+   * sample, i.e. only SpaceDimension * ( SplineOrder + 1 ) values.
+   */
+  typedef typename Superclass::SampleWeightValueType SampleWeightValueType;
+  unsigned int GetNumberOfSampleWeights( void ) const override;
+
+  void ComputeSampleWeights(
+    const ContinuousIndexType & cindex,
+    typename WeightsType::ValueType * weights,
+    IndexType & supportIndex ) const override;
+
   /** Compute the nonzero Jacobian indices. */
   void ComputeNonZeroJacobianIndices(
     NonZeroJacobianIndicesType & nonZeroJacobianIndices,
@@ -21,6 +21,7 @@
 #include "itkRecursiveBSplineTransform.h"
 
 #include "itkRecursiveBSplineTransformImplementation.h"
+#include "itkRecursiveBSplineTransformImplementationSIMD.h"
 
 
 namespace itk
@@ -102,7 +103,7 @@ RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
 
   /** Call the recursive TransformPoint function. */
   ScalarType displacement[ SpaceDimension ];
-  RecursiveBSplineTransformImplementation< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
+  RecursiveBSplineTransformImplementationSIMD< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
     ::TransformPoint( displacement, mu, bsplineOffsetTable, weightsArray1D );
 
   // The output point is the start point + displacement.
@@ -115,6 +116,90 @@ RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
 } // end TransformPoint()
 
 
+/**
+ * ********************* TransformPoints ****************************
+ */
+
+template< typename TScalar, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
+::TransformPoints(
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  const SizeValueType numberOfPoints ) const
+{
+  /** Check if the coefficient image has been set. */
+  if( !this->m_CoefficientImages[ 0 ] )
+  {
+    itkWarningMacro( << "B-spline coefficients have not been set" );
+    for( SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+      outputPoints[ i ] = inputPoints[ i ];
+    }
+    return;
+  }
+
+  /** Define some constants, and get the things that are the same for all points. */
+  const unsigned int numberOfWeights = RecursiveBSplineWeightFunctionType::NumberOfWeights;
+  const OffsetValueType * bsplineOffsetTable = this->m_CoefficientImages[ 0 ]->GetOffsetTable();
+  ScalarType *            bufferPointers[ SpaceDimension ];
+  for( unsigned int j = 0; j < SpaceDimension; ++j )
+  {
+    bufferPointers[ j ] = this->m_CoefficientImages[ j ]->GetBufferPointer();
+  }
+
+  /** Allocate weights on the stack: */
+  typename WeightsType::ValueType weightsArray1D[ numberOfWeights ];
+  WeightsType weights1D( weightsArray1D, numberOfWeights, false );
+
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    const InputPointType & point = inputPoints[ i ];
+
+    /** Convert to continuous index. */
+    ContinuousIndexType cindex;
+    this->TransformPointToContinuousGridIndex( point, cindex );
+
+    // NOTE: if the support region does not lie totally within the grid
+    // we assume zero displacement and return the input point
+    if( !this->InsideValidRegion( cindex ) )
+    {
+      outputPoints[ i ] = point;
+      continue;
+    }
+
+    // Compute interpolation weighs and store them in weights1D
+    IndexType supportIndex;
+    this->m_RecursiveBSplineWeightFunction->Evaluate( cindex, weights1D, supportIndex );
+
+    OffsetValueType totalOffsetToSupportIndex = 0;
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      totalOffsetToSupportIndex += supportIndex[ j ] * bsplineOffsetTable[ j ];
+    }
+
+    ScalarType * mu[ SpaceDimension ];
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      mu[ j ] = bufferPointers[ j ] + totalOffsetToSupportIndex;
+    }
+
+    /** Call the recursive TransformPoint function. */
+    ScalarType displacement[ SpaceDimension ];
+    RecursiveBSplineTransformImplementationSIMD< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
+      ::TransformPoint( displacement, mu, bsplineOffsetTable, weightsArray1D );
+
+    // The output point is the start point + displacement.
+    OutputPointType & outputPoint = outputPoints[ i ];
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      outputPoint[ j ] = displacement[ j ] + point[ j ];
+    }
+  }
+
+} // end TransformPoints()
+
+
 /**
  * ********************* GetJacobian ****************************
  */
@@ -167,7 +252,7 @@ RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
    * The pointer has changed after this function call.
    */
   ParametersValueType * jacobianPointer = jacobian.data_block();
-  RecursiveBSplineTransformImplementation< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
+  RecursiveBSplineTransformImplementationSIMD< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
     ::GetJacobian( jacobianPointer, weightsArray1D, 1.0 );
 
   /** Compute the nonzero Jacobian indices.
@@ -234,7 +319,7 @@ RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
     migArray[ j ] = movingImageGradient[ j ];
   }
   ParametersValueType * imageJacobianPointer = imageJacobian.data_block();
-  RecursiveBSplineTransformImplementation< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
+  RecursiveBSplineTransformImplementationSIMD< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
     ::EvaluateJacobianWithImageGradientProduct( imageJacobianPointer, migArray, weightsArray1D, 1.0 );
 
   /** Setup support region needed for the nonZeroJacobianIndices. */
@@ -250,6 +335,417 @@ RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ********************* EvaluateJacobianWithImageGradientProducts ****************************
+ */
+
+template< class TScalar, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
+::EvaluateJacobianWithImageGradientProducts(
+  const InputPointType * ipps,
+  const MovingImageGradientType * movingImageGradients,
+  DerivativeType * imageJacobians,
+  NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+  const SizeValueType numberOfPoints ) const
+{
+  const NumberOfParametersType nnzji = this->GetNumberOfNonZeroJacobianIndices();
+
+  /** Check if the coefficient image has been set. */
+  if( !this->m_CoefficientImages[ 0 ] )
+  {
+    itkWarningMacro( << "B-spline coefficients have not been set" );
+    for( SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+      imageJacobians[ i ].Fill( 0.0 );
+      nonZeroJacobianIndices[ i ].resize( nnzji );
+      for( NumberOfParametersType k = 0; k < nnzji; ++k )
+      {
+        nonZeroJacobianIndices[ i ][ k ] = k;
+      }
+    }
+    return;
+  }
+
+  /** Get the things that are the same for all points. */
+  const unsigned long     parametersPerDim = this->GetNumberOfParametersPerDimension();
+  const OffsetValueType * gridOffsetTable  = this->m_CoefficientImages[ 0 ]->GetOffsetTable();
+
+  /** Allocate weights on the stack. */
+  const unsigned int numberOfWeights = RecursiveBSplineWeightFunctionType::NumberOfWeights;
+  typename WeightsType::ValueType weightsArray1D[ numberOfWeights ];
+  WeightsType weights1D( weightsArray1D, numberOfWeights, false );
+
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    NonZeroJacobianIndicesType & nzji = nonZeroJacobianIndices[ i ];
+    nzji.resize( nnzji );
+
+    /** Convert the physical point to a continuous index. */
+    ContinuousIndexType cindex;
+    this->TransformPointToContinuousGridIndex( ipps[ i ], cindex );
+
+    /** NOTE: if the support region does not lie totally within the grid
+     * we assume zero displacement and zero Jacobian.
+     */
+    if( !this->InsideValidRegion( cindex ) )
+    {
+      imageJacobians[ i ].Fill( 0.0 );
+      for( NumberOfParametersType k = 0; k < nnzji; ++k )
+      {
+        nzji[ k ] = k;
+      }
+      continue;
+    }
+
+    /** Compute the individual 1D interpolation weights. */
+    IndexType supportIndex;
+    this->m_RecursiveBSplineWeightFunction->Evaluate( cindex, weights1D, supportIndex );
+
+    /** Recursively compute the inner product of the Jacobian and the moving image gradient. */
+    double migArray[ SpaceDimension ];
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      migArray[ j ] = movingImageGradients[ i ][ j ];
+    }
+    ParametersValueType * imageJacobianPointer = imageJacobians[ i ].data_block();
+    RecursiveBSplineTransformImplementationSIMD< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
+      ::EvaluateJacobianWithImageGradientProduct( imageJacobianPointer, migArray, weightsArray1D, 1.0 );
+
+    /** Compute the nonzero Jacobian indices, directly from the support index. */
+    OffsetValueType totalOffsetToSupportIndex = 0;
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      totalOffsetToSupportIndex += supportIndex[ j ] * gridOffsetTable[ j ];
+    }
+    unsigned long   currentIndex = totalOffsetToSupportIndex;
+    unsigned long * nzjiPointer  = &nzji[ 0 ];
+    RecursiveBSplineTransformImplementation< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
+      ::ComputeNonZeroJacobianIndices( nzjiPointer, parametersPerDim, currentIndex, gridOffsetTable );
+  }
+
+} // end EvaluateJacobianWithImageGradientProducts()
+
+
+/**
+ * ********************* TransformSamples ****************************
+ */
+
+template< typename TScalar, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
+::TransformSamples(
+  const SizeValueType * sampleIndices,
+  const InputPointType * inputPoints,
+  OutputPointType * outputPoints,
+  const SizeValueType numberOfPoints ) const
+{
+  /** Without valid pre-computed weights, compute everything. */
+  if( !this->m_CoefficientImages[ 0 ] || !this->SampleWeightsAreValid( sampleIndices, numberOfPoints ) )
+  {
+    this->TransformPoints( inputPoints, outputPoints, numberOfPoints );
+    return;
+  }
+
+  /** Get the things that are the same for all points. */
+  const unsigned int      numberOfWeights    = RecursiveBSplineWeightFunctionType::NumberOfWeights;
+  const OffsetValueType * bsplineOffsetTable = this->m_CoefficientImages[ 0 ]->GetOffsetTable();
+  ScalarType *            bufferPointers[ SpaceDimension ];
+  for( unsigned int j = 0; j < SpaceDimension; ++j )
+  {
+    bufferPointers[ j ] = this->m_CoefficientImages[ j ]->GetBufferPointer();
+  }
+
+  typename WeightsType::ValueType weightsArray1D[ numberOfWeights ];
+
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    const SizeValueType    sample = sampleIndices[ i ];
+    const InputPointType & point  = inputPoints[ i ];
+
+    // NOTE: if the support region does not lie totally within the grid
+    // we assume zero displacement and return the input point
+    if( !this->m_SampleIsInside[ sample ] )
+    {
+      outputPoints[ i ] = point;
+      continue;
+    }
+
+    /** Get the stored weights. */
+    const SampleWeightValueType * sampleWeights = &this->m_SampleWeights[ sample * numberOfWeights ];
+    for( unsigned int k = 0; k < numberOfWeights; ++k )
+    {
+      weightsArray1D[ k ] = sampleWeights[ k ];
+    }
+
+    const IndexType & supportIndex              = this->m_SampleSupportIndices[ sample ];
+    OffsetValueType   totalOffsetToSupportIndex = 0;
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      totalOffsetToSupportIndex += supportIndex[ j ] * bsplineOffsetTable[ j ];
+    }
+
+    ScalarType * mu[ SpaceDimension ];
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      mu[ j ] = bufferPointers[ j ] + totalOffsetToSupportIndex;
+    }
+
+    /** Call the recursive TransformPoint function. */
+    ScalarType displacement[ SpaceDimension ];
+    RecursiveBSplineTransformImplementationSIMD< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
+      ::TransformPoint( displacement, mu, bsplineOffsetTable, weightsArray1D );
+
+    // The output point is the start point + displacement.
+    OutputPointType & outputPoint = outputPoints[ i ];
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      outputPoint[ j ] = displacement[ j ] + point[ j ];
+    }
+  }
+
+} // end TransformSamples()
+
+
+/**
+ * ********************* EvaluateJacobianWithImageGradientProductsOfSamples ****************************
+ */
+
+template< class TScalar, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
+::EvaluateJacobianWithImageGradientProductsOfSamples(
+  const SizeValueType * sampleIndices,
+  const InputPointType * ipps,
+  const MovingImageGradientType * movingImageGradients,
+  DerivativeType * imageJacobians,
+  NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+  const SizeValueType numberOfPoints ) const
+{
+  /** Without valid pre-computed weights, compute everything. */
+  if( !this->SampleWeightsAreValid( sampleIndices, numberOfPoints ) )
+  {
+    this->EvaluateJacobianWithImageGradientProducts(
+      ipps, movingImageGradients, imageJacobians, nonZeroJacobianIndices, numberOfPoints );
+    return;
+  }
+
+  /** Get the things that are the same for all points. */
+  const NumberOfParametersType nnzji            = this->GetNumberOfNonZeroJacobianIndices();
+  const unsigned long          parametersPerDim = this->GetNumberOfParametersPerDimension();
+  const OffsetValueType *      gridOffsetTable  = this->m_CoefficientImages[ 0 ]->GetOffsetTable();
+  const unsigned int           numberOfWeights  = RecursiveBSplineWeightFunctionType::NumberOfWeights;
+
+  typename WeightsType::ValueType weightsArray1D[ numberOfWeights ];
+
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    const SizeValueType          sample = sampleIndices[ i ];
+    NonZeroJacobianIndicesType & nzji   = nonZeroJacobianIndices[ i ];
+    nzji.resize( nnzji );
+
+    /** NOTE: if the support region does not lie totally within the grid
+     * we assume zero displacement and zero Jacobian.
+     */
+    if( !this->m_SampleIsInside[ sample ] )
+    {
+      imageJacobians[ i ].Fill( 0.0 );
+      for( NumberOfParametersType k = 0; k < nnzji; ++k )
+      {
+        nzji[ k ] = k;
+      }
+      continue;
+    }
+
+    /** Get the stored weights. */
+    const SampleWeightValueType * sampleWeights = &this->m_SampleWeights[ sample * numberOfWeights ];
+    for( unsigned int k = 0; k < numberOfWeights; ++k )
+    {
+      weightsArray1D[ k ] = sampleWeights[ k ];
+    }
+
+    /** Recursively compute the inner product of the Jacobian and the moving image gradient. */
+    double migArray[ SpaceDimension ];
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      migArray[ j ] = movingImageGradients[ i ][ j ];
+    }
+    ParametersValueType * imageJacobianPointer = imageJacobians[ i ].data_block();
+    RecursiveBSplineTransformImplementationSIMD< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
+      ::EvaluateJacobianWithImageGradientProduct( imageJacobianPointer, migArray, weightsArray1D, 1.0 );
+
+    /** Compute the nonzero Jacobian indices, directly from the support index. */
+    const IndexType & supportIndex              = this->m_SampleSupportIndices[ sample ];
+    OffsetValueType   totalOffsetToSupportIndex = 0;
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      totalOffsetToSupportIndex += supportIndex[ j ] * gridOffsetTable[ j ];
+    }
+    unsigned long   currentIndex = totalOffsetToSupportIndex;
+    unsigned long * nzjiPointer  = &nzji[ 0 ];
+    RecursiveBSplineTransformImplementation< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
+      ::ComputeNonZeroJacobianIndices( nzjiPointer, parametersPerDim, currentIndex, gridOffsetTable );
+  }
+
+} // end EvaluateJacobianWithImageGradientProductsOfSamples()
+
+
+/**
+ * ********************* EvaluateFloatJacobianWithImageGradientProducts ****************************
+ */
+
+template< class TScalar, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
+::EvaluateFloatJacobianWithImageGradientProducts(
+  const SizeValueType * sampleIndices,
+  const InputPointType * ipps,
+  const MovingImageGradientType * movingImageGradients,
+  FloatDerivativeType * imageJacobians,
+  NonZeroJacobianIndicesType * nonZeroJacobianIndices,
+  const SizeValueType numberOfPoints ) const
+{
+  const NumberOfParametersType nnzji = this->GetNumberOfNonZeroJacobianIndices();
+
+  /** Check if the coefficient image has been set. */
+  if( !this->m_CoefficientImages[ 0 ] )
+  {
+    itkWarningMacro( << "B-spline coefficients have not been set" );
+    for( SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+      imageJacobians[ i ].Fill( 0.0f );
+      nonZeroJacobianIndices[ i ].resize( nnzji );
+      for( NumberOfParametersType k = 0; k < nnzji; ++k )
+      {
+        nonZeroJacobianIndices[ i ][ k ] = k;
+      }
+    }
+    return;
+  }
+
+  /** Use the pre-computed weights if they are valid for these samples. */
+  const bool useSampleWeights = sampleIndices != 0
+    && this->SampleWeightsAreValid( sampleIndices, numberOfPoints );
+
+  /** Get the things that are the same for all points. */
+  const unsigned int      numberOfWeights  = RecursiveBSplineWeightFunctionType::NumberOfWeights;
+  const unsigned long     parametersPerDim = this->GetNumberOfParametersPerDimension();
+  const OffsetValueType * gridOffsetTable  = this->m_CoefficientImages[ 0 ]->GetOffsetTable();
+
+  /** Allocate the weights on the stack. The products are computed from
+   * single-precision 1D weights, which are either the stored ones, or the
+   * computed ones rounded to float.
+   */
+  typename WeightsType::ValueType weightsArray1D[ numberOfWeights ];
+  WeightsType weights1D( weightsArray1D, numberOfWeights, false );
+  float       floatWeightsArray1D[ numberOfWeights ];
+
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+  {
+    NonZeroJacobianIndicesType & nzji = nonZeroJacobianIndices[ i ];
+    nzji.resize( nnzji );
+
+    /** Get the 1D weights and the support index, stored or computed. */
+    bool          inside = false;
+    IndexType     supportIndex;
+    const float * floatWeights1D = floatWeightsArray1D;
+    if( useSampleWeights )
+    {
+      const SizeValueType sample = sampleIndices[ i ];
+      inside = this->m_SampleIsInside[ sample ];
+      if( inside )
+      {
+        floatWeights1D = &this->m_SampleWeights[ sample * numberOfWeights ];
+        supportIndex   = this->m_SampleSupportIndices[ sample ];
+      }
+    }
+    else
+    {
+      ContinuousIndexType cindex;
+      this->TransformPointToContinuousGridIndex( ipps[ i ], cindex );
+      inside = this->InsideValidRegion( cindex );
+      if( inside )
+      {
+        this->m_RecursiveBSplineWeightFunction->Evaluate( cindex, weights1D, supportIndex );
+        for( unsigned int k = 0; k < numberOfWeights; ++k )
+        {
+          floatWeightsArray1D[ k ] = static_cast< float >( weightsArray1D[ k ] );
+        }
+      }
+    }
+
+    /** NOTE: if the support region does not lie totally within the grid
+     * we assume zero displacement and zero Jacobian.
+     */
+    if( !inside )
+    {
+      imageJacobians[ i ].Fill( 0.0f );
+      for( NumberOfParametersType k = 0; k < nnzji; ++k )
+      {
+        nzji[ k ] = k;
+      }
+      continue;
+    }
+
+    /** Recursively compute the inner product of the Jacobian and the moving
+     * image gradient in single precision, directly into the image Jacobian.
+     */
+    float migArray[ SpaceDimension ];
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      migArray[ j ] = static_cast< float >( movingImageGradients[ i ][ j ] );
+    }
+    float * imageJacobianPointer = imageJacobians[ i ].data_block();
+    RecursiveBSplineTransformImplementation< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
+      ::EvaluateFloatJacobianWithImageGradientProduct( imageJacobianPointer, migArray, floatWeights1D, 1.0f );
+
+    /** Compute the nonzero Jacobian indices, directly from the support index. */
+    OffsetValueType totalOffsetToSupportIndex = 0;
+    for( unsigned int j = 0; j < SpaceDimension; ++j )
+    {
+      totalOffsetToSupportIndex += supportIndex[ j ] * gridOffsetTable[ j ];
+    }
+    unsigned long   currentIndex = totalOffsetToSupportIndex;
+    unsigned long * nzjiPointer  = &nzji[ 0 ];
+    RecursiveBSplineTransformImplementation< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
+      ::ComputeNonZeroJacobianIndices( nzjiPointer, parametersPerDim, currentIndex, gridOffsetTable );
+  }
+
+} // end EvaluateFloatJacobianWithImageGradientProducts()
+
+
+/**
+ * ********************* GetNumberOfSampleWeights ****************************
+ */
+
+template< class TScalar, unsigned int NDimensions, unsigned int VSplineOrder >
+unsigned int
+RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
+::GetNumberOfSampleWeights( void ) const
+{
+  return RecursiveBSplineWeightFunctionType::NumberOfWeights;
+
+} // end GetNumberOfSampleWeights()
+
+
+/**
+ * ********************* ComputeSampleWeights ****************************
+ */
+
+template< class TScalar, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
+::ComputeSampleWeights(
+  const ContinuousIndexType & cindex,
+  typename WeightsType::ValueType * weights,
+  IndexType & supportIndex ) const
+{
+  WeightsType weights1D( weights, RecursiveBSplineWeightFunctionType::NumberOfWeights, false );
+  this->m_RecursiveBSplineWeightFunction->Evaluate( cindex, weights1D, supportIndex );
+
+} // end ComputeSampleWeights()
+
+
 /**
  * ********************* GetSpatialJacobian ****************************
  */
@@ -260,6 +756,24 @@ RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
 ::GetSpatialJacobian(
   const InputPointType & ipp,
   SpatialJacobianType & sj ) const
+{
+  OutputPointType opp;
+  this->TransformPointAndSpatialJacobian( ipp, opp, sj );
+
+} // end GetSpatialJacobian()
+
+
+/**
+ * ********************* TransformPointAndSpatialJacobian ****************************
+ */
+
+template< class TScalar, unsigned int NDimensions, unsigned int VSplineOrder >
+void
+RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
+::TransformPointAndSpatialJacobian(
+  const InputPointType & ipp,
+  OutputPointType & opp,
+  SpatialJacobianType & sj ) const
 {
   /** Convert the physical point to a continuous index, which
    * is needed for the 'Evaluate()' functions below.
@@ -271,6 +785,7 @@ RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
   // we assume zero displacement and identity spatial Jacobian
   if( !this->InsideValidRegion( cindex ) )
   {
+    opp = ipp;
     sj.SetIdentity();
     return;
   }
@@ -313,11 +828,16 @@ RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
   RecursiveBSplineTransformImplementation< SpaceDimension, SpaceDimension, SplineOrder, TScalar >
     ::GetSpatialJacobian( spatialJacobian, mu, bsplineOffsetTable, weightsPointer, derivativeWeightsPointer );
 
-  /** Copy the correct elements to the spatial Jacobian.
-   * The first SpaceDimension elements are actually the displacement, i.e. the recursive
+  /** The first SpaceDimension elements are actually the displacement, i.e. the recursive
    * function GetSpatialJacobian() has the TransformPoint as a free by-product.
    */
   for( unsigned int i = 0; i < SpaceDimension; ++i )
+  {
+    opp[ i ] = ipp[ i ] + spatialJacobian[ i ];
+  }
+
+  /** Copy the correct elements to the spatial Jacobian. */
+  for( unsigned int i = 0; i < SpaceDimension; ++i )
   {
     for( unsigned int j = 0; j < SpaceDimension; ++j )
     {
@@ -334,7 +854,7 @@ RecursiveBSplineTransform< TScalar, NDimensions, VSplineOrder >
     sj( j, j ) += 1.0;
   }
 
-} // end GetSpatialJacobian()
+} // end TransformPointAndSpatialJacobian()
 
 
 /**
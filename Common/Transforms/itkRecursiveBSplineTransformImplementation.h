@@ -128,6 +128,23 @@ public:
   } // end EvaluateJacobianWithImageGradientProduct()
 
 
+  /** EvaluateJacobianWithImageGradientProduct recursive implementation,
+   * in single precision.
+   */
+  static inline void EvaluateFloatJacobianWithImageGradientProduct(
+    float * & imageJacobian, const float * movingImageGradient,
+    const float * weights1D, float value )
+  {
+    for( unsigned int k = 0; k <= SplineOrder; ++k )
+    {
+      /** Recurse. */
+      RecursiveBSplineTransformImplementation< OutputDimension, SpaceDimension - 1, SplineOrder, TScalar >
+        ::EvaluateFloatJacobianWithImageGradientProduct( imageJacobian, movingImageGradient, weights1D,
+        value * weights1D[ k + HelperConstVariable ] );
+    }
+  } // end EvaluateFloatJacobianWithImageGradientProduct()
+
+
   /** ComputeNonZeroJacobianIndices recursive implementation. */
   static inline void ComputeNonZeroJacobianIndices(
     unsigned long * & nzji,
@@ -430,6 +447,19 @@ public:
   } // end EvaluateJacobianWithImageGradientProduct()
 
 
+  /** EvaluateFloatJacobianWithImageGradientProduct recursive implementation. */
+  static inline void EvaluateFloatJacobianWithImageGradientProduct(
+    float * & imageJacobian, const float * movingImageGradient,
+    const float * weights1D, float value )
+  {
+    for( unsigned int j = 0; j < OutputDimension; ++j )
+    {
+      *( imageJacobian + j * BSplineNumberOfIndices ) = value * movingImageGradient[ j ];
+    }
+    ++imageJacobian;
+  } // end EvaluateFloatJacobianWithImageGradientProduct()
+
+
   /** ComputeNonZeroJacobianIndices recursive implementation. */
   static inline void ComputeNonZeroJacobianIndices(
     unsigned long * & nzji,
@@ -0,0 +1,422 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkRecursiveBSplineTransformImplementationSIMD_h
+#define __itkRecursiveBSplineTransformImplementationSIMD_h
+
+#include "itkRecursiveBSplineTransformImplementation.h"
+
+/** The SIMD kernels are only available on x86-64, where SSE2 is always present.
+ * AVX2 + FMA is detected at run time, so that the binary still runs on older CPUs.
+ */
+#if defined( ELASTIX_USE_SIMD ) && ( defined( __x86_64__ ) || defined( _M_X64 ) )
+#define ELASTIX_BSPLINE_SIMD_X86
+#include <immintrin.h>
+#if defined( _MSC_VER )
+#include <intrin.h>
+#define ELASTIX_BSPLINE_TARGET_AVX2
+#else
+#define ELASTIX_BSPLINE_TARGET_AVX2 __attribute__( ( target( "avx2,fma" ) ) )
+#endif
+#endif
+
+namespace itk
+{
+
+/** \class RecursiveBSplineSIMDInstructionSet
+ *
+ * \brief Detects once, at run time, which instruction set is used by
+ * the SIMD kernels of the recursive B-spline transform.
+ *
+ * \ingroup ITKTransform
+ */
+
+class RecursiveBSplineSIMDInstructionSet
+{
+public:
+
+  typedef enum { Scalar = 0, SSE2 = 1, AVX2 = 2 } InstructionSetType;
+
+  /** Get the instruction set, which is detected at the first call. */
+  static InstructionSetType Get( void )
+  {
+    static const InstructionSetType instructionSet = Detect();
+    return instructionSet;
+  }
+
+
+private:
+
+  static InstructionSetType Detect( void )
+  {
+#if defined( ELASTIX_BSPLINE_SIMD_X86 )
+#if defined( _MSC_VER )
+    int info[ 4 ];
+    __cpuid( info, 0 );
+    if( info[ 0 ] < 7 )
+    {
+      return SSE2;
+    }
+    __cpuid( info, 1 );
+    const bool fma     = ( info[ 2 ] & ( 1 << 12 ) ) != 0;
+    const bool osxsave = ( info[ 2 ] & ( 1 << 27 ) ) != 0;
+    const bool avx     = ( info[ 2 ] & ( 1 << 28 ) ) != 0;
+    __cpuidex( info, 7, 0 );
+    const bool avx2 = ( info[ 1 ] & ( 1 << 5 ) ) != 0;
+    if( fma && osxsave && avx && avx2 && ( _xgetbv( 0 ) & 0x6 ) == 0x6 )
+    {
+      return AVX2;
+    }
+    return SSE2;
+#else
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" ) )
+    {
+      return AVX2;
+    }
+    return SSE2;
+#endif
+#else
+    return Scalar;
+#endif
+  }
+
+
+};
+
+/** \class RecursiveBSplineTransformImplementationSIMD
+ *
+ * \brief Selects the implementation of TransformPoint(), GetJacobian() and
+ * EvaluateJacobianWithImageGradientProduct() of the recursive B-spline transform.
+ *
+ * The general case simply forwards to the scalar RecursiveBSplineTransformImplementation.
+ * For third order B-splines in double precision a specialization is provided, that
+ * evaluates the innermost dimension of the support region with SIMD instructions.
+ *
+ * \ingroup ITKTransform
+ */
+
+template< unsigned int OutputDimension, unsigned int SpaceDimension, unsigned int SplineOrder, class TScalar >
+class RecursiveBSplineTransformImplementationSIMD
+{
+public:
+
+  typedef RecursiveBSplineTransformImplementation<
+    OutputDimension, SpaceDimension, SplineOrder, TScalar >     ScalarImplementationType;
+  typedef typename ScalarImplementationType::ScalarType                   ScalarType;
+  typedef typename ScalarImplementationType::InternalFloatType            InternalFloatType;
+  typedef typename ScalarImplementationType::OutputPointType              OutputPointType;
+  typedef typename ScalarImplementationType::CoefficientPointerVectorType CoefficientPointerVectorType;
+
+  static inline void TransformPoint(
+    OutputPointType opp, const CoefficientPointerVectorType mu,
+    const OffsetValueType * gridOffsetTable,
+    const double * weights1D )
+  {
+    ScalarImplementationType::TransformPoint( opp, mu, gridOffsetTable, weights1D );
+  }
+
+
+  static inline void GetJacobian(
+    ScalarType * & jacobians, const double * weights1D, double value )
+  {
+    ScalarImplementationType::GetJacobian( jacobians, weights1D, value );
+  }
+
+
+  static inline void EvaluateJacobianWithImageGradientProduct(
+    ScalarType * & imageJacobian, const InternalFloatType * movingImageGradient,
+    const double * weights1D, double value )
+  {
+    ScalarImplementationType::EvaluateJacobianWithImageGradientProduct(
+      imageJacobian, movingImageGradient, weights1D, value );
+  }
+
+
+};
+
+/** \class RecursiveBSplineTransformImplementationSIMD
+ *
+ * \brief Specialization for third order B-splines in double precision.
+ *
+ * The support region of 4^SpaceDimension coefficients is split in rows along
+ * the first dimension. The 4 coefficients of a row are contiguous in memory, so
+ * they fit in a single AVX register, or in two SSE2 registers. The products of
+ * the weights of the other dimensions are computed once per row, in the same
+ * order as the scalar recursion, so the Jacobians are bitwise identical to the
+ * scalar results. TransformPoint() sums in a different order, and therefore
+ * differs in the order of the machine precision.
+ */
+
+template< unsigned int Dimension >
+class RecursiveBSplineTransformImplementationSIMD< Dimension, Dimension, 3, double >
+{
+public:
+
+  typedef RecursiveBSplineTransformImplementation<
+    Dimension, Dimension, 3, double >                                     ScalarImplementationType;
+  typedef typename ScalarImplementationType::ScalarType                   ScalarType;
+  typedef typename ScalarImplementationType::InternalFloatType            InternalFloatType;
+  typedef typename ScalarImplementationType::OutputPointType              OutputPointType;
+  typedef typename ScalarImplementationType::CoefficientPointerVectorType CoefficientPointerVectorType;
+
+  /** The number of coefficients in the support region, and the number of rows. */
+  itkStaticConstMacro( BSplineNumberOfIndices, unsigned int,
+    ScalarImplementationType::BSplineNumberOfIndices );
+  itkStaticConstMacro( NumberOfRows, unsigned int, BSplineNumberOfIndices / 4 );
+
+  static inline void TransformPoint(
+    OutputPointType opp, const CoefficientPointerVectorType mu,
+    const OffsetValueType * gridOffsetTable,
+    const double * weights1D )
+  {
+#if defined( ELASTIX_BSPLINE_SIMD_X86 )
+    if( gridOffsetTable[ 0 ] == 1 )
+    {
+      double          rowWeights[ NumberOfRows ];
+      OffsetValueType rowOffsets[ NumberOfRows ];
+      ComputeRows( weights1D, gridOffsetTable, rowWeights, rowOffsets );
+
+      if( RecursiveBSplineSIMDInstructionSet::Get() == RecursiveBSplineSIMDInstructionSet::AVX2 )
+      {
+        TransformPointAVX2( opp, mu, rowWeights, rowOffsets, weights1D );
+      }
+      else
+      {
+        TransformPointSSE2( opp, mu, rowWeights, rowOffsets, weights1D );
+      }
+      return;
+    }
+#endif
+    ScalarImplementationType::TransformPoint( opp, mu, gridOffsetTable, weights1D );
+  } // end TransformPoint()
+
+
+  static inline void GetJacobian(
+    ScalarType * & jacobians, const double * weights1D, double value )
+  {
+#if defined( ELASTIX_BSPLINE_SIMD_X86 )
+    double rowWeights[ NumberOfRows ];
+    ComputeRows( weights1D, 0, rowWeights, 0, value );
+
+    if( RecursiveBSplineSIMDInstructionSet::Get() == RecursiveBSplineSIMDInstructionSet::AVX2 )
+    {
+      GetJacobianAVX2( jacobians, rowWeights, weights1D );
+    }
+    else
+    {
+      GetJacobianSSE2( jacobians, rowWeights, weights1D );
+    }
+    jacobians += BSplineNumberOfIndices;
+#else
+    ScalarImplementationType::GetJacobian( jacobians, weights1D, value );
+#endif
+  } // end GetJacobian()
+
+
+  static inline void EvaluateJacobianWithImageGradientProduct(
+    ScalarType * & imageJacobian, const InternalFloatType * movingImageGradient,
+    const double * weights1D, double value )
+  {
+#if defined( ELASTIX_BSPLINE_SIMD_X86 )
+    double rowWeights[ NumberOfRows ];
+    ComputeRows( weights1D, 0, rowWeights, 0, value );
+
+    if( RecursiveBSplineSIMDInstructionSet::Get() == RecursiveBSplineSIMDInstructionSet::AVX2 )
+    {
+      EvaluateJacobianWithImageGradientProductAVX2( imageJacobian, movingImageGradient, rowWeights, weights1D );
+    }
+    else
+    {
+      EvaluateJacobianWithImageGradientProductSSE2( imageJacobian, movingImageGradient, rowWeights, weights1D );
+    }
+    imageJacobian += BSplineNumberOfIndices;
+#else
+    ScalarImplementationType::EvaluateJacobianWithImageGradientProduct(
+      imageJacobian, movingImageGradient, weights1D, value );
+#endif
+  } // end EvaluateJacobianWithImageGradientProduct()
+
+
+private:
+
+  /** Compute the product of the weights of dimensions 1 .. Dimension - 1 for each
+   * row, and optionally the offset of each row. The rows are ordered like in the
+   * scalar recursion: the last dimension runs slowest.
+   */
+  static inline void ComputeRows(
+    const double * weights1D, const OffsetValueType * gridOffsetTable,
+    double * rowWeights, OffsetValueType * rowOffsets, const double value = 1.0 )
+  {
+    rowWeights[ 0 ] = value;
+    if( rowOffsets ) { rowOffsets[ 0 ] = 0; }
+    unsigned int numberOfRows = 1;
+    for( unsigned int d = Dimension - 1; d > 0; --d )
+    {
+      /** Expand from back to front, so that the old rows are not overwritten. */
+      for( unsigned int r = numberOfRows; r-- > 0; )
+      {
+        const double oldWeight = rowWeights[ r ];
+        for( unsigned int k = 4; k-- > 0; )
+        {
+          rowWeights[ r * 4 + k ] = oldWeight * weights1D[ d * 4 + k ];
+        }
+        if( rowOffsets )
+        {
+          const OffsetValueType oldOffset = rowOffsets[ r ];
+          for( unsigned int k = 4; k-- > 0; )
+          {
+            rowOffsets[ r * 4 + k ] = oldOffset + k * gridOffsetTable[ d ];
+          }
+        }
+      }
+      numberOfRows *= 4;
+    }
+  } // end ComputeRows()
+
+
+#if defined( ELASTIX_BSPLINE_SIMD_X86 )
+
+  /** SSE2 kernels, each row is processed in two halves. */
+  static inline void TransformPointSSE2(
+    OutputPointType opp, const CoefficientPointerVectorType mu,
+    const double * rowWeights, const OffsetValueType * rowOffsets,
+    const double * weights1D )
+  {
+    for( unsigned int j = 0; j < Dimension; ++j )
+    {
+      const double * muj = mu[ j ];
+      __m128d        lo  = _mm_setzero_pd();
+      __m128d        hi  = _mm_setzero_pd();
+      for( unsigned int r = 0; r < NumberOfRows; ++r )
+      {
+        const __m128d w = _mm_set1_pd( rowWeights[ r ] );
+        lo = _mm_add_pd( lo, _mm_mul_pd( w, _mm_loadu_pd( muj + rowOffsets[ r ] ) ) );
+        hi = _mm_add_pd( hi, _mm_mul_pd( w, _mm_loadu_pd( muj + rowOffsets[ r ] + 2 ) ) );
+      }
+      lo = _mm_mul_pd( lo, _mm_loadu_pd( weights1D ) );
+      hi = _mm_mul_pd( hi, _mm_loadu_pd( weights1D + 2 ) );
+      const __m128d sum = _mm_add_pd( lo, hi );
+      opp[ j ] = _mm_cvtsd_f64( _mm_add_sd( sum, _mm_unpackhi_pd( sum, sum ) ) );
+    }
+  } // end TransformPointSSE2()
+
+
+  static inline void GetJacobianSSE2(
+    ScalarType * jacobians, const double * rowWeights, const double * weights1D )
+  {
+    const __m128d wlo = _mm_loadu_pd( weights1D );
+    const __m128d whi = _mm_loadu_pd( weights1D + 2 );
+    for( unsigned int r = 0; r < NumberOfRows; ++r )
+    {
+      const __m128d w  = _mm_set1_pd( rowWeights[ r ] );
+      const __m128d lo = _mm_mul_pd( w, wlo );
+      const __m128d hi = _mm_mul_pd( w, whi );
+      for( unsigned int j = 0; j < Dimension; ++j )
+      {
+        double * out = jacobians + j * BSplineNumberOfIndices * ( Dimension + 1 ) + r * 4;
+        _mm_storeu_pd( out, lo );
+        _mm_storeu_pd( out + 2, hi );
+      }
+    }
+  } // end GetJacobianSSE2()
+
+
+  static inline void EvaluateJacobianWithImageGradientProductSSE2(
+    ScalarType * imageJacobian, const InternalFloatType * movingImageGradient,
+    const double * rowWeights, const double * weights1D )
+  {
+    const __m128d wlo = _mm_loadu_pd( weights1D );
+    const __m128d whi = _mm_loadu_pd( weights1D + 2 );
+    for( unsigned int r = 0; r < NumberOfRows; ++r )
+    {
+      const __m128d w  = _mm_set1_pd( rowWeights[ r ] );
+      const __m128d lo = _mm_mul_pd( w, wlo );
+      const __m128d hi = _mm_mul_pd( w, whi );
+      for( unsigned int j = 0; j < Dimension; ++j )
+      {
+        const __m128d mig = _mm_set1_pd( movingImageGradient[ j ] );
+        double *      out = imageJacobian + j * BSplineNumberOfIndices + r * 4;
+        _mm_storeu_pd( out, _mm_mul_pd( lo, mig ) );
+        _mm_storeu_pd( out + 2, _mm_mul_pd( hi, mig ) );
+      }
+    }
+  } // end EvaluateJacobianWithImageGradientProductSSE2()
+
+
+  /** AVX2 + FMA kernels, each row fits in a single register. */
+  ELASTIX_BSPLINE_TARGET_AVX2 static void TransformPointAVX2(
+    OutputPointType opp, const CoefficientPointerVectorType mu,
+    const double * rowWeights, const OffsetValueType * rowOffsets,
+    const double * weights1D )
+  {
+    const __m256d wx = _mm256_loadu_pd( weights1D );
+    for( unsigned int j = 0; j < Dimension; ++j )
+    {
+      const double * muj = mu[ j ];
+      __m256d        acc = _mm256_setzero_pd();
+      for( unsigned int r = 0; r < NumberOfRows; ++r )
+      {
+        acc = _mm256_fmadd_pd( _mm256_set1_pd( rowWeights[ r ] ),
+          _mm256_loadu_pd( muj + rowOffsets[ r ] ), acc );
+      }
+      acc = _mm256_mul_pd( acc, wx );
+      const __m128d sum = _mm_add_pd( _mm256_castpd256_pd128( acc ), _mm256_extractf128_pd( acc, 1 ) );
+      opp[ j ] = _mm_cvtsd_f64( _mm_add_sd( sum, _mm_unpackhi_pd( sum, sum ) ) );
+    }
+  } // end TransformPointAVX2()
+
+
+  ELASTIX_BSPLINE_TARGET_AVX2 static void GetJacobianAVX2(
+    ScalarType * jacobians, const double * rowWeights, const double * weights1D )
+  {
+    const __m256d wx = _mm256_loadu_pd( weights1D );
+    for( unsigned int r = 0; r < NumberOfRows; ++r )
+    {
+      const __m256d row = _mm256_mul_pd( _mm256_set1_pd( rowWeights[ r ] ), wx );
+      for( unsigned int j = 0; j < Dimension; ++j )
+      {
+        _mm256_storeu_pd( jacobians + j * BSplineNumberOfIndices * ( Dimension + 1 ) + r * 4, row );
+      }
+    }
+  } // end GetJacobianAVX2()
+
+
+  ELASTIX_BSPLINE_TARGET_AVX2 static void EvaluateJacobianWithImageGradientProductAVX2(
+    ScalarType * imageJacobian, const InternalFloatType * movingImageGradient,
+    const double * rowWeights, const double * weights1D )
+  {
+    const __m256d wx = _mm256_loadu_pd( weights1D );
+    for( unsigned int r = 0; r < NumberOfRows; ++r )
+    {
+      const __m256d row = _mm256_mul_pd( _mm256_set1_pd( rowWeights[ r ] ), wx );
+      for( unsigned int j = 0; j < Dimension; ++j )
+      {
+        _mm256_storeu_pd( imageJacobian + j * BSplineNumberOfIndices + r * 4,
+          _mm256_mul_pd( row, _mm256_set1_pd( movingImageGradient[ j ] ) ) );
+      }
+    }
+  } // end EvaluateJacobianWithImageGradientProductAVX2()
+
+
+#endif // ELASTIX_BSPLINE_SIMD_X86
+
+};
+
+} // end namespace itk
+
+#endif /* __itkRecursiveBSplineTransformImplementationSIMD_h */
@@ -0,0 +1,266 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkTransformToMultipleOutputsSource_h
+#define __itkTransformToMultipleOutputsSource_h
+
+#include "itkAdvancedTransform.h"
+#include "itkImageSource.h"
+#include "itkInterpolateImageFunction.h"
+#include "itkMatrix.h"
+#include "itkVector.h"
+
+namespace itk
+{
+
+/** \class TransformToMultipleOutputsSource
+ * \brief Generate the displacement field, the spatial Jacobian, its
+ * determinant and the resampled image of a transform in a single pass.
+ *
+ * The filters TransformToDisplacementFieldFilter,
+ * TransformToDeterminantOfSpatialJacobianSource,
+ * TransformToSpatialJacobianSource and ResampleImageFilter each visit all
+ * voxels of the output grid, and each evaluate the transform in every voxel.
+ * This filter visits the output grid only once, and obtains the transformed
+ * point and the spatial Jacobian from a single call to
+ * AdvancedTransform::TransformPointAndSpatialJacobian(). For B-spline
+ * transforms this means that the B-spline weights and the coefficients
+ * of the support region are computed and read only once per voxel.
+ *
+ * The filter has four outputs:
+ * \li output 0: the displacement field, see GetDisplacementFieldOutput();
+ * \li output 1: the determinant of the spatial Jacobian, see
+ *   GetDeterminantOfSpatialJacobianOutput();
+ * \li output 2: the spatial Jacobian, see GetSpatialJacobianOutput();
+ * \li output 3: the resampled input image, see GetResampledImageOutput().
+ *
+ * Each output is only allocated and computed when it is enabled, see
+ * SetComputeDisplacementField() etc. The resampled image requires an
+ * input image and an interpolator.
+ *
+ * Output information (spacing, size and direction) for the output
+ * images should be set, like for TransformToDeterminantOfSpatialJacobianSource.
+ *
+ * This filter is implemented as a multithreaded filter. It provides a
+ * ThreadedGenerateData() method for its implementation.
+ *
+ * \ingroup GeometricTransforms
+ */
+template< class TInputImage,
+class TTransformPrecisionType = double >
+class TransformToMultipleOutputsSource :
+  public ImageSource< Image< Vector< float, TInputImage::ImageDimension >,
+    TInputImage::ImageDimension > >
+{
+public:
+
+  /** Number of dimensions. */
+  itkStaticConstMacro( ImageDimension, unsigned int,
+    TInputImage::ImageDimension );
+
+  /** Typedefs for the output images. */
+  typedef Image< Vector< float, ImageDimension >,
+    ImageDimension >                                  DisplacementFieldImageType;
+  typedef Image< float, ImageDimension >              DeterminantImageType;
+  typedef Image< Matrix< float, ImageDimension, ImageDimension >,
+    ImageDimension >                                  SpatialJacobianImageType;
+  typedef TInputImage                                 ResampledImageType;
+
+  /** Standard class typedefs. */
+  typedef TransformToMultipleOutputsSource          Self;
+  typedef ImageSource< DisplacementFieldImageType > Superclass;
+  typedef SmartPointer< Self >                      Pointer;
+  typedef SmartPointer< const Self >                ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( TransformToMultipleOutputsSource, ImageSource );
+
+  /** Typedefs for the input image and the interpolator. */
+  typedef TInputImage                                  InputImageType;
+  typedef typename InputImageType::ConstPointer        InputImageConstPointer;
+  typedef InterpolateImageFunction< InputImageType,
+    TTransformPrecisionType >                          InterpolatorType;
+  typedef typename InterpolatorType::Pointer           InterpolatorPointerType;
+  typedef typename ResampledImageType::PixelType       ResampledPixelType;
+
+  /** Typedefs for transform. */
+  typedef AdvancedTransform< TTransformPrecisionType,
+    itkGetStaticConstMacro( ImageDimension ),
+    itkGetStaticConstMacro( ImageDimension ) >     TransformType;
+  typedef typename TransformType::ConstPointer        TransformPointerType;
+  typedef typename TransformType::InputPointType      InputPointType;
+  typedef typename TransformType::OutputPointType     OutputPointType;
+  typedef typename TransformType::SpatialJacobianType SpatialJacobianType;
+
+  /** Typedefs for the output grid. */
+  typedef typename Superclass::OutputImageRegionType    OutputImageRegionType;
+  typedef typename DisplacementFieldImageType::RegionType    RegionType;
+  typedef typename RegionType::SizeType                      SizeType;
+  typedef typename DisplacementFieldImageType::IndexType     IndexType;
+  typedef typename DisplacementFieldImageType::PointType     PointType;
+  typedef typename DisplacementFieldImageType::SpacingType   SpacingType;
+  typedef typename DisplacementFieldImageType::PointType     OriginType;
+  typedef typename DisplacementFieldImageType::DirectionType DirectionType;
+
+  /** Typedefs for base image. */
+  typedef ImageBase< itkGetStaticConstMacro( ImageDimension ) > ImageBaseType;
+
+  /** Set the coordinate transformation. This is the output-to-input
+   * transform, as for the ResampleImageFilter.
+   */
+  itkSetConstObjectMacro( Transform, TransformType );
+
+  /** Get a pointer to the coordinate transform. */
+  itkGetConstObjectMacro( Transform, TransformType );
+
+  /** Set/Get the image that is resampled to output 3. */
+  itkSetConstObjectMacro( InputImage, InputImageType );
+  itkGetConstObjectMacro( InputImage, InputImageType );
+
+  /** Set/Get the interpolator that is used to resample the input image. */
+  itkSetObjectMacro( Interpolator, InterpolatorType );
+  itkGetModifiableObjectMacro( Interpolator, InterpolatorType );
+
+  /** Set/Get the pixel value of the resampled image outside the input image. */
+  itkSetMacro( DefaultPixelValue, ResampledPixelType );
+  itkGetConstReferenceMacro( DefaultPixelValue, ResampledPixelType );
+
+  /** Select the outputs that are computed. Default: only the displacement field. */
+  itkSetMacro( ComputeDisplacementField, bool );
+  itkGetConstMacro( ComputeDisplacementField, bool );
+  itkBooleanMacro( ComputeDisplacementField );
+  itkSetMacro( ComputeDeterminantOfSpatialJacobian, bool );
+  itkGetConstMacro( ComputeDeterminantOfSpatialJacobian, bool );
+  itkBooleanMacro( ComputeDeterminantOfSpatialJacobian );
+  itkSetMacro( ComputeSpatialJacobian, bool );
+  itkGetConstMacro( ComputeSpatialJacobian, bool );
+  itkBooleanMacro( ComputeSpatialJacobian );
+  itkSetMacro( ComputeResampledImage, bool );
+  itkGetConstMacro( ComputeResampledImage, bool );
+  itkBooleanMacro( ComputeResampledImage );
+
+  /** Get the outputs. */
+  DisplacementFieldImageType * GetDisplacementFieldOutput( void );
+  DeterminantImageType * GetDeterminantOfSpatialJacobianOutput( void );
+  SpatialJacobianImageType * GetSpatialJacobianOutput( void );
+  ResampledImageType * GetResampledImageOutput( void );
+
+  /** Set the size of the output image. */
+  virtual void SetOutputSize( const SizeType & size );
+
+  /** Get the size of the output image. */
+  virtual const SizeType & GetOutputSize();
+
+  /** Set the start index of the output largest possible region.
+   * The default is an index of all zeros.
+   */
+  virtual void SetOutputIndex( const IndexType & index );
+
+  /** Get the start index of the output largest possible region. */
+  virtual const IndexType & GetOutputIndex();
+
+  /** Set the region of the output image. */
+  itkSetMacro( OutputRegion, OutputImageRegionType );
+
+  /** Get the region of the output image. */
+  itkGetConstReferenceMacro( OutputRegion, OutputImageRegionType );
+
+  /** Set the output image spacing. */
+  itkSetMacro( OutputSpacing, SpacingType );
+  virtual void SetOutputSpacing( const double * values );
+
+  /** Get the output image spacing. */
+  itkGetConstReferenceMacro( OutputSpacing, SpacingType );
+
+  /** Set the output image origin. */
+  itkSetMacro( OutputOrigin, OriginType );
+  virtual void SetOutputOrigin( const double * values );
+
+  /** Get the output image origin. */
+  itkGetConstReferenceMacro( OutputOrigin, OriginType );
+
+  /** Set the output direction cosine matrix. */
+  itkSetMacro( OutputDirection, DirectionType );
+  itkGetConstReferenceMacro( OutputDirection, DirectionType );
+
+  /** Helper method to set the output parameters based on this image */
+  void SetOutputParametersFromImage( const ImageBaseType * image );
+
+  /** Set the output information of all four outputs. */
+  void GenerateOutputInformation( void ) override;
+
+  /** Check the components and set up the interpolator. */
+  void BeforeThreadedGenerateData( void ) override;
+
+  /** Compute the Modified Time based on changes to the components. */
+  ModifiedTimeType GetMTime( void ) const override;
+
+protected:
+
+  TransformToMultipleOutputsSource();
+  ~TransformToMultipleOutputsSource() override {}
+
+  void PrintSelf( std::ostream & os, Indent indent ) const override;
+
+  /** Create the outputs, each of its own image type. */
+  typedef ProcessObject::DataObjectPointerArraySizeType DataObjectPointerArraySizeType;
+  using Superclass::MakeOutput;
+  ProcessObject::DataObjectPointer MakeOutput( DataObjectPointerArraySizeType idx ) override;
+
+  /** Only allocate the outputs that are enabled. */
+  void AllocateOutputs( void ) override;
+
+  /** Compute all enabled outputs for a part of the output grid. */
+  void ThreadedGenerateData(
+    const OutputImageRegionType & outputRegionForThread,
+    ThreadIdType threadId ) override;
+
+private:
+
+  TransformToMultipleOutputsSource( const Self & ); // purposely not implemented
+  void operator=( const Self & );                   // purposely not implemented
+
+  /** Returns whether the output with index idx is enabled. */
+  bool IsOutputEnabled( const DataObjectPointerArraySizeType idx ) const;
+
+  /** Member variables. */
+  RegionType              m_OutputRegion;         // region of the output image
+  TransformPointerType    m_Transform;            // Coordinate transform to use
+  SpacingType             m_OutputSpacing;        // output image spacing
+  OriginType              m_OutputOrigin;         // output image origin
+  DirectionType           m_OutputDirection;      // output image direction cosines
+  InputImageConstPointer  m_InputImage;
+  InterpolatorPointerType m_Interpolator;
+  ResampledPixelType      m_DefaultPixelValue;
+
+  bool m_ComputeDisplacementField;
+  bool m_ComputeDeterminantOfSpatialJacobian;
+  bool m_ComputeSpatialJacobian;
+  bool m_ComputeResampledImage;
+
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkTransformToMultipleOutputsSource.hxx"
+#endif
+
+#endif // end #ifndef __itkTransformToMultipleOutputsSource_h
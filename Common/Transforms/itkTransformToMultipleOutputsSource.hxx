@@ -0,0 +1,530 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkTransformToMultipleOutputsSource_hxx
+#define __itkTransformToMultipleOutputsSource_hxx
+
+#include "itkTransformToMultipleOutputsSource.h"
+
+#include "itkAdvancedIdentityTransform.h"
+#include "itkProgressReporter.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIteratorWithOnlyIndex.h"
+#include "vnl/vnl_det.h"
+
+namespace itk
+{
+
+/**
+ * Constructor
+ */
+template< class TInputImage, class TTransformPrecisionType >
+TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::TransformToMultipleOutputsSource()
+{
+  this->m_OutputSpacing.Fill( 1.0 );
+  this->m_OutputOrigin.Fill( 0.0 );
+  this->m_OutputDirection.SetIdentity();
+
+  SizeType size;
+  size.Fill( 0 );
+  this->m_OutputRegion.SetSize( size );
+
+  IndexType index;
+  index.Fill( 0 );
+  this->m_OutputRegion.SetIndex( index );
+
+  this->m_Transform = AdvancedIdentityTransform< TTransformPrecisionType, ImageDimension >::New();
+  this->m_DefaultPixelValue = NumericTraits< ResampledPixelType >::ZeroValue();
+
+  this->m_ComputeDisplacementField            = true;
+  this->m_ComputeDeterminantOfSpatialJacobian = false;
+  this->m_ComputeSpatialJacobian              = false;
+  this->m_ComputeResampledImage               = false;
+
+  /** Create the four outputs. Output 0 is created by the superclass. */
+  this->SetNumberOfRequiredOutputs( 4 );
+  for( DataObjectPointerArraySizeType i = 1; i < 4; ++i )
+  {
+    this->SetNthOutput( i, this->MakeOutput( i ) );
+  }
+
+  // Use the classic (ITK4) threading model, to ensure ThreadedGenerateData is being called.
+  this->itk::ImageSource< DisplacementFieldImageType >::DynamicMultiThreadingOff();
+
+} // end Constructor
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template< class TInputImage, class TTransformPrecisionType >
+void
+TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "OutputRegion: " << this->m_OutputRegion << std::endl;
+  os << indent << "OutputSpacing: " << this->m_OutputSpacing << std::endl;
+  os << indent << "OutputOrigin: " << this->m_OutputOrigin << std::endl;
+  os << indent << "OutputDirection: " << this->m_OutputDirection << std::endl;
+  os << indent << "Transform: " << this->m_Transform.GetPointer() << std::endl;
+  os << indent << "InputImage: " << this->m_InputImage.GetPointer() << std::endl;
+  os << indent << "Interpolator: " << this->m_Interpolator.GetPointer() << std::endl;
+  os << indent << "ComputeDisplacementField: "
+     << this->m_ComputeDisplacementField << std::endl;
+  os << indent << "ComputeDeterminantOfSpatialJacobian: "
+     << this->m_ComputeDeterminantOfSpatialJacobian << std::endl;
+  os << indent << "ComputeSpatialJacobian: "
+     << this->m_ComputeSpatialJacobian << std::endl;
+  os << indent << "ComputeResampledImage: "
+     << this->m_ComputeResampledImage << std::endl;
+
+} // end PrintSelf()
+
+
+/**
+ * ******************* MakeOutput *******************
+ */
+
+template< class TInputImage, class TTransformPrecisionType >
+ProcessObject::DataObjectPointer
+TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::MakeOutput( DataObjectPointerArraySizeType idx )
+{
+  switch( idx )
+  {
+    case 1:
+      return DeterminantImageType::New().GetPointer();
+    case 2:
+      return SpatialJacobianImageType::New().GetPointer();
+    case 3:
+      return ResampledImageType::New().GetPointer();
+    default:
+      return DisplacementFieldImageType::New().GetPointer();
+  }
+
+} // end MakeOutput()
+
+
+/**
+ * ******************* Get*Output *******************
+ */
+
+template< class TInputImage, class TTransformPrecisionType >
+typename TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >::DisplacementFieldImageType
+* TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::GetDisplacementFieldOutput( void )
+{
+  return dynamic_cast< DisplacementFieldImageType * >( this->ProcessObject::GetOutput( 0 ) );
+}
+
+
+template< class TInputImage, class TTransformPrecisionType >
+typename TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >::DeterminantImageType
+* TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::GetDeterminantOfSpatialJacobianOutput( void )
+{
+  return dynamic_cast< DeterminantImageType * >( this->ProcessObject::GetOutput( 1 ) );
+}
+
+
+template< class TInputImage, class TTransformPrecisionType >
+typename TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >::SpatialJacobianImageType
+* TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::GetSpatialJacobianOutput( void )
+{
+  return dynamic_cast< SpatialJacobianImageType * >( this->ProcessObject::GetOutput( 2 ) );
+}
+
+
+template< class TInputImage, class TTransformPrecisionType >
+typename TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >::ResampledImageType
+* TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::GetResampledImageOutput( void )
+{
+  return dynamic_cast< ResampledImageType * >( this->ProcessObject::GetOutput( 3 ) );
+}
+
+
+/**
+ * ******************* IsOutputEnabled *******************
+ */
+
+template< class TInputImage, class TTransformPrecisionType >
+bool
+TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::IsOutputEnabled( const DataObjectPointerArraySizeType idx ) const
+{
+  switch( idx )
+  {
+    case 0:
+      return this->m_ComputeDisplacementField;
+    case 1:
+      return this->m_ComputeDeterminantOfSpatialJacobian;
+    case 2:
+      return this->m_ComputeSpatialJacobian;
+    case 3:
+      return this->m_ComputeResampledImage;
+    default:
+      return false;
+  }
+
+} // end IsOutputEnabled()
+
+
+/**
+ * Set the output image size.
+ */
+template< class TInputImage, class TTransformPrecisionType >
+void
+TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::SetOutputSize( const SizeType & size )
+{
+  this->m_OutputRegion.SetSize( size );
+}
+
+
+/**
+ * Get the output image size.
+ */
+template< class TInputImage, class TTransformPrecisionType >
+const typename TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::SizeType
+& TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::GetOutputSize()
+{
+  return this->m_OutputRegion.GetSize();
+}
+
+
+/**
+ * Set the output image index.
+ */
+template< class TInputImage, class TTransformPrecisionType >
+void
+TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::SetOutputIndex( const IndexType & index )
+{
+  this->m_OutputRegion.SetIndex( index );
+}
+
+
+/**
+ * Get the output image index.
+ */
+template< class TInputImage, class TTransformPrecisionType >
+const typename TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::IndexType
+& TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::GetOutputIndex()
+{
+  return this->m_OutputRegion.GetIndex();
+}
+
+
+/**
+ * Set the output image spacing.
+ */
+template< class TInputImage, class TTransformPrecisionType >
+void
+TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::SetOutputSpacing( const double * spacing )
+{
+  SpacingType s( spacing );
+  this->SetOutputSpacing( s );
+
+} // end SetOutputSpacing()
+
+
+/**
+ * Set the output image origin.
+ */
+template< class TInputImage, class TTransformPrecisionType >
+void
+TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::SetOutputOrigin( const double * origin )
+{
+  OriginType p( origin );
+  this->SetOutputOrigin( p );
+
+} // end SetOutputOrigin()
+
+
+/** Helper method to set the output parameters based on this image */
+template< class TInputImage, class TTransformPrecisionType >
+void
+TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::SetOutputParametersFromImage( const ImageBaseType * image )
+{
+  if( !image )
+  {
+    itkExceptionMacro( << "Cannot use a null image reference" );
+  }
+
+  this->SetOutputOrigin( image->GetOrigin() );
+  this->SetOutputSpacing( image->GetSpacing() );
+  this->SetOutputDirection( image->GetDirection() );
+  this->SetOutputRegion( image->GetLargestPossibleRegion() );
+
+} // end SetOutputParametersFromImage()
+
+
+/**
+ * ******************* AllocateOutputs *******************
+ */
+
+template< class TInputImage, class TTransformPrecisionType >
+void
+TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::AllocateOutputs( void )
+{
+  /** The disabled outputs keep their (empty) buffer, so that they
+   * do not cost any memory.
+   */
+  for( DataObjectPointerArraySizeType i = 0; i < this->GetNumberOfIndexedOutputs(); ++i )
+  {
+    ImageBaseType * outputPtr = dynamic_cast< ImageBaseType * >( this->ProcessObject::GetOutput( i ) );
+    if( outputPtr && this->IsOutputEnabled( i ) )
+    {
+      outputPtr->SetBufferedRegion( outputPtr->GetRequestedRegion() );
+      outputPtr->Allocate();
+    }
+  }
+
+} // end AllocateOutputs()
+
+
+/**
+ * ******************* BeforeThreadedGenerateData *******************
+ */
+
+template< class TInputImage, class TTransformPrecisionType >
+void
+TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::BeforeThreadedGenerateData( void )
+{
+  if( !this->m_Transform )
+  {
+    itkExceptionMacro( << "Transform not set" );
+  }
+
+  /** InterpolatorType::SetInputImage is not thread-safe and hence
+   * has to be set up before ThreadedGenerateData.
+   */
+  if( this->m_ComputeResampledImage )
+  {
+    if( !this->m_InputImage || !this->m_Interpolator )
+    {
+      itkExceptionMacro( << "The resampled image requires an input image and an interpolator" );
+    }
+    this->m_Interpolator->SetInputImage( this->m_InputImage );
+  }
+
+} // end BeforeThreadedGenerateData()
+
+
+/**
+ * ******************* ThreadedGenerateData *******************
+ */
+
+template< class TInputImage, class TTransformPrecisionType >
+void
+TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::ThreadedGenerateData(
+  const OutputImageRegionType & outputRegionForThread,
+  ThreadIdType threadId )
+{
+  /** Typedefs for the output iterators. */
+  typedef ImageRegionIterator< DisplacementFieldImageType > DisplacementIteratorType;
+  typedef ImageRegionIterator< DeterminantImageType >       DeterminantIteratorType;
+  typedef ImageRegionIterator< SpatialJacobianImageType >   SpatialJacobianIteratorType;
+  typedef ImageRegionIterator< ResampledImageType >         ResampledIteratorType;
+  typedef typename DisplacementFieldImageType::PixelType    DisplacementType;
+  typedef typename SpatialJacobianImageType::PixelType      OutputSpatialJacobianType;
+  typedef typename InterpolatorType::OutputType             InterpolatorOutputType;
+
+  const bool computeDisplacement = this->m_ComputeDisplacementField;
+  const bool computeDeterminant  = this->m_ComputeDeterminantOfSpatialJacobian;
+  const bool computeJacobian     = this->m_ComputeSpatialJacobian;
+  const bool computeResampled    = this->m_ComputeResampledImage;
+
+  /** Walk the output grid by index, since output 0 may not be allocated.
+   * The iterators of the enabled outputs walk along in the same order.
+   */
+  DisplacementFieldImageType * gridPtr = this->GetDisplacementFieldOutput();
+  ImageRegionConstIteratorWithOnlyIndex< DisplacementFieldImageType > gridIt( gridPtr, outputRegionForThread );
+
+  DisplacementIteratorType    dispIt;
+  DeterminantIteratorType     detIt;
+  SpatialJacobianIteratorType jacIt;
+  ResampledIteratorType       resIt;
+  if( computeDisplacement )
+  {
+    dispIt = DisplacementIteratorType( this->GetDisplacementFieldOutput(), outputRegionForThread );
+  }
+  if( computeDeterminant )
+  {
+    detIt = DeterminantIteratorType( this->GetDeterminantOfSpatialJacobianOutput(), outputRegionForThread );
+  }
+  if( computeJacobian )
+  {
+    jacIt = SpatialJacobianIteratorType( this->GetSpatialJacobianOutput(), outputRegionForThread );
+  }
+  if( computeResampled )
+  {
+    resIt = ResampledIteratorType( this->GetResampledImageOutput(), outputRegionForThread );
+  }
+
+  /** The range of the resampled pixel type, to clamp the interpolated values. */
+  const InterpolatorOutputType minValue
+    = static_cast< InterpolatorOutputType >( NumericTraits< ResampledPixelType >::NonpositiveMin() );
+  const InterpolatorOutputType maxValue
+    = static_cast< InterpolatorOutputType >( NumericTraits< ResampledPixelType >::max() );
+
+  InputPointType      point;
+  OutputPointType     mappedPoint;
+  SpatialJacobianType sj;
+
+  // Support for progress methods/callbacks
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  // Walk the output region
+  for( gridIt.GoToBegin(); !gridIt.IsAtEnd(); ++gridIt )
+  {
+    // Determine the coordinates of the current voxel
+    gridPtr->TransformIndexToPhysicalPoint( gridIt.GetIndex(), point );
+
+    /** A single evaluation of the transform for all outputs. */
+    this->m_Transform->TransformPointAndSpatialJacobian( point, mappedPoint, sj );
+
+    if( computeDisplacement )
+    {
+      DisplacementType displacement;
+      for( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+        displacement[ i ] = static_cast< float >( mappedPoint[ i ] - point[ i ] );
+      }
+      dispIt.Set( displacement );
+      ++dispIt;
+    }
+
+    if( computeDeterminant )
+    {
+      detIt.Set( static_cast< float >( vnl_det( sj.GetVnlMatrix() ) ) );
+      ++detIt;
+    }
+
+    if( computeJacobian )
+    {
+      OutputSpatialJacobianType outputsj;
+      for( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+        for( unsigned int j = 0; j < ImageDimension; ++j )
+        {
+          outputsj( i, j ) = static_cast< float >( sj( i, j ) );
+        }
+      }
+      jacIt.Set( outputsj );
+      ++jacIt;
+    }
+
+    if( computeResampled )
+    {
+      if( this->m_Interpolator->IsInsideBuffer( mappedPoint ) )
+      {
+        InterpolatorOutputType value = this->m_Interpolator->Evaluate( mappedPoint );
+        value = value < minValue ? minValue : ( value > maxValue ? maxValue : value );
+        resIt.Set( static_cast< ResampledPixelType >( value ) );
+      }
+      else
+      {
+        resIt.Set( this->m_DefaultPixelValue );
+      }
+      ++resIt;
+    }
+
+    progress.CompletedPixel();
+  }
+
+} // end ThreadedGenerateData()
+
+
+/**
+ * Inform pipeline of required output region
+ */
+template< class TInputImage, class TTransformPrecisionType >
+void
+TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::GenerateOutputInformation( void )
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateOutputInformation();
+
+  /** All outputs share the same grid. */
+  for( DataObjectPointerArraySizeType i = 0; i < this->GetNumberOfIndexedOutputs(); ++i )
+  {
+    ImageBaseType * outputPtr = dynamic_cast< ImageBaseType * >( this->ProcessObject::GetOutput( i ) );
+    if( !outputPtr )
+    {
+      continue;
+    }
+
+    outputPtr->SetLargestPossibleRegion( this->m_OutputRegion );
+    outputPtr->SetSpacing( this->m_OutputSpacing );
+    outputPtr->SetOrigin( this->m_OutputOrigin );
+    outputPtr->SetDirection( this->m_OutputDirection );
+  }
+
+} // end GenerateOutputInformation()
+
+
+/**
+ * Verify if any of the components has been modified.
+ */
+template< class TInputImage, class TTransformPrecisionType >
+ModifiedTimeType
+TransformToMultipleOutputsSource< TInputImage, TTransformPrecisionType >
+::GetMTime( void ) const
+{
+  ModifiedTimeType latestTime = Object::GetMTime();
+
+  if( this->m_Transform )
+  {
+    if( latestTime < this->m_Transform->GetMTime() )
+    {
+      latestTime = this->m_Transform->GetMTime();
+    }
+  }
+
+  if( this->m_ComputeResampledImage && this->m_Interpolator )
+  {
+    if( latestTime < this->m_Interpolator->GetMTime() )
+    {
+      latestTime = this->m_Interpolator->GetMTime();
+    }
+  }
+
+  return latestTime;
+} // end GetMTime()
+
+
+} // end namespace itk
+
+#endif // end #ifndef __itkTransformToMultipleOutputsSource_hxx
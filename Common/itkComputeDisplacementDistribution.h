@@ -25,6 +25,14 @@
 #include "itkImageRandomCoordinateSampler.h"
 #include "itkImageFullSampler.h"
 #include "itkPlatformMultiThreader.h"
+#include "itkAdvancedCombinationTransform.h"
+#include "itkImageMaskSpatialObject.h"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <tuple>
 
 namespace itk
 {
@@ -40,6 +48,16 @@ namespace itk
  * IEEE Transactions on Medical Imaging, vol. 35, no. 2, pp. 391 - 403, February 2016.
  * http://elastix.isi.uu.nl/marius/publications/2016_j_TMIa.php
  *
+ * The results of Compute() can be cached, see SetUseCache(). The cache key is
+ * a hash of the fixed image, the fixed image region and mask, the transform
+ * (including its initial transforms), the current position, the scales, the
+ * number of Jacobian measurements, the estimation method, and a user supplied
+ * string, see SetAdditionalCacheKey(). The latter should identify everything
+ * else the exact gradient depends on, such as the moving image and the metric
+ * settings. The cache is shared by all objects of the same type within a
+ * process, and can optionally be stored in a text file, see SetCacheFileName(),
+ * so that it can be reused by subsequent runs. The pixel data of an image is
+ * only hashed once per process, until the image is modified.
  */
 
 template< class TFixedImage, class TTransform >
@@ -125,6 +143,50 @@ public:
     this->m_Threader->SetNumberOfWorkUnits( numberOfThreads );
   }
 
+  /** Set/Get whether the results of Compute() are cached. Default false. */
+  itkSetMacro( UseCache, bool );
+  itkGetConstMacro( UseCache, bool );
+  itkBooleanMacro( UseCache );
+
+  /** Set/Get the file in which the cache is stored. Default: "", meaning that
+   * the cache is only kept in memory.
+   */
+  itkSetStringMacro( CacheFileName );
+  itkGetStringMacro( CacheFileName );
+
+  /** Set/Get a string that is added to the cache key. */
+  itkSetStringMacro( AdditionalCacheKey );
+  itkGetStringMacro( AdditionalCacheKey );
+
+  /** Type of the hashes used for the cache key. */
+  typedef std::uint64_t HashValueType;
+
+  /** Update a hash with a block of memory. */
+  static void UpdateHash( const void * data, const std::size_t size, HashValueType & hash );
+
+  /** Update a hash with the hash of the geometry and the buffer of an image.
+   * The buffer is only read the first time an image is seen, see ComputeImageHash().
+   */
+  template< class TImage >
+  static void UpdateHashWithImage( const TImage * image, HashValueType & hash );
+
+  /** Compute the hash of the geometry and the buffer of an image. The hash is
+   * remembered per image object, buffer and modification time, so the buffer
+   * of, for example, the fixed image is read only once, and not at every
+   * resolution level or restart.
+   */
+  template< class TImage >
+  static HashValueType ComputeImageHash( const TImage * image );
+
+  /** Compute a string for SetAdditionalCacheKey(), for the optimizers of
+   * elastix. TElastix is an elastix::ElastixTemplate. The string is a hash of
+   * the moving images of the current resolution level and the moving masks,
+   * the additional fixed images and masks of multi-image registrations, the
+   * current resolution level and all parameters of the parameter file.
+   */
+  template< class TElastix >
+  static std::string ComputeAdditionalCacheKey( TElastix * elastix );
+
 
   virtual void BeforeThreadedCompute( const ParametersType & mu );
 
@@ -181,6 +243,20 @@ protected:
   virtual void SampleFixedImageForJacobianTerms(
     ImageSampleContainerPointer & sampleContainer );
 
+  /** Compute the cache key for the current settings. Returns an empty string
+   * when the settings can not be identified, i.e. when the result should not be cached.
+   */
+  virtual std::string ComputeCacheKey( const ParametersType & mu,
+    const std::string & method ) const;
+
+  /** Look up the results of Compute() in the cache. */
+  virtual bool ReadFromCache( const std::string & key,
+    double & jacg, double & maxJJ ) const;
+
+  /** Store the results of Compute() in the cache. */
+  virtual void WriteToCache( const std::string & key,
+    const double jacg, const double maxJJ ) const;
+
   /** Launch MultiThread Compute. */
   void LaunchComputeThreaderCallback( void ) const;
 
@@ -219,6 +295,31 @@ protected:
   bool                        m_UseMultiThread;
   ImageSampleContainerPointer m_SampleContainer;
 
+  /** Cache related variables. */
+  bool        m_UseCache;
+  std::string m_CacheFileName;
+  std::string m_AdditionalCacheKey;
+
+  /** The cache, shared by all objects of this type. */
+  typedef std::map< std::string, std::pair< double, double > > CacheMapType;
+  struct CacheType
+  {
+    CacheMapType            st_Map;
+    std::set< std::string > st_LoadedFiles;
+    std::mutex              st_Mutex;
+  };
+
+  /** The image hashes, identified by the image, its buffer and its modification time. */
+  typedef std::tuple< const void *, const void *, ModifiedTimeType > ImageHashKeyType;
+  typedef std::map< ImageHashKeyType, HashValueType >                ImageHashMapType;
+  struct ImageHashCacheType
+  {
+    ImageHashMapType st_Map;
+    std::mutex       st_Mutex;
+  };
+  static ImageHashCacheType & GetImageHashCache( void );
+  static CacheType & GetCache( void );
+
 private:
 
   ComputeDisplacementDistribution( const Self & ); // purposely not implemented
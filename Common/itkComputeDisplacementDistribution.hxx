@@ -20,6 +20,9 @@
 
 #include "itkComputeDisplacementDistribution.h"
 
+#include <fstream>
+#include <iomanip>
+#include <sstream>
 #include <string>
 #include "vnl/vnl_math.h"
 #include "vnl/vnl_fastops.h"
@@ -50,6 +53,11 @@ ComputeDisplacementDistribution< TFixedImage, TTransform >
   this->m_NumberOfJacobianMeasurements = 0;
   this->m_SampleContainer              = 0;
 
+  /** Cache related variables. */
+  this->m_UseCache           = false;
+  this->m_CacheFileName      = "";
+  this->m_AdditionalCacheKey = "";
+
   /** Threading related variables. */
   this->m_UseMultiThread = true;
   this->m_Threader       = ThreaderType::New();
@@ -259,28 +267,435 @@ ComputeDisplacementDistribution< TFixedImage, TTransform >
 ::Compute( const ParametersType & mu,
   double & jacg, double & maxJJ, std::string methods )
 {
+  /** Look up the results in the cache. */
+  std::string cacheKey = "";
+  if( this->m_UseCache )
+  {
+    cacheKey = this->ComputeCacheKey( mu, methods );
+    if( this->ReadFromCache( cacheKey, jacg, maxJJ ) )
+    {
+      return;
+    }
+  }
+
   /** Option for now to still use the single threaded code. */
   if( !this->m_UseMultiThread )
   {
-    return this->ComputeSingleThreaded( mu, jacg, maxJJ, methods );
+    this->ComputeSingleThreaded( mu, jacg, maxJJ, methods );
   }
-  // The multi-threaded route only supports methods == 2sigma for now
+  else
+  {
+    // The multi-threaded route only supports methods == 2sigma for now
+
+    /** Initialize multi-threading. */
+    this->InitializeThreadingParameters();
 
-  /** Initialize multi-threading. */
-  this->InitializeThreadingParameters();
+    /** Tackle stuff needed before multi-threading. */
+    this->BeforeThreadedCompute( mu );
 
-  /** Tackle stuff needed before multi-threading. */
-  this->BeforeThreadedCompute( mu );
+    /** Launch multi-threaded computation. */
+    this->LaunchComputeThreaderCallback();
 
-  /** Launch multi-threaded computation. */
-  this->LaunchComputeThreaderCallback();
+    /** Gather the jacg, maxJJ values from all threads. */
+    this->AfterThreadedCompute( jacg, maxJJ );
+  }
 
-  /** Gather the jacg, maxJJ values from all threads. */
-  this->AfterThreadedCompute( jacg, maxJJ );
+  /** Store the results in the cache. */
+  if( !cacheKey.empty() )
+  {
+    this->WriteToCache( cacheKey, jacg, maxJJ );
+  }
 
 } // end Compute()
 
 
+/**
+ * ************************* UpdateHash ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeDisplacementDistribution< TFixedImage, TTransform >
+::UpdateHash( const void * data, const std::size_t size, HashValueType & hash )
+{
+  /** 64-bit FNV-1a. */
+  const unsigned char * bytes = static_cast< const unsigned char * >( data );
+  for( std::size_t i = 0; i < size; ++i )
+  {
+    hash ^= static_cast< HashValueType >( bytes[ i ] );
+    hash *= static_cast< HashValueType >( 1099511628211ULL );
+  }
+
+} // end UpdateHash()
+
+
+/**
+ * ************************* UpdateHashWithImage ************************
+ */
+
+template< class TFixedImage, class TTransform >
+template< class TImage >
+void
+ComputeDisplacementDistribution< TFixedImage, TTransform >
+::UpdateHashWithImage( const TImage * image, HashValueType & hash )
+{
+  const HashValueType imageHash = ComputeImageHash( image );
+  UpdateHash( &imageHash, sizeof( HashValueType ), hash );
+
+} // end UpdateHashWithImage()
+
+
+/**
+ * ************************* ComputeImageHash ************************
+ */
+
+template< class TFixedImage, class TTransform >
+template< class TImage >
+typename ComputeDisplacementDistribution< TFixedImage, TTransform >::HashValueType
+ComputeDisplacementDistribution< TFixedImage, TTransform >
+::ComputeImageHash( const TImage * image )
+{
+  const unsigned int Dimension = TImage::ImageDimension;
+  typedef typename TImage::PixelType PixelType;
+
+  /** Look up the hash of this image. The modification time stamps of ITK are
+   * unique, so a modified or a new image at the same address has another key.
+   */
+  ImageHashCacheType &   imageHashes = GetImageHashCache();
+  const ImageHashKeyType key( image, image->GetBufferPointer(), image->GetMTime() );
+  {
+    std::lock_guard< std::mutex > lock( imageHashes.st_Mutex );
+    typename ImageHashMapType::const_iterator it = imageHashes.st_Map.find( key );
+    if( it != imageHashes.st_Map.end() )
+    {
+      return it->second;
+    }
+  }
+
+  /** Initialize the hash with the FNV-1a offset basis. */
+  HashValueType hash = static_cast< HashValueType >( 14695981039346656037ULL );
+
+  /** The geometry. */
+  const typename TImage::RegionType region = image->GetBufferedRegion();
+  UpdateHash( &region.GetIndex()[ 0 ], Dimension * sizeof( IndexValueType ), hash );
+  UpdateHash( &region.GetSize()[ 0 ], Dimension * sizeof( SizeValueType ), hash );
+  UpdateHash( image->GetSpacing().GetDataPointer(), Dimension * sizeof( SpacePrecisionType ), hash );
+  UpdateHash( image->GetOrigin().GetDataPointer(), Dimension * sizeof( SpacePrecisionType ), hash );
+  UpdateHash( image->GetDirection().GetVnlMatrix().data_block(),
+    Dimension * Dimension * sizeof( SpacePrecisionType ), hash );
+
+  /** The pixel data. */
+  UpdateHash( image->GetBufferPointer(),
+    region.GetNumberOfPixels() * sizeof( PixelType ), hash );
+
+  /** Remember the hash. The entries of images that no longer exist are never
+   * found again, so start over when there are many.
+   */
+  std::lock_guard< std::mutex > lock( imageHashes.st_Mutex );
+  if( imageHashes.st_Map.size() >= 1024 )
+  {
+    imageHashes.st_Map.clear();
+  }
+  imageHashes.st_Map[ key ] = hash;
+  return hash;
+
+} // end ComputeImageHash()
+
+
+/**
+ * ************************* ComputeAdditionalCacheKey ************************
+ */
+
+template< class TFixedImage, class TTransform >
+template< class TElastix >
+std::string
+ComputeDisplacementDistribution< TFixedImage, TTransform >
+::ComputeAdditionalCacheKey( TElastix * elastix )
+{
+  typedef typename TElastix::ConfigurationType::ParameterFileParserType::ParameterMapType ParameterMapType;
+
+  /** Initialize the hash with the FNV-1a offset basis. */
+  HashValueType hash = static_cast< HashValueType >( 14695981039346656037ULL );
+
+  /** The resolution level. */
+  const unsigned int level
+    = elastix->GetElxRegistrationBase()->GetAsITKBaseType()->GetCurrentLevel();
+  UpdateHash( &level, sizeof( level ), hash );
+
+  /** The moving images of this level, and the moving masks. The fixed image
+   * and mask of the first metric are taken into account by ComputeCacheKey().
+   * A pyramid that did not keep its output is identified by its input.
+   */
+  for( unsigned int i = 0; i < elastix->GetNumberOfMovingImagePyramids(); ++i )
+  {
+    const typename TElastix::MovingImageType * image
+      = elastix->GetElxMovingImagePyramidBase( i )->GetAsITKBaseType()->GetOutput( level );
+    if( image == nullptr || image->GetBufferPointer() == nullptr )
+    {
+      image = elastix->GetMovingImage( i );
+    }
+    UpdateHashWithImage( image, hash );
+  }
+  for( unsigned int i = 0; i < elastix->GetNumberOfMovingMasks(); ++i )
+  {
+    if( elastix->GetMovingMask( i ) != nullptr )
+    {
+      UpdateHashWithImage( elastix->GetMovingMask( i ), hash );
+    }
+  }
+
+  /** The additional fixed images of this level, and masks. */
+  for( unsigned int i = 1; i < elastix->GetNumberOfFixedImagePyramids(); ++i )
+  {
+    const typename TElastix::FixedImageType * image
+      = elastix->GetElxFixedImagePyramidBase( i )->GetAsITKBaseType()->GetOutput( level );
+    if( image == nullptr || image->GetBufferPointer() == nullptr )
+    {
+      image = elastix->GetFixedImage( i );
+    }
+    UpdateHashWithImage( image, hash );
+  }
+  for( unsigned int i = 1; i < elastix->GetNumberOfFixedMasks(); ++i )
+  {
+    if( elastix->GetFixedMask( i ) != nullptr )
+    {
+      UpdateHashWithImage( elastix->GetFixedMask( i ), hash );
+    }
+  }
+
+  /** The settings of the metric, the interpolator, etc. For simplicity all
+   * parameters of the parameter file are used.
+   */
+  const ParameterMapType & parameterMap = elastix->GetConfiguration()->GetParameterMap();
+  for( typename ParameterMapType::const_iterator it = parameterMap.begin();
+    it != parameterMap.end(); ++it )
+  {
+    std::string parameter = it->first;
+    for( std::size_t j = 0; j < it->second.size(); ++j )
+    {
+      parameter += " " + it->second[ j ];
+    }
+    parameter += "\n";
+    UpdateHash( parameter.data(), parameter.size(), hash );
+  }
+
+  std::ostringstream key;
+  key << std::hex << std::setw( 16 ) << std::setfill( '0' ) << hash;
+  return key.str();
+
+} // end ComputeAdditionalCacheKey()
+
+
+/**
+ * ************************* ComputeCacheKey ************************
+ */
+
+template< class TFixedImage, class TTransform >
+std::string
+ComputeDisplacementDistribution< TFixedImage, TTransform >
+::ComputeCacheKey( const ParametersType & mu, const std::string & method ) const
+{
+  typedef AdvancedTransform< CoordinateRepresentationType,
+    FixedImageDimension, FixedImageDimension >                AdvancedTransformType;
+  typedef AdvancedCombinationTransform< CoordinateRepresentationType,
+    FixedImageDimension >                                     CombinationTransformType;
+  typedef ImageMaskSpatialObject< FixedImageDimension > ImageMaskSpatialObjectType;
+
+  if( this->m_FixedImage.IsNull() || this->m_Transform.IsNull() )
+  {
+    return "";
+  }
+
+  /** Initialize the hash with the FNV-1a offset basis. */
+  HashValueType hash = static_cast< HashValueType >( 14695981039346656037ULL );
+
+  /** The estimation method and the sampler settings. */
+  UpdateHash( method.data(), method.size(), hash );
+  UpdateHash( &this->m_NumberOfJacobianMeasurements, sizeof( SizeValueType ), hash );
+
+  /** The fixed image, region and mask. Only image masks can be identified. */
+  UpdateHashWithImage( this->m_FixedImage.GetPointer(), hash );
+  UpdateHash( &this->m_FixedImageRegion.GetIndex()[ 0 ],
+    FixedImageDimension * sizeof( IndexValueType ), hash );
+  UpdateHash( &this->m_FixedImageRegion.GetSize()[ 0 ],
+    FixedImageDimension * sizeof( SizeValueType ), hash );
+  if( this->m_FixedImageMask.IsNotNull() )
+  {
+    const ImageMaskSpatialObjectType * imageMask
+      = dynamic_cast< const ImageMaskSpatialObjectType * >( this->m_FixedImageMask.GetPointer() );
+    if( imageMask == nullptr || imageMask->GetImage() == nullptr )
+    {
+      return "";
+    }
+    UpdateHashWithImage( imageMask->GetImage(), hash );
+  }
+
+  /** The scales. */
+  const bool useScales = this->GetUseScales();
+  UpdateHash( &useScales, sizeof( bool ), hash );
+  if( useScales )
+  {
+    const ScalesType & scales = this->GetScales();
+    UpdateHash( scales.data_block(), scales.size() * sizeof( double ), hash );
+  }
+
+  /** The transform and its initial transforms. The current position mu
+   * takes the place of the parameters of the outermost transform.
+   */
+  const AdvancedTransformType * transform
+    = dynamic_cast< const AdvancedTransformType * >( this->m_Transform.GetPointer() );
+  bool isOutermost = true;
+  while( transform != nullptr )
+  {
+    const CombinationTransformType * combinationTransform
+      = dynamic_cast< const CombinationTransformType * >( transform );
+    const AdvancedTransformType * currentTransform = transform;
+    if( combinationTransform != nullptr )
+    {
+      const bool useComposition = combinationTransform->GetUseComposition();
+      UpdateHash( &useComposition, sizeof( bool ), hash );
+      currentTransform = combinationTransform->GetCurrentTransform();
+      if( currentTransform == nullptr )
+      {
+        return "";
+      }
+    }
+
+    const std::string name = currentTransform->GetNameOfClass();
+    UpdateHash( name.data(), name.size(), hash );
+    const typename AdvancedTransformType::FixedParametersType & fixedParameters
+      = currentTransform->GetFixedParameters();
+    UpdateHash( fixedParameters.data_block(),
+      fixedParameters.size() * sizeof( typename AdvancedTransformType::FixedParametersValueType ), hash );
+    if( isOutermost )
+    {
+      UpdateHash( mu.data_block(), mu.size() * sizeof( typename ParametersType::ValueType ), hash );
+    }
+    else
+    {
+      const typename AdvancedTransformType::ParametersType & parameters
+        = currentTransform->GetParameters();
+      UpdateHash( parameters.data_block(),
+        parameters.size() * sizeof( typename AdvancedTransformType::ParametersValueType ), hash );
+    }
+
+    /** Continue with the initial transform. */
+    transform   = combinationTransform != nullptr ? combinationTransform->GetInitialTransform() : nullptr;
+    isOutermost = false;
+  }
+
+  /** Everything else the estimate depends on. */
+  UpdateHash( this->m_AdditionalCacheKey.data(), this->m_AdditionalCacheKey.size(), hash );
+
+  std::ostringstream key;
+  key << std::hex << std::setw( 16 ) << std::setfill( '0' ) << hash;
+  return key.str();
+
+} // end ComputeCacheKey()
+
+
+/**
+ * ************************* GetCache ************************
+ */
+
+template< class TFixedImage, class TTransform >
+typename ComputeDisplacementDistribution< TFixedImage, TTransform >::CacheType
+& ComputeDisplacementDistribution< TFixedImage, TTransform >
+::GetCache( void )
+{
+  static CacheType cache;
+  return cache;
+
+} // end GetCache()
+
+
+/**
+ * ************************* GetImageHashCache ************************
+ */
+
+template< class TFixedImage, class TTransform >
+typename ComputeDisplacementDistribution< TFixedImage, TTransform >::ImageHashCacheType
+& ComputeDisplacementDistribution< TFixedImage, TTransform >
+::GetImageHashCache( void )
+{
+  static ImageHashCacheType imageHashes;
+  return imageHashes;
+
+} // end GetImageHashCache()
+
+
+/**
+ * ************************* ReadFromCache ************************
+ */
+
+template< class TFixedImage, class TTransform >
+bool
+ComputeDisplacementDistribution< TFixedImage, TTransform >
+::ReadFromCache( const std::string & key, double & jacg, double & maxJJ ) const
+{
+  if( key.empty() )
+  {
+    return false;
+  }
+
+  CacheType &                   cache = GetCache();
+  std::lock_guard< std::mutex > lock( cache.st_Mutex );
+
+  /** Read the cache file, once per process. Each line contains a key, jacg and maxJJ. */
+  if( !this->m_CacheFileName.empty()
+    && cache.st_LoadedFiles.insert( this->m_CacheFileName ).second )
+  {
+    std::ifstream input( this->m_CacheFileName.c_str() );
+    std::string   fileKey;
+    double        fileJacg  = 0.0;
+    double        fileMaxJJ = 0.0;
+    while( input >> fileKey >> fileJacg >> fileMaxJJ )
+    {
+      cache.st_Map[ fileKey ] = std::make_pair( fileJacg, fileMaxJJ );
+    }
+  }
+
+  typename CacheMapType::const_iterator it = cache.st_Map.find( key );
+  if( it == cache.st_Map.end() )
+  {
+    return false;
+  }
+  jacg  = it->second.first;
+  maxJJ = it->second.second;
+  return true;
+
+} // end ReadFromCache()
+
+
+/**
+ * ************************* WriteToCache ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeDisplacementDistribution< TFixedImage, TTransform >
+::WriteToCache( const std::string & key, const double jacg, const double maxJJ ) const
+{
+  CacheType &                   cache = GetCache();
+  std::lock_guard< std::mutex > lock( cache.st_Mutex );
+
+  cache.st_Map[ key ] = std::make_pair( jacg, maxJJ );
+
+  /** Append the entry to the cache file. */
+  if( !this->m_CacheFileName.empty() )
+  {
+    std::ofstream output( this->m_CacheFileName.c_str(), std::ios::app );
+    if( !output )
+    {
+      itkWarningMacro( << "Could not write to the cache file " << this->m_CacheFileName );
+      return;
+    }
+    output << key << " " << std::setprecision( 17 ) << jacg << " " << maxJJ << std::endl;
+  }
+
+} // end WriteToCache()
+
+
 /**
  * *********************** BeforeThreadedCompute***************
  */
@@ -22,6 +22,12 @@
 #include "itkImageRandomSamplerBase.h"
 #include "itkImageRandomCoordinateSampler.h"
 #include "itkScaledSingleValuedNonLinearOptimizer.h"
+#include "itkPlatformMultiThreader.h"
+
+#include "vnl/vnl_diag_matrix.h"
+#include "vnl/vnl_sparse_matrix.h"
+
+#include <vector>
 
 namespace itk
 {
@@ -31,6 +37,13 @@ namespace itk
  * More specifically this class computes the Jacobian terms related to the automatic
  * parameter estimation for the adaptive stochastic gradient descent optimizer.
  * Details can be found in the paper.
+ *
+ * The covariance matrix and the maximum terms are computed multi-threaded.
+ * For the covariance matrix, each thread owns a contiguous part of the rows.
+ * It visits all samples in order, and only computes and adds the elements of
+ * its own rows, so no locks are needed. The maximum terms are computed over a
+ * contiguous part of the samples per thread. The results do not depend on the
+ * number of threads.
  */
 
 template< class TFixedImage, class TTransform >
@@ -103,6 +116,15 @@ public:
   /** Get the region over which the metric will be computed. */
   itkGetConstReferenceMacro( FixedImageRegion, FixedImageRegionType );
 
+  /** Set whether the computation is multi-threaded. Default true. */
+  itkSetMacro( UseMultiThread, bool );
+
+  /** Set the number of threads. */
+  void SetNumberOfWorkUnits( ThreadIdType numberOfThreads )
+  {
+    this->m_Threader->SetNumberOfWorkUnits( numberOfThreads );
+  }
+
   /** The main functions that performs the computation. */
   virtual void Compute( double & TrC, double & TrCC,
     double & maxJJ, double & maxJCJ );
@@ -110,7 +132,11 @@ public:
 protected:
 
   ComputeJacobianTerms();
-  ~ComputeJacobianTerms() override {}
+  ~ComputeJacobianTerms() override;
+
+  /** Typedefs for multi-threading. */
+  typedef itk::PlatformMultiThreader ThreaderType;
+  typedef ThreaderType::WorkUnitInfo ThreadInfoType;
 
   typename FixedImageType::ConstPointer m_FixedImage;
   FixedImageRegionType       m_FixedImageRegion;
@@ -151,6 +177,73 @@ protected:
   virtual void SampleFixedImageForJacobianTerms(
     ImageSampleContainerPointer & sampleContainer );
 
+  /** Typedefs for the covariance matrix. Sparse, diagonal, and band form. */
+  typedef double                                   CovarianceValueType;
+  typedef itk::Array2D< CovarianceValueType >      CovarianceMatrixType;
+  typedef vnl_sparse_matrix< CovarianceValueType > SparseCovarianceMatrixType;
+  typedef typename SparseCovarianceMatrixType::row SparseRowType;
+  typedef vnl_diag_matrix< CovarianceValueType >   DiagCovarianceMatrixType;
+
+  /** Launch a threaded computation. */
+  void LaunchThreaderCallback( ThreadFunctionType callback ) const;
+
+  /** Threader callback functions. */
+  static ITK_THREAD_RETURN_TYPE ComputeCovarianceThreaderCallback( void * arg );
+  static ITK_THREAD_RETURN_TYPE ComputeMaxTermsThreaderCallback( void * arg );
+
+  /** Add 1/n J_j^T J_j of all samples to the rows of the covariance matrix of this thread. */
+  virtual void ThreadedComputeCovariance( ThreadIdType threadId );
+
+  /** Compute maxJJ and maxJCJ over the samples of this thread. */
+  virtual void ThreadedComputeMaxTerms( ThreadIdType threadId );
+
+  /** Add the upper triangular part of jactjac / n to the rows jacind
+   * of the band and sparse covariance matrices, within [row_begin, row_end).
+   */
+  void UpdateCovariance( const NonZeroJacobianIndicesType & jacind,
+    const CovarianceMatrixType & jactjac,
+    const unsigned int row_begin, const unsigned int row_end );
+
+  /** Get the range of samples handled by a thread. */
+  void GetSampleRange( ThreadIdType threadId,
+    SizeValueType & pos_begin, SizeValueType & pos_end ) const;
+
+  /** Get the range of rows of the covariance matrix owned by a thread. */
+  void GetRowRange( ThreadIdType threadId,
+    unsigned int & row_begin, unsigned int & row_end ) const;
+
+  /** Get the number of threads that is actually used. */
+  ThreadIdType GetNumberOfThreadsUsed( void ) const;
+
+  /** To give the threads access to all member variables and functions. */
+  struct MultiThreaderParameterType
+  {
+    Self * st_Self;
+  };
+  mutable MultiThreaderParameterType m_ThreaderParameters;
+
+  struct ComputePerThreadStruct
+  {
+    /**  Used for accumulating variables. */
+    double st_MaxJJ;
+    double st_MaxJCJ;
+  };
+  itkPadStruct( ITK_CACHE_LINE_ALIGNMENT, ComputePerThreadStruct,
+    PaddedComputePerThreadStruct );
+  itkAlignedTypedef( ITK_CACHE_LINE_ALIGNMENT, PaddedComputePerThreadStruct,
+    AlignedComputePerThreadStruct );
+  AlignedComputePerThreadStruct * m_ComputePerThreadVariables;
+  ThreadIdType                    m_ComputePerThreadVariablesSize;
+
+  /** Variables shared by the threads during Compute(). */
+  ThreaderType::Pointer       m_Threader;
+  bool                        m_UseMultiThread;
+  ImageSampleContainerPointer m_SampleContainer;
+  SparseCovarianceMatrixType  m_Covariance;
+  CovarianceMatrixType        m_BandCovariance;
+  std::vector< unsigned int > m_BandCovarianceMap;
+  DiagCovarianceMatrixType    m_DiagonalCovariance;
+
 private:
 
   ComputeJacobianTerms( const Self & ); // purposely not implemented
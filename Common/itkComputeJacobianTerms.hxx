@@ -22,8 +22,9 @@
 
 #include "vnl/vnl_math.h"
 #include "vnl/vnl_fastops.h"
-#include "vnl/vnl_diag_matrix.h"
-#include "vnl/vnl_sparse_matrix.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace itk
 {
@@ -45,9 +46,32 @@ ComputeJacobianTerms< TFixedImage, TTransform >
   this->m_NumberOfBandStructureSamples = 0;
   this->m_NumberOfJacobianMeasurements = 0;
 
+  /** Threading related variables. */
+  this->m_UseMultiThread = true;
+  this->m_Threader       = ThreaderType::New();
+
+  /** Initialize the m_ThreaderParameters. */
+  this->m_ThreaderParameters.st_Self = this;
+
+  // Multi-threading structs
+  this->m_ComputePerThreadVariables     = nullptr;
+  this->m_ComputePerThreadVariablesSize = 0;
+
 } // end Constructor
 
 
+/**
+ * ************************* Destructor ************************
+ */
+
+template< class TFixedImage, class TTransform >
+ComputeJacobianTerms< TFixedImage, TTransform >
+::~ComputeJacobianTerms()
+{
+  delete[] this->m_ComputePerThreadVariables;
+} // end Destructor
+
+
 /**
  * ************************* Compute ************************
  */
@@ -73,40 +97,23 @@ ComputeJacobianTerms< TFixedImage, TTransform >
    * Term 4: maxJCJ, see (54)
    */
 
-  typedef double                                   CovarianceValueType;
-  typedef itk::Array2D< CovarianceValueType >      CovarianceMatrixType;
-  typedef vnl_sparse_matrix< CovarianceValueType > SparseCovarianceMatrixType;
-  typedef SparseCovarianceMatrixType::row          SparseRowType;
-  typedef itk::Array< SizeValueType >              NonZeroJacobianIndicesExpandedType;
-  typedef vnl_diag_matrix< CovarianceValueType >   DiagCovarianceMatrixType;
-
   /** Initialize. */
   TrC = TrCC = maxJJ = maxJCJ = 0.0;
 
   /** Get samples. */
-  ImageSampleContainerPointer sampleContainer; // default-constructed (null)
-  SampleFixedImageForJacobianTerms( sampleContainer );
-  const SizeValueType nrofsamples = sampleContainer->Size();
-  const double        n           = static_cast< double >( nrofsamples );
+  this->SampleFixedImageForJacobianTerms( this->m_SampleContainer );
+  const SizeValueType nrofsamples = this->m_SampleContainer->Size();
 
   /** Get the number of parameters. */
   const unsigned int P = static_cast< unsigned int >(
     this->m_Transform->GetNumberOfParameters() );
 
   /** Get transform and set current position. */
-  typename TransformType::Pointer transform
-    = this->m_Transform;
   const unsigned int outdim = this->m_Transform->GetOutputSpaceDimension();
 
   /** Get scales vector */
   const ScalesType & scales = this->m_Scales;
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator iter;
-  typename ImageSampleContainerType::ConstIterator begin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator end   = sampleContainer->End();
-  unsigned int samplenr = 0;
-
   /** Variables for nonzerojacobian indices and the Jacobian. */
   NumberOfParametersType sizejacind
     = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
@@ -115,16 +122,6 @@ ComputeJacobianTerms< TFixedImage, TTransform >
   NonZeroJacobianIndicesType jacind( sizejacind );
   jacind[ 0 ] = 0;
   if( sizejacind > 1 ) { jacind[ 1 ] = 0; }
-  NonZeroJacobianIndicesType prevjacind = jacind;
-
-  /** Initialize covariance matrix. Sparse, diagonal, and band form. */
-  SparseCovarianceMatrixType cov( P, P );
-  DiagCovarianceMatrixType   diagcov( P, 0.0 );
-  CovarianceMatrixType       bandcov;
-
-  /** For temporary storage of J'J. */
-  CovarianceMatrixType jactjac( sizejacind, sizejacind );
-  jactjac.Fill( 0.0 );
 
   typedef std::vector< unsigned int >             DifHistType;
   typedef std::pair< unsigned int, unsigned int > FreqPairType;
@@ -163,7 +160,7 @@ ComputeJacobianTerms< TFixedImage, TTransform >
 
     /** Read fixed coordinates and get Jacobian J_j. */
     const FixedImagePointType & point
-      = sampleContainer->GetElement( samplenr ).m_ImageCoordinates;
+      = this->m_SampleContainer->GetElement( samplenr ).m_ImageCoordinates;
     this->m_Transform->GetJacobian( point, jacj, jacind );
 
     /** Skip invalid Jacobians in the beginning, if any. */
@@ -200,7 +197,7 @@ ComputeJacobianTerms< TFixedImage, TTransform >
     static_cast< unsigned int >( difHist2.size() ) );
 
   /** Maps parameterNrDifference (q-p) to colnr in bandcov. */
-  std::vector< unsigned int > bandcovMap( P, bandcovsize );
+  this->m_BandCovarianceMap.assign( P, bandcovsize );
   /** Maps colnr in bandcov to parameterNrDifference (q-p). */
   std::vector< unsigned int > bandcovMap2( bandcovsize, P );
 
@@ -212,13 +209,32 @@ ComputeJacobianTerms< TFixedImage, TTransform >
   for( unsigned int b = 0; b < bandcovsize; ++b )
   {
     --difHist2It;
-    bandcovMap[ difHist2It->second ] = b;
-    bandcovMap2[ b ]                 = difHist2It->second;
+    this->m_BandCovarianceMap[ difHist2It->second ] = b;
+    bandcovMap2[ b ]                                = difHist2It->second;
   }
 
-  /** Initialize band matrix. */
-  bandcov = CovarianceMatrixType( P, bandcovsize );
-  bandcov.Fill( 0.0 );
+  /** Initialize the covariance matrices. */
+  SparseCovarianceMatrixType & cov = this->m_Covariance;
+  cov.set_size( P, P );
+  this->m_BandCovariance.SetSize( P, bandcovsize );
+  this->m_BandCovariance.Fill( 0.0 );
+  DiagCovarianceMatrixType & diagcov = this->m_DiagonalCovariance;
+  diagcov.set_size( P );
+  diagcov.fill( 0.0 );
+
+  /** Initialize the per thread variables. */
+  const ThreadIdType numberOfThreads = this->GetNumberOfThreadsUsed();
+  if( this->m_ComputePerThreadVariablesSize != numberOfThreads )
+  {
+    delete[] this->m_ComputePerThreadVariables;
+    this->m_ComputePerThreadVariables     = new AlignedComputePerThreadStruct[ numberOfThreads ];
+    this->m_ComputePerThreadVariablesSize = numberOfThreads;
+  }
+  for( ThreadIdType i = 0; i < numberOfThreads; ++i )
+  {
+    this->m_ComputePerThreadVariables[ i ].st_MaxJJ  = NumericTraits< double >::Zero;
+    this->m_ComputePerThreadVariables[ i ].st_MaxJCJ = NumericTraits< double >::Zero;
+  }
 
   /**
    *    TERM 1
@@ -227,97 +243,14 @@ ComputeJacobianTerms< TFixedImage, TTransform >
    * Compute C = 1/n \sum_i J_i^T J_i
    * Possibly apply scaling afterwards.
    */
-  jacind[ 0 ] = 0;
-  if( sizejacind > 1 ) { jacind[ 1 ] = 0; }
-  for( iter = begin; iter != end; ++iter )
+  if( this->m_UseMultiThread )
   {
-    /** Print progress 0-50%.
-     *progressObserver->UpdateAndPrintProgress( samplenr );*/
-    ++samplenr;
-
-    /** Read fixed coordinates and get Jacobian J_j. */
-    const FixedImagePointType & point = ( *iter ).Value().m_ImageCoordinates;
-    this->m_Transform->GetJacobian( point, jacj, jacind  );
-
-    /** Skip invalid Jacobians in the beginning, if any. */
-    if( sizejacind > 1 )
-    {
-      if( jacind[ 0 ] == jacind[ 1 ] ) { continue; }
-    }
-
-    if( jacind == prevjacind )
-    {
-      /** Update sum of J_j^T J_j. */
-      vnl_fastops::inc_X_by_AtA( jactjac, jacj );
-    }
-    else
-    {
-      /** The following should only be done after the first sample. */
-      if( iter != begin )
-      {
-        /** Update covariance matrix. */
-        for( unsigned int pi = 0; pi < sizejacind; ++pi )
-        {
-          const unsigned int p = prevjacind[ pi ];
-          for( unsigned int qi = 0; qi < sizejacind; ++qi )
-          {
-            const unsigned int q = prevjacind[ qi ];
-            if( q >= p )
-            {
-              const double tempval = jactjac( pi, qi ) / n;
-              if( std::abs( tempval ) > 1e-14 )
-              {
-                const unsigned int bandindex = bandcovMap[ q - p ];
-                if( bandindex < bandcovsize )
-                {
-                  bandcov( p, bandindex ) += tempval;
-                }
-                else
-                {
-                  cov( p, q ) += tempval;
-                }
-              }
-            }
-          } // qi
-        }   // pi
-      }     // end if
-
-      /** Initialize jactjac by J_j^T J_j. */
-      vnl_fastops::AtA( jactjac, jacj );
-
-      /** Remember nonzerojacobian indices. */
-      prevjacind = jacind;
-    } // end else
-
-  } // end iter loop: end computation of covariance matrix
-
-  /** Update covariance matrix once again to include last jactjac updates
-   * \todo: a bit ugly that this loop is copied from above.
-   */
-  for( unsigned int pi = 0; pi < sizejacind; ++pi )
+    this->LaunchThreaderCallback( this->ComputeCovarianceThreaderCallback );
+  }
+  else
   {
-    const unsigned int p = prevjacind[ pi ];
-    for( unsigned int qi = 0; qi < sizejacind; ++qi )
-    {
-      const unsigned int q = prevjacind[ qi ];
-      if( q >= p )
-      {
-        const double tempval = jactjac( pi, qi ) / n;
-        if( std::abs( tempval ) > 1e-14 )
-        {
-          const unsigned int bandindex = bandcovMap[ q - p ];
-          if( bandindex < bandcovsize )
-          {
-            bandcov( p, bandindex ) += tempval;
-          }
-          else
-          {
-            cov( p, q ) += tempval;
-          }
-        }
-      }
-    } // qi
-  }   // pi
+    this->ThreadedComputeCovariance( 0 );
+  }
 
   /** Copy the bandmatrix into the sparse matrix and empty the bandcov matrix.
    * \todo: perhaps work further with this bandmatrix instead.
@@ -326,7 +259,7 @@ ComputeJacobianTerms< TFixedImage, TTransform >
   {
     for( unsigned int b = 0; b < bandcovsize; ++b )
     {
-      const double tempval = bandcov( p, b );
+      const double tempval = this->m_BandCovariance( p, b );
       if( std::abs( tempval ) > 1e-14 )
       {
         const unsigned int q = p + bandcovMap2[ b ];
@@ -334,7 +267,7 @@ ComputeJacobianTerms< TFixedImage, TTransform >
       }
     }
   }
-  bandcov.set_size( 0, 0 );
+  this->m_BandCovariance.set_size( 0, 0 );
 
   /** Apply scales. the use of m_Scales maybe something wrong. */
   if( this->m_UseScales )
@@ -390,9 +323,341 @@ ComputeJacobianTerms< TFixedImage, TTransform >
    * \li maxJJ = max_j [ ||J_j||_F^2 + 2\sqrt{2} || J_j J_j^T ||_F ]
    * \li maxJCJ = max_j [ Tr( J_j C J_j^T ) + 2\sqrt{2} || J_j C J_j^T ||_F ]
    */
+  if( this->m_UseMultiThread )
+  {
+    this->LaunchThreaderCallback( this->ComputeMaxTermsThreaderCallback );
+  }
+  else
+  {
+    this->ThreadedComputeMaxTerms( 0 );
+  }
+
+  /** Take the maximum over the threads. */
   maxJJ  = 0.0;
   maxJCJ = 0.0;
-  const double sqrt2 = std::sqrt( static_cast< double >( 2.0 ) );
+  for( ThreadIdType i = 0; i < numberOfThreads; ++i )
+  {
+    maxJJ  = std::max( maxJJ, this->m_ComputePerThreadVariables[ i ].st_MaxJJ );
+    maxJCJ = std::max( maxJCJ, this->m_ComputePerThreadVariables[ i ].st_MaxJCJ );
+  }
+
+  /** Release the memory of the covariance matrix and the samples. */
+  cov.set_size( 0, 0 );
+  diagcov.set_size( 0 );
+  this->m_BandCovarianceMap.clear();
+  this->m_SampleContainer = nullptr;
+
+} // end Compute()
+
+
+/**
+ * ************************* GetNumberOfThreadsUsed ************************
+ */
+
+template< class TFixedImage, class TTransform >
+ThreadIdType
+ComputeJacobianTerms< TFixedImage, TTransform >
+::GetNumberOfThreadsUsed( void ) const
+{
+  return this->m_UseMultiThread ? this->m_Threader->GetNumberOfWorkUnits() : 1;
+} // end GetNumberOfThreadsUsed()
+
+
+/**
+ * ************************* GetSampleRange ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::GetSampleRange( ThreadIdType threadId,
+  SizeValueType & pos_begin, SizeValueType & pos_end ) const
+{
+  /** Each thread handles a contiguous part of the samples, so that
+   * subsequent samples with the same nonzero Jacobian indices can still
+   * be combined in the covariance computation.
+   */
+  const SizeValueType sampleContainerSize = this->m_SampleContainer->Size();
+  const ThreadIdType  numberOfThreads     = this->GetNumberOfThreadsUsed();
+  const SizeValueType nrOfSamplesPerThreads
+    = static_cast< SizeValueType >( std::ceil( static_cast< double >( sampleContainerSize )
+    / static_cast< double >( numberOfThreads ) ) );
+
+  pos_begin = std::min( nrOfSamplesPerThreads * threadId, sampleContainerSize );
+  pos_end   = std::min( nrOfSamplesPerThreads * ( threadId + 1 ), sampleContainerSize );
+
+} // end GetSampleRange()
+
+
+/**
+ * *********************** LaunchThreaderCallback***************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::LaunchThreaderCallback( ThreadFunctionType callback ) const
+{
+  /** Setup threader. */
+  this->m_Threader->SetSingleMethod( callback,
+    const_cast< void * >( static_cast< const void * >( &this->m_ThreaderParameters ) ) );
+
+  /** Launch. */
+  this->m_Threader->SingleMethodExecute();
+
+} // end LaunchThreaderCallback()
+
+
+/**
+ * ************ ComputeCovarianceThreaderCallback ****************************
+ */
+
+template< class TFixedImage, class TTransform >
+ITK_THREAD_RETURN_TYPE
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ComputeCovarianceThreaderCallback( void * arg )
+{
+  /** Get the current thread id and user data. */
+  ThreadInfoType *             infoStruct = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType                 threadID   = infoStruct->WorkUnitID;
+  MultiThreaderParameterType * temp
+    = static_cast< MultiThreaderParameterType * >( infoStruct->UserData );
+
+  /** Call the real implementation. */
+  temp->st_Self->ThreadedComputeCovariance( threadID );
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeCovarianceThreaderCallback()
+
+
+/**
+ * ************ ComputeMaxTermsThreaderCallback ****************************
+ */
+
+template< class TFixedImage, class TTransform >
+ITK_THREAD_RETURN_TYPE
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ComputeMaxTermsThreaderCallback( void * arg )
+{
+  /** Get the current thread id and user data. */
+  ThreadInfoType *             infoStruct = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType                 threadID   = infoStruct->WorkUnitID;
+  MultiThreaderParameterType * temp
+    = static_cast< MultiThreaderParameterType * >( infoStruct->UserData );
+
+  /** Call the real implementation. */
+  temp->st_Self->ThreadedComputeMaxTerms( threadID );
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeMaxTermsThreaderCallback()
+
+
+/**
+ * ************************* GetRowRange ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::GetRowRange( ThreadIdType threadId,
+  unsigned int & row_begin, unsigned int & row_end ) const
+{
+  /** Each thread owns a contiguous part of the rows of the covariance matrix. */
+  const SizeValueType P               = this->m_Transform->GetNumberOfParameters();
+  const ThreadIdType  numberOfThreads = this->GetNumberOfThreadsUsed();
+
+  row_begin = static_cast< unsigned int >( P * threadId / numberOfThreads );
+  row_end   = static_cast< unsigned int >( P * ( threadId + 1 ) / numberOfThreads );
+
+} // end GetRowRange()
+
+
+/**
+ * ************************* ThreadedComputeCovariance ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ThreadedComputeCovariance( ThreadIdType threadId )
+{
+  /** Get the rows of the covariance matrix for this thread. Each thread visits
+   * all samples, in the same order, but only computes the rows it owns. The
+   * summation order of every element is therefore that of a single thread.
+   */
+  unsigned int row_begin = 0;
+  unsigned int row_end   = 0;
+  this->GetRowRange( threadId, row_begin, row_end );
+  if( row_begin == row_end )
+  {
+    return;
+  }
+
+  /** Variables for nonzerojacobian indices and the Jacobian. */
+  const unsigned int     outdim = this->m_Transform->GetOutputSpaceDimension();
+  NumberOfParametersType sizejacind
+    = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
+  JacobianType jacj( outdim, sizejacind );
+  jacj.Fill( 0.0 );
+  NonZeroJacobianIndicesType jacind( sizejacind );
+  jacind[ 0 ] = 0;
+  if( sizejacind > 1 ) { jacind[ 1 ] = 0; }
+  NonZeroJacobianIndicesType prevjacind = jacind;
+
+  /** For temporary storage of the rows of J'J that this thread owns. */
+  CovarianceMatrixType jactjac( sizejacind, sizejacind );
+  jactjac.Fill( 0.0 );
+  bool firstValidSample = true;
+
+  /** Create iterator over the sample container. */
+  typename ImageSampleContainerType::ConstIterator iter;
+  typename ImageSampleContainerType::ConstIterator begin = this->m_SampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator end   = this->m_SampleContainer->End();
+
+  for( iter = begin; iter != end; ++iter )
+  {
+    /** Read fixed coordinates and get Jacobian J_j. */
+    const FixedImagePointType & point = ( *iter ).Value().m_ImageCoordinates;
+    this->m_Transform->GetJacobian( point, jacj, jacind );
+
+    /** Skip invalid Jacobians, if any. */
+    if( sizejacind > 1 )
+    {
+      if( jacind[ 0 ] == jacind[ 1 ] ) { continue; }
+    }
+
+    /** Add the sum of the previous nonzero Jacobian indices to the covariance
+     * matrix, when the indices change, and start a new sum.
+     */
+    const bool sameIndices = !firstValidSample && jacind == prevjacind;
+    if( !sameIndices )
+    {
+      if( !firstValidSample )
+      {
+        this->UpdateCovariance( prevjacind, jactjac, row_begin, row_end );
+      }
+      prevjacind       = jacind;
+      firstValidSample = false;
+    }
+
+    /** Update the owned rows of the sum of J_j^T J_j. */
+    for( unsigned int pi = 0; pi < sizejacind; ++pi )
+    {
+      const unsigned int p = jacind[ pi ];
+      if( p < row_begin || p >= row_end )
+      {
+        continue;
+      }
+      for( unsigned int qi = 0; qi < sizejacind; ++qi )
+      {
+        double sum = 0.0;
+        for( unsigned int d = 0; d < outdim; ++d )
+        {
+          sum += jacj[ d ][ pi ] * jacj[ d ][ qi ];
+        }
+        jactjac( pi, qi ) = sameIndices ? jactjac( pi, qi ) + sum : sum;
+      }
+    }
+
+  } // end iter loop: end computation of covariance matrix
+
+  /** Update covariance matrix once again to include last jactjac updates. */
+  if( !firstValidSample )
+  {
+    this->UpdateCovariance( prevjacind, jactjac, row_begin, row_end );
+  }
+
+} // end ThreadedComputeCovariance()
+
+
+/**
+ * ************************* UpdateCovariance ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::UpdateCovariance( const NonZeroJacobianIndicesType & jacind,
+  const CovarianceMatrixType & jactjac,
+  const unsigned int row_begin, const unsigned int row_end )
+{
+  const double       n           = static_cast< double >( this->m_SampleContainer->Size() );
+  const unsigned int bandcovsize = this->m_BandCovariance.cols();
+  const unsigned int sizejacind  = jacind.size();
+
+  for( unsigned int pi = 0; pi < sizejacind; ++pi )
+  {
+    /** Only the rows of this thread, so no other thread writes to row p. */
+    const unsigned int p = jacind[ pi ];
+    if( p < row_begin || p >= row_end )
+    {
+      continue;
+    }
+
+    for( unsigned int qi = 0; qi < sizejacind; ++qi )
+    {
+      const unsigned int q = jacind[ qi ];
+      if( q >= p )
+      {
+        const double tempval = jactjac( pi, qi ) / n;
+        if( std::abs( tempval ) > 1e-14 )
+        {
+          const unsigned int bandindex = this->m_BandCovarianceMap[ q - p ];
+          if( bandindex < bandcovsize )
+          {
+            this->m_BandCovariance( p, bandindex ) += tempval;
+          }
+          else
+          {
+            this->m_Covariance( p, q ) += tempval;
+          }
+        }
+      }
+    } // qi
+  }   // pi
+
+} // end UpdateCovariance()
+
+
+/**
+ * ************************* ThreadedComputeMaxTerms ************************
+ */
+
+template< class TFixedImage, class TTransform >
+void
+ComputeJacobianTerms< TFixedImage, TTransform >
+::ThreadedComputeMaxTerms( ThreadIdType threadId )
+{
+  typedef itk::Array< SizeValueType > NonZeroJacobianIndicesExpandedType;
+
+  /** Get the samples for this thread. */
+  SizeValueType pos_begin = 0;
+  SizeValueType pos_end   = 0;
+  this->GetSampleRange( threadId, pos_begin, pos_end );
+
+  /** Get the number of parameters, and the covariance matrix. */
+  const unsigned int P = static_cast< unsigned int >(
+    this->m_Transform->GetNumberOfParameters() );
+  SparseCovarianceMatrixType &     cov     = this->m_Covariance;
+  const DiagCovarianceMatrixType & diagcov = this->m_DiagonalCovariance;
+  const ScalesType &               scales  = this->m_Scales;
+
+  /** Variables for nonzerojacobian indices and the Jacobian. */
+  const unsigned int     outdim = this->m_Transform->GetOutputSpaceDimension();
+  NumberOfParametersType sizejacind
+    = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
+  JacobianType jacj( outdim, sizejacind );
+  jacj.Fill( 0.0 );
+  NonZeroJacobianIndicesType jacind( sizejacind );
+  jacind[ 0 ] = 0;
+  if( sizejacind > 1 ) { jacind[ 1 ] = 0; }
+
+  /** Temporaries. */
+  const double sqrt2  = std::sqrt( static_cast< double >( 2.0 ) );
+  double       maxJJ  = 0.0;
+  double       maxJCJ = 0.0;
 
   JacobianType                       jacjjacj( outdim, outdim );
   JacobianType                       jacjcov( outdim, sizejacind );
@@ -401,8 +666,15 @@ ComputeJacobianTerms< TFixedImage, TTransform >
   JacobianType                       jacjdiagcovjacj( outdim, outdim );
   JacobianType                       jacjcovjacj( outdim, outdim );
   NonZeroJacobianIndicesExpandedType jacindExpanded( P );
+  jacindExpanded.Fill( sizejacind );
+
+  /** Create iterator over the sample container. */
+  typename ImageSampleContainerType::ConstIterator iter;
+  typename ImageSampleContainerType::ConstIterator begin = this->m_SampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator end   = this->m_SampleContainer->Begin();
+  begin += (int)pos_begin;
+  end   += (int)pos_end;
 
-  samplenr = 0;
   for( iter = begin; iter != end; ++iter )
   {
     /** Read fixed coordinates and get Jacobian. */
@@ -438,7 +710,6 @@ ComputeJacobianTerms< TFixedImage, TTransform >
     /** Store the nonzero Jacobian indices in a different format
      * and create the sparse diagcov.
      */
-    jacindExpanded.Fill( sizejacind );
     for( unsigned int pi = 0; pi < sizejacind; ++pi )
     {
       const unsigned int p = jacind[ pi ];
@@ -479,6 +750,12 @@ ComputeJacobianTerms< TFixedImage, TTransform >
       } // if not empty row
     }   // pi
 
+    /** Reset the expanded indices, only where they were set. */
+    for( unsigned int pi = 0; pi < sizejacind; ++pi )
+    {
+      jacindExpanded[ jacind[ pi ] ] = sizejacind;
+    }
+
     /** J_j C J_j^T  = jacjCjacj.
      * But note that we actually compute J_j cov' J_j^T
      */
@@ -502,16 +779,13 @@ ComputeJacobianTerms< TFixedImage, TTransform >
     /** Max_j [JCJ_j]. */
     maxJCJ = std::max( maxJCJ, JCJ_j );
 
-    /** Show progress 50-100%. */
-    //progressObserver->UpdateAndPrintProgress( samplenr + nrofsamples );
-    ++samplenr;
-
   } // end loop over sample container
 
-  /** Finalize progress information. */
-  //progressObserver->PrintProgress( 1.0 );
+  /** Store the results of this thread. */
+  this->m_ComputePerThreadVariables[ threadId ].st_MaxJJ  = maxJJ;
+  this->m_ComputePerThreadVariables[ threadId ].st_MaxJCJ = maxJCJ;
 
-} // end Compute()
+} // end ThreadedComputeMaxTerms()
 
 
 /**
@@ -0,0 +1,145 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkCostFunctionClones_h
+#define __itkCostFunctionClones_h
+
+#include "itkScaledSingleValuedCostFunction.h"
+#include "itkThreadPoolJobs.h"
+#include "itkMacro.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <string>
+#include <vector>
+
+namespace itk
+{
+
+/** \class CostFunctionClones
+ * \brief Evaluates a number of positions on independent copies of a cost
+ * function, in parallel.
+ *
+ * The optimizers that evaluate a batch of positions per iteration, such as the
+ * FullSearchOptimizer, the CMAEvolutionStrategyOptimizer, the
+ * FiniteDifferenceGradientDescentOptimizer and the SimultaneousPerturbation
+ * optimizer of elastix, accept such copies ("clones") of their cost function.
+ *
+ * Evaluate( n, m, evaluate ) calls evaluate( c, i ) for the evaluations
+ * i = 0, ..., m - 1, where clone c = i mod n does evaluation i. This static
+ * assignment makes the results independent of the timing. The clones run as
+ * jobs of the ThreadPoolJobs, each on its own thread. A clone stops at its
+ * first error; Evaluate() then throws the error of the evaluation with the
+ * lowest index, always as an ExceptionObject, so that the optimizers can
+ * handle it as a metric error.
+ *
+ * \ingroup Numerics
+ */
+
+class CostFunctionClones
+{
+public:
+
+  /** Typedefs. */
+  typedef SingleValuedCostFunction                 CostFunctionType;
+  typedef std::vector< CostFunctionType::Pointer > CostFunctionContainerType;
+  typedef ScaledSingleValuedCostFunction           ScaledCostFunctionType;
+  typedef ScaledCostFunctionType::Pointer          ScaledCostFunctionPointer;
+  typedef std::vector< ScaledCostFunctionPointer > ScaledCostFunctionContainerType;
+
+  /** Wrap the first numberOfClones clones each in a scaled cost function, with
+   * the same scales and negation as the scaled cost function of an optimizer.
+   */
+  static ScaledCostFunctionContainerType CreateScaledClones(
+    const CostFunctionContainerType & clones,
+    const ScaledCostFunctionType * scaledCostFunction,
+    const std::size_t numberOfClones )
+  {
+    ScaledCostFunctionContainerType scaledClones( numberOfClones );
+    for( std::size_t c = 0; c < numberOfClones; ++c )
+    {
+      scaledClones[ c ] = ScaledCostFunctionType::New();
+      scaledClones[ c ]->SetUnscaledCostFunction( clones[ c ] );
+      scaledClones[ c ]->SetNegateCostFunction( scaledCostFunction->GetNegateCostFunction() );
+      scaledClones[ c ]->SetUseScales( scaledCostFunction->GetUseScales() );
+      if( scaledCostFunction->GetUseScales() )
+      {
+        scaledClones[ c ]->SetScales( scaledCostFunction->GetScales() );
+      }
+    }
+    return scaledClones;
+  }
+
+
+  /** Call evaluate( c, i ) for i = 0, ..., numberOfEvaluations - 1, on
+   * min( numberOfClones, numberOfEvaluations ) clones, see the class documentation.
+   */
+  template< class TEvaluate >
+  static void Evaluate( const std::size_t numberOfClones,
+    const std::size_t numberOfEvaluations, const TEvaluate & evaluate )
+  {
+    const std::size_t numberOfJobs = std::min( numberOfClones, numberOfEvaluations );
+    if( numberOfJobs == 0 )
+    {
+      return;
+    }
+
+    std::vector< std::exception_ptr > errors( numberOfEvaluations );
+    ThreadPoolJobs::RunJobs( numberOfJobs, [ & ]( const std::size_t c )
+    {
+      for( std::size_t i = c; i < numberOfEvaluations; i += numberOfJobs )
+      {
+        try
+        {
+          evaluate( c, i );
+        }
+        catch( ExceptionObject & )
+        {
+          errors[ i ] = std::current_exception();
+          return;
+        }
+        catch( std::exception & e )
+        {
+          errors[ i ] = std::make_exception_ptr( ExceptionObject( __FILE__, __LINE__,
+            std::string( "Cost function clone evaluation failed: " ) + e.what(), ITK_LOCATION ) );
+          return;
+        }
+        catch( ... )
+        {
+          errors[ i ] = std::make_exception_ptr( ExceptionObject( __FILE__, __LINE__,
+            "Cost function clone evaluation failed with an unknown exception", ITK_LOCATION ) );
+          return;
+        }
+      }
+    } );
+
+    for( std::size_t i = 0; i < numberOfEvaluations; ++i )
+    {
+      if( errors[ i ] )
+      {
+        std::rethrow_exception( errors[ i ] );
+      }
+    }
+  }
+
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkCostFunctionClones_h
@@ -21,6 +21,8 @@
 #include "itkMultiResolutionPyramidImageFilter.h"
 #include "itkSmoothingRecursiveGaussianImageFilter.h"
 
+#include <future>
+
 namespace itk
 {
 /** \class GenericMultiResolutionPyramidImageFilter
@@ -96,7 +98,31 @@ namespace itk
  *
  * The GenericMultiResolutionPyramidImageFilter provides direct control to
  * compute only single level of the pyramid via SetCurrentLevel() and
- * SetComputeOnlyForCurrentLevel() methods.
+ * SetComputeOnlyForCurrentLevel() methods. In that mode the outputs of the
+ * other levels are released when the current level changes, so that only one
+ * level is kept in memory. With SetComputeNextLevelInBackground() the next
+ * level is additionally computed in a background thread, directly after the
+ * current level has been generated. When the next level is requested later
+ * on, its output is taken from the background computation, so that the
+ * construction of the pyramid overlaps with the use of the current level,
+ * for example with the optimization in a registration.
+ *
+ * When all levels are computed at once, SetUseIncrementalSmoothing() enables
+ * a cascade: the levels are computed from fine to coarse, and a level is
+ * computed from the already smoothed and rescaled image of the next finer
+ * level, instead of from the full resolution input. Since Gaussian smoothing
+ * composes, sigma_n^2 = sigma_{n+1}^2 + deltaSigma^2, only the additional
+ * smoothing deltaSigma is applied, on the smaller image of the finer level.
+ * This is only used with the resampler, and when the finer level is smoothed
+ * in each dimension in which it is rescaled. The additional smoothing should
+ * also be at least one pixel of the finer level, because the recursive Gaussian
+ * is inaccurate for smaller sigmas; otherwise the level is smoothed from the
+ * input as usual. With the default smoothing schedule, sigma is half the shrink
+ * factor, which gives deltaSigma = 0.87 finer pixels, so the cascade needs a
+ * schedule that smooths more, e.g. sigma equal to the shrink factor. The finer
+ * level is interpolated with a cubic B-spline, since linear interpolation of
+ * its coarse grid would noticeably damp the image. The result differs slightly
+ * from the default computation, mainly near the image border.
  *
  * \author Denis P. Shamonin and Marius Staring. Division of Image Processing,
  * Department of Radiology, Leiden, The Netherlands
@@ -220,6 +246,21 @@ public:
   itkGetConstMacro( ComputeOnlyForCurrentLevel, bool );
   itkBooleanMacro( ComputeOnlyForCurrentLevel );
 
+  /** Set/Get whether the level after the current level is computed in a
+   * background thread. Only used when ComputeOnlyForCurrentLevel is true.
+   * Default false.
+   */
+  itkSetMacro( ComputeNextLevelInBackground, bool );
+  itkGetConstMacro( ComputeNextLevelInBackground, bool );
+  itkBooleanMacro( ComputeNextLevelInBackground );
+
+  /** Set/Get whether coarser levels are computed from finer levels. Not used
+   * when ComputeOnlyForCurrentLevel is true, or with the shrinker. Default false.
+   */
+  itkSetMacro( UseIncrementalSmoothing, bool );
+  itkGetConstMacro( UseIncrementalSmoothing, bool );
+  itkBooleanMacro( UseIncrementalSmoothing );
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro( SameDimensionCheck,
@@ -232,7 +273,7 @@ public:
 protected:
 
   GenericMultiResolutionPyramidImageFilter();
-  ~GenericMultiResolutionPyramidImageFilter() override {}
+  ~GenericMultiResolutionPyramidImageFilter() override;
 
   /** PrintSelf. */
   void PrintSelf( std::ostream & os, Indent indent ) const override;
@@ -266,6 +307,8 @@ protected:
   unsigned int          m_CurrentLevel;
   bool                  m_ComputeOnlyForCurrentLevel;
   bool                  m_SmoothingScheduleDefined;
+  bool                  m_ComputeNextLevelInBackground;
+  bool                  m_UseIncrementalSmoothing;
 
 private:
 
@@ -275,6 +318,10 @@ private:
   typedef SmoothingRecursiveGaussianImageFilter<
     InputImageType, OutputImageType > SmootherType;
 
+  /** Typedef for the smoother that smooths a finer level further. */
+  typedef SmoothingRecursiveGaussianImageFilter<
+    OutputImageType, OutputImageType > IncrementalSmootherType;
+
   /** Typedefs for shrinker or resample. If smoother has not been used, then
    * we have to use InputImageType to OutputImageType,
    * otherwise OutputImageType to OutputImageType.
@@ -310,6 +357,23 @@ private:
     typename ImageToImageFilterSameTypes::Pointer & rescaleSameTypes,
     typename ImageToImageFilterDifferentTypes::Pointer & rescaleDifferentTypes );
 
+  /** Get the additional smoothing of the level relative to the next finer
+   * level: sigma_n^2 = sigma_{n+1}^2 + deltaSigma^2.
+   */
+  void GetIncrementalSigma( const unsigned int level, SigmaArrayType & deltaSigma ) const;
+
+  /** Returns true if the level can be computed from the next finer level. */
+  bool CanComputeFromFinerLevel( const unsigned int level ) const;
+
+  /** Compute the level from the next finer level, which should have been
+   * computed already. Only the additional smoothing is applied. The resampler
+   * is created on first use, with a cubic B-spline interpolator.
+   */
+  void ComputeFromFinerLevel( const unsigned int level,
+    typename IncrementalSmootherType::Pointer & smoother,
+    const OutputImagePointer & outputPtr,
+    typename ImageToImageFilterSameTypes::Pointer & resampler );
+
   /** Initialize m_SmoothingSchedule to default values for backward compatibility. */
   void SetSmoothingScheduleToDefault( void );
 
@@ -348,11 +412,31 @@ private:
   /** Returns true if rescale has been used in pipeline, otherwise return false. */
   bool IsRescaleUsed( void ) const;
 
+  /** Start computing the given level in a background thread. A copy of this
+   * filter is used, which gets a disconnected copy of the input, so that the
+   * background thread does not touch the pipeline of this filter.
+   */
+  void ComputeLevelInBackground( const unsigned int level );
+
+  /** Graft the output of the background computation to the output of the
+   * given level. Returns false if no background computation for this level,
+   * input and schedules was started, or if it failed. In all cases a pending
+   * background computation is finished and discarded.
+   */
+  bool GraftLevelComputedInBackground( const unsigned int level );
+
 private:
 
   GenericMultiResolutionPyramidImageFilter( const Self & ); // purposely not implemented
   void operator=( const Self & );                           // purposely not implemented
 
+  /** Member variables for the background computation of a level. */
+  Pointer                 m_BackgroundPyramid;
+  std::future< void >     m_BackgroundFuture;
+  unsigned int            m_BackgroundLevel;
+  const InputImageType *  m_BackgroundInput;
+  ModifiedTimeType        m_BackgroundInputMTime;
+
 };
 
 } // namespace itk
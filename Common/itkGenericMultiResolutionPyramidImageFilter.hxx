@@ -21,9 +21,13 @@
 #include "itkGenericMultiResolutionPyramidImageFilter.h"
 
 #include "itkResampleImageFilter.h"
+#include "itkBSplineInterpolateImageFunction.h"
 #include "itkShrinkImageFilter.h"
 #include "itkImageAlgorithm.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace // anonymous namespace
 {
 /**
@@ -65,9 +69,31 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
   temp.Fill( NumericTraits< ScalarRealType >::ZeroValue() );
   this->m_SmoothingSchedule        = temp;
   this->m_SmoothingScheduleDefined = false;
+
+  this->m_ComputeNextLevelInBackground = false;
+  this->m_UseIncrementalSmoothing      = false;
+  this->m_BackgroundLevel              = 0;
+  this->m_BackgroundInput              = nullptr;
+  this->m_BackgroundInputMTime         = 0;
 } // end Constructor
 
 
+/**
+ * ******************* Destructor ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::~GenericMultiResolutionPyramidImageFilter()
+{
+  /** Do not leave a background computation behind. */
+  if( this->m_BackgroundFuture.valid() )
+  {
+    this->m_BackgroundFuture.wait();
+  }
+} // end Destructor
+
+
 /**
  * ******************* SetNumberOfLevels ***********************
  */
@@ -332,22 +358,45 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
   typename SmootherType::Pointer smoother;
   typename ImageToImageFilterSameTypes::Pointer rescaleSameTypes;
   typename ImageToImageFilterDifferentTypes::Pointer rescaleDifferentTypes;
+  typename IncrementalSmootherType::Pointer incrementalSmoother;
+  typename ImageToImageFilterSameTypes::Pointer incrementalResampler;
+
+  // In the incremental mode the levels are computed from fine to coarse
+  const bool incremental = this->m_UseIncrementalSmoothing
+    && !this->m_ComputeOnlyForCurrentLevel;
 
-  for( unsigned int level = 0; level < this->m_NumberOfLevels; ++level )
+  for( unsigned int i = 0; i < this->m_NumberOfLevels; ++i )
   {
+    const unsigned int level = incremental ? this->m_NumberOfLevels - 1 - i : i;
+
     if( !this->m_ComputeOnlyForCurrentLevel )
     {
-      this->UpdateProgress( static_cast< float >( level )
+      this->UpdateProgress( static_cast< float >( i )
         / static_cast< float >( this->m_NumberOfLevels ) );
     }
 
     if( this->ComputeForCurrentLevel( level ) )
     {
+      // Use the result of the background computation, if there is one
+      if( this->m_ComputeOnlyForCurrentLevel
+        && this->GraftLevelComputedInBackground( level ) )
+      {
+        continue;
+      }
+
       // Allocate memory for each output
       OutputImagePointer outputPtr = this->GetOutput( level );
       outputPtr->SetBufferedRegion( outputPtr->GetRequestedRegion() );
       outputPtr->Allocate();
 
+      // Derive the level from the finer level, if possible
+      if( incremental && this->CanComputeFromFinerLevel( level ) )
+      {
+        this->ComputeFromFinerLevel( level, incrementalSmoother, outputPtr,
+          incrementalResampler );
+        continue;
+      }
+
       // Setup the smoother
       const bool smootherIsUsed = this->SetupSmoother( level, smoother, input );
 
@@ -381,6 +430,13 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
 
     }
   } // end for ilevel
+
+  // Start computing the next level, while the current level is being used
+  if( this->m_ComputeOnlyForCurrentLevel && this->m_ComputeNextLevelInBackground
+    && this->m_CurrentLevel + 1 < this->m_NumberOfLevels )
+  {
+    this->ComputeLevelInBackground( this->m_CurrentLevel + 1 );
+  }
 } // end GenerateData()
 
 
@@ -412,6 +468,145 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
 } // end SetupSmoother()
 
 
+/**
+ * ******************* GetIncrementalSigma ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+void
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::GetIncrementalSigma( const unsigned int level, SigmaArrayType & deltaSigma ) const
+{
+  SigmaArrayType sigma, finerSigma;
+  this->GetSigma( level, sigma );
+  this->GetSigma( level + 1, finerSigma );
+  for( unsigned int dim = 0; dim < ImageDimension; ++dim )
+  {
+    deltaSigma[ dim ] = std::sqrt( std::max( NumericTraits< ScalarRealType >::ZeroValue(),
+      sigma[ dim ] * sigma[ dim ] - finerSigma[ dim ] * finerSigma[ dim ] ) );
+  }
+} // end GetIncrementalSigma()
+
+
+/**
+ * ******************* CanComputeFromFinerLevel ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+bool
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::CanComputeFromFinerLevel( const unsigned int level ) const
+{
+  if( level + 1 >= this->m_NumberOfLevels || this->GetUseShrinkImageFilter() )
+  {
+    return false;
+  }
+
+  SigmaArrayType         sigma, finerSigma, deltaSigma;
+  RescaleFactorArrayType factors, finerFactors;
+  this->GetSigma( level, sigma );
+  this->GetSigma( level + 1, finerSigma );
+  this->GetIncrementalSigma( level, deltaSigma );
+  this->GetShrinkFactors( level, factors );
+  this->GetShrinkFactors( level + 1, finerFactors );
+
+  // Only worth it if this level is rescaled
+  if( this->AreRescaleFactorsAllOnes( factors ) ) { return false; }
+
+  const SpacingType & inputSpacing = this->GetInput()->GetSpacing();
+  for( unsigned int dim = 0; dim < ImageDimension; ++dim )
+  {
+    // The finer level should be less smoothed and less rescaled
+    if( sigma[ dim ] < finerSigma[ dim ] || factors[ dim ] < finerFactors[ dim ] )
+    {
+      return false;
+    }
+
+    // A rescaled finer level without smoothing is aliased
+    if( finerFactors[ dim ] > 1 && finerSigma[ dim ] <= 0.0 )
+    {
+      return false;
+    }
+
+    // The recursive Gaussian is inaccurate below one pixel of the finer level
+    const double finerSpacing = inputSpacing[ dim ] * finerFactors[ dim ];
+    if( deltaSigma[ dim ] > 0.0 && deltaSigma[ dim ] < finerSpacing )
+    {
+      return false;
+    }
+  }
+
+  return true;
+
+} // end CanComputeFromFinerLevel()
+
+
+/**
+ * ******************* ComputeFromFinerLevel ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+void
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::ComputeFromFinerLevel( const unsigned int level,
+  typename IncrementalSmootherType::Pointer & smoother,
+  const OutputImagePointer & outputPtr,
+  typename ImageToImageFilterSameTypes::Pointer & resampler )
+{
+  typedef IdentityTransform< TPrecisionType, OutputImageType::ImageDimension >    TransformType;
+  typedef ResampleImageFilter< OutputImageType, OutputImageType, TPrecisionType > ResamplerType;
+  typedef BSplineInterpolateImageFunction<
+    OutputImageType, TPrecisionType, TPrecisionType >                             InterpolatorType;
+
+  /** The finer level is an output of this filter. A copy that shares the
+   * pixel buffer, but has no source, is used as input for the pipeline.
+   */
+  OutputImagePointer finerImage = OutputImageType::New();
+  finerImage->Graft( this->GetOutput( level + 1 ) );
+
+  /** The additional smoothing, at least one finer pixel, see CanComputeFromFinerLevel(). */
+  SigmaArrayType deltaSigma;
+  this->GetIncrementalSigma( level, deltaSigma );
+
+  /** Setup the resampler to the grid of this level. The finer level is
+   * interpolated with a cubic B-spline: its grid is coarse, and linear
+   * interpolation halfway between its pixels would damp the image.
+   */
+  if( resampler.IsNull() )
+  {
+    typename ResamplerType::Pointer newResampler = ResamplerType::New();
+    newResampler->SetDefaultPixelValue( 0 );
+
+    typename InterpolatorType::Pointer interpolator = InterpolatorType::New();
+    interpolator->SetSplineOrder( 3 );
+    newResampler->SetInterpolator( interpolator );
+
+    typename TransformType::Pointer transform = TransformType::New();
+    newResampler->SetTransform( transform );
+
+    resampler = newResampler.GetPointer();
+  }
+  ResamplerType * bsplineResampler = dynamic_cast< ResamplerType * >( resampler.GetPointer() );
+  bsplineResampler->SetOutputParametersFromImage( outputPtr );
+
+  if( this->AreSigmasAllZeros( deltaSigma ) )
+  {
+    resampler->SetInput( finerImage );
+  }
+  else
+  {
+    if( smoother.IsNull() ) { smoother = IncrementalSmootherType::New(); }
+    smoother->SetInput( finerImage );
+    smoother->SetSigmaArray( deltaSigma );
+    resampler->SetInput( smoother->GetOutput() );
+  }
+
+  UpdateAndGraft< Self, ImageToImageFilterSameTypes, OutputImageType >(
+    this, resampler, outputPtr, level );
+
+} // end ComputeFromFinerLevel()
+
+
 /**
  * ******************* SetupShrinkerOrResampler ***********************
  */
@@ -719,6 +914,93 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
 } // end ComputeOnlyForCurrentLevel()
 
 
+/**
+ * ******************* ComputeLevelInBackground ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+void
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::ComputeLevelInBackground( const unsigned int level )
+{
+  /** Finish a previous background computation, its result is not used. */
+  if( this->m_BackgroundFuture.valid() )
+  {
+    this->m_BackgroundFuture.wait();
+  }
+
+  /** Setup a pyramid that computes only the requested level. The schedules
+   * are copied as they are now, i.e. including the default smoothing schedule.
+   */
+  Pointer pyramid = Self::New();
+  pyramid->SetNumberOfLevels( this->m_NumberOfLevels );
+  pyramid->SetRescaleSchedule( this->GetRescaleSchedule() );
+  pyramid->m_SmoothingSchedule        = this->m_SmoothingSchedule;
+  pyramid->m_SmoothingScheduleDefined = true;
+  pyramid->SetUseShrinkImageFilter( this->GetUseShrinkImageFilter() );
+  pyramid->SetComputeOnlyForCurrentLevel( true );
+  pyramid->SetCurrentLevel( level );
+  pyramid->SetNumberOfWorkUnits( this->GetNumberOfWorkUnits() );
+
+  /** The input is a copy that shares the pixel buffer, but has no source. */
+  InputImagePointer input = InputImageType::New();
+  input->Graft( this->GetInput() );
+  pyramid->SetInput( input );
+
+  this->m_BackgroundPyramid    = pyramid;
+  this->m_BackgroundLevel      = level;
+  this->m_BackgroundInput      = this->GetInput();
+  this->m_BackgroundInputMTime = this->GetInput()->GetMTime();
+  this->m_BackgroundFuture     = std::async( std::launch::async,
+    [ pyramid ]() { pyramid->UpdateLargestPossibleRegion(); } );
+
+} // end ComputeLevelInBackground()
+
+
+/**
+ * ******************* GraftLevelComputedInBackground ***********************
+ */
+
+template< class TInputImage, class TOutputImage, class TPrecisionType >
+bool
+GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionType >
+::GraftLevelComputedInBackground( const unsigned int level )
+{
+  if( !this->m_BackgroundFuture.valid() ) { return false; }
+
+  Pointer pyramid = this->m_BackgroundPyramid;
+  this->m_BackgroundPyramid = nullptr;
+
+  /** Wait for the result. When the background computation failed, the level
+   * is computed again, which reports the error if it persists.
+   */
+  try
+  {
+    this->m_BackgroundFuture.get();
+  }
+  catch( ... )
+  {
+    return false;
+  }
+
+  /** Check that the result still matches the input and settings of this filter. */
+  const InputImageType * input = this->GetInput();
+  if( level != this->m_BackgroundLevel
+    || input != this->m_BackgroundInput
+    || input->GetMTime() != this->m_BackgroundInputMTime
+    || pyramid->GetRescaleSchedule() != this->GetRescaleSchedule()
+    || pyramid->m_SmoothingSchedule != this->m_SmoothingSchedule
+    || pyramid->GetUseShrinkImageFilter() != this->GetUseShrinkImageFilter() )
+  {
+    return false;
+  }
+
+  this->GraftNthOutput( level, pyramid->GetOutput( level ) );
+  return true;
+
+} // end GraftLevelComputedInBackground()
+
+
 /**
  * ******************* GetDefaultSigma ***********************
  */
@@ -914,6 +1196,10 @@ GenericMultiResolutionPyramidImageFilter< TInputImage, TOutputImage, TPrecisionT
      << this->m_CurrentLevel << std::endl;
   os << indent << "ComputeOnlyForCurrentLevel: "
      << ( this->m_ComputeOnlyForCurrentLevel ? "true" : "false" ) << std::endl;
+  os << indent << "ComputeNextLevelInBackground: "
+     << ( this->m_ComputeNextLevelInBackground ? "true" : "false" ) << std::endl;
+  os << indent << "UseIncrementalSmoothing: "
+     << ( this->m_UseIncrementalSmoothing ? "true" : "false" ) << std::endl;
   os << indent << "SmoothingScheduleDefined: "
      << ( this->m_SmoothingScheduleDefined ? "true" : "false" ) << std::endl;
   os << indent << "Smoothing Schedule: ";
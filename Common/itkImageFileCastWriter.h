@@ -103,6 +103,11 @@ protected:
     localInputImage->Graft( static_cast< const ScalarInputImageType * >(inputImage) );
 
     caster->SetInput( localInputImage );
+
+    /** When the image is written in pieces, the input only contains
+     * the current piece, so only cast that region.
+     */
+    caster->GetOutput()->SetRequestedRegion( localInputImage->GetBufferedRegion() );
     caster->Update();
 
     /** return the pixel buffer of the casted image */
@@ -266,6 +266,12 @@ protected:
   /** Compute the size of the fixed region for each level of the pyramid. */
   virtual void PreparePyramids( void );
 
+  /** Let the pyramids know which level is requested next. Pyramids of type
+   * GenericMultiResolutionPyramidImageFilter that compute only the current
+   * level, then compute each level just-in-time and release the previous one.
+   */
+  virtual void SetCurrentLevelOfPyramids( const unsigned int level );
+
   /** Set the current level to be processed. */
   itkSetMacro( CurrentLevel, unsigned long );
 
@@ -41,6 +41,7 @@
 
 #include "itkMultiResolutionImageRegistrationMethod2.h"
 #include "itkRecursiveMultiResolutionPyramidImageFilter.h"
+#include "itkGenericMultiResolutionPyramidImageFilter.h"
 #include "itkContinuousIndex.h"
 #include "vnl/vnl_math.h"
 
@@ -120,6 +121,9 @@ MultiResolutionImageRegistrationMethod2< TFixedImage, TMovingImage >
     itkExceptionMacro( << "Interpolator is not present" );
   }
 
+  // Request the images of the current level
+  this->SetCurrentLevelOfPyramids( this->m_CurrentLevel );
+
   // Setup the metric
   this->m_Metric->SetMovingImage( this->m_MovingImagePyramid->GetOutput( this->m_CurrentLevel ) );
   this->m_Metric->SetFixedImage( this->m_FixedImagePyramid->GetOutput( this->m_CurrentLevel ) );
@@ -199,6 +203,9 @@ MultiResolutionImageRegistrationMethod2< TFixedImage, TMovingImage >
     itkExceptionMacro( << "Moving image pyramid is not present" );
   }
 
+  // Pyramids that compute per level only compute the first level here
+  this->SetCurrentLevelOfPyramids( 0 );
+
   // Setup the fixed image pyramid
   this->m_FixedImagePyramid->SetNumberOfLevels( this->m_NumberOfLevels );
   this->m_FixedImagePyramid->SetInput( this->m_FixedImage );
@@ -363,6 +370,36 @@ MultiResolutionImageRegistrationMethod2< TFixedImage, TMovingImage >
 } // end StartRegistration()
 
 
+/*
+ * Set the current level of the pyramids
+ */
+template< typename TFixedImage, typename TMovingImage >
+void
+MultiResolutionImageRegistrationMethod2< TFixedImage, TMovingImage >
+::SetCurrentLevelOfPyramids( const unsigned int level )
+{
+  typedef GenericMultiResolutionPyramidImageFilter<
+    FixedImageType, FixedImageType >   GenericFixedImagePyramidType;
+  typedef GenericMultiResolutionPyramidImageFilter<
+    MovingImageType, MovingImageType > GenericMovingImagePyramidType;
+
+  GenericFixedImagePyramidType * fixedPyramid
+    = dynamic_cast< GenericFixedImagePyramidType * >( this->m_FixedImagePyramid.GetPointer() );
+  if( fixedPyramid != nullptr )
+  {
+    fixedPyramid->SetCurrentLevel( level );
+  }
+
+  GenericMovingImagePyramidType * movingPyramid
+    = dynamic_cast< GenericMovingImagePyramidType * >( this->m_MovingImagePyramid.GetPointer() );
+  if( movingPyramid != nullptr )
+  {
+    movingPyramid->SetCurrentLevel( level );
+  }
+
+} // end SetCurrentLevelOfPyramids()
+
+
 /*
  * PrintSelf
  */
@@ -0,0 +1,152 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkThreadPoolJobs_h
+#define __itkThreadPoolJobs_h
+
+#include "itkThreadPool.h"
+
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <vector>
+
+namespace itk
+{
+
+/** \class ThreadPoolJobs
+ * \brief Executes a number of independent jobs on the persistent ITK thread pool.
+ *
+ * RunJobs( n, job ) calls job( i ) for i = 0, ..., n - 1. Job 0 is executed
+ * by the calling thread, which would otherwise just wait, the other jobs by
+ * the threads of the global itk::ThreadPool. RunJobs() returns when all jobs
+ * are finished. When jobs throw, the exception of the job with the lowest
+ * index is rethrown, so that the result does not depend on the timing.
+ *
+ * A job that waits for other jobs of the pool can deadlock when all threads of
+ * the pool are busy with such jobs. Therefore RunJobs() executes all jobs on the
+ * calling thread, one after the other, when it is called from one of its jobs,
+ * including job 0 on the calling thread. This is the case when, for example, an
+ * optimizer evaluates cost function clones with RunJobs(), and each metric
+ * evaluation distributes its samples with RunJobs() again. Job 0 then does its
+ * nested work itself, instead of queueing it behind the jobs of the other clones.
+ *
+ * \ingroup ITKSystemObjects
+ */
+
+class ThreadPoolJobs
+{
+public:
+
+  /** Returns true when called from a job that is executed via RunJobs(),
+   * either by a thread of the pool or, for job 0, by the calling thread.
+   */
+  static bool IsPoolJob( void )
+  {
+    return PoolJobFlag();
+  }
+
+
+  /** Execute job( i ) for i = 0, ..., numberOfJobs - 1, and wait until all are finished. */
+  template< class TJob >
+  static void RunJobs( const std::size_t numberOfJobs, const TJob & job )
+  {
+    std::vector< std::exception_ptr > errors( numberOfJobs );
+
+    /** Inside a job of the pool: execute everything here, see the class documentation. */
+    if( IsPoolJob() || numberOfJobs < 2 )
+    {
+      for( std::size_t i = 0; i < numberOfJobs; ++i )
+      {
+        RunJob( job, i, errors[ i ] );
+      }
+      RethrowFirstError( errors );
+      return;
+    }
+
+    /** Hand jobs 1, ..., n - 1 over to the persistent threads of the pool.
+     * The calling thread would otherwise just wait, so let it do job 0.
+     */
+    ThreadPool::Pointer                threadPool = ThreadPool::GetInstance();
+    std::vector< std::future< void > > futures;
+    futures.reserve( numberOfJobs - 1 );
+    for( std::size_t i = 1; i < numberOfJobs; ++i )
+    {
+      std::exception_ptr * error = &errors[ i ];
+      futures.push_back( threadPool->AddWork( [ &job, i, error ]()
+      {
+        PoolJobFlag() = true;
+        RunJob( job, i, *error );
+        PoolJobFlag() = false;
+      } ) );
+    }
+    PoolJobFlag() = true;
+    RunJob( job, 0, errors[ 0 ] );
+    PoolJobFlag() = false;
+
+    /** Wait for all jobs to finish, before anything goes out of scope. */
+    for( std::size_t i = 0; i < futures.size(); ++i )
+    {
+      futures[ i ].wait();
+    }
+    RethrowFirstError( errors );
+  }
+
+
+private:
+
+  /** The flag that tells whether the current thread executes a job of the pool. */
+  static bool & PoolJobFlag( void )
+  {
+    static thread_local bool poolJob = false;
+    return poolJob;
+  }
+
+
+  /** Execute a single job, and store its exception. */
+  template< class TJob >
+  static void RunJob( const TJob & job, const std::size_t i, std::exception_ptr & error )
+  {
+    try
+    {
+      job( i );
+    }
+    catch( ... )
+    {
+      error = std::current_exception();
+    }
+  }
+
+
+  /** Rethrow the exception of the job with the lowest index, if any. */
+  static void RethrowFirstError( const std::vector< std::exception_ptr > & errors )
+  {
+    for( std::size_t i = 0; i < errors.size(); ++i )
+    {
+      if( errors[ i ] )
+      {
+        std::rethrow_exception( errors[ i ] );
+      }
+    }
+  }
+
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkThreadPoolJobs_h
@@ -0,0 +1,210 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkTransformParametersBinaryFile_h
+#define __itkTransformParametersBinaryFile_h
+
+#include "itkByteSwapper.h"
+#include "itkIntTypes.h"
+#include "itkMacro.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace itk
+{
+
+/** \class TransformParametersBinaryFile
+ * \brief Writes and reads a transform parameter vector as a binary file.
+ *
+ * The file starts with a header of 24 bytes: the characters "ELXTPBIN", the
+ * format version (uint32), the number of bytes per value (uint32, 4 for float
+ * or 8 for double) and the number of values (uint64). The values follow
+ * directly. All numbers are little endian. Files without this header, as
+ * written by earlier versions of elastix, only contain the values, as doubles
+ * in the byte order of the machine.
+ *
+ * TParameters is a parameter array type with GetSize(), data_block() and
+ * begin()/end(), such as itk::OptimizerParameters< double >.
+ *
+ * \ingroup Transforms
+ */
+
+class TransformParametersBinaryFile
+{
+public:
+
+  /** The size of the header. */
+  static constexpr std::size_t HeaderSize = 24;
+
+  /** The format version that is written. */
+  static constexpr uint32_t Version = 1;
+
+  /** The first bytes of a file with header. */
+  static const char * GetMagic( void )
+  {
+    return "ELXTPBIN";
+  }
+
+
+  /** Write param to the file, as float or as double values.
+   * Throws an itk::ExceptionObject if the file can not be written.
+   */
+  template< class TParameters >
+  static void Write( const std::string & fileName, const TParameters & param,
+    const bool useFloat )
+  {
+    typedef typename TParameters::ValueType ValueType;
+
+    std::ofstream outfile( fileName.c_str(), std::ios::out | std::ios::binary );
+    if( !outfile.is_open() )
+    {
+      itkGenericExceptionMacro( << "ERROR: could not open " << fileName << " for writing." );
+    }
+
+    /** Write the header, in little endian byte order. */
+    const std::size_t nrP            = param.GetSize();
+    uint32_t          version        = Version;
+    uint32_t          bytesPerValue  = useFloat ? sizeof( float ) : sizeof( ValueType );
+    uint64_t          numberOfValues = nrP;
+    ByteSwapper< uint32_t >::SwapFromSystemToLittleEndian( &version );
+    ByteSwapper< uint32_t >::SwapFromSystemToLittleEndian( &bytesPerValue );
+    ByteSwapper< uint64_t >::SwapFromSystemToLittleEndian( &numberOfValues );
+
+    outfile.write( GetMagic(), MagicSize );
+    outfile.write( reinterpret_cast< const char * >( &version ), sizeof( version ) );
+    outfile.write( reinterpret_cast< const char * >( &bytesPerValue ), sizeof( bytesPerValue ) );
+    outfile.write( reinterpret_cast< const char * >( &numberOfValues ), sizeof( numberOfValues ) );
+
+    /** Write the values. A copy is only needed to convert or swap them. */
+    if( useFloat )
+    {
+      std::vector< float > values( param.begin(), param.end() );
+      ByteSwapper< float >::SwapRangeFromSystemToLittleEndian( values.data(), nrP );
+      outfile.write( reinterpret_cast< const char * >( values.data() ), sizeof( float ) * nrP );
+    }
+    else if( ByteSwapper< ValueType >::SystemIsBigEndian() )
+    {
+      std::vector< ValueType > values( param.begin(), param.end() );
+      ByteSwapper< ValueType >::SwapRangeFromSystemToLittleEndian( values.data(), nrP );
+      outfile.write( reinterpret_cast< const char * >( values.data() ), sizeof( ValueType ) * nrP );
+    }
+    else
+    {
+      outfile.write( reinterpret_cast< const char * >( param.data_block() ), sizeof( ValueType ) * nrP );
+    }
+
+    if( !outfile )
+    {
+      itkGenericExceptionMacro( << "ERROR: could not write the transform parameters to " << fileName );
+    }
+  }
+
+
+  /** Read the file into param, which should already have the expected size.
+   * Returns the number of values in the file; param is only filled when that
+   * equals the size of param. Throws an itk::ExceptionObject if the file can
+   * not be opened, or if its header is invalid.
+   */
+  template< class TParameters >
+  static std::size_t Read( const std::string & fileName, TParameters & param )
+  {
+    typedef typename TParameters::ValueType ValueType;
+
+    std::ifstream infile( fileName.c_str(), std::ios::in | std::ios::binary );
+    if( !infile.is_open() )
+    {
+      itkGenericExceptionMacro( << "ERROR: could not open the binary transform parameter file "
+                                << fileName );
+    }
+
+    /** Files without header only contain the values, as ValueType. */
+    const std::size_t nrP = param.GetSize();
+    char              magic[ MagicSize ];
+    infile.read( magic, MagicSize );
+    if( infile.gcount() != static_cast< std::streamsize >( MagicSize )
+      || std::memcmp( magic, GetMagic(), MagicSize ) != 0 )
+    {
+      infile.clear();
+      infile.seekg( 0 );
+      infile.read( reinterpret_cast< char * >( param.data_block() ), sizeof( ValueType ) * nrP );
+      return infile.gcount() / sizeof( ValueType );
+    }
+
+    /** Read the header. */
+    uint32_t version        = 0;
+    uint32_t bytesPerValue  = 0;
+    uint64_t numberOfValues = 0;
+    infile.read( reinterpret_cast< char * >( &version ), sizeof( version ) );
+    infile.read( reinterpret_cast< char * >( &bytesPerValue ), sizeof( bytesPerValue ) );
+    infile.read( reinterpret_cast< char * >( &numberOfValues ), sizeof( numberOfValues ) );
+    ByteSwapper< uint32_t >::SwapFromSystemToLittleEndian( &version );
+    ByteSwapper< uint32_t >::SwapFromSystemToLittleEndian( &bytesPerValue );
+    ByteSwapper< uint64_t >::SwapFromSystemToLittleEndian( &numberOfValues );
+
+    if( !infile || version != Version
+      || ( bytesPerValue != sizeof( float ) && bytesPerValue != sizeof( double ) ) )
+    {
+      itkGenericExceptionMacro( << "ERROR: invalid header in the binary transform parameter file "
+                                << fileName );
+    }
+
+    /** Let the caller report a mismatch in the number of parameters. */
+    if( numberOfValues != nrP )
+    {
+      return static_cast< std::size_t >( numberOfValues );
+    }
+
+    /** Read the values, directly into param if the value type matches. */
+    if( bytesPerValue == sizeof( ValueType ) )
+    {
+      infile.read( reinterpret_cast< char * >( param.data_block() ), sizeof( ValueType ) * nrP );
+      ByteSwapper< ValueType >::SwapRangeFromSystemToLittleEndian( param.data_block(), nrP );
+    }
+    else if( bytesPerValue == sizeof( float ) )
+    {
+      std::vector< float > values( nrP );
+      infile.read( reinterpret_cast< char * >( values.data() ), sizeof( float ) * nrP );
+      ByteSwapper< float >::SwapRangeFromSystemToLittleEndian( values.data(), nrP );
+      std::copy( values.begin(), values.end(), param.begin() );
+    }
+    else
+    {
+      std::vector< double > values( nrP );
+      infile.read( reinterpret_cast< char * >( values.data() ), sizeof( double ) * nrP );
+      ByteSwapper< double >::SwapRangeFromSystemToLittleEndian( values.data(), nrP );
+      std::copy( values.begin(), values.end(), param.begin() );
+    }
+
+    return infile.gcount() / bytesPerValue;
+  }
+
+
+private:
+
+  /** The number of characters of the magic string, without the terminating zero. */
+  static constexpr std::size_t MagicSize = 8;
+
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkTransformParametersBinaryFile_h
@@ -21,6 +21,7 @@
 
 #include "itkMeshFileReaderBase.h"
 
+#include <cstdint>
 #include <fstream>
 
 namespace itk
@@ -40,8 +41,38 @@ namespace itk
  *
  * The second word in the text file represents the number of points that
  * should be read.
+ *
+ * Large point sets can also be given in a binary format, which avoids the
+ * text parsing. A binary point file starts with the 8 characters "ELXPOINT",
+ * followed by the header fields of a TransformixBinaryPointFileHeader, and
+ * the coordinates of all points as doubles: x0 y0 z0 x1 y1 z1 etc. All
+ * numbers are little endian. The reader recognizes the format by the first 8
+ * characters, so the file extension does not matter.
  **/
 
+/** \struct TransformixBinaryPointFileHeader
+ *
+ * \brief The header of a binary transformix point file.
+ *
+ * Written directly after the 8 characters "ELXPOINT": the fields in the order
+ * of declaration, 16 bytes in total, little endian.
+ */
+
+struct TransformixBinaryPointFileHeader
+{
+  /** The 8 characters at the start of a binary point file. */
+  static const char * GetMagic( void ) { return "ELXPOINT"; }
+
+  /** The dimension of the points. */
+  uint32_t m_Dimension;
+
+  /** 1 if the points are image indices, 0 if they are world coordinates. */
+  uint32_t m_PointsAreIndices;
+
+  /** The number of points. */
+  uint64_t m_NumberOfPoints;
+};
+
 template< class TOutputMesh >
 class TransformixInputPointFileReader : public MeshFileReaderBase< TOutputMesh >
 {
@@ -82,6 +113,9 @@ public:
    */
   itkGetConstMacro( NumberOfPoints, unsigned long );
 
+  /** Get whether the file is a binary point file, see TransformixBinaryPointFileHeader. */
+  itkGetConstMacro( IsBinaryFile, bool );
+
   /** Prepare the allocation of the output mesh during the first back
    * propagation of the pipeline. Updates the PointsAreIndices and NumberOfPoints.
    */
@@ -97,6 +131,7 @@ protected:
 
   unsigned long m_NumberOfPoints;
   bool          m_PointsAreIndices;
+  bool          m_IsBinaryFile;
 
   std::ifstream m_Reader;
 
@@ -20,6 +20,10 @@
 #define __itkTransformixInputPointFileReader_hxx
 
 #include "itkTransformixInputPointFileReader.h"
+#include "itkByteSwapper.h"
+
+#include <algorithm>
+#include <vector>
 
 namespace itk
 {
@@ -34,6 +38,7 @@ TransformixInputPointFileReader< TOutputMesh >
 {
   this->m_NumberOfPoints   = 0;
   this->m_PointsAreIndices = false;
+  this->m_IsBinaryFile     = false;
 } // end constructor
 
 
@@ -69,7 +74,40 @@ TransformixInputPointFileReader< TOutputMesh >
   {
     this->m_Reader.close();
   }
-  this->m_Reader.open( this->m_FileName.c_str() );
+  this->m_Reader.open( this->m_FileName.c_str(), std::ios::in | std::ios::binary );
+
+  /** Check for a binary point file. */
+  const std::string magic = TransformixBinaryPointFileHeader::GetMagic();
+  char              firstCharacters[ 8 ] = { 0 };
+  this->m_Reader.read( firstCharacters, 8 );
+  this->m_IsBinaryFile = this->m_Reader.gcount() == 8
+    && magic.compare( 0, 8, firstCharacters, 8 ) == 0;
+  if( this->m_IsBinaryFile )
+  {
+    TransformixBinaryPointFileHeader header;
+    this->m_Reader.read( reinterpret_cast< char * >( &header ), sizeof( header ) );
+    ByteSwapper< uint32_t >::SwapFromSystemToLittleEndian( &header.m_Dimension );
+    ByteSwapper< uint32_t >::SwapFromSystemToLittleEndian( &header.m_PointsAreIndices );
+    ByteSwapper< uint64_t >::SwapFromSystemToLittleEndian( &header.m_NumberOfPoints );
+    if( !this->m_Reader || header.m_Dimension != OutputMeshType::PointDimension )
+    {
+      std::ostringstream msg;
+      msg << "The binary point file has an invalid header, or the dimension "
+          << "of the points does not match. " << std::endl
+          << "Filename: " << this->m_FileName << std::endl;
+      MeshFileReaderException e( __FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION );
+      throw e;
+    }
+    this->m_PointsAreIndices = header.m_PointsAreIndices != 0;
+    this->m_NumberOfPoints   = static_cast< unsigned long >( header.m_NumberOfPoints );
+
+    /** Leave the file open for the generate data method */
+    return;
+  }
+
+  /** A text file: start reading from the beginning again. */
+  this->m_Reader.clear();
+  this->m_Reader.seekg( 0 );
 
   /** Read the first entry */
   std::string indexOrPoint;
@@ -118,7 +156,39 @@ TransformixInputPointFileReader< TOutputMesh >
   PointsContainerPointer points = PointsContainerType::New();
 
   /** Read the file */
-  if( this->m_Reader.is_open() )
+  if( this->m_Reader.is_open() && this->m_IsBinaryFile )
+  {
+    /** Read the coordinates in blocks, to limit the size of the buffer. */
+    const unsigned long   blockSize = 65536;
+    std::vector< double > buffer( blockSize * dimension );
+    points->Reserve( this->m_NumberOfPoints );
+    for( unsigned long first = 0; first < this->m_NumberOfPoints; first += blockSize )
+    {
+      const unsigned long n = std::min( blockSize, this->m_NumberOfPoints - first );
+      this->m_Reader.read( reinterpret_cast< char * >( &buffer[ 0 ] ),
+        n * dimension * sizeof( double ) );
+      if( !this->m_Reader )
+      {
+        std::ostringstream msg;
+        msg << "The file is not large enough. "
+            << std::endl << "Filename: " << this->m_FileName
+            << std::endl;
+        MeshFileReaderException e( __FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION );
+        throw e;
+      }
+      ByteSwapper< double >::SwapRangeFromSystemToLittleEndian( &buffer[ 0 ], n * dimension );
+      for( unsigned long i = 0; i < n; ++i )
+      {
+        PointType point;
+        for( unsigned int j = 0; j < dimension; j++ )
+        {
+          point[ j ] = buffer[ i * dimension + j ];
+        }
+        points->SetElement( first + i, point );
+      }
+    }
+  }
+  else if( this->m_Reader.is_open() )
   {
     for( unsigned int i = 0; i < this->m_NumberOfPoints; ++i )
     {
@@ -61,6 +61,19 @@ namespace elastix
  *    at once, or per resolution. Latter saves memory.\n
  *    example: <tt>(ComputePyramidImagesPerResolution "true")</tt>\n
  *    Default false.
+ * \parameter ComputePyramidImagesInBackground: Flag to specify if the pyramid images of the
+ *    next resolution are computed in a background thread, while the current resolution is
+ *    registered. Only used when ComputePyramidImagesPerResolution is "true".\n
+ *    example: <tt>(ComputePyramidImagesInBackground "true")</tt>\n
+ *    Default false.
+ * \parameter ImagePyramidUseIncrementalSmoothing: Flag to specify if the coarser resolution
+ *    levels are computed from the finer levels, which only requires the additional smoothing
+ *    on a smaller image. Results differ slightly from the default. Not used with
+ *    ComputePyramidImagesPerResolution "true" or with the ShrinkingImageFilter. A level is
+ *    only computed this way if its additional smoothing is at least one voxel of the finer
+ *    level, which requires a smoothing schedule that smooths more than the default.\n
+ *    example: <tt>(ImagePyramidUseIncrementalSmoothing "true")</tt>\n
+ *    Default false.
  * \parameter ImagePyramidUseShrinkImageFilter: Flag to specify if the ShrinkingImageFilter is used
  *    for rescaling the image, or the ResampleImageFilter. Skrinker is faster.\n
  *    example: <tt>(ImagePyramidUseShrinkImageFilter "true")</tt>\n
@@ -129,6 +142,12 @@ public:
   /** Update the current resolution level. */
   void BeforeEachResolution( void ) override;
 
+  /** Add the smoothing schedule and the other settings to the key that identifies
+   * the pyramid images in the FixedImageDataCache. Returns an empty string when
+   * the pyramid images are computed per resolution, which are not cached.
+   */
+  std::string GetPyramidImagesCacheKey( void ) const override;
+
 protected:
 
   /** The constructor. */
@@ -136,6 +155,11 @@ protected:
   /** The destructor. */
   ~FixedGenericPyramid() override {}
 
+  /** Generate the pyramid images, or reuse those of a previous registration,
+   * see the parameter CacheFixedImageData.
+   */
+  void GenerateData( void ) override;
+
 private:
 
   /** The private constructor. */
@@ -144,6 +144,12 @@ FixedGenericPyramid< TElastix >
     "ImagePyramidUseShrinkImageFilter", 0, false );
   this->SetUseShrinkImageFilter( useShrinkImageFilter );
 
+  /** Compute the coarser levels incrementally from the finer levels. */
+  bool useIncrementalSmoothing = false;
+  this->m_Configuration->ReadParameter( useIncrementalSmoothing,
+    "ImagePyramidUseIncrementalSmoothing", 0, false );
+  this->SetUseIncrementalSmoothing( useIncrementalSmoothing );
+
   /** Decide whether or not to compute the pyramid images only for the current
    * resolution. Setting the option to true saves memory, since only one level
    * of the pyramid gets allocated per resolution.
@@ -153,6 +159,14 @@ FixedGenericPyramid< TElastix >
     "ComputePyramidImagesPerResolution", 0, false );
   this->SetComputeOnlyForCurrentLevel( computeThisResolution );
 
+  /** Decide whether or not to compute the pyramid images of the next resolution
+   * in the background, while the current resolution is registered.
+   */
+  bool computeInBackground = false;
+  this->m_Configuration->ReadParameter( computeInBackground,
+    "ComputePyramidImagesInBackground", 0, false );
+  this->SetComputeNextLevelInBackground( computeInBackground );
+
 } // end SetFixedSchedule()
 
 
@@ -177,6 +191,48 @@ FixedGenericPyramid< TElastix >
 } // end BeforeEachResolution()
 
 
+/**
+ * ******************* GetPyramidImagesCacheKey ***********************
+ */
+
+template< class TElastix >
+std::string
+FixedGenericPyramid< TElastix >
+::GetPyramidImagesCacheKey( void ) const
+{
+  if( this->GetComputeOnlyForCurrentLevel() )
+  {
+    return std::string();
+  }
+
+  std::ostringstream key;
+  key << this->Superclass2::GetPyramidImagesCacheKey()
+      << " rescale schedule " << this->GetRescaleSchedule()
+      << " smoothing schedule " << this->GetSmoothingSchedule()
+      << " incremental smoothing " << this->GetUseIncrementalSmoothing();
+  return key.str();
+
+} // end GetPyramidImagesCacheKey()
+
+
+/**
+ * ******************* GenerateData ***********************
+ */
+
+template< class TElastix >
+void
+FixedGenericPyramid< TElastix >
+::GenerateData( void )
+{
+  if( !this->GraftCachedPyramidImages() )
+  {
+    this->Superclass1::GenerateData();
+    this->AddPyramidImagesToCache();
+  }
+
+} // end GenerateData()
+
+
 } // end namespace elastix
 
 #endif // end #ifndef __elxFixedGenericPyramid_hxx
@@ -21,6 +21,27 @@
 
 #include "elxFixedRecursivePyramid.h"
 
-//nothing
+namespace elastix
+{
+
+/**
+ * ******************* GenerateData ***********************
+ */
+
+template< class TElastix >
+void
+FixedRecursivePyramid< TElastix >
+::GenerateData( void )
+{
+  if( !this->GraftCachedPyramidImages() )
+  {
+    this->Superclass1::GenerateData();
+    this->AddPyramidImagesToCache();
+  }
+
+} // end GenerateData()
+
+
+} // end namespace elastix
 
 #endif //#ifndef __elxFixedRecursivePyramid_hxx
@@ -22,6 +22,26 @@
 #include "elxFixedShrinkingPyramid.h"
 
 namespace elastix
-{} // end namespace elastix
+{
+
+/**
+ * ******************* GenerateData ***********************
+ */
+
+template< class TElastix >
+void
+FixedShrinkingPyramid< TElastix >
+::GenerateData( void )
+{
+  if( !this->GraftCachedPyramidImages() )
+  {
+    this->Superclass1::GenerateData();
+    this->AddPyramidImagesToCache();
+  }
+
+} // end GenerateData()
+
+
+} // end namespace elastix
 
 #endif //#ifndef __elxFixedShrinkingPyramid_hxx
@@ -94,6 +94,11 @@ protected:
   /** The destructor. */
   ~FixedSmoothingPyramid() override {}
 
+  /** Generate the pyramid images, or reuse those of a previous registration,
+   * see the parameter CacheFixedImageData.
+   */
+  void GenerateData( void ) override;
+
 private:
 
   /** The private constructor. */
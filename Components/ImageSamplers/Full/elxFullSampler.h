@@ -105,6 +105,11 @@ protected:
   /** The destructor. */
   ~FullSampler() override {}
 
+  /** Select the samples, or reuse those of a previous registration,
+   * see the parameter CacheFixedImageData.
+   */
+  void GenerateData( void ) override;
+
 private:
 
   /** The private constructor. */
@@ -24,7 +24,23 @@
 namespace elastix
 {
 
-//nothing
+/**
+ * ******************* GenerateData ******************
+ */
+
+template< class TElastix >
+void
+FullSampler< TElastix >
+::GenerateData( void )
+{
+  if( !this->CopyCachedSamples() )
+  {
+    this->Superclass1::GenerateData();
+    this->AddSamplesToCache();
+  }
+
+} // end GenerateData()
+
 
 } // end namespace elastix
 
@@ -110,6 +110,12 @@ public:
    */
   void BeforeEachResolution( void ) override;
 
+  /** Add the sample grid spacing to the key that identifies the samples in the
+   * FixedImageDataCache. Returns an empty string when the grid spacing is computed
+   * from a requested number of samples, which is not cached.
+   */
+  std::string GetSamplesCacheKey( void ) const override;
+
 protected:
 
   /** The constructor. */
@@ -117,6 +123,11 @@ protected:
   /** The destructor. */
   ~GridSampler() override {}
 
+  /** Select the samples, or reuse those of a previous registration,
+   * see the parameter CacheFixedImageData.
+   */
+  void GenerateData( void ) override;
+
 private:
 
   /** The private constructor. */
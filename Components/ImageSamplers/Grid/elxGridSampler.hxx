@@ -53,6 +53,46 @@ GridSampler< TElastix >
 } // end BeforeEachResolution()
 
 
+/**
+ * ******************* GetSamplesCacheKey ******************
+ */
+
+template< class TElastix >
+std::string
+GridSampler< TElastix >
+::GetSamplesCacheKey( void ) const
+{
+  if( this->m_RequestedNumberOfSamples != 0 )
+  {
+    return std::string();
+  }
+
+  std::ostringstream key;
+  key << this->Superclass2::GetSamplesCacheKey()
+      << " grid spacing " << this->GetSampleGridSpacing();
+  return key.str();
+
+} // end GetSamplesCacheKey()
+
+
+/**
+ * ******************* GenerateData ******************
+ */
+
+template< class TElastix >
+void
+GridSampler< TElastix >
+::GenerateData( void )
+{
+  if( !this->CopyCachedSamples() )
+  {
+    this->Superclass1::GenerateData();
+    this->AddSamplesToCache();
+  }
+
+} // end GenerateData()
+
+
 } // end namespace elastix
 
 #endif // end #ifndef __elxGridSampler_hxx
@@ -480,16 +480,6 @@ AdvancedKappaStatisticImageToImageMetric< TFixedImage, TMovingImage >
   ImageSampleContainerPointer sampleContainer     = this->GetImageSampler()->GetOutput();
   const unsigned long         sampleContainerSize = sampleContainer->Size();
 
-  /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads
-    = static_cast< unsigned long >( std::ceil( static_cast< double >( sampleContainerSize )
-    / static_cast< double >( Self::GetNumberOfWorkUnits() ) ) );
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
-  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
-  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
-
   /** Some variables. */
   RealType             movingImageValue;
   MovingImagePointType mappedPoint;
@@ -498,70 +488,77 @@ AdvancedKappaStatisticImageToImageMetric< TFixedImage, TMovingImage >
   std::size_t          intersection          = 0;
   unsigned long        numberOfPixelsCounted = 0;
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend   = sampleContainer->Begin();
-  fbegin                                                 += (int)pos_begin;
-  fend                                                   += (int)pos_end;
-
-  /** Loop over the fixed image to calculate the kappa statistic. */
-  for( fiter = fbegin; fiter != fend; ++fiter )
+  /** Loop over the ranges of samples that are assigned to this thread. */
+  unsigned long pos_begin = 0;
+  unsigned long pos_end   = 0;
+  while( this->GetNextSampleRange( threadId, sampleContainerSize, pos_begin, pos_end ) )
   {
-    /** Read fixed coordinates. */
-    const FixedImagePointType & fixedPoint = ( *fiter ).Value().m_ImageCoordinates;
+    /** Create iterator over the sample container. */
+    typename ImageSampleContainerType::ConstIterator fiter;
+    typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
+    typename ImageSampleContainerType::ConstIterator fend   = sampleContainer->Begin();
+    fbegin                                                 += (int)pos_begin;
+    fend                                                   += (int)pos_end;
+
+    /** Loop over the fixed image to calculate the kappa statistic. */
+    for( fiter = fbegin; fiter != fend; ++fiter )
+    {
+      /** Read fixed coordinates. */
+      const FixedImagePointType & fixedPoint = ( *fiter ).Value().m_ImageCoordinates;
 
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+      /** Transform point and check if it is inside the B-spline support region. */
+      bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
 
-    /** Check if point is inside moving mask. */
-    if( sampleOk )
-    {
-      sampleOk = this->IsInsideMovingMask( mappedPoint );
-    }
+      /** Check if point is inside moving mask. */
+      if( sampleOk )
+      {
+        sampleOk = this->IsInsideMovingMask( mappedPoint );
+      }
 
-    /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
-     * the point is inside the moving image buffer.
-     */
-    MovingImageDerivativeType movingImageDerivative;
-    if( sampleOk )
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(
-        mappedPoint, movingImageValue, &movingImageDerivative );
-    }
+      /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
+       * the point is inside the moving image buffer.
+       */
+      MovingImageDerivativeType movingImageDerivative;
+      if( sampleOk )
+      {
+        sampleOk = this->EvaluateMovingImageValueAndDerivative(
+          mappedPoint, movingImageValue, &movingImageDerivative );
+      }
 
-    /** Do the actual calculation of the metric value. */
-    if( sampleOk )
-    {
-      numberOfPixelsCounted++;
+      /** Do the actual calculation of the metric value. */
+      if( sampleOk )
+      {
+        numberOfPixelsCounted++;
 
-      /** Get the fixed image value. */
-      const RealType & fixedImageValue
-        = static_cast< RealType >( ( *fiter ).Value().m_ImageValue );
+        /** Get the fixed image value. */
+        const RealType & fixedImageValue
+          = static_cast< RealType >( ( *fiter ).Value().m_ImageValue );
 
 #if 0
-      /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
+        /** Get the TransformJacobian dT/dmu. */
+        this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
 
-      /** Compute the inner products (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
+        /** Compute the inner products (dM/dx)^T (dT/dmu). */
+        this->EvaluateTransformJacobianInnerProduct(
+          jacobian, movingImageDerivative, imageJacobian );
 #else
-      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
-      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji );
+        /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
+        this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
+          fixedPoint, movingImageDerivative, imageJacobian, nzji );
 #endif
 
-      /** Compute this pixel's contribution to the measure and derivatives. */
-      this->UpdateValueAndDerivativeTerms(
-        fixedImageValue, movingImageValue,
-        fixedForegroundArea, movingForegroundArea, intersection,
-        imageJacobian, nzji,
-        vecSum1, vecSum2 );
+        /** Compute this pixel's contribution to the measure and derivatives. */
+        this->UpdateValueAndDerivativeTerms(
+          fixedImageValue, movingImageValue,
+          fixedForegroundArea, movingForegroundArea, intersection,
+          imageJacobian, nzji,
+          vecSum1, vecSum2 );
 
-    } // end if sampleOk
+      } // end if sampleOk
 
-  } // end for loop over the image sample container
+    } // end for loop over the image sample container
+
+  } // end while over the sample ranges
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
   this->m_KappaGetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = numberOfPixelsCounted;
@@ -648,8 +645,7 @@ AdvancedKappaStatisticImageToImageMetric< TFixedImage, TMovingImage >
     temp->st_Coefficient2      = tmp2;
     temp->st_DerivativePointer = derivative.begin();
 
-    this->m_Threader->SetSingleMethod( AccumulateDerivativesThreaderCallback, temp );
-    this->m_Threader->SingleMethodExecute();
+    this->ExecuteThreaderCallback( AccumulateDerivativesThreaderCallback, temp );
 
     delete temp;
   }
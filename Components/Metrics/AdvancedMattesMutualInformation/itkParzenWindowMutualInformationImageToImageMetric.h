@@ -157,6 +157,10 @@ public:
   itkGetConstMacro( UseJacobianPreconditioning, bool );
   itkSetMacro( UseJacobianPreconditioning, bool );
 
+  /** Create an independent copy of this metric, with the same settings,
+   * see AdvancedImageToImageMetric::CreateClone(). */
+  typename Superclass::AdvancedMetricPointer CreateClone( void ) const override;
+
 protected:
 
   /** The constructor. */
@@ -169,6 +173,7 @@ protected:
 
   /** Typedefs inherited from superclass */
   typedef typename Superclass::FixedImageIndexType                 FixedImageIndexType;
+  typedef typename Superclass::ScopedHotPathTimer                  ScopedHotPathTimer;
   typedef typename Superclass::FixedImageIndexValueType            FixedImageIndexValueType;
   typedef typename Superclass::MovingImageIndexType                MovingImageIndexType;
   typedef typename Superclass::FixedImagePointType                 FixedImagePointType;
@@ -192,6 +197,9 @@ protected:
   typedef typename Superclass::ParzenValueContainerType            ParzenValueContainerType;
   typedef typename Superclass::KernelFunctionType                  KernelFunctionType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::ImageSampleType                     ImageSampleType;
+  typedef typename Superclass::TransformMovingImageGradientType    TransformMovingImageGradientType;
+  typedef typename Superclass::FloatImageJacobianType              FloatImageJacobianType;
 
   /**  Get the value and analytic derivative.
    * Called by GetValueAndDerivative if UseFiniteDifferenceDerivative == false.
@@ -246,6 +254,12 @@ protected:
   /** Multi-threaded versions of the ComputePDF function. */
   inline void ThreadedComputeDerivativeLowMemory( ThreadIdType threadId );
 
+  /** Batched version of ThreadedComputeDerivativeLowMemory(), storing the
+   * image Jacobians of each batch of samples as TImageJacobian.
+   */
+  template< class TImageJacobian >
+  void ThreadedComputeDerivativeLowMemoryInBatches( ThreadIdType threadId );
+
   /** Single-threadedly accumulate results. */
   inline void AfterThreadedComputeDerivativeLowMemory(
     DerivativeType & derivative ) const;
@@ -276,11 +290,14 @@ private:
 
   void ComputeDerivativeLowMemory( DerivativeType & derivative ) const;
 
-  /** Helper function to update the derivative for the low memory variant. */
+  /** Helper function to update the derivative for the low memory variant.
+   * The image Jacobian may be stored in single precision, see SetUseMixedPrecision().
+   */
+  template< class TImageJacobian >
   void UpdateDerivativeLowMemory(
     const RealType & fixedImageValue,
     const RealType & movingImageValue,
-    const DerivativeType & imageJacobian,
+    const TImageJacobian & imageJacobian,
     const NonZeroJacobianIndicesType & nzji,
     DerivativeType & derivative ) const;
 
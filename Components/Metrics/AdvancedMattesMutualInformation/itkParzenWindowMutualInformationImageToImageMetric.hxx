@@ -26,6 +26,8 @@
 #include "itkMatrix.h"
 #include "vnl/vnl_inverse.h"
 #include "vnl/vnl_det.h"
+#include <algorithm>
+#include <vector>
 
 #ifdef ELASTIX_USE_OPENMP
 #include <omp.h>
@@ -138,6 +140,29 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
 } // end GetValue()
 
 
+/**
+ * ********************* CreateClone ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >::Superclass::AdvancedMetricPointer
+ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::CreateClone( void ) const
+{
+  Pointer clone = Self::New();
+  this->CopyToClone( clone );
+
+  clone->m_UseJacobianPreconditioning = this->m_UseJacobianPreconditioning;
+
+  if( !this->InitializeClone( clone ) )
+  {
+    return nullptr;
+  }
+  return clone.GetPointer();
+
+} // end CreateClone()
+
+
 /**
  * ******************** GetValueAndAnalyticDerivative *******************
  */
@@ -426,9 +451,13 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
   }
 
   /** Launch multi-threading derivative computation. */
-  this->LaunchComputeDerivativeLowMemoryThreaderCallback();
+  {
+    ScopedHotPathTimer timer( this, Self::ThreadedTimer );
+    this->LaunchComputeDerivativeLowMemoryThreaderCallback();
+  }
 
   /** Gather the results from all threads. */
+  ScopedHotPathTimer timer( this, Self::AccumulateTimer );
   this->AfterThreadedComputeDerivativeLowMemory( derivative );
 
 } // end ComputeDerivativeLowMemory()
@@ -443,10 +472,47 @@ void
 ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
 ::ThreadedComputeDerivativeLowMemory( ThreadIdType threadId )
 {
-  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
-  const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
-  NonZeroJacobianIndicesType   nzji  = NonZeroJacobianIndicesType( nnzji );
-  DerivativeType               imageJacobian( nzji.size() );
+  if( this->m_UseMixedPrecision )
+  {
+    this->ThreadedComputeDerivativeLowMemoryInBatches< FloatImageJacobianType >( threadId );
+  }
+  else
+  {
+    this->ThreadedComputeDerivativeLowMemoryInBatches< DerivativeType >( threadId );
+  }
+
+} // end ThreadedComputeDerivativeLowMemory()
+
+
+/**
+ * ******************* ThreadedComputeDerivativeLowMemoryInBatches *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+template< class TImageJacobian >
+void
+ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedComputeDerivativeLowMemoryInBatches( ThreadIdType threadId )
+{
+  /** The samples are processed in batches, like in the threaded functions of
+   * AdvancedMeanSquaresImageToImageMetric, such that the transform is called
+   * once per batch instead of once per sample.
+   */
+  const unsigned long batchSize        = 64;
+  const bool          useSampleWeights = this->m_SampleWeightsCacheIsAvailable;
+
+  /** Initialize the per batch buffers. The arrays that store dM(x)/dmu and the
+   * sparse Jacobian indices are allocated once, for each sample in a batch.
+   */
+  const NumberOfParametersType                    nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  std::vector< SizeValueType >                    sampleIndices( batchSize );
+  std::vector< FixedImagePointType >              fixedPoints( batchSize );
+  std::vector< RealType >                         fixedImageValues( batchSize );
+  std::vector< MovingImagePointType >             mappedPoints( batchSize );
+  std::vector< RealType >                         movingImageValues( batchSize );
+  std::vector< TransformMovingImageGradientType > movingImageDerivatives( batchSize );
+  std::vector< TImageJacobian >                   imageJacobians( batchSize, TImageJacobian( nnzji ) );
+  std::vector< NonZeroJacobianIndicesType >       nzjis( batchSize, NonZeroJacobianIndicesType( nnzji ) );
 
   /** Get a handle to the pre-allocated derivative for the current thread.
    * The initialization is performed at the beginning of each resolution in
@@ -456,113 +522,117 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
   DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Derivative;
 
   /** Declare and allocate arrays for Jacobian preconditioning. */
-  DerivativeType jacobianPreconditioner, preconditioningDivisor;
+  DerivativeType             jacobianPreconditioner, preconditioningDivisor;
+  TransformJacobianType      jacobian;
+  NonZeroJacobianIndicesType nzji;
   if( this->GetUseJacobianPreconditioning() )
   {
-    jacobianPreconditioner = DerivativeType( nzji.size() );
+    jacobianPreconditioner = DerivativeType( nnzji );
     preconditioningDivisor = DerivativeType( this->GetNumberOfParameters() );
     preconditioningDivisor.Fill( 0.0 );
+    nzji = NonZeroJacobianIndicesType( nnzji );
   }
 
   /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer     = this->GetImageSampler()->GetOutput();
   const unsigned long         sampleContainerSize = sampleContainer->Size();
 
-  /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads
-    = static_cast< unsigned long >( std::ceil( static_cast< double >( sampleContainerSize )
-    / static_cast< double >( Self::GetNumberOfWorkUnits() ) ) );
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
-  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
-  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
-
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend   = sampleContainer->Begin();
-  fbegin                                                 += (int)pos_begin;
-  fend                                                   += (int)pos_end;
-
-  /** Loop over sample container and compute contribution of each sample to pdfs. */
-  for( fiter = fbegin; fiter != fend; ++fiter )
+  /** Loop over the ranges of samples that are assigned to this thread. */
+  unsigned long pos_begin = 0;
+  unsigned long pos_end   = 0;
+  while( this->GetNextSampleRange( threadId, sampleContainerSize, pos_begin, pos_end ) )
   {
-    /** Read fixed coordinates and create some variables. */
-    const FixedImagePointType & fixedPoint = ( *fiter ).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImageDerivativeType   movingImageDerivative;
-    MovingImagePointType        mappedPoint;
-
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
-
-    /** Check if the point is inside the moving mask. */
-    if( sampleOk )
+    /** Loop over the batches in this range. */
+    for( unsigned long batch_begin = pos_begin; batch_begin < pos_end; batch_begin += batchSize )
     {
-      sampleOk = this->IsInsideMovingMask( mappedPoint );
-    }
+      const unsigned long numberOfPoints = std::min( batchSize, pos_end - batch_begin );
 
-    /** Compute the moving image value, its derivative, and check
-     * if the point is inside the moving image buffer.
-     */
-    if( sampleOk )
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(
-        mappedPoint, movingImageValue, &movingImageDerivative );
-    }
+      /** Read fixed coordinates and values. */
+      for( unsigned long k = 0; k < numberOfPoints; ++k )
+      {
+        const ImageSampleType & sample = sampleContainer->ElementAt( batch_begin + k );
+        sampleIndices[ k ]    = batch_begin + k;
+        fixedPoints[ k ]      = sample.m_ImageCoordinates;
+        fixedImageValues[ k ] = static_cast< RealType >( sample.m_ImageValue );
+      }
 
-    if( sampleOk )
-    {
-      /** Get the fixed image value. */
-      RealType fixedImageValue = static_cast< RealType >( ( *fiter ).Value().m_ImageValue );
+      /** Transform all points of the batch. */
+      if( useSampleWeights )
+      {
+        this->m_AdvancedTransform->TransformSamples(
+          &sampleIndices[ 0 ], &fixedPoints[ 0 ], &mappedPoints[ 0 ], numberOfPoints );
+      }
+      else
+      {
+        this->m_AdvancedTransform->TransformPoints( &fixedPoints[ 0 ], &mappedPoints[ 0 ], numberOfPoints );
+      }
 
-      /** Make sure the values fall within the histogram range. */
-      fixedImageValue  = this->GetFixedImageLimiter()->Evaluate( fixedImageValue );
-      movingImageValue = this->GetMovingImageLimiter()
-        ->Evaluate( movingImageValue, movingImageDerivative );
+      /** Check if the points are inside the moving mask, and compute the moving
+       * image value M(T(x)) and derivative dM/dx. The values are limited to the
+       * histogram range, and the valid samples are moved to the front of the buffers.
+       */
+      unsigned long numberOfValidPoints = 0;
+      for( unsigned long k = 0; k < numberOfPoints; ++k )
+      {
+        RealType                  movingImageValue;
+        MovingImageDerivativeType movingImageDerivative;
 
-#if 0
-      /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
+        bool sampleOk = this->IsInsideMovingMask( mappedPoints[ k ] );
+        if( sampleOk )
+        {
+          sampleOk = this->EvaluateMovingImageValueAndDerivative(
+            mappedPoints[ k ], movingImageValue, &movingImageDerivative );
+        }
 
-      /** Compute the inner products (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
-#else
-      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
-      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji );
-#endif
+        if( sampleOk )
+        {
+          /** Make sure the values fall within the histogram range. */
+          movingImageValue = this->GetMovingImageLimiter()
+            ->Evaluate( movingImageValue, movingImageDerivative );
+
+          sampleIndices[ numberOfValidPoints ]     = sampleIndices[ k ];
+          fixedPoints[ numberOfValidPoints ]       = fixedPoints[ k ];
+          fixedImageValues[ numberOfValidPoints ]  = this->GetFixedImageLimiter()->Evaluate( fixedImageValues[ k ] );
+          movingImageValues[ numberOfValidPoints ] = movingImageValue;
+          for( unsigned int d = 0; d < MovingImageDimension; ++d )
+          {
+            movingImageDerivatives[ numberOfValidPoints ][ d ] = movingImageDerivative[ d ];
+          }
+          ++numberOfValidPoints;
+        }
+      }
 
-      /** If desired, apply the technique introduced by Tustison. */
-      TransformJacobianType jacobian;
-      if( this->GetUseJacobianPreconditioning() )
-      {
-        this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
+      /** Compute the inner products of the transform Jacobian dT/dmu and the
+       * moving image gradient dM/dx, for all valid samples of the batch.
+       */
+      this->EvaluateImageJacobians( useSampleWeights ? &sampleIndices[ 0 ] : 0,
+        &fixedPoints[ 0 ], &movingImageDerivatives[ 0 ],
+        &imageJacobians[ 0 ], &nzjis[ 0 ], numberOfValidPoints );
 
-        this->ComputeJacobianPreconditioner( jacobian, nzji,
-          jacobianPreconditioner, preconditioningDivisor );
-        DerivativeValueType * imjacit   = imageJacobian.begin();
-        DerivativeValueType * jacprecit = jacobianPreconditioner.begin();
-        for( unsigned int i = 0; i < nzji.size(); ++i )
+      for( unsigned long k = 0; k < numberOfValidPoints; ++k )
+      {
+        /** If desired, apply the technique introduced by Tustison. */
+        if( this->GetUseJacobianPreconditioning() )
         {
-          while( imjacit != imageJacobian.end() )
+          this->EvaluateTransformJacobian( fixedPoints[ k ], jacobian, nzji );
+
+          this->ComputeJacobianPreconditioner( jacobian, nzji,
+            jacobianPreconditioner, preconditioningDivisor );
+          for( unsigned int i = 0; i < imageJacobians[ k ].GetSize(); ++i )
           {
-            ( *imjacit ) *= ( *jacprecit );
-            ++imjacit;
-            ++jacprecit;
+            imageJacobians[ k ][ i ] *= jacobianPreconditioner[ i ];
           }
         }
+
+        /** Compute this sample's contribution to the joint distributions. */
+        this->UpdateDerivativeLowMemory(
+          fixedImageValues[ k ], movingImageValues[ k ], imageJacobians[ k ], nzjis[ k ],
+          derivative );
       }
 
-      /** Compute this sample's contribution to the joint distributions. */
-      this->UpdateDerivativeLowMemory(
-        fixedImageValue, movingImageValue, imageJacobian, nzji,
-        derivative );
+    } // end for loop over the batches
 
-    } // end sampleOk
-  } // end loop over sample container
+  } // end while over the sample ranges
 
   /** If desired, apply the technique introduced by Tustison. */
   if( this->GetUseJacobianPreconditioning() )
@@ -582,7 +652,7 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
     }
   }
 
-} // end ThreadedComputeDerivativeLowMemory()
+} // end ThreadedComputeDerivativeLowMemoryInBatches()
 
 
 /**
@@ -630,9 +700,8 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
     this->m_ThreaderMetricParameters.st_DerivativePointer   = derivative.begin();
     this->m_ThreaderMetricParameters.st_NormalizationFactor = 1.0;
 
-    this->m_Threader->SetSingleMethod( this->AccumulateDerivativesThreaderCallback,
+    this->ExecuteThreaderCallback( this->AccumulateDerivativesThreaderCallback,
       const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
-    this->m_Threader->SingleMethodExecute();
   }
 
 } // end AfterThreadedComputeDerivativeLowMemory()
@@ -669,14 +738,11 @@ void
 ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
 ::LaunchComputeDerivativeLowMemoryThreaderCallback( void ) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod( this->ComputeDerivativeLowMemoryThreaderCallback,
+  /** Launch. */
+  this->ExecuteThreaderCallback( this->ComputeDerivativeLowMemoryThreaderCallback,
     const_cast< void * >( static_cast< const void * >(
       &this->m_ParzenWindowMutualInformationThreaderParameters ) ) );
 
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
-
 } // end LaunchComputeDerivativeLowMemoryThreaderCallback()
 
 
@@ -762,12 +828,13 @@ ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
  */
 
 template< class TFixedImage, class TMovingImage >
+template< class TImageJacobian >
 void
 ParzenWindowMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
 ::UpdateDerivativeLowMemory(
   const RealType & fixedImageValue,
   const RealType & movingImageValue,
-  const DerivativeType & imageJacobian,
+  const TImageJacobian & imageJacobian,
   const NonZeroJacobianIndicesType & nzji,
   DerivativeType & derivative ) const
 {
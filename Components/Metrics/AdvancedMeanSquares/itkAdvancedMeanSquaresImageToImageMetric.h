@@ -87,6 +87,7 @@ public:
   typedef typename Superclass::TransformParametersType    TransformParametersType;
   typedef typename Superclass::TransformJacobianType      TransformJacobianType;
   typedef typename Superclass::NumberOfParametersType     NumberOfParametersType;
+  typedef typename Superclass::AdvancedTransformType      AdvancedTransformType;
   typedef typename Superclass::InterpolatorType           InterpolatorType;
   typedef typename Superclass::InterpolatorPointer        InterpolatorPointer;
   typedef typename Superclass::RealType                   RealType;
@@ -102,6 +103,7 @@ public:
   typedef typename Superclass::MeasureType                MeasureType;
   typedef typename Superclass::DerivativeType             DerivativeType;
   typedef typename Superclass::DerivativeValueType        DerivativeValueType;
+  typedef typename Superclass::AtomicDerivativeValueType  AtomicDerivativeValueType;
   typedef typename Superclass::ParametersType             ParametersType;
   typedef typename Superclass::FixedImagePixelType        FixedImagePixelType;
   typedef typename Superclass::MovingImageRegionType      MovingImageRegionType;
@@ -110,6 +112,7 @@ public:
   typedef typename Superclass::ImageSampleContainerType   ImageSampleContainerType;
   typedef typename
     Superclass::ImageSampleContainerPointer ImageSampleContainerPointer;
+  typedef typename Superclass::ImageSampleType            ImageSampleType;
   typedef typename Superclass::FixedImageLimiterType  FixedImageLimiterType;
   typedef typename Superclass::MovingImageLimiterType MovingImageLimiterType;
   typedef typename
@@ -171,6 +174,10 @@ public:
    * \li Estimate the normalization factor, if asked for.  */
   void Initialize( void ) override;
 
+  /** Create an independent copy of this metric, with the same settings,
+   * see AdvancedImageToImageMetric::CreateClone(). */
+  typename Superclass::AdvancedMetricPointer CreateClone( void ) const override;
+
   /** Set/Get whether to normalize the mean squares measure.
    * This divides the MeanSquares by a factor (range/10)^2,
    * where range represents the maximum gray value range of the
@@ -199,6 +206,7 @@ protected:
 
   /** Typedefs inherited from superclass */
   typedef typename Superclass::FixedImageIndexType                 FixedImageIndexType;
+  typedef typename Superclass::ScopedHotPathTimer                  ScopedHotPathTimer;
   typedef typename Superclass::FixedImageIndexValueType            FixedImageIndexValueType;
   typedef typename Superclass::MovingImageIndexType                MovingImageIndexType;
   typedef typename Superclass::FixedImagePointType                 FixedImagePointType;
@@ -208,6 +216,8 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::TransformMovingImageGradientType    TransformMovingImageGradientType;
+  typedef typename Superclass::FloatImageJacobianType              FloatImageJacobianType;
 
   /** Protected typedefs for SelfHessian */
   typedef SmoothingRecursiveGaussianImageFilter<
@@ -221,15 +231,31 @@ protected:
   double m_NormalizationFactor;
 
   /** Compute a pixel's contribution to the measure and derivatives;
-   * Called by GetValueAndDerivative(). */
+   * Called by GetValueAndDerivative(). The image Jacobian may be stored
+   * in single precision, see SetUseMixedPrecision(); the contribution is
+   * accumulated in double precision.
+   */
+  template< class TImageJacobian >
   void UpdateValueAndDerivativeTerms(
     const RealType fixedImageValue,
     const RealType movingImageValue,
-    const DerivativeType & imageJacobian,
+    const TImageJacobian & imageJacobian,
     const NonZeroJacobianIndicesType & nzji,
     MeasureType & measure,
     DerivativeType & deriv ) const;
 
+  /** Same as above, but atomically adds the contribution to the
+   * shared derivative, in the atomic derivative accumulation mode.
+   */
+  template< class TImageJacobian >
+  void UpdateValueAndDerivativeTerms(
+    const RealType fixedImageValue,
+    const RealType movingImageValue,
+    const TImageJacobian & imageJacobian,
+    const NonZeroJacobianIndicesType & nzji,
+    MeasureType & measure,
+    AtomicDerivativeValueType * deriv ) const;
+
   /** Compute a pixel's contribution to the SelfHessian;
    * Called by GetSelfHessian(). */
   void UpdateSelfHessianTerms(
@@ -246,6 +272,12 @@ protected:
   /** Get value and derivatives for each thread. */
   inline void ThreadedGetValueAndDerivative( ThreadIdType threadID ) override;
 
+  /** Get value and derivatives for each thread, storing the image Jacobians
+   * of each batch of samples as TImageJacobian.
+   */
+  template< class TImageJacobian >
+  void ThreadedGetValueAndDerivativeInBatches( ThreadIdType threadID );
+
   /** Gather the values and derivatives from all threads. */
   inline void AfterThreadedGetValueAndDerivative(
     MeasureType & value, DerivativeType & derivative ) const override;
@@ -23,6 +23,9 @@
 #include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkComputeImageExtremaFilter.h"
 
+#include <algorithm>
+#include <vector>
+
 #ifdef ELASTIX_USE_OPENMP
 #include <omp.h>
 #endif
@@ -52,6 +55,8 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
 
   this->m_SelfHessianNoiseRange = 1.0;
 
+  this->m_SupportsAtomicDerivativeAccumulation = true;
+
 } // end Constructor
 
 
@@ -152,6 +157,32 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
 } // end Initialize()
 
 
+/**
+ * ********************* CreateClone ****************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >::Superclass::AdvancedMetricPointer
+AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
+::CreateClone( void ) const
+{
+  Pointer clone = Self::New();
+  this->CopyToClone( clone );
+
+  clone->m_UseNormalization              = this->m_UseNormalization;
+  clone->m_SelfHessianSmoothingSigma     = this->m_SelfHessianSmoothingSigma;
+  clone->m_SelfHessianNoiseRange         = this->m_SelfHessianNoiseRange;
+  clone->m_NumberOfSamplesForSelfHessian = this->m_NumberOfSamplesForSelfHessian;
+
+  if( !this->InitializeClone( clone ) )
+  {
+    return nullptr;
+  }
+  return clone.GetPointer();
+
+} // end CreateClone()
+
+
 /**
  * ******************* PrintSelf *******************
  */
@@ -323,69 +354,66 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
   ImageSampleContainerPointer sampleContainer     = this->GetImageSampler()->GetOutput();
   const unsigned long         sampleContainerSize = sampleContainer->Size();
 
-  /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads
-    = static_cast< unsigned long >( std::ceil( static_cast< double >( sampleContainerSize )
-    / static_cast< double >( Self::GetNumberOfWorkUnits() ) ) );
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
-  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
-  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
-
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator threader_fiter;
-  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator threader_fend   = sampleContainer->Begin();
-
-  threader_fbegin += (int)pos_begin;
-  threader_fend   += (int)pos_end;
-
   /** Create variables to store intermediate results. circumvent false sharing */
   unsigned long numberOfPixelsCounted = 0;
   MeasureType   measure               = NumericTraits< MeasureType >::Zero;
 
-  /** Loop over the fixed image to calculate the mean squares. */
-  for( threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter )
+  /** Loop over the ranges of samples that are assigned to this thread. */
+  unsigned long pos_begin = 0;
+  unsigned long pos_end   = 0;
+  while( this->GetNextSampleRange( threadId, sampleContainerSize, pos_begin, pos_end ) )
   {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = ( *threader_fiter ).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImagePointType        mappedPoint;
+    /** Create iterator over the sample container. */
+    typename ImageSampleContainerType::ConstIterator threader_fiter;
+    typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
+    typename ImageSampleContainerType::ConstIterator threader_fend   = sampleContainer->Begin();
 
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
+    threader_fbegin += (int)pos_begin;
+    threader_fend   += (int)pos_end;
 
-    /** Check if point is inside mask. */
-    if( sampleOk )
+    /** Loop over the fixed image to calculate the mean squares. */
+    for( threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter )
     {
-      sampleOk = this->IsInsideMovingMask( mappedPoint ); // thread-safe?
-    }
+      /** Read fixed coordinates and initialize some variables. */
+      const FixedImagePointType & fixedPoint = ( *threader_fiter ).Value().m_ImageCoordinates;
+      RealType                    movingImageValue;
+      MovingImagePointType        mappedPoint;
 
-    /** Compute the moving image value M(T(x)) and check if
-     * the point is inside the moving image buffer.
-     */
-    if( sampleOk )
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(
-        mappedPoint, movingImageValue, 0 );
-    }
+      /** Transform point and check if it is inside the B-spline support region. */
+      bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
 
-    if( sampleOk )
-    {
-      numberOfPixelsCounted++;
+      /** Check if point is inside mask. */
+      if( sampleOk )
+      {
+        sampleOk = this->IsInsideMovingMask( mappedPoint ); // thread-safe?
+      }
 
-      /** Get the fixed image value. */
-      const RealType & fixedImageValue
-        = static_cast< RealType >( ( *threader_fiter ).Value().m_ImageValue );
+      /** Compute the moving image value M(T(x)) and check if
+       * the point is inside the moving image buffer.
+       */
+      if( sampleOk )
+      {
+        sampleOk = this->EvaluateMovingImageValueAndDerivative(
+          mappedPoint, movingImageValue, 0 );
+      }
 
-      /** The difference squared. */
-      const RealType diff = movingImageValue - fixedImageValue;
-      measure += diff * diff;
+      if( sampleOk )
+      {
+        numberOfPixelsCounted++;
 
-    } // end if sampleOk
+        /** Get the fixed image value. */
+        const RealType & fixedImageValue
+          = static_cast< RealType >( ( *threader_fiter ).Value().m_ImageValue );
 
-  } // end for loop over the image sample container
+        /** The difference squared. */
+        const RealType diff = movingImageValue - fixedImageValue;
+        measure += diff * diff;
+
+      } // end if sampleOk
+
+    } // end for loop over the image sample container
+
+  } // end while over the sample ranges
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
   this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = numberOfPixelsCounted;
@@ -624,6 +652,7 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
   this->LaunchGetValueAndDerivativeThreaderCallback();
 
   /** Gather the metric values and derivatives from all threads. */
+  ScopedHotPathTimer timer( this, Self::AccumulateTimer );
   this->AfterThreadedGetValueAndDerivative( value, derivative );
 
 } // end GetValueAndDerivative()
@@ -638,107 +667,165 @@ void
 AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
 ::ThreadedGetValueAndDerivative( ThreadIdType threadId )
 {
-  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
-  const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
-  NonZeroJacobianIndicesType   nzji  = NonZeroJacobianIndicesType( nnzji );
-  DerivativeType               imageJacobian( nnzji );
+  if( this->m_UseMixedPrecision )
+  {
+    this->ThreadedGetValueAndDerivativeInBatches< FloatImageJacobianType >( threadId );
+  }
+  else
+  {
+    this->ThreadedGetValueAndDerivativeInBatches< DerivativeType >( threadId );
+  }
+
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ******************* ThreadedGetValueAndDerivativeInBatches *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+template< class TImageJacobian >
+void
+AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedGetValueAndDerivativeInBatches( ThreadIdType threadId )
+{
+  /** The samples are processed in batches, such that the transform is called
+   * once per batch instead of once per sample, see
+   * AdvancedTransform::TransformPoints() and
+   * AdvancedTransform::EvaluateJacobianWithImageGradientProducts().
+   * When the transform pre-computed its weights for the samples, see
+   * UpdateSampleWeightsCache(), the sample indices are passed along.
+   */
+  const unsigned long batchSize        = 64;
+  const bool          useSampleWeights = this->m_SampleWeightsCacheIsAvailable;
+
+  /** Initialize the per batch buffers. The arrays that store dM(x)/dmu and the
+   * sparse Jacobian indices are allocated once, for each sample in a batch.
+   */
+  const NumberOfParametersType                    nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  std::vector< SizeValueType >                    sampleIndices( batchSize );
+  std::vector< FixedImagePointType >              fixedPoints( batchSize );
+  std::vector< RealType >                         fixedImageValues( batchSize );
+  std::vector< MovingImagePointType >             mappedPoints( batchSize );
+  std::vector< RealType >                         movingImageValues( batchSize );
+  std::vector< TransformMovingImageGradientType > movingImageDerivatives( batchSize );
+  std::vector< TImageJacobian >                   imageJacobians( batchSize, TImageJacobian( nnzji ) );
+  std::vector< NonZeroJacobianIndicesType >       nzjis( batchSize, NonZeroJacobianIndicesType( nnzji ) );
 
   /** Get a handle to the pre-allocated derivative for the current thread.
    * The initialization is performed at the beginning of each resolution in
    * InitializeThreadingParameters(), and at the end of each iteration in
    * AfterThreadedGetValueAndDerivative() and the accumulate functions.
+   * In the atomic derivative accumulation mode all threads share one derivative.
    */
-  DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Derivative;
+  DerivativeType &            derivative       = this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Derivative;
+  AtomicDerivativeValueType * atomicDerivative = this->m_AtomicDerivative;
 
   /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer     = this->GetImageSampler()->GetOutput();
   const unsigned long         sampleContainerSize = sampleContainer->Size();
 
-  /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads
-    = static_cast< unsigned long >( std::ceil( static_cast< double >( sampleContainerSize )
-    / static_cast< double >( Self::GetNumberOfWorkUnits() ) ) );
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
-  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
-  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
-
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator threader_fiter;
-  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator threader_fend   = sampleContainer->Begin();
-
-  threader_fbegin += (int)pos_begin;
-  threader_fend   += (int)pos_end;
-
   /** Create variables to store intermediate results. circumvent false sharing */
   unsigned long numberOfPixelsCounted = 0;
   MeasureType   measure               = NumericTraits< MeasureType >::Zero;
 
-  /** Loop over the fixed image to calculate the mean squares. */
-  for( threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter )
+  /** Loop over the ranges of samples that are assigned to this thread. */
+  unsigned long pos_begin = 0;
+  unsigned long pos_end   = 0;
+  while( this->GetNextSampleRange( threadId, sampleContainerSize, pos_begin, pos_end ) )
   {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = ( *threader_fiter ).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImagePointType        mappedPoint;
-    MovingImageDerivativeType   movingImageDerivative;
-
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
-
-    /** Check if point is inside mask. */
-    if( sampleOk )
+    /** Loop over the batches in this range to calculate the mean squares. */
+    for( unsigned long batch_begin = pos_begin; batch_begin < pos_end; batch_begin += batchSize )
     {
-      sampleOk = this->IsInsideMovingMask( mappedPoint ); // thread-safe?
-    }
+      const unsigned long numberOfPoints = std::min( batchSize, pos_end - batch_begin );
 
-    /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
-     * the point is inside the moving image buffer.
-     */
-    if( sampleOk )
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(
-        mappedPoint, movingImageValue, &movingImageDerivative );
-    }
-
-    if( sampleOk )
-    {
-      numberOfPixelsCounted++;
+      /** Read fixed coordinates and values. */
+      for( unsigned long k = 0; k < numberOfPoints; ++k )
+      {
+        const ImageSampleType & sample = sampleContainer->ElementAt( batch_begin + k );
+        sampleIndices[ k ]    = batch_begin + k;
+        fixedPoints[ k ]      = sample.m_ImageCoordinates;
+        fixedImageValues[ k ] = static_cast< RealType >( sample.m_ImageValue );
+      }
 
-      /** Get the fixed image value. */
-      const RealType & fixedImageValue
-        = static_cast< RealType >( ( *threader_fiter ).Value().m_ImageValue );
+      /** Transform all points of the batch. */
+      if( useSampleWeights )
+      {
+        this->m_AdvancedTransform->TransformSamples(
+          &sampleIndices[ 0 ], &fixedPoints[ 0 ], &mappedPoints[ 0 ], numberOfPoints );
+      }
+      else
+      {
+        this->m_AdvancedTransform->TransformPoints( &fixedPoints[ 0 ], &mappedPoints[ 0 ], numberOfPoints );
+      }
 
-#if 0
-      /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
+      /** Check if the points are inside the moving mask, and compute the moving
+       * image value M(T(x)) and derivative dM/dx. The valid samples are moved
+       * to the front of the buffers.
+       */
+      unsigned long numberOfValidPoints = 0;
+      for( unsigned long k = 0; k < numberOfPoints; ++k )
+      {
+        RealType                  movingImageValue;
+        MovingImageDerivativeType movingImageDerivative;
+
+        bool sampleOk = this->IsInsideMovingMask( mappedPoints[ k ] );
+        if( sampleOk )
+        {
+          sampleOk = this->EvaluateMovingImageValueAndDerivative(
+            mappedPoints[ k ], movingImageValue, &movingImageDerivative );
+        }
+
+        if( sampleOk )
+        {
+          sampleIndices[ numberOfValidPoints ]     = sampleIndices[ k ];
+          fixedPoints[ numberOfValidPoints ]       = fixedPoints[ k ];
+          fixedImageValues[ numberOfValidPoints ]  = fixedImageValues[ k ];
+          movingImageValues[ numberOfValidPoints ] = movingImageValue;
+          for( unsigned int d = 0; d < MovingImageDimension; ++d )
+          {
+            movingImageDerivatives[ numberOfValidPoints ][ d ] = movingImageDerivative[ d ];
+          }
+          ++numberOfValidPoints;
+        }
+      }
+      numberOfPixelsCounted += numberOfValidPoints;
 
-      /** Compute the inner products (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
-#else
-      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
-      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji );
-#endif
+      /** Compute the inner products of the transform Jacobian dT/dmu and the
+       * moving image gradient dM/dx, for all valid samples of the batch.
+       */
+      this->EvaluateImageJacobians( useSampleWeights ? &sampleIndices[ 0 ] : 0,
+        &fixedPoints[ 0 ], &movingImageDerivatives[ 0 ],
+        &imageJacobians[ 0 ], &nzjis[ 0 ], numberOfValidPoints );
 
-      /** Compute this pixel's contribution to the measure and derivatives. */
-      this->UpdateValueAndDerivativeTerms(
-        fixedImageValue, movingImageValue,
-        imageJacobian, nzji,
-        measure, derivative );
+      /** Compute the contributions of the valid samples to the measure and derivatives. */
+      for( unsigned long k = 0; k < numberOfValidPoints; ++k )
+      {
+        if( atomicDerivative )
+        {
+          this->UpdateValueAndDerivativeTerms(
+            fixedImageValues[ k ], movingImageValues[ k ],
+            imageJacobians[ k ], nzjis[ k ],
+            measure, atomicDerivative );
+        }
+        else
+        {
+          this->UpdateValueAndDerivativeTerms(
+            fixedImageValues[ k ], movingImageValues[ k ],
+            imageJacobians[ k ], nzjis[ k ],
+            measure, derivative );
+        }
+      }
 
-    } // end if sampleOk
+    } // end for loop over the batches
 
-  } // end for loop over the image sample container
+  } // end while over the sample ranges
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
   this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = numberOfPixelsCounted;
   this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_Value                 = measure;
 
-} // end ThreadedGetValueAndDerivative()
+} // end ThreadedGetValueAndDerivativeInBatches()
 
 
 /**
@@ -784,8 +871,17 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
   value *= normal_sum;
 
   /** Accumulate derivatives. */
+  // copy the shared derivative of the atomic accumulation mode
+  if( this->m_AtomicDerivative )
+  {
+    this->m_ThreaderMetricParameters.st_DerivativePointer   = derivative.begin();
+    this->m_ThreaderMetricParameters.st_NormalizationFactor = 1.0 / normal_sum;
+
+    this->ExecuteThreaderCallback( this->AccumulateAtomicDerivativeThreaderCallback,
+      const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
+  }
   // compute single-threadedly
-  if( !this->m_UseMultiThread && false ) // force multi-threaded
+  else if( !this->m_UseMultiThread && false ) // force multi-threaded
   {
     derivative = this->m_GetValueAndDerivativePerThreadVariables[ 0 ].st_Derivative * normal_sum;
     for( ThreadIdType i = 1; i < numberOfThreads; i++ )
@@ -799,9 +895,8 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
     this->m_ThreaderMetricParameters.st_DerivativePointer   = derivative.begin();
     this->m_ThreaderMetricParameters.st_NormalizationFactor = 1.0 / normal_sum;
 
-    this->m_Threader->SetSingleMethod( this->AccumulateDerivativesThreaderCallback,
+    this->ExecuteThreaderCallback( this->AccumulateDerivativesThreaderCallback,
       const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
-    this->m_Threader->SingleMethodExecute();
   }
 #ifdef ELASTIX_USE_OPENMP
   // compute multi-threadedly with openmp
@@ -830,12 +925,13 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
  */
 
 template< class TFixedImage, class TMovingImage >
+template< class TImageJacobian >
 void
 AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
 ::UpdateValueAndDerivativeTerms(
   const RealType fixedImageValue,
   const RealType movingImageValue,
-  const DerivativeType & imageJacobian,
+  const TImageJacobian & imageJacobian,
   const NonZeroJacobianIndicesType & nzji,
   MeasureType & measure,
   DerivativeType & deriv ) const
@@ -850,7 +946,7 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
   if( nzji.size() == this->GetNumberOfParameters() )
   {
     /** Loop over all Jacobians. */
-    typename DerivativeType::const_iterator imjacit = imageJacobian.begin();
+    typename TImageJacobian::const_iterator imjacit = imageJacobian.begin();
     typename DerivativeType::iterator derivit       = deriv.begin();
     for( unsigned int mu = 0; mu < this->GetNumberOfParameters(); ++mu )
     {
@@ -871,6 +967,36 @@ AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
 } // end UpdateValueAndDerivativeTerms()
 
 
+/**
+ * *************** UpdateValueAndDerivativeTerms ***************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+template< class TImageJacobian >
+void
+AdvancedMeanSquaresImageToImageMetric< TFixedImage, TMovingImage >
+::UpdateValueAndDerivativeTerms(
+  const RealType fixedImageValue,
+  const RealType movingImageValue,
+  const TImageJacobian & imageJacobian,
+  const NonZeroJacobianIndicesType & nzji,
+  MeasureType & measure,
+  AtomicDerivativeValueType * deriv ) const
+{
+  /** The difference squared. */
+  const RealType diff     = movingImageValue - fixedImageValue;
+  const RealType diffdiff = diff * diff;
+  measure += diffdiff;
+
+  /** Atomically add the contributions to the derivatives with respect to each parameter. */
+  const RealType diff_2 = diff * 2.0;
+  for( unsigned int i = 0; i < imageJacobian.GetSize(); ++i )
+  {
+    Superclass::AtomicAdd( deriv[ nzji[ i ] ], diff_2 * imageJacobian[ i ] );
+  }
+} // end UpdateValueAndDerivativeTerms()
+
+
 /**
  * ******************* GetSelfHessian *******************
  */
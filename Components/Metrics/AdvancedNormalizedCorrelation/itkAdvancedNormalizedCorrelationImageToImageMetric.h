@@ -144,6 +144,7 @@ public:
   typedef typename Superclass::ImageSampleContainerType   ImageSampleContainerType;
   typedef typename
     Superclass::ImageSampleContainerPointer ImageSampleContainerPointer;
+  typedef typename Superclass::ImageSampleType            ImageSampleType;
   typedef typename Superclass::FixedImageLimiterType  FixedImageLimiterType;
   typedef typename Superclass::MovingImageLimiterType MovingImageLimiterType;
   typedef typename
@@ -189,6 +190,10 @@ public:
   itkGetConstReferenceMacro( SubtractMean, bool );
   itkBooleanMacro( SubtractMean );
 
+  /** Create an independent copy of this metric, with the same settings,
+   * see AdvancedImageToImageMetric::CreateClone(). */
+  typename Superclass::AdvancedMetricPointer CreateClone( void ) const override;
+
 protected:
 
   AdvancedNormalizedCorrelationImageToImageMetric();
@@ -200,6 +205,7 @@ protected:
 
   /** Typedefs inherited from superclass */
   typedef typename Superclass::FixedImageIndexType                 FixedImageIndexType;
+  typedef typename Superclass::ScopedHotPathTimer                  ScopedHotPathTimer;
   typedef typename Superclass::FixedImageIndexValueType            FixedImageIndexValueType;
   typedef typename Superclass::MovingImageIndexType                MovingImageIndexType;
   typedef typename Superclass::FixedImagePointType                 FixedImagePointType;
@@ -209,14 +215,18 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::TransformMovingImageGradientType    TransformMovingImageGradientType;
+  typedef typename Superclass::FloatImageJacobianType              FloatImageJacobianType;
 
   /** Compute a pixel's contribution to the derivative terms;
-   * Called by GetValueAndDerivative().
+   * Called by GetValueAndDerivative(). The image Jacobian may be stored
+   * in single precision, see SetUseMixedPrecision().
    */
+  template< class TImageJacobian >
   void UpdateDerivativeTerms(
     const RealType & fixedImageValue,
     const RealType & movingImageValue,
-    const DerivativeType & imageJacobian,
+    const TImageJacobian & imageJacobian,
     const NonZeroJacobianIndicesType & nzji,
     DerivativeType & derivativeF,
     DerivativeType & derivativeM,
@@ -231,6 +241,12 @@ protected:
   /** Get value and derivatives for each thread. */
   inline void ThreadedGetValueAndDerivative( ThreadIdType threadID ) override;
 
+  /** Get value and derivatives for each thread, storing the image Jacobians
+   * of each batch of samples as TImageJacobian.
+   */
+  template< class TImageJacobian >
+  void ThreadedGetValueAndDerivativeInBatches( ThreadIdType threadID );
+
   /** Gather the values and derivatives from all threads */
   inline void AfterThreadedGetValueAndDerivative(
     MeasureType & value, DerivativeType & derivative ) const override;
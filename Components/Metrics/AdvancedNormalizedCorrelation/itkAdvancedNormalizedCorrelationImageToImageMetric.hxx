@@ -20,6 +20,9 @@
 
 #include "itkAdvancedNormalizedCorrelationImageToImageMetric.h"
 
+#include <algorithm>
+#include <vector>
+
 #ifdef ELASTIX_USE_OPENMP
 #include <omp.h>
 #endif
@@ -109,6 +112,29 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
 } // end InitializeThreadingParameters()
 
 
+/**
+ * ******************* CreateClone *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >::Superclass::AdvancedMetricPointer
+AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
+::CreateClone( void ) const
+{
+  Pointer clone = Self::New();
+  this->CopyToClone( clone );
+
+  clone->m_SubtractMean = this->m_SubtractMean;
+
+  if( !this->InitializeClone( clone ) )
+  {
+    return nullptr;
+  }
+  return clone.GetPointer();
+
+} // end CreateClone()
+
+
 /**
  * ******************* PrintSelf *******************
  */
@@ -129,12 +155,13 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
  */
 
 template< class TFixedImage, class TMovingImage >
+template< class TImageJacobian >
 void
 AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
 ::UpdateDerivativeTerms(
   const RealType & fixedImageValue,
   const RealType & movingImageValue,
-  const DerivativeType & imageJacobian,
+  const TImageJacobian & imageJacobian,
   const NonZeroJacobianIndicesType & nzji,
   DerivativeType & derivativeF,
   DerivativeType & derivativeM,
@@ -144,7 +171,7 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
   if( nzji.size() == this->GetNumberOfParameters() )
   {
     /** Loop over all Jacobians. */
-    typename DerivativeType::const_iterator imjacit  = imageJacobian.begin();
+    typename TImageJacobian::const_iterator imjacit  = imageJacobian.begin();
     typename DerivativeType::iterator derivativeFit  = derivativeF.begin();
     typename DerivativeType::iterator derivativeMit  = derivativeM.begin();
     typename DerivativeType::iterator differentialit = differential.begin();
@@ -517,6 +544,7 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
   this->LaunchGetValueAndDerivativeThreaderCallback();
 
   /** Gather the metric values and derivatives from all threads. */
+  ScopedHotPathTimer timer( this, Self::AccumulateTimer );
   this->AfterThreadedGetValueAndDerivative( value, derivative );
 
 } // end GetValueAndDerivative()
@@ -531,10 +559,50 @@ void
 AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
 ::ThreadedGetValueAndDerivative( ThreadIdType threadId )
 {
-  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
-  const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
-  NonZeroJacobianIndicesType   nzji  = NonZeroJacobianIndicesType( nnzji );
-  DerivativeType               imageJacobian( nzji.size() );
+  if( this->m_UseMixedPrecision )
+  {
+    this->ThreadedGetValueAndDerivativeInBatches< FloatImageJacobianType >( threadId );
+  }
+  else
+  {
+    this->ThreadedGetValueAndDerivativeInBatches< DerivativeType >( threadId );
+  }
+
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ******************* ThreadedGetValueAndDerivativeInBatches *******************
+ */
+
+template< class TFixedImage, class TMovingImage >
+template< class TImageJacobian >
+void
+AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
+::ThreadedGetValueAndDerivativeInBatches( ThreadIdType threadId )
+{
+  /** The samples are processed in batches, such that the transform is called
+   * once per batch instead of once per sample, see
+   * AdvancedTransform::TransformPoints() and
+   * AdvancedTransform::EvaluateJacobianWithImageGradientProducts().
+   * When the transform pre-computed its weights for the samples, see
+   * UpdateSampleWeightsCache(), the sample indices are passed along.
+   */
+  const unsigned long batchSize        = 64;
+  const bool          useSampleWeights = this->m_SampleWeightsCacheIsAvailable;
+
+  /** Initialize the per batch buffers. The arrays that store dM(x)/dmu and the
+   * sparse Jacobian indices are allocated once, for each sample in a batch.
+   */
+  const NumberOfParametersType                    nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  std::vector< SizeValueType >                    sampleIndices( batchSize );
+  std::vector< FixedImagePointType >              fixedPoints( batchSize );
+  std::vector< RealType >                         fixedImageValues( batchSize );
+  std::vector< MovingImagePointType >             mappedPoints( batchSize );
+  std::vector< RealType >                         movingImageValues( batchSize );
+  std::vector< TransformMovingImageGradientType > movingImageDerivatives( batchSize );
+  std::vector< TImageJacobian >                   imageJacobians( batchSize, TImageJacobian( nnzji ) );
+  std::vector< NonZeroJacobianIndicesType >       nzjis( batchSize, NonZeroJacobianIndicesType( nnzji ) );
 
   /** Get handles to the pre-allocated derivatives for the current thread.
    * The initialization is performed at the beginning of each resolution in
@@ -549,24 +617,6 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
   ImageSampleContainerPointer sampleContainer     = this->GetImageSampler()->GetOutput();
   const unsigned long         sampleContainerSize = sampleContainer->Size();
 
-  /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads
-    = static_cast< unsigned long >( std::ceil( static_cast< double >( sampleContainerSize )
-    / static_cast< double >( Self::GetNumberOfWorkUnits() ) ) );
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
-  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
-  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
-
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator threader_fiter;
-  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator threader_fend   = sampleContainer->Begin();
-
-  threader_fbegin += (int)pos_begin;
-  threader_fend   += (int)pos_end;
-
   /** Create variables to store intermediate results. */
   AccumulateType sff                   = NumericTraits< AccumulateType >::Zero;
   AccumulateType smm                   = NumericTraits< AccumulateType >::Zero;
@@ -575,69 +625,97 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
   AccumulateType sm                    = NumericTraits< AccumulateType >::Zero;
   unsigned long  numberOfPixelsCounted = 0;
 
-  /** Loop over the fixed image to calculate the mean squares. */
-  for( threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter )
+  /** Loop over the ranges of samples that are assigned to this thread. */
+  unsigned long pos_begin = 0;
+  unsigned long pos_end   = 0;
+  while( this->GetNextSampleRange( threadId, sampleContainerSize, pos_begin, pos_end ) )
   {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = ( *threader_fiter ).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImagePointType        mappedPoint;
-    MovingImageDerivativeType   movingImageDerivative;
-
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
-
-    /** Check if point is inside mask. */
-    if( sampleOk )
+    /** Loop over the batches in this range to calculate the correlation. */
+    for( unsigned long batch_begin = pos_begin; batch_begin < pos_end; batch_begin += batchSize )
     {
-      sampleOk = this->IsInsideMovingMask( mappedPoint );
-    }
+      const unsigned long numberOfPoints = std::min( batchSize, pos_end - batch_begin );
 
-    /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
-     * the point is inside the moving image buffer.
-     */
-    if( sampleOk )
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(
-        mappedPoint, movingImageValue, &movingImageDerivative );
-    }
-
-    if( sampleOk )
-    {
-      numberOfPixelsCounted++;
-
-      /** Get the fixed image value. */
-      const RealType & fixedImageValue
-        = static_cast< RealType >( ( *threader_fiter ).Value().m_ImageValue );
+      /** Read fixed coordinates and values. */
+      for( unsigned long k = 0; k < numberOfPoints; ++k )
+      {
+        const ImageSampleType & sample = sampleContainer->ElementAt( batch_begin + k );
+        sampleIndices[ k ]    = batch_begin + k;
+        fixedPoints[ k ]      = sample.m_ImageCoordinates;
+        fixedImageValues[ k ] = static_cast< RealType >( sample.m_ImageValue );
+      }
 
-#if 0
-      /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
+      /** Transform all points of the batch. */
+      if( useSampleWeights )
+      {
+        this->m_AdvancedTransform->TransformSamples(
+          &sampleIndices[ 0 ], &fixedPoints[ 0 ], &mappedPoints[ 0 ], numberOfPoints );
+      }
+      else
+      {
+        this->m_AdvancedTransform->TransformPoints( &fixedPoints[ 0 ], &mappedPoints[ 0 ], numberOfPoints );
+      }
 
-      /** Compute the inner products (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
-#else
-      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
-      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji );
-#endif
+      /** Check if the points are inside the moving mask, and compute the moving
+       * image value M(T(x)) and derivative dM/dx. The valid samples are moved
+       * to the front of the buffers.
+       */
+      unsigned long numberOfValidPoints = 0;
+      for( unsigned long k = 0; k < numberOfPoints; ++k )
+      {
+        RealType                  movingImageValue;
+        MovingImageDerivativeType movingImageDerivative;
+
+        bool sampleOk = this->IsInsideMovingMask( mappedPoints[ k ] );
+        if( sampleOk )
+        {
+          sampleOk = this->EvaluateMovingImageValueAndDerivative(
+            mappedPoints[ k ], movingImageValue, &movingImageDerivative );
+        }
+
+        if( sampleOk )
+        {
+          sampleIndices[ numberOfValidPoints ]     = sampleIndices[ k ];
+          fixedPoints[ numberOfValidPoints ]       = fixedPoints[ k ];
+          fixedImageValues[ numberOfValidPoints ]  = fixedImageValues[ k ];
+          movingImageValues[ numberOfValidPoints ] = movingImageValue;
+          for( unsigned int d = 0; d < MovingImageDimension; ++d )
+          {
+            movingImageDerivatives[ numberOfValidPoints ][ d ] = movingImageDerivative[ d ];
+          }
+          ++numberOfValidPoints;
+        }
+      }
+      numberOfPixelsCounted += numberOfValidPoints;
 
-      /** Update some sums needed to calculate the value of NC. */
-      sff += fixedImageValue  * fixedImageValue;
-      smm += movingImageValue * movingImageValue;
-      sfm += fixedImageValue  * movingImageValue;
-      sf  += fixedImageValue;  // Only needed when m_SubtractMean == true
-      sm  += movingImageValue; // Only needed when m_SubtractMean == true
+      /** Compute the inner products of the transform Jacobian dT/dmu and the
+       * moving image gradient dM/dx, for all valid samples of the batch.
+       */
+      this->EvaluateImageJacobians( useSampleWeights ? &sampleIndices[ 0 ] : 0,
+        &fixedPoints[ 0 ], &movingImageDerivatives[ 0 ],
+        &imageJacobians[ 0 ], &nzjis[ 0 ], numberOfValidPoints );
 
-      /** Compute this voxel's contribution to the derivative terms. */
-      this->UpdateDerivativeTerms(
-        fixedImageValue, movingImageValue, imageJacobian, nzji,
-        derivativeF, derivativeM, differential );
+      /** Compute the contributions of the valid samples. */
+      for( unsigned long k = 0; k < numberOfValidPoints; ++k )
+      {
+        const RealType fixedImageValue  = fixedImageValues[ k ];
+        const RealType movingImageValue = movingImageValues[ k ];
+
+        /** Update some sums needed to calculate the value of NC. */
+        sff += fixedImageValue  * fixedImageValue;
+        smm += movingImageValue * movingImageValue;
+        sfm += fixedImageValue  * movingImageValue;
+        sf  += fixedImageValue;  // Only needed when m_SubtractMean == true
+        sm  += movingImageValue; // Only needed when m_SubtractMean == true
+
+        /** Compute this voxel's contribution to the derivative terms. */
+        this->UpdateDerivativeTerms(
+          fixedImageValue, movingImageValue, imageJacobians[ k ], nzjis[ k ],
+          derivativeF, derivativeM, differential );
+      }
 
-    } // end if sampleOk
+    } // end for loop over the batches
 
-  } // end for loop over the image sample container
+  } // end while over the sample ranges
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
   this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = numberOfPixelsCounted;
@@ -647,7 +725,7 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
   this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Sf                    = sf;
   this->m_CorrelationGetValueAndDerivativePerThreadVariables[ threadId ].st_Sm                    = sm;
 
-} // end ThreadedGetValueAndDerivative()
+} // end ThreadedGetValueAndDerivativeInBatches()
 
 
 /**
@@ -771,8 +849,7 @@ AdvancedNormalizedCorrelationImageToImageMetric< TFixedImage, TMovingImage >
     temp->st_InvertedDenominator = 1.0 / denom;
     temp->st_DerivativePointer   = derivative.begin();
 
-    this->m_Threader->SetSingleMethod( AccumulateDerivativesThreaderCallback, temp );
-    this->m_Threader->SingleMethodExecute();
+    this->ExecuteThreaderCallback( AccumulateDerivativesThreaderCallback, temp );
 
     delete temp;
   }
@@ -39,6 +39,13 @@ namespace elastix
  * The parameters used in this class are:
  * \parameter Metric: Select this metric as follows:\n
  *    <tt>(Metric "TransformBendingEnergyPenalty")</tt>
+ * \parameter UseAnalyticBendingEnergy: Whether to compute the bending energy
+ *    exactly from the B-spline coefficients, instead of from the spatial
+ *    Hessian at the image samples. This is faster and has no sampling noise,
+ *    but requires a third order B-spline transform. The energy of the B-spline
+ *    itself is computed, also when it is combined with an initial transform.\n
+ *    example: <tt>(UseAnalyticBendingEnergy "true")</tt> \n
+ *    Default is "false". Can be given for each resolution.
  *
  * \ingroup Metrics
  *
@@ -144,6 +151,7 @@ public:
   /**
    * Do some things before each resolution:
    * \li Set options for SelfHessian
+   * \li Set the UseAnalyticBendingEnergy option
    */
   void BeforeEachResolution( void ) override;
 
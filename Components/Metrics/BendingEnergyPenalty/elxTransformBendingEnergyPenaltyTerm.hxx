@@ -62,6 +62,12 @@ TransformBendingEnergyPenalty< TElastix >
     "NumberOfSamplesForSelfHessian", this->GetComponentLabel(), level, 0 );
   this->SetNumberOfSamplesForSelfHessian( numberOfSamplesForSelfHessian );
 
+  /** Set whether to compute the bending energy from the B-spline coefficients. */
+  bool useAnalyticBendingEnergy = false;
+  this->GetConfiguration()->ReadParameter( useAnalyticBendingEnergy,
+    "UseAnalyticBendingEnergy", this->GetComponentLabel(), level, 0 );
+  this->SetUseAnalyticBendingEnergy( useAnalyticBendingEnergy );
+
 } // end BeforeEachResolution()
 
 
@@ -34,6 +34,19 @@ namespace itk
  * [1]. For rigid and affine transformation this energy is always
  * zero.
  *
+ * By default the bending energy is estimated from the spatial Hessian of
+ * the transformation at the samples of the image sampler. For a third order
+ * B-spline transform the bending energy is a quadratic form in the B-spline
+ * coefficients, which can also be computed exactly, see
+ * SetUseAnalyticBendingEnergy(). In that case the integral of the bending
+ * energy over the support of the B-spline grid is divided by the volume of
+ * the fixed image region, so that it compares to the sampled mean. Since the
+ * integral includes the border of the grid, that is outside the image, the
+ * values are not identical. The quadratic form is a sum of D(D+1)/2 separable
+ * terms, which are applied to the coefficient images with a 7 tap filter per
+ * dimension. Each filter pass is multi-threaded over the lines of the grid when
+ * the metric uses multi-threading.
+ *
  *
  * [1]: D. Rueckert, L. I. Sonoda, C. Hayes, D. L. G. Hill,
  *      M. O. Leach, and D. J. Hawkes, "Nonrigid registration
@@ -160,6 +173,14 @@ public:
   itkSetMacro( NumberOfSamplesForSelfHessian, unsigned int );
   itkGetConstMacro( NumberOfSamplesForSelfHessian, unsigned int );
 
+  /** Compute the bending energy exactly from the B-spline coefficients,
+   * instead of from the image samples. Only for third order B-spline
+   * transforms. Default: false.
+   */
+  itkSetMacro( UseAnalyticBendingEnergy, bool );
+  itkGetConstMacro( UseAnalyticBendingEnergy, bool );
+  itkBooleanMacro( UseAnalyticBendingEnergy );
+
 protected:
 
   /** Typedefs for indices and points. */
@@ -187,7 +208,70 @@ private:
   /** The private copy constructor. */
   void operator=( const Self & );                    // purposely not implemented
 
+  /** Typedefs for the analytic bending energy. */
+  typedef typename BSplineOrder3TransformType::SpacingType GridSpacingType;
+  typedef typename BSplineOrder3TransformType::RegionType  GridRegionType;
+  typedef typename ParametersType::ValueType               ParametersValueType;
+
+  /** The width of the 1D filters, the number of separable terms of the
+   * quadratic form, and the number of elements of its 7x7(x7) stencil.
+   */
+  itkStaticConstMacro( StencilWidth, unsigned int, 7 );
+  itkStaticConstMacro( NumberOfBendingEnergyTerms, unsigned int,
+    FixedImageDimension * ( FixedImageDimension + 1 ) / 2 );
+  itkStaticConstMacro( NumberOfStencilElements, unsigned int,
+    FixedImageDimension == 2 ? 49 : ( FixedImageDimension == 3 ? 343 : 2401 ) );
+
+  /** Get the cubic B-spline transform. Throws an exception if there is none. */
+  BSplineOrder3TransformType * GetAnalyticBSplineTransform( void ) const;
+
+  /** Create the 1D filters of the separable terms of the quadratic form,
+   * for the given grid spacing.
+   */
+  void InitializeBendingEnergyFilters( const GridSpacingType & spacing ) const;
+
+  /** Get element s of the 7x7(x7) stencil of the quadratic form. */
+  RealType GetBendingEnergyStencilElement( const unsigned int s ) const;
+
+  /** Compute the analytic bending energy and, if derivative is not null, its derivative. */
+  MeasureType ComputeAnalyticBendingEnergy( const ParametersType & parameters,
+    DerivativeValueType * derivative ) const;
+
+  /** Apply the filters of one dimension to a range of lines of the grid along
+   * that dimension. The pass of the last dimension also computes the value
+   * and the derivative.
+   */
+  void ComputeAnalyticBendingEnergyForLines( const unsigned int dimension,
+    const SizeValueType lineBegin, const SizeValueType lineEnd,
+    const ParametersValueType * parameters, DerivativeValueType * derivative ) const;
+
+  /** Thread callback for the analytic bending energy. */
+  static ITK_THREAD_RETURN_TYPE AnalyticBendingEnergyThreaderCallback( void * arg );
+
+  /** Helper struct that passes the arguments to the threads. */
+  struct BendingEnergyMultiThreaderParameterType
+  {
+    Self *                      m_Metric;
+    unsigned int                st_Dimension;
+    SizeValueType               st_NumberOfLines;
+    const ParametersValueType * st_Parameters;
+    DerivativeValueType *       st_DerivativePointer;
+  };
+  mutable BendingEnergyMultiThreaderParameterType m_BendingEnergyThreaderParameters;
+
   unsigned int m_NumberOfSamplesForSelfHessian;
+  bool         m_UseAnalyticBendingEnergy;
+
+  /** The filters of the quadratic form and the grid spacing they were created
+   * for, the grid, the filtered coefficient images of each term, and the
+   * contributions of the lines. They are reused in every iteration.
+   */
+  mutable std::vector< RealType >    m_BendingEnergyFilters;
+  mutable GridSpacingType            m_BendingEnergyFilterSpacing;
+  mutable GridRegionType             m_BendingEnergyGridRegion;
+  mutable MeasureType                m_BendingEnergyNormalization;
+  mutable std::vector< RealType >    m_BendingEnergyWorkspace;
+  mutable std::vector< MeasureType > m_BendingEnergyLineSums;
 
 };
 
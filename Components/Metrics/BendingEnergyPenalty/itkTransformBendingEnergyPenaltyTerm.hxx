@@ -20,6 +20,9 @@
 
 #include "itkTransformBendingEnergyPenaltyTerm.h"
 
+#include <algorithm>
+#include <cmath>
+
 #ifdef ELASTIX_USE_OPENMP
 #include <omp.h>
 #endif
@@ -41,6 +44,16 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
   this->SetUseImageSampler( true );
 
   this->m_NumberOfSamplesForSelfHessian = 100000;
+  this->m_UseAnalyticBendingEnergy      = false;
+
+  /** Initialize the analytic bending energy. */
+  this->m_BendingEnergyFilterSpacing.Fill( 0.0 );
+  this->m_BendingEnergyNormalization                           = NumericTraits< MeasureType >::One;
+  this->m_BendingEnergyThreaderParameters.m_Metric             = this;
+  this->m_BendingEnergyThreaderParameters.st_Dimension         = 0;
+  this->m_BendingEnergyThreaderParameters.st_NumberOfLines     = 0;
+  this->m_BendingEnergyThreaderParameters.st_Parameters        = nullptr;
+  this->m_BendingEnergyThreaderParameters.st_DerivativePointer = nullptr;
 
 } // end Constructor
 
@@ -59,6 +72,12 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
   RealType           measure = NumericTraits< RealType >::Zero;
   SpatialHessianType spatialHessian;
 
+  /** Compute the bending energy exactly from the B-spline coefficients, if desired. */
+  if( this->m_UseAnalyticBendingEnergy )
+  {
+    return this->ComputeAnalyticBendingEnergy( parameters, nullptr );
+  }
+
   /** Check if the SpatialHessian is nonzero. */
   if( !this->m_AdvancedTransform->GetHasNonZeroSpatialHessian() )
   {
@@ -181,6 +200,13 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
   jacobianOfSpatialHessian.resize( numberOfNonZeroJacobianIndices );
   nonZeroJacobianIndices.resize( numberOfNonZeroJacobianIndices );
 
+  /** Compute the bending energy exactly from the B-spline coefficients, if desired. */
+  if( this->m_UseAnalyticBendingEnergy )
+  {
+    value = this->ComputeAnalyticBendingEnergy( parameters, derivative.data_block() );
+    return;
+  }
+
   /** Check if the SpatialHessian is nonzero. */
   if( !this->m_AdvancedTransform->GetHasNonZeroSpatialHessian()
     && !this->m_AdvancedTransform->GetHasNonZeroJacobianOfSpatialHessian() )
@@ -368,8 +394,10 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
   const ParametersType & parameters,
   MeasureType & value, DerivativeType & derivative ) const
 {
-  /** Option for now to still use the single threaded code. */
-  if( !this->m_UseMultiThread )
+  /** Option for now to still use the single threaded code.
+   * The analytic bending energy does its own multi-threading.
+   */
+  if( !this->m_UseMultiThread || this->m_UseAnalyticBendingEnergy )
   {
     return this->GetValueAndDerivativeSingleThreaded(
       parameters, value, derivative );
@@ -440,140 +468,137 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
   ImageSampleContainerPointer sampleContainer     = this->GetImageSampler()->GetOutput();
   const unsigned long         sampleContainerSize = sampleContainer->Size();
 
-  /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads
-    = static_cast< unsigned long >( std::ceil( static_cast< double >( sampleContainerSize )
-    / static_cast< double >( Self::GetNumberOfWorkUnits() ) ) );
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end   = nrOfSamplesPerThreads * ( threadId + 1 );
-  pos_begin = ( pos_begin > sampleContainerSize ) ? sampleContainerSize : pos_begin;
-  pos_end   = ( pos_end > sampleContainerSize ) ? sampleContainerSize : pos_end;
-
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend   = sampleContainer->Begin();
-  fbegin                                                 += (int)pos_begin;
-  fend                                                   += (int)pos_end;
-
   /** Create variables to store intermediate results. circumvent false sharing */
   unsigned long numberOfPixelsCounted = 0;
   MeasureType   measure               = NumericTraits< MeasureType >::Zero;
 
-  /** Loop over the fixed image to calculate the penalty term and its derivative. */
-  for( fiter = fbegin; fiter != fend; ++fiter )
+  /** Loop over the ranges of samples that are assigned to this thread. */
+  unsigned long pos_begin = 0;
+  unsigned long pos_end   = 0;
+  while( this->GetNextSampleRange( threadId, sampleContainerSize, pos_begin, pos_end ) )
   {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = ( *fiter ).Value().m_ImageCoordinates;
-    MovingImagePointType        mappedPoint;
-
-    /** Although the mapped point is not needed to compute the penalty term,
-     * we compute in order to check if it maps inside the support region of
-     * the B-spline and if it maps inside the moving image mask.
-     */
-
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
-
-    /** Check if point is inside mask. */
-    if( sampleOk )
-    {
-      sampleOk = this->IsInsideMovingMask( mappedPoint );
-    }
-
-    if( sampleOk )
+    /** Create iterator over the sample container. */
+    typename ImageSampleContainerType::ConstIterator fiter;
+    typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
+    typename ImageSampleContainerType::ConstIterator fend   = sampleContainer->Begin();
+    fbegin                                                 += (int)pos_begin;
+    fend                                                   += (int)pos_end;
+
+    /** Loop over the fixed image to calculate the penalty term and its derivative. */
+    for( fiter = fbegin; fiter != fend; ++fiter )
     {
-      numberOfPixelsCounted++;
+      /** Read fixed coordinates and initialize some variables. */
+      const FixedImagePointType & fixedPoint = ( *fiter ).Value().m_ImageCoordinates;
+      MovingImagePointType        mappedPoint;
 
-      /** Get the spatial Hessian of the transformation at the current point.
-       * This is needed to compute the bending energy.
+      /** Although the mapped point is not needed to compute the penalty term,
+       * we compute in order to check if it maps inside the support region of
+       * the B-spline and if it maps inside the moving image mask.
        */
-      this->m_AdvancedTransform->GetJacobianOfSpatialHessian( fixedPoint,
-        spatialHessian, jacobianOfSpatialHessian, nonZeroJacobianIndices );
 
-      /** Prepare some stuff for the computation of the metric (derivative). */
-      FixedArray< InternalMatrixType, FixedImageDimension > A;
-      for( unsigned int k = 0; k < FixedImageDimension; ++k )
-      {
-        A[ k ] = spatialHessian[ k ].GetVnlMatrix();
-      }
+      /** Transform point and check if it is inside the B-spline support region. */
+      bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
 
-      /** Compute the contribution to the metric value of this point. */
-      for( unsigned int k = 0; k < FixedImageDimension; ++k )
+      /** Check if point is inside mask. */
+      if( sampleOk )
       {
-        measure += vnl_math::sqr( A[ k ].frobenius_norm() );
+        sampleOk = this->IsInsideMovingMask( mappedPoint );
       }
 
-      /** Make a distinction between a B-spline transform and other transforms. */
-      if( !transformIsBSpline )
+      if( sampleOk )
       {
-        /** Compute the contribution to the metric derivative of this point. */
-        for( unsigned int mu = 0; mu < nonZeroJacobianIndices.size(); ++mu )
-        {
-          for( unsigned int k = 0; k < FixedImageDimension; ++k )
-          {
-            /** This computes:
-             * \sum_i \sum_j A_ij B_ij = element_product(A,B).mean()*B.size()
-             */
-            const InternalMatrixType & B
-              = jacobianOfSpatialHessian[ mu ][ k ].GetVnlMatrix();
+        numberOfPixelsCounted++;
 
-            RealType matrixElementProduct = 0.0;
-            typename InternalMatrixType::const_iterator itA    = A[ k ].begin();
-            typename InternalMatrixType::const_iterator itB    = B.begin();
-            typename InternalMatrixType::const_iterator itAend = A[ k ].end();
-            while( itA != itAend )
-            {
-              matrixElementProduct += ( *itA ) * ( *itB );
-              ++itA;
-              ++itB;
-            }
+        /** Get the spatial Hessian of the transformation at the current point.
+         * This is needed to compute the bending energy.
+         */
+        this->m_AdvancedTransform->GetJacobianOfSpatialHessian( fixedPoint,
+          spatialHessian, jacobianOfSpatialHessian, nonZeroJacobianIndices );
 
-            derivative[ nonZeroJacobianIndices[ mu ] ]
-              += 2.0 * matrixElementProduct;
-          }
+        /** Prepare some stuff for the computation of the metric (derivative). */
+        FixedArray< InternalMatrixType, FixedImageDimension > A;
+        for( unsigned int k = 0; k < FixedImageDimension; ++k )
+        {
+          A[ k ] = spatialHessian[ k ].GetVnlMatrix();
         }
-      }
-      else
-      {
-        /** For the B-spline transform we know that only 1/FixedImageDimension
-         * part of the JacobianOfSpatialHessian is non-zero.
-         *
-         * In addition we know that jsh[ mu + numParPerDim * k ][ k ] is the same for all k.
-         */
 
-        /** Compute the contribution to the metric derivative of this point. */
-        const unsigned int numParPerDim
-          = nonZeroJacobianIndices.size() / FixedImageDimension;
-        for( unsigned int mu = 0; mu < numParPerDim; ++mu )
+        /** Compute the contribution to the metric value of this point. */
+        for( unsigned int k = 0; k < FixedImageDimension; ++k )
         {
-          const InternalMatrixType & B
-            = jacobianOfSpatialHessian[ mu + numParPerDim * 0 ][ 0 ].GetVnlMatrix();
+          measure += vnl_math::sqr( A[ k ].frobenius_norm() );
+        }
 
-          for( unsigned int k = 0; k < FixedImageDimension; ++k )
+        /** Make a distinction between a B-spline transform and other transforms. */
+        if( !transformIsBSpline )
+        {
+          /** Compute the contribution to the metric derivative of this point. */
+          for( unsigned int mu = 0; mu < nonZeroJacobianIndices.size(); ++mu )
           {
-            /** This computes:
-             * \sum_i \sum_j A_ij B_ij = element_product(A,B).mean()*B.size()
-             */
-            RealType matrixElementProduct = 0.0;
-            typename InternalMatrixType::const_iterator itA    = A[ k ].begin();
-            typename InternalMatrixType::const_iterator itB    = B.begin();
-            typename InternalMatrixType::const_iterator itAend = A[ k ].end();
-            while( itA != itAend )
+            for( unsigned int k = 0; k < FixedImageDimension; ++k )
             {
-              matrixElementProduct += ( *itA ) * ( *itB );
-              ++itA;
-              ++itB;
+              /** This computes:
+               * \sum_i \sum_j A_ij B_ij = element_product(A,B).mean()*B.size()
+               */
+              const InternalMatrixType & B
+                = jacobianOfSpatialHessian[ mu ][ k ].GetVnlMatrix();
+
+              RealType matrixElementProduct = 0.0;
+              typename InternalMatrixType::const_iterator itA    = A[ k ].begin();
+              typename InternalMatrixType::const_iterator itB    = B.begin();
+              typename InternalMatrixType::const_iterator itAend = A[ k ].end();
+              while( itA != itAend )
+              {
+                matrixElementProduct += ( *itA ) * ( *itB );
+                ++itA;
+                ++itB;
+              }
+
+              derivative[ nonZeroJacobianIndices[ mu ] ]
+                += 2.0 * matrixElementProduct;
             }
-
-            derivative[ nonZeroJacobianIndices[ mu + numParPerDim * k ] ]
-              += 2.0 * matrixElementProduct;
           }
         }
-      } // end if B-spline
-    } // end if sampleOk
-  }     // end for loop over the image sample container
+        else
+        {
+          /** For the B-spline transform we know that only 1/FixedImageDimension
+           * part of the JacobianOfSpatialHessian is non-zero.
+           *
+           * In addition we know that jsh[ mu + numParPerDim * k ][ k ] is the same for all k.
+           */
+
+          /** Compute the contribution to the metric derivative of this point. */
+          const unsigned int numParPerDim
+            = nonZeroJacobianIndices.size() / FixedImageDimension;
+          for( unsigned int mu = 0; mu < numParPerDim; ++mu )
+          {
+            const InternalMatrixType & B
+              = jacobianOfSpatialHessian[ mu + numParPerDim * 0 ][ 0 ].GetVnlMatrix();
+
+            for( unsigned int k = 0; k < FixedImageDimension; ++k )
+            {
+              /** This computes:
+               * \sum_i \sum_j A_ij B_ij = element_product(A,B).mean()*B.size()
+               */
+              RealType matrixElementProduct = 0.0;
+              typename InternalMatrixType::const_iterator itA    = A[ k ].begin();
+              typename InternalMatrixType::const_iterator itB    = B.begin();
+              typename InternalMatrixType::const_iterator itAend = A[ k ].end();
+              while( itA != itAend )
+              {
+                matrixElementProduct += ( *itA ) * ( *itB );
+                ++itA;
+                ++itB;
+              }
+
+              derivative[ nonZeroJacobianIndices[ mu + numParPerDim * k ] ]
+                += 2.0 * matrixElementProduct;
+            }
+          }
+        } // end if B-spline
+      } // end if sampleOk
+    }     // end for loop over the image sample container
+
+  } // end while over the sample ranges
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
   this->m_GetValueAndDerivativePerThreadVariables[ threadId ].st_NumberOfPixelsCounted = numberOfPixelsCounted;
@@ -640,9 +665,8 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
     this->m_ThreaderMetricParameters.st_NormalizationFactor
       = static_cast< DerivativeValueType >( this->m_NumberOfPixelsCounted );
 
-    this->m_Threader->SetSingleMethod( this->AccumulateDerivativesThreaderCallback,
+    this->ExecuteThreaderCallback( this->AccumulateDerivativesThreaderCallback,
       const_cast< void * >( static_cast< const void * >( &this->m_ThreaderMetricParameters ) ) );
-    this->m_Threader->SingleMethodExecute();
   }
 #ifdef ELASTIX_USE_OPENMP
   // compute multi-threadedly with openmp
@@ -668,6 +692,339 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
 } // end AfterThreadedGetValueAndDerivative()
 
 
+/**
+ * ******************* GetAnalyticBSplineTransform *******************
+ */
+
+template< class TFixedImage, class TScalarType >
+typename TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >::BSplineOrder3TransformType *
+TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
+::GetAnalyticBSplineTransform( void ) const
+{
+  /** Check if this transform is a third order B-spline transform. */
+  BSplineOrder3TransformPointer bspline; // default-constructed (null)
+  const bool transformIsBSpline = this->CheckForBSplineTransform2( bspline );
+  if( !transformIsBSpline || bspline.IsNull() )
+  {
+    itkExceptionMacro( << "ERROR: the analytic bending energy requires a third order B-spline transform." );
+  }
+
+  return bspline.GetPointer();
+
+} // end GetAnalyticBSplineTransform()
+
+
+/**
+ * ******************* InitializeBendingEnergyFilters *******************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
+::InitializeBendingEnergyFilters( const GridSpacingType & spacing ) const
+{
+  /** The filters only depend on the grid spacing. */
+  if( !this->m_BendingEnergyFilters.empty() && spacing == this->m_BendingEnergyFilterSpacing )
+  {
+    return;
+  }
+
+  /** The inner products of the derivatives of order 0, 1 and 2 of two cubic
+   * B-splines at distance m = -3, ..., 3, i.e. the values of the 7th order
+   * B-spline and of minus its 2nd and its 4th derivative at the integers.
+   */
+  const double innerProducts[ 3 ][ StencilWidth ] = {
+    { 1.0 / 5040.0, 1.0 / 42.0, 397.0 / 1680.0, 151.0 / 315.0, 397.0 / 1680.0, 1.0 / 42.0, 1.0 / 5040.0 },
+    { -1.0 / 120.0, -1.0 / 5.0, -1.0 / 8.0, 2.0 / 3.0, -1.0 / 8.0, -1.0 / 5.0, -1.0 / 120.0 },
+    { 1.0 / 6.0, 0.0, -3.0 / 2.0, 8.0 / 3.0, -3.0 / 2.0, 0.0, 1.0 / 6.0 } };
+
+  /** The bending energy sum_k sum_a sum_b \int ( d^2 T_k / dx_a dx_b )^2 dx is
+   * sum_k c_k^T Q c_k, with c_k the coefficients of dimension k. Q is the sum
+   * over a <= b of separable terms, counted twice if a != b. In dimension d,
+   * the filter of term ( a, b ) is the inner product of the derivatives of
+   * order o_d = [d==a] + [d==b], scaled by spacing_d^( 1 - 2 o_d ). The factor
+   * 2 of the mixed terms is included in the filter of the first dimension.
+   * Tap t of a filter is at distance t - 3.
+   */
+  this->m_BendingEnergyFilters.assign(
+    NumberOfBendingEnergyTerms * FixedImageDimension * StencilWidth, NumericTraits< RealType >::Zero );
+  unsigned int term = 0;
+  for( unsigned int a = 0; a < FixedImageDimension; ++a )
+  {
+    for( unsigned int b = a; b < FixedImageDimension; ++b, ++term )
+    {
+      for( unsigned int d = 0; d < FixedImageDimension; ++d )
+      {
+        const unsigned int order  = ( d == a ? 1 : 0 ) + ( d == b ? 1 : 0 );
+        const double       factor = ( d == 0 && a != b ? 2.0 : 1.0 )
+          * std::pow( static_cast< double >( spacing[ d ] ), 1.0 - 2.0 * order );
+        RealType * filter = &this->m_BendingEnergyFilters[ ( term * FixedImageDimension + d ) * StencilWidth ];
+        for( unsigned int t = 0; t < StencilWidth; ++t )
+        {
+          filter[ t ] = factor * innerProducts[ order ][ t ];
+        }
+      }
+    }
+  }
+
+  this->m_BendingEnergyFilterSpacing = spacing;
+
+} // end InitializeBendingEnergyFilters()
+
+
+/**
+ * ******************* GetBendingEnergyStencilElement *******************
+ */
+
+template< class TFixedImage, class TScalarType >
+typename TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >::RealType
+TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
+::GetBendingEnergyStencilElement( const unsigned int s ) const
+{
+  /** Element s of the stencil is at distance ( s mod 7, s / 7 mod 7, ... ) - 3,
+   * and is the sum over the terms of the product of their filters.
+   */
+  RealType value = NumericTraits< RealType >::Zero;
+  for( unsigned int term = 0; term < NumberOfBendingEnergyTerms; ++term )
+  {
+    RealType     product = 1.0;
+    unsigned int rest    = s;
+    for( unsigned int d = 0; d < FixedImageDimension; ++d )
+    {
+      product *= this->m_BendingEnergyFilters[
+        ( term * FixedImageDimension + d ) * StencilWidth + rest % StencilWidth ];
+      rest /= StencilWidth;
+    }
+    value += product;
+  }
+  return value;
+
+} // end GetBendingEnergyStencilElement()
+
+
+/**
+ * ******************* ComputeAnalyticBendingEnergy *******************
+ */
+
+template< class TFixedImage, class TScalarType >
+typename TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >::MeasureType
+TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
+::ComputeAnalyticBendingEnergy( const ParametersType & parameters,
+  DerivativeValueType * derivative ) const
+{
+  /** Get the B-spline grid and create the filters for its spacing. */
+  const BSplineOrder3TransformType * bspline = this->GetAnalyticBSplineTransform();
+  this->m_BendingEnergyGridRegion = bspline->GetGridRegion();
+  this->InitializeBendingEnergyFilters( bspline->GetGridSpacing() );
+
+  const SizeValueType numberOfGridPoints = this->m_BendingEnergyGridRegion.GetNumberOfPixels();
+  if( parameters.GetSize() != numberOfGridPoints * FixedImageDimension )
+  {
+    itkExceptionMacro( << "ERROR: the number of parameters does not match the B-spline grid." );
+  }
+
+  /** Divide by the volume of the fixed image region, so that the integral
+   * compares to the mean over the samples.
+   */
+  const FixedImageRegionType & fixedImageRegion = this->GetFixedImageRegion();
+  MeasureType                  volume           = NumericTraits< MeasureType >::One;
+  for( unsigned int d = 0; d < FixedImageDimension; ++d )
+  {
+    volume *= fixedImageRegion.GetSize()[ d ] * this->GetFixedImage()->GetSpacing()[ d ];
+  }
+  this->m_BendingEnergyNormalization = NumericTraits< MeasureType >::One / volume;
+
+  /** Filter the coefficient images of each term along each dimension in turn,
+   * multi-threaded over the lines if desired. This does not reallocate the
+   * workspace when the size of the grid did not change since the last call.
+   */
+  const SizeValueType lastDimensionSize
+    = this->m_BendingEnergyGridRegion.GetSize()[ FixedImageDimension - 1 ];
+  this->m_BendingEnergyWorkspace.resize(
+    NumberOfBendingEnergyTerms * FixedImageDimension * numberOfGridPoints );
+  this->m_BendingEnergyLineSums.resize( numberOfGridPoints / lastDimensionSize );
+  this->m_BendingEnergyThreaderParameters.st_Parameters        = parameters.data_block();
+  this->m_BendingEnergyThreaderParameters.st_DerivativePointer = derivative;
+  for( unsigned int d = 0; d < FixedImageDimension; ++d )
+  {
+    const SizeValueType numberOfLines
+      = numberOfGridPoints / this->m_BendingEnergyGridRegion.GetSize()[ d ];
+    this->m_BendingEnergyThreaderParameters.st_Dimension     = d;
+    this->m_BendingEnergyThreaderParameters.st_NumberOfLines = numberOfLines;
+    if( this->m_UseMultiThread )
+    {
+      this->ExecuteThreaderCallback( this->AnalyticBendingEnergyThreaderCallback,
+        const_cast< void * >( static_cast< const void * >(
+          &this->m_BendingEnergyThreaderParameters ) ) );
+    }
+    else
+    {
+      this->ComputeAnalyticBendingEnergyForLines( d, 0, numberOfLines,
+        parameters.data_block(), derivative );
+    }
+  }
+
+  /** Add the contributions of the lines, always in the same order. */
+  MeasureType measure = NumericTraits< MeasureType >::Zero;
+  for( SizeValueType line = 0; line < this->m_BendingEnergyLineSums.size(); ++line )
+  {
+    measure += this->m_BendingEnergyLineSums[ line ];
+  }
+
+  return measure * this->m_BendingEnergyNormalization;
+
+} // end ComputeAnalyticBendingEnergy()
+
+
+/**
+ * ******************* ComputeAnalyticBendingEnergyForLines *******************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
+::ComputeAnalyticBendingEnergyForLines( const unsigned int dimension,
+  const SizeValueType lineBegin, const SizeValueType lineEnd,
+  const ParametersValueType * parameters, DerivativeValueType * derivative ) const
+{
+  typedef typename GridRegionType::SizeType GridSizeType;
+  const GridSizeType  size               = this->m_BendingEnergyGridRegion.GetSize();
+  const SizeValueType numberOfGridPoints = this->m_BendingEnergyGridRegion.GetNumberOfPixels();
+  const SizeValueType lineSize           = size[ dimension ];
+  const long          halfWidth          = StencilWidth / 2;
+  const bool          isLastDimension    = dimension == FixedImageDimension - 1;
+  const RealType      derivativeFactor   = 2.0 * this->m_BendingEnergyNormalization;
+  RealType *          workspace          = &this->m_BendingEnergyWorkspace[ 0 ];
+
+  /** The stride of the line dimension in the grid. */
+  SizeValueType lineStride = 1;
+  for( unsigned int d = 0; d < dimension; ++d )
+  {
+    lineStride *= size[ d ];
+  }
+
+  std::vector< RealType > input( lineSize );
+  for( SizeValueType line = lineBegin; line < lineEnd; ++line )
+  {
+    /** Compute the offset of the first grid point of the line, from its
+     * position in the other dimensions.
+     */
+    SizeValueType lineStart = 0;
+    SizeValueType stride    = 1;
+    SizeValueType rest      = line;
+    for( unsigned int d = 0; d < FixedImageDimension; ++d )
+    {
+      if( d != dimension )
+      {
+        lineStart += ( rest % size[ d ] ) * stride;
+        rest      /= size[ d ];
+      }
+      stride *= size[ d ];
+    }
+
+    /** Filter the line of each term and coefficient image. The first pass
+     * reads the coefficients, the others filter the workspace in place.
+     * Outside the grid there are no B-spline coefficients, i.e. they are zero.
+     */
+    for( unsigned int term = 0; term < NumberOfBendingEnergyTerms; ++term )
+    {
+      const RealType * filter = &this->m_BendingEnergyFilters[
+        ( term * FixedImageDimension + dimension ) * StencilWidth ];
+      for( unsigned int k = 0; k < FixedImageDimension; ++k )
+      {
+        RealType * filtered = workspace + ( term * FixedImageDimension + k ) * numberOfGridPoints + lineStart;
+        if( dimension == 0 )
+        {
+          const ParametersValueType * coefficients = parameters + k * numberOfGridPoints + lineStart;
+          for( SizeValueType x = 0; x < lineSize; ++x )
+          {
+            input[ x ] = coefficients[ x * lineStride ];
+          }
+        }
+        else
+        {
+          for( SizeValueType x = 0; x < lineSize; ++x )
+          {
+            input[ x ] = filtered[ x * lineStride ];
+          }
+        }
+
+        for( SizeValueType x = 0; x < lineSize; ++x )
+        {
+          const long lx       = static_cast< long >( x );
+          const long tapBegin = std::max( halfWidth - lx, 0L );
+          const long tapEnd   = std::min( static_cast< long >( StencilWidth ),
+            static_cast< long >( lineSize ) + halfWidth - lx );
+          RealType   sum      = NumericTraits< RealType >::Zero;
+          for( long t = tapBegin; t < tapEnd; ++t )
+          {
+            sum += filter[ t ] * input[ lx + t - halfWidth ];
+          }
+          filtered[ x * lineStride ] = sum;
+        }
+      }
+    }
+
+    /** After the last pass, the sum over the terms is ( Q c_k ). The value is
+     * c_k^T Q c_k, the derivative 2 Q c_k.
+     */
+    if( isLastDimension )
+    {
+      MeasureType lineSum = NumericTraits< MeasureType >::Zero;
+      for( unsigned int k = 0; k < FixedImageDimension; ++k )
+      {
+        for( SizeValueType x = 0; x < lineSize; ++x )
+        {
+          const SizeValueType gridPoint = lineStart + x * lineStride;
+          RealType            Qc        = NumericTraits< RealType >::Zero;
+          for( unsigned int term = 0; term < NumberOfBendingEnergyTerms; ++term )
+          {
+            Qc += workspace[ ( term * FixedImageDimension + k ) * numberOfGridPoints + gridPoint ];
+          }
+          lineSum += parameters[ k * numberOfGridPoints + gridPoint ] * Qc;
+          if( derivative )
+          {
+            derivative[ k * numberOfGridPoints + gridPoint ] = derivativeFactor * Qc;
+          }
+        }
+      }
+      this->m_BendingEnergyLineSums[ line ] = lineSum;
+    }
+
+  } // end for lines
+
+} // end ComputeAnalyticBendingEnergyForLines()
+
+
+/**
+ * **************** AnalyticBendingEnergyThreaderCallback *******
+ */
+
+template< class TFixedImage, class TScalarType >
+ITK_THREAD_RETURN_TYPE
+TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
+::AnalyticBendingEnergyThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadId   = infoStruct->WorkUnitID;
+
+  BendingEnergyMultiThreaderParameterType * temp
+    = static_cast< BendingEnergyMultiThreaderParameterType * >( infoStruct->UserData );
+
+  /** Process the lines handed out to this thread. */
+  unsigned long lineBegin = 0;
+  unsigned long lineEnd   = 0;
+  while( temp->m_Metric->GetNextSampleRange( threadId, temp->st_NumberOfLines, lineBegin, lineEnd ) )
+  {
+    temp->m_Metric->ComputeAnalyticBendingEnergyForLines( temp->st_Dimension,
+      lineBegin, lineEnd, temp->st_Parameters, temp->st_DerivativePointer );
+  }
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end AnalyticBendingEnergyThreaderCallback()
+
+
 /**
  * ******************* GetSelfHessian *******************
  */
@@ -708,6 +1065,56 @@ TransformBendingEnergyPenaltyTerm< TFixedImage, TScalarType >
     return;
   }
 
+  /** The Hessian of the analytic bending energy is 2 Q / volume, for each
+   * dimension, see InitializeBendingEnergyFilters(). Computing the bending
+   * energy once sets up the filters, the grid and the normalization.
+   */
+  if( this->m_UseAnalyticBendingEnergy )
+  {
+    this->ComputeAnalyticBendingEnergy( parameters, nullptr );
+    const typename GridRegionType::SizeType size = this->m_BendingEnergyGridRegion.GetSize();
+    const SizeValueType numberOfGridPoints       = this->m_BendingEnergyGridRegion.GetNumberOfPixels();
+    const long          halfWidth                = StencilWidth / 2;
+
+    std::vector< RealType > stencil( NumberOfStencilElements );
+    for( unsigned int s = 0; s < NumberOfStencilElements; ++s )
+    {
+      stencil[ s ] = this->GetBendingEnergyStencilElement( s );
+    }
+
+    for( SizeValueType i = 0; i < numberOfGridPoints; ++i )
+    {
+      for( unsigned int s = 0; s < NumberOfStencilElements; ++s )
+      {
+        /** Compute the grid point j at distance s from grid point i. */
+        SizeValueType restI  = i;
+        unsigned int  restS  = s;
+        SizeValueType j      = 0;
+        SizeValueType stride = 1;
+        bool          inside = true;
+        for( unsigned int d = 0; d < FixedImageDimension; ++d )
+        {
+          const long p = static_cast< long >( restI % size[ d ] )
+            + static_cast< long >( restS % StencilWidth ) - halfWidth;
+          inside  = inside && p >= 0 && p < static_cast< long >( size[ d ] );
+          j      += static_cast< SizeValueType >( p ) * stride;
+          stride *= size[ d ];
+          restI  /= size[ d ];
+          restS  /= StencilWidth;
+        }
+
+        /** Only the upper triangular part is stored. */
+        if( !inside || j < i ) { continue; }
+        const double val = 2.0 * this->m_BendingEnergyNormalization * stencil[ s ];
+        for( unsigned int k = 0; k < FixedImageDimension; ++k )
+        {
+          H( k * numberOfGridPoints + i, k * numberOfGridPoints + j ) = val;
+        }
+      }
+    }
+    return;
+  }
+
   /** Set up grid sampler */
   typename SelfHessianSamplerType::Pointer sampler = SelfHessianSamplerType::New();
   sampler->SetInputImageRegion( this->GetImageSampler()->GetInputImageRegion() );
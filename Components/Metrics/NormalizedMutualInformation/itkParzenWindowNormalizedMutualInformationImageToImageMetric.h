@@ -150,6 +150,10 @@ public:
   void GetValueAndDerivative( const ParametersType & parameters,
     MeasureType & Value, DerivativeType & Derivative ) const override;
 
+  /** Create an independent copy of this metric, with the same settings,
+   * see AdvancedImageToImageMetric::CreateClone(). */
+  typename Superclass::AdvancedMetricPointer CreateClone( void ) const override;
+
 protected:
 
   /** The constructor. */
@@ -46,6 +46,27 @@ ParzenWindowNormalizedMutualInformationImageToImageMetric< TFixedImage, TMovingI
 } // end PrintSelf()
 
 
+/**
+ * ********************* CreateClone ******************************
+ */
+
+template< class TFixedImage, class TMovingImage >
+typename ParzenWindowNormalizedMutualInformationImageToImageMetric< TFixedImage, TMovingImage >::Superclass::AdvancedMetricPointer
+ParzenWindowNormalizedMutualInformationImageToImageMetric< TFixedImage, TMovingImage >
+::CreateClone( void ) const
+{
+  Pointer clone = Self::New();
+  this->CopyToClone( clone );
+
+  if( !this->InitializeClone( clone ) )
+  {
+    return nullptr;
+  }
+  return clone.GetPointer();
+
+} // end CreateClone()
+
+
 /**
  * ********************** ComputeLogMarginalPDF***********************
  */
@@ -101,6 +101,11 @@ namespace elastix
  *    times the grid spacing of the B-spline transform. \n
  *    example: <tt>(DilationRadiusMultiplier 1.0 1.0 2.0)</tt> \n
  *    Default is 1.0.
+ * \parameter UseFusedRigidityPasses: flag to compute the conditions and their
+ *    derivatives in two passes over the coefficient images, instead of with
+ *    the chains of separable filters. The results agree up to rounding. \n
+ *    example: <tt>(UseFusedRigidityPasses "true")</tt> \n
+ *    Default is "false".
  *
  * \ingroup Metrics
  *
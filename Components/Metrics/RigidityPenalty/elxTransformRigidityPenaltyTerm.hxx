@@ -270,6 +270,12 @@ TransformRigidityPenalty< TElastix >
     "PropernessConditionWeight", this->GetComponentLabel(), level, 0 );
   this->SetPropernessConditionWeight( propernessConditionWeight );
 
+  /** Set the computation of the conditions in single passes. */
+  bool useFusedRigidityPasses = false;
+  this->GetConfiguration()->ReadParameter( useFusedRigidityPasses,
+    "UseFusedRigidityPasses", this->GetComponentLabel(), level, 0 );
+  this->SetUseFusedPasses( useFusedRigidityPasses );
+
 } // end BeforeEachResolution()
 
 
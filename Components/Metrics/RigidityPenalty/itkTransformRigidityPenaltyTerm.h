@@ -52,6 +52,18 @@ namespace itk
  * The RigidityPenaltyTermValueImageFilter at each pixel location is computed by
  * convolution with some separable 1D kernels.
  *
+ * By default the convolutions are done with chains of image filters, one
+ * per kernel and dimension. With SetUseFusedPasses( true ) the separable
+ * kernels are instead combined to 3x3 (x3) stencils, which are applied to
+ * the coefficient images in a single pass over the B-spline grid, computing
+ * the condition values and the subparts of the derivative at once. A second
+ * pass applies the adjoint stencils to the subparts, to compute the derivative.
+ * Both passes are multi-threaded over the rows of the grid, when the metric
+ * uses multi-threading. The stencils and the workspace of the subparts are
+ * kept, so that nothing is reallocated as long as the grid does not change.
+ * The fused passes use the same operators and formulas as the filter chains,
+ * but sum in another order, so their results agree up to rounding.
+ *
  * The rigid penalty term penalizes deviations from a rigid
  * transformation at regions specified by the so-called rigidity images.
  *
@@ -122,6 +134,7 @@ public:
   typedef typename Superclass::ImageSampleContainerType     ImageSampleContainerType;
   typedef typename Superclass::ImageSampleContainerPointer  ImageSampleContainerPointer;
   typedef typename Superclass::ScalarType                   ScalarType;
+  typedef typename Superclass::ThreadInfoType               ThreadInfoType;
 
   /** Typedef's for the B-spline transform. */
   typedef typename Superclass::CombinationTransformType       CombinationTransformType;
@@ -154,6 +167,7 @@ public:
   typedef typename BSplineTransformType::ImageType   CoefficientImageType;
   typedef typename CoefficientImageType::Pointer     CoefficientImagePointer;
   typedef typename CoefficientImageType::SpacingType CoefficientImageSpacingType;
+  typedef typename CoefficientImageType::PixelType   CoefficientPixelType;
 
   /** Typedef support for neighborhoods, filters, etc. */
   typedef Neighborhood< ScalarType,
@@ -291,6 +305,13 @@ public:
   /** Set to use the MovingRigidityImage or not. */
   itkSetMacro( UseMovingRigidityImage, bool );
 
+  /** Set/Get whether the penalty is computed in the fused passes over the
+   * B-spline grid, instead of with the chains of image filters. Default false.
+   */
+  itkSetMacro( UseFusedPasses, bool );
+  itkGetConstMacro( UseFusedPasses, bool );
+  itkBooleanMacro( UseFusedPasses );
+
   /** Function to fill the RigidityCoefficientImage every iteration. */
   void FillRigidityCoefficientImage( const ParametersType & parameters ) const;
 
@@ -326,6 +347,91 @@ private:
   CoefficientImagePointer FilterSeparable( const CoefficientImageType *,
     const std::vector< NeighborhoodType > & Operators ) const;
 
+  /** Private functions that compute the condition values, and optionally the
+   * derivative, with the chains of image filters.
+   */
+  void ComputeConditionValuesWithFilters( const ScalarType rigidityCoefficientSum ) const;
+
+  void ComputeConditionValuesAndDerivativeWithFilters(
+    const ScalarType rigidityCoefficientSum, DerivativeType & derivative ) const;
+
+  /** The operators that are applied to the coefficient images. The operators
+   * C, F, H and I are only used in 3D.
+   */
+  enum { OperatorA = 0, OperatorB, OperatorC, OperatorD, OperatorE,
+         OperatorF, OperatorG, OperatorH, OperatorI, NumberOfOperators };
+
+  /** The number of voxels in a 3x3 (x3) neighbourhood, and the number of
+   * subparts of the derivative that are stored per voxel: D^2 for the
+   * orthonormality condition, D^2 for the properness condition, and
+   * D(3D-3) for the linearity condition.
+   */
+  itkStaticConstMacro( NumberOfNeighbours, unsigned int, ImageDimension == 2 ? 9 : 27 );
+  itkStaticConstMacro( NumberOfLinearityParts, unsigned int, 3 * ImageDimension - 3 );
+  itkStaticConstMacro( SubpartsOffsetOC, unsigned int, 0 );
+  itkStaticConstMacro( SubpartsOffsetPC, unsigned int, ImageDimension * ImageDimension );
+  itkStaticConstMacro( SubpartsOffsetLC, unsigned int, 2 * ImageDimension * ImageDimension );
+  itkStaticConstMacro( NumberOfSubparts, unsigned int,
+    2 * ImageDimension * ImageDimension + ImageDimension * ( 3 * ImageDimension - 3 ) );
+
+  /** Private function that creates the 3x3 (x3) stencils of all operators,
+   * for the given grid spacing. The separable stencils are the tensor
+   * products of the 1D operators, the adjoint stencils are the ND operators.
+   */
+  void InitializeStencils( const CoefficientImageSpacingType & spacing ) const;
+
+  /** Private function that computes the condition values in a single pass over
+   * the coefficient images, and optionally stores the subparts of the derivative.
+   */
+  void ComputeConditionValues( const ScalarType rigidityCoefficientSum,
+    const bool computeParts ) const;
+
+  /** Private function that filters the stored subparts with the adjoint
+   * operators in a single pass, to compute the derivative.
+   */
+  void ComputeConditionDerivatives( const ScalarType rigidityCoefficientSum,
+    DerivativeType & derivative ) const;
+
+  /** Private functions that do the work of the two passes for a range of rows
+   * of the B-spline grid, i.e. lines along the first dimension.
+   */
+  void ComputeConditionValuesForRows( const SizeValueType rowBegin,
+    const SizeValueType rowEnd, const bool computeParts ) const;
+
+  void ComputeConditionDerivativesForRows( const SizeValueType rowBegin,
+    const SizeValueType rowEnd, DerivativeValueType * derivative,
+    const ScalarType rigidityCoefficientSum ) const;
+
+  /** Private function that computes the buffer offsets of the rows neighbouring row. */
+  void ComputeRowOffsets( const SizeValueType row, SizeValueType * rowOffsets ) const;
+
+  /** Private function that applies a stencil to a neighbourhood. */
+  static ScalarType ApplyStencil( const ScalarType * stencil, const ScalarType * neighbourhood )
+  {
+    ScalarType result = NumericTraits< ScalarType >::Zero;
+    for( unsigned int k = 0; k < NumberOfNeighbours; ++k )
+    {
+      result += stencil[ k ] * neighbourhood[ k ];
+    }
+    return result;
+  }
+
+  /** Thread callbacks for the two passes. */
+  static ITK_THREAD_RETURN_TYPE ComputeConditionValuesThreaderCallback( void * arg );
+
+  static ITK_THREAD_RETURN_TYPE ComputeConditionDerivativesThreaderCallback( void * arg );
+
+  /** Helper struct that passes the arguments of the two passes to the threads. */
+  struct RigidityPenaltyMultiThreaderParameterType
+  {
+    Self *                m_Metric;
+    bool                  st_ComputeParts;
+    SizeValueType         st_NumberOfRows;
+    DerivativeValueType * st_DerivativePointer;
+    ScalarType            st_RigidityCoefficientSum;
+  };
+  mutable RigidityPenaltyMultiThreaderParameterType m_RigidityPenaltyThreaderParameters;
+
   /** Member variables. */
   BSplineTransformPointer m_BSplineTransform;
   ScalarType              m_LinearityConditionWeight;
@@ -360,6 +466,16 @@ private:
   RigidityImagePointer               m_MovingRigidityImageDilated;
   bool                               m_UseFixedRigidityImage;
   bool                               m_UseMovingRigidityImage;
+  bool                               m_UseFusedPasses;
+
+  /** The stencils and workspaces of the single pass computation. They are
+   * reused in every iteration, and only reallocated when the grid changes.
+   */
+  mutable std::vector< ScalarType >  m_SeparableStencils;
+  mutable std::vector< ScalarType >  m_AdjointStencils;
+  mutable CoefficientImageSpacingType m_StencilSpacing;
+  mutable std::vector< ScalarType >  m_SubpartsWorkspace;
+  mutable std::vector< MeasureType > m_RowSums;
 
 };
 
@@ -20,8 +20,6 @@
 
 #include "itkTransformRigidityPenaltyTerm.h"
 
-#include "itkZeroFluxNeumannBoundaryCondition.h"
-
 namespace itk
 {
 
@@ -87,6 +85,17 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
 
   this->m_BSplineTransform = nullptr;
 
+  /** By default the penalty is computed with the filter chains. */
+  this->m_UseFusedPasses = false;
+
+  /** Initialize the thread parameters of the single pass computation. */
+  this->m_StencilSpacing.Fill( 0.0 );
+  this->m_RigidityPenaltyThreaderParameters.m_Metric                  = this;
+  this->m_RigidityPenaltyThreaderParameters.st_ComputeParts           = false;
+  this->m_RigidityPenaltyThreaderParameters.st_NumberOfRows           = 0;
+  this->m_RigidityPenaltyThreaderParameters.st_DerivativePointer      = nullptr;
+  this->m_RigidityPenaltyThreaderParameters.st_RigidityCoefficientSum = NumericTraits< ScalarType >::Zero;
+
 } // end Constructor
 
 
@@ -495,15 +504,138 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     itkExceptionMacro( << "ERROR: This filter is only implemented for dimension 2 and 3." );
   }
 
-  /** Get a handle to the B-spline coefficient images. */
-  std::vector< CoefficientImagePointer > inputImages( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
+  /** TASK 0:
+   * Compute the rigidityCoefficientSum and check on it.
+   *
+   ************************************************************************* */
+
+  /** Create iterator over the rigidity coeficient image. */
+  CoefficientImageIteratorType it_RCI( this->m_RigidityCoefficientImage,
+  this->m_RigidityCoefficientImage->GetLargestPossibleRegion() );
+  it_RCI.GoToBegin();
+  ScalarType rigidityCoefficientSum = NumericTraits< ScalarType >::Zero;
+
+  /** Add the rigidity coefficients together. */
+  while( !it_RCI.IsAtEnd() )
   {
-    inputImages[ i ] = this->m_BSplineTransform->GetCoefficientImages()[ i ];
+    rigidityCoefficientSum += it_RCI.Get();
+    ++it_RCI;
   }
 
-  /** Get the B-spline coefficient image spacing. */
-  CoefficientImageSpacingType spacing = inputImages[ 0 ]->GetSpacing();
+  /** Check for early termination. */
+  if( rigidityCoefficientSum < 1e-14 )
+  {
+    this->m_RigidityPenaltyTermValue = NumericTraits< MeasureType >::Zero;
+    return this->m_RigidityPenaltyTermValue;
+  }
+
+  /** TASK 1:
+   * Compute the condition values, in a single pass over the coefficient images
+   * or with the filter chains, and combine them to the rigidity penalty term value.
+   *
+   ************************************************************************* */
+
+  if( this->m_UseFusedPasses )
+  {
+    this->ComputeConditionValues( rigidityCoefficientSum, false );
+  }
+  else
+  {
+    this->ComputeConditionValuesWithFilters( rigidityCoefficientSum );
+  }
+
+  /** Return the rigidity penalty term value. */
+  return this->m_RigidityPenaltyTermValue;
+
+} // end GetValue()
+
+
+
+/**
+ * *********************** GetDerivative ************************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::GetDerivative( const ParametersType & parameters,
+  DerivativeType & derivative ) const
+{
+  /** When the derivative is calculated, all information for calculating
+   * the metric value is available. It does not cost anything to calculate
+   * the metric value now. Therefore, we have chosen to only implement the
+   * GetValueAndDerivative(), supplying it with a dummy value variable.
+   */
+  MeasureType dummyvalue = NumericTraits< MeasureType >::Zero;
+  this->GetValueAndDerivative( parameters, dummyvalue, derivative );
+
+} // end GetDerivative()
+
+
+/**
+ * *********************** BeforeThreadedGetValueAndDerivative ***********************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::BeforeThreadedGetValueAndDerivative( const TransformParametersType & parameters ) const
+{
+  /** In this function do all stuff that cannot be multi-threaded.
+   * Meant for use in the combo-metric. So, I did not think about general usage yet.
+   */
+  if( this->m_UseMetricSingleThreaded )
+  {
+    this->m_BSplineTransform->SetParameters( parameters );
+  }
+
+} // end BeforeThreadedGetValueAndDerivative()
+
+
+/**
+ * *********************** GetValueAndDerivative ****************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::GetValueAndDerivative( const ParametersType & parameters,
+  MeasureType & value, DerivativeType & derivative ) const
+{
+  /** Fill the rigidity image based on the current transform parameters. */
+  this->FillRigidityCoefficientImage( parameters );
+
+  /** Set output values to zero. */
+  value                                = NumericTraits< MeasureType >::Zero;
+  this->m_RigidityPenaltyTermValue     = NumericTraits< MeasureType >::Zero;
+  this->m_LinearityConditionValue      = NumericTraits< MeasureType >::Zero;
+  this->m_OrthonormalityConditionValue = NumericTraits< MeasureType >::Zero;
+  this->m_PropernessConditionValue     = NumericTraits< MeasureType >::Zero;
+
+  /** Set output values to zero. */
+  derivative = DerivativeType( this->GetNumberOfParameters() );
+  derivative.Fill( NumericTraits< MeasureType >::ZeroValue() );
+
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   * Because of these calls GetValueAndDerivative itself is not thread-safe,
+   * so cannot be called multiple times simultaneously.
+   * This is however needed in the CombinationImageToImageMetric.
+   * In that case, you need to:
+   * - switch the use of this function to on, using m_UseMetricSingleThreaded = true
+   * - call BeforeThreadedGetValueAndDerivative once (single-threaded) before
+   *   calling GetValueAndDerivative
+   * - switch the use of this function to off, using m_UseMetricSingleThreaded = false
+   * - Now you can call GetValueAndDerivative multi-threaded.
+   */
+  this->BeforeThreadedGetValueAndDerivative( parameters );
+
+  /** Sanity check. */
+  if( ImageDimension != 2 && ImageDimension != 3 )
+  {
+    itkExceptionMacro( << "ERROR: This filter is only implemented for dimension 2 and 3." );
+  }
 
   /** TASK 0:
    * Compute the rigidityCoefficientSum and check on it.
@@ -527,9 +659,60 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   if( rigidityCoefficientSum < 1e-14 )
   {
     this->m_RigidityPenaltyTermValue = NumericTraits< MeasureType >::Zero;
-    return this->m_RigidityPenaltyTermValue;
+    return;
+  }
+
+  /** The filter chains compute the value and the derivative at once. */
+  if( !this->m_UseFusedPasses )
+  {
+    this->ComputeConditionValuesAndDerivativeWithFilters( rigidityCoefficientSum, derivative );
+    value = this->m_RigidityPenaltyTermValue;
+    return;
+  }
+
+  /** TASK 1:
+   * Compute the condition values, and store the subparts of their derivatives,
+   * in a single pass over the coefficient images.
+   *
+   ************************************************************************* */
+
+  this->ComputeConditionValues( rigidityCoefficientSum, true );
+  value = this->m_RigidityPenaltyTermValue;
+
+  /** TASK 2:
+   * Filter the subparts with the adjoint operators, and add it all to create
+   * the derivative, in a second pass over the coefficient images.
+   *
+   ************************************************************************* */
+
+  this->ComputeConditionDerivatives( rigidityCoefficientSum, derivative );
+
+} // end GetValueAndDerivative()
+
+
+/**
+ * *********************** ComputeConditionValuesWithFilters ****************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ComputeConditionValuesWithFilters( const ScalarType rigidityCoefficientSum ) const
+{
+  /** Get a handle to the B-spline coefficient images. */
+  std::vector< CoefficientImagePointer > inputImages( ImageDimension );
+  for( unsigned int i = 0; i < ImageDimension; i++ )
+  {
+    inputImages[ i ] = this->m_BSplineTransform->GetCoefficientImages()[ i ];
   }
 
+  /** Get the B-spline coefficient image spacing. */
+  CoefficientImageSpacingType spacing = inputImages[ 0 ]->GetSpacing();
+
+  /** Create iterator over the rigidity coeficient image. */
+  CoefficientImageIteratorType it_RCI( this->m_RigidityCoefficientImage,
+  this->m_RigidityCoefficientImage->GetLargestPossibleRegion() );
+
   /** TASK 1:
    * Prepare for the calculation of the rigidity penalty term.
    *
@@ -887,151 +1070,51 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
       += this->m_PropernessConditionWeight * this->m_PropernessConditionValue;
   }
 
-  /** Return the rigidity penalty term value. */
-  return this->m_RigidityPenaltyTermValue;
-
-} // end GetValue()
-
-
-/**
- * *********************** GetDerivative ************************
- */
-
-template< class TFixedImage, class TScalarType >
-void
-TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
-::GetDerivative( const ParametersType & parameters,
-  DerivativeType & derivative ) const
-{
-  /** When the derivative is calculated, all information for calculating
-   * the metric value is available. It does not cost anything to calculate
-   * the metric value now. Therefore, we have chosen to only implement the
-   * GetValueAndDerivative(), supplying it with a dummy value variable.
-   */
-  MeasureType dummyvalue = NumericTraits< MeasureType >::Zero;
-  this->GetValueAndDerivative( parameters, dummyvalue, derivative );
-
-} // end GetDerivative()
+} // end ComputeConditionValuesWithFilters()
 
 
 /**
- * *********************** BeforeThreadedGetValueAndDerivative ***********************
+ * *********************** ComputeConditionValuesAndDerivativeWithFilters ****************
  */
 
 template< class TFixedImage, class TScalarType >
 void
 TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
-::BeforeThreadedGetValueAndDerivative( const TransformParametersType & parameters ) const
+::ComputeConditionValuesAndDerivativeWithFilters(
+  const ScalarType rigidityCoefficientSum, DerivativeType & derivative ) const
 {
-  /** In this function do all stuff that cannot be multi-threaded.
-   * Meant for use in the combo-metric. So, I did not think about general usage yet.
-   */
-  if( this->m_UseMetricSingleThreaded )
+  /** Get a handle to the B-spline coefficient images. */
+  std::vector< CoefficientImagePointer > inputImages( ImageDimension );
+  for( unsigned int i = 0; i < ImageDimension; i++ )
   {
-    this->m_BSplineTransform->SetParameters( parameters );
+    inputImages[ i ] = this->m_BSplineTransform->GetCoefficientImages()[ i ];
   }
 
-} // end BeforeThreadedGetValueAndDerivative()
-
+  /** Get the B-spline coefficient image spacing. */
+  CoefficientImageSpacingType spacing = inputImages[ 0 ]->GetSpacing();
 
-/**
- * *********************** GetValueAndDerivative ****************
- */
+  /** Create iterator over the rigidity coeficient image. */
+  CoefficientImageIteratorType it_RCI( this->m_RigidityCoefficientImage,
+  this->m_RigidityCoefficientImage->GetLargestPossibleRegion() );
 
-template< class TFixedImage, class TScalarType >
-void
-TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
-::GetValueAndDerivative( const ParametersType & parameters,
-  MeasureType & value, DerivativeType & derivative ) const
-{
-  /** Fill the rigidity image based on the current transform parameters. */
-  this->FillRigidityCoefficientImage( parameters );
+  /** TASK 1:
+   * Prepare for the calculation of the rigidity penalty term.
+   *
+   ************************************************************************* */
 
-  /** Set output values to zero. */
-  value                                = NumericTraits< MeasureType >::Zero;
-  this->m_RigidityPenaltyTermValue     = NumericTraits< MeasureType >::Zero;
-  this->m_LinearityConditionValue      = NumericTraits< MeasureType >::Zero;
-  this->m_OrthonormalityConditionValue = NumericTraits< MeasureType >::Zero;
-  this->m_PropernessConditionValue     = NumericTraits< MeasureType >::Zero;
+  /** Create 1D neighbourhood operators. */
+  std::vector< NeighborhoodType > Operators_A( ImageDimension ),
+  Operators_B( ImageDimension ), Operators_C( ImageDimension ),
+  Operators_D( ImageDimension ), Operators_E( ImageDimension ),
+  Operators_F( ImageDimension ), Operators_G( ImageDimension ),
+  Operators_H( ImageDimension ), Operators_I( ImageDimension );
 
-  /** Set output values to zero. */
-  derivative = DerivativeType( this->GetNumberOfParameters() );
-  derivative.Fill( NumericTraits< MeasureType >::ZeroValue() );
-
-  /** Call non-thread-safe stuff, such as:
-   *   this->SetTransformParameters( parameters );
-   *   this->GetImageSampler()->Update();
-   * Because of these calls GetValueAndDerivative itself is not thread-safe,
-   * so cannot be called multiple times simultaneously.
-   * This is however needed in the CombinationImageToImageMetric.
-   * In that case, you need to:
-   * - switch the use of this function to on, using m_UseMetricSingleThreaded = true
-   * - call BeforeThreadedGetValueAndDerivative once (single-threaded) before
-   *   calling GetValueAndDerivative
-   * - switch the use of this function to off, using m_UseMetricSingleThreaded = false
-   * - Now you can call GetValueAndDerivative multi-threaded.
-   */
-  this->BeforeThreadedGetValueAndDerivative( parameters );
-
-  /** Sanity check. */
-  if( ImageDimension != 2 && ImageDimension != 3 )
-  {
-    itkExceptionMacro( << "ERROR: This filter is only implemented for dimension 2 and 3." );
-  }
-
-  /** Get a handle to the B-spline coefficient images. */
-  std::vector< CoefficientImagePointer > inputImages( ImageDimension );
-  for( unsigned int i = 0; i < ImageDimension; i++ )
-  {
-    inputImages[ i ] = this->m_BSplineTransform->GetCoefficientImages()[ i ];
-  }
-
-  /** Get the B-spline coefficient image spacing. */
-  CoefficientImageSpacingType spacing = inputImages[ 0 ]->GetSpacing();
-
-  /** TASK 0:
-   * Compute the rigidityCoefficientSum and check on it.
-   *
-   ************************************************************************* */
-
-  /** Create iterator over the rigidity coeficient image. */
-  CoefficientImageIteratorType it_RCI( this->m_RigidityCoefficientImage,
-  this->m_RigidityCoefficientImage->GetLargestPossibleRegion() );
-  it_RCI.GoToBegin();
-  ScalarType rigidityCoefficientSum = NumericTraits< ScalarType >::Zero;
-
-  /** Add the rigidity coefficients together. */
-  while( !it_RCI.IsAtEnd() )
-  {
-    rigidityCoefficientSum += it_RCI.Get();
-    ++it_RCI;
-  }
-
-  /** Check for early termination. */
-  if( rigidityCoefficientSum < 1e-14 )
-  {
-    this->m_RigidityPenaltyTermValue = NumericTraits< MeasureType >::Zero;
-    return;
-  }
-
-  /** TASK 1:
-   * Prepare for the calculation of the rigidity penalty term.
-   *
-   ************************************************************************* */
-
-  /** Create 1D neighbourhood operators. */
-  std::vector< NeighborhoodType > Operators_A( ImageDimension ),
-  Operators_B( ImageDimension ), Operators_C( ImageDimension ),
-  Operators_D( ImageDimension ), Operators_E( ImageDimension ),
-  Operators_F( ImageDimension ), Operators_G( ImageDimension ),
-  Operators_H( ImageDimension ), Operators_I( ImageDimension );
-
-  /** Create B-spline coefficient images that are filtered once. */
-  std::vector< CoefficientImagePointer > ui_FA( ImageDimension ),
-  ui_FB( ImageDimension ), ui_FC( ImageDimension ),
-  ui_FD( ImageDimension ), ui_FE( ImageDimension ),
-  ui_FF( ImageDimension ), ui_FG( ImageDimension ),
-  ui_FH( ImageDimension ), ui_FI( ImageDimension );
+  /** Create B-spline coefficient images that are filtered once. */
+  std::vector< CoefficientImagePointer > ui_FA( ImageDimension ),
+  ui_FB( ImageDimension ), ui_FC( ImageDimension ),
+  ui_FD( ImageDimension ), ui_FE( ImageDimension ),
+  ui_FF( ImageDimension ), ui_FG( ImageDimension ),
+  ui_FH( ImageDimension ), ui_FI( ImageDimension );
 
   /** For all dimensions ... */
   for( unsigned int i = 0; i < ImageDimension; i++ )
@@ -1318,12 +1401,12 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
         /** mu1, part2 */
         valueOC
           = +( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * mu1_B
-          + ( 1.0 + mu1_A ) * mu2_A * mu3_B
+          + ( 1.0 + mu1_A ) * mu2_A * ( 1.0 + mu2_B )
           + ( 1.0 + mu1_A ) * mu3_A * mu3_B
-          + mu1_B * mu1_B * mu1_B
-          + mu1_B * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
-          + mu1_B * mu3_B * mu3_B
-          - mu1_B
+          + 2.0 * mu1_B * mu1_B * mu1_B
+          + 2.0 * mu1_B * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
+          + 2.0 * mu1_B * mu3_B * mu3_B
+          - 2.0 * mu1_B
           + mu1_B * mu1_C * mu1_C
           + mu1_C * ( 1.0 + mu2_B ) * mu2_C
           + mu1_C * mu3_B * ( 1.0 + mu3_C );
@@ -1373,7 +1456,7 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
           + ( 1.0 + mu1_A ) * mu1_C * mu2_A
           + mu2_A * mu3_A * ( 1.0 + mu3_C )
           + ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu2_C
-          + mu1_B * mu1_C * mu2_B
+          + mu1_B * mu1_C * ( 1.0 + mu2_B )
           + ( 1.0 + mu2_B ) * mu3_B * ( 1.0 + mu3_C )
           + 2.0 * mu2_C * mu2_C * mu2_C
           + 2.0 * mu1_C * mu1_C * mu2_C
@@ -1628,7 +1711,7 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
           - ( 1.0 + mu1_A ) * mu1_B * mu2_C * mu2_C * mu3_B
           - mu1_B * mu1_B * mu2_A * mu2_C * ( 1.0 + mu3_C )
           + ( 1.0 + mu1_A ) * mu1_B * ( 1.0 + mu2_B ) * mu2_C * ( 1.0 + mu3_C )
-          + mu1_B * mu2_C;
+          - mu1_B * mu2_C;
         itPCp[ 2 ][ 0 ].Set( 2.0 * valuePC );
         /** mu3, part 2 */
         valuePC
@@ -1657,7 +1740,7 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
           - mu1_B * mu1_C * mu2_A * mu2_A * mu3_B
           + ( 1.0 + mu1_A ) * mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_B
           + ( 1.0 + mu1_A ) * mu1_B * mu2_A * mu2_C * mu3_B
-          + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu2_C * mu3_B
+          - ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu2_C * mu3_B
           - 2.0 * ( 1.0 + mu1_A ) * mu1_B * mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
           + mu1_B * mu2_A
           - ( 1.0 + mu1_A ) * ( 1.0 + mu2_B );
@@ -1796,7 +1879,6 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     this->m_RigidityPenaltyTermValue
       += this->m_PropernessConditionWeight * this->m_PropernessConditionValue;
   }
-  value = this->m_RigidityPenaltyTermValue;
 
   /** TASK 6:
    * Create filtered versions of the subparts.
@@ -2148,7 +2230,1015 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
     } // end while
   } // end for
 
-} // end GetValueAndDerivative()
+} // end ComputeConditionValuesAndDerivativeWithFilters()
+
+
+/**
+ * *********************** ComputeConditionValues ****************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ComputeConditionValues( const ScalarType rigidityCoefficientSum,
+  const bool computeParts ) const
+{
+  /** Create the stencils, for the current B-spline grid spacing. */
+  this->InitializeStencils(
+    this->m_BSplineTransform->GetCoefficientImages()[ 0 ]->GetSpacing() );
+
+  /** Make sure the workspaces have the right size. This does not reallocate
+   * when the size of the B-spline grid did not change since the last call.
+   */
+  const SizeValueType numberOfVoxels
+    = this->m_RigidityCoefficientImage->GetBufferedRegion().GetNumberOfPixels();
+  const SizeValueType numberOfRows = numberOfVoxels
+    / this->m_RigidityCoefficientImage->GetBufferedRegion().GetSize()[ 0 ];
+  this->m_RowSums.resize( 3 * numberOfRows );
+  if( computeParts )
+  {
+    this->m_SubpartsWorkspace.resize( numberOfVoxels * NumberOfSubparts );
+  }
+
+  /** Do the pass over the rows of the images, multi-threaded if desired. */
+  this->m_RigidityPenaltyThreaderParameters.st_NumberOfRows = numberOfRows;
+  this->m_RigidityPenaltyThreaderParameters.st_ComputeParts = computeParts;
+  if( this->m_UseMultiThread )
+  {
+    this->ExecuteThreaderCallback( this->ComputeConditionValuesThreaderCallback,
+      const_cast< void * >( static_cast< const void * >(
+        &this->m_RigidityPenaltyThreaderParameters ) ) );
+  }
+  else
+  {
+    this->ComputeConditionValuesForRows( 0, numberOfRows, computeParts );
+  }
+
+  /** Add the contributions of the rows, always in the same order,
+   * so that the result does not depend on the number of threads.
+   */
+  for( SizeValueType row = 0; row < numberOfRows; ++row )
+  {
+    this->m_LinearityConditionValue      += this->m_RowSums[ 3 * row ];
+    this->m_OrthonormalityConditionValue += this->m_RowSums[ 3 * row + 1 ];
+    this->m_PropernessConditionValue     += this->m_RowSums[ 3 * row + 2 ];
+  }
+
+  /** Calculate the rigidity penalty term value. */
+  if( this->m_CalculateLinearityCondition )
+  {
+    this->m_LinearityConditionValue /= rigidityCoefficientSum;
+  }
+  if( this->m_CalculateOrthonormalityCondition )
+  {
+    this->m_OrthonormalityConditionValue /= rigidityCoefficientSum;
+  }
+  if( this->m_CalculatePropernessCondition )
+  {
+    this->m_PropernessConditionValue /= rigidityCoefficientSum;
+  }
+
+  if( this->m_UseLinearityCondition )
+  {
+    this->m_RigidityPenaltyTermValue
+      += this->m_LinearityConditionWeight * this->m_LinearityConditionValue;
+  }
+  if( this->m_UseOrthonormalityCondition )
+  {
+    this->m_RigidityPenaltyTermValue
+      += this->m_OrthonormalityConditionWeight * this->m_OrthonormalityConditionValue;
+  }
+  if( this->m_UsePropernessCondition )
+  {
+    this->m_RigidityPenaltyTermValue
+      += this->m_PropernessConditionWeight * this->m_PropernessConditionValue;
+  }
+
+} // end ComputeConditionValues()
+
+
+/**
+ * *********************** ComputeConditionDerivatives ****************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ComputeConditionDerivatives( const ScalarType rigidityCoefficientSum,
+  DerivativeType & derivative ) const
+{
+  const SizeValueType numberOfRows
+    = this->m_RigidityPenaltyThreaderParameters.st_NumberOfRows;
+
+  /** Do the pass over the rows of the images, multi-threaded if desired. */
+  this->m_RigidityPenaltyThreaderParameters.st_DerivativePointer      = derivative.data_block();
+  this->m_RigidityPenaltyThreaderParameters.st_RigidityCoefficientSum = rigidityCoefficientSum;
+  if( this->m_UseMultiThread )
+  {
+    this->ExecuteThreaderCallback( this->ComputeConditionDerivativesThreaderCallback,
+      const_cast< void * >( static_cast< const void * >(
+        &this->m_RigidityPenaltyThreaderParameters ) ) );
+  }
+  else
+  {
+    this->ComputeConditionDerivativesForRows( 0, numberOfRows,
+      derivative.data_block(), rigidityCoefficientSum );
+  }
+
+  /** Add the contributions of the rows to the gradient magnitudes,
+   * always in the same order.
+   */
+  MeasureType gradMagLC = NumericTraits< MeasureType >::Zero;
+  MeasureType gradMagOC = NumericTraits< MeasureType >::Zero;
+  MeasureType gradMagPC = NumericTraits< MeasureType >::Zero;
+  for( SizeValueType row = 0; row < numberOfRows; ++row )
+  {
+    gradMagLC += this->m_RowSums[ 3 * row ];
+    gradMagOC += this->m_RowSums[ 3 * row + 1 ];
+    gradMagPC += this->m_RowSums[ 3 * row + 2 ];
+  }
+
+  /** Set the gradient magnitudes of the several terms. */
+  this->m_LinearityConditionGradientMagnitude
+    = std::sqrt( gradMagLC ) / rigidityCoefficientSum;
+  this->m_OrthonormalityConditionGradientMagnitude
+    = std::sqrt( gradMagOC ) / rigidityCoefficientSum;
+  this->m_PropernessConditionGradientMagnitude
+    = std::sqrt( gradMagPC ) / rigidityCoefficientSum;
+
+} // end ComputeConditionDerivatives()
+
+
+/**
+ * *********************** ComputeConditionValuesForRows ****************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ComputeConditionValuesForRows( const SizeValueType rowBegin,
+  const SizeValueType rowEnd, const bool computeParts ) const
+{
+  /** Get the buffers of the coefficient images and the rigidity coefficient image.
+   * All have the same region, the B-spline grid region.
+   */
+  const CoefficientPixelType * coefficients[ 3 ] = { nullptr, nullptr, nullptr };
+  for( unsigned int i = 0; i < ImageDimension; i++ )
+  {
+    coefficients[ i ] = this->m_BSplineTransform->GetCoefficientImages()[ i ]->GetBufferPointer();
+  }
+  const RigidityPixelType * rigidity = this->m_RigidityCoefficientImage->GetBufferPointer();
+  const SizeValueType sizeX = this->m_RigidityCoefficientImage->GetBufferedRegion().GetSize()[ 0 ];
+
+  /** The first derivative operators are FA, FB and FC, and the second
+   * derivative operators of the linearity condition FD, FE, FG, FF, FH and FI.
+   */
+  const unsigned int linearityOperators[ 6 ] = {
+    OperatorD, OperatorE, OperatorG, OperatorF, OperatorH, OperatorI };
+  const bool calculateLC = this->m_CalculateLinearityCondition;
+  const bool calculateOC = this->m_CalculateOrthonormalityCondition;
+  const bool calculatePC = this->m_CalculatePropernessCondition;
+
+  const ScalarType * stencils = &this->m_SeparableStencils[ 0 ];
+  ScalarType *       subparts = computeParts ? &this->m_SubpartsWorkspace[ 0 ] : nullptr;
+
+  SizeValueType rowOffsets[ NumberOfNeighbours / 3 ];
+  for( SizeValueType row = rowBegin; row < rowEnd; ++row )
+  {
+    /** Compute the offsets of the neighbouring rows, with clamping at the borders. */
+    this->ComputeRowOffsets( row, rowOffsets );
+
+    MeasureType rowValueLC = NumericTraits< MeasureType >::Zero;
+    MeasureType rowValueOC = NumericTraits< MeasureType >::Zero;
+    MeasureType rowValuePC = NumericTraits< MeasureType >::Zero;
+    for( SizeValueType x = 0; x < sizeX; ++x )
+    {
+      /** The centre row has relative position 0 in all dimensions, see ComputeRowOffsets(). */
+      const SizeValueType voxel = rowOffsets[ NumberOfNeighbours / 6 ] + x;
+      const ScalarType    c     = rigidity[ voxel ];
+
+      /** The neighbouring columns, with clamping at the borders. */
+      const SizeValueType columns[ 3 ] = {
+        x > 0 ? x - 1 : 0, x, x + 1 < sizeX ? x + 1 : x };
+
+      /** Apply the separable operators to the neighbourhood of each coefficient image.
+       * mu[ i ][ F ] is the result of operator F on coefficient image i.
+       */
+      ScalarType mu[ 3 ][ NumberOfOperators ] = {};
+      for( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+        ScalarType neighbourhood[ NumberOfNeighbours ];
+        for( unsigned int k = 0; k < NumberOfNeighbours; ++k )
+        {
+          neighbourhood[ k ] = coefficients[ i ][ rowOffsets[ k / 3 ] + columns[ k % 3 ] ];
+        }
+        if( calculateOC || calculatePC )
+        {
+          for( unsigned int j = 0; j < ImageDimension; j++ )
+          {
+            mu[ i ][ j ] = this->ApplyStencil( stencils + j * NumberOfNeighbours, neighbourhood );
+          }
+        }
+        if( calculateLC )
+        {
+          for( unsigned int j = 0; j < NumberOfLinearityParts; j++ )
+          {
+            const unsigned int op = linearityOperators[ j ];
+            mu[ i ][ op ] = this->ApplyStencil( stencils + op * NumberOfNeighbours, neighbourhood );
+          }
+        }
+      }
+
+      /** Copy values: this way the formulas below remain readable. */
+      const ScalarType mu1_A = mu[ 0 ][ OperatorA ];
+      const ScalarType mu2_A = mu[ 1 ][ OperatorA ];
+      const ScalarType mu3_A = mu[ 2 ][ OperatorA ];
+      const ScalarType mu1_B = mu[ 0 ][ OperatorB ];
+      const ScalarType mu2_B = mu[ 1 ][ OperatorB ];
+      const ScalarType mu3_B = mu[ 2 ][ OperatorB ];
+      const ScalarType mu1_C = mu[ 0 ][ OperatorC ];
+      const ScalarType mu2_C = mu[ 1 ][ OperatorC ];
+      const ScalarType mu3_C = mu[ 2 ][ OperatorC ];
+
+      /** Calculate the orthonormality condition and its subparts. */
+      if( calculateOC )
+      {
+        ScalarType partsOC[ 3 ][ 3 ];
+        ScalarType valueOC;
+        if( ImageDimension == 2 )
+        {
+          /** Calculate the value of the orthonormality condition. */
+          rowValueOC
+            += c * (
+            std::pow(
+            +( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
+            + mu2_A * mu2_A
+            - 1.0,
+            2.0 )
+            + std::pow(
+            +mu1_B * mu1_B
+            + ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
+            - 1.0,
+            2.0 )
+            + std::pow(
+            +( 1.0 + mu1_A ) * mu1_B
+            + mu2_A * ( 1.0 + mu2_B ),
+            2.0 )
+            );
+          if( computeParts )
+          {
+            /** Calculate the derivative of the orthonormality condition. */
+            /** mu1, part 1 */
+            valueOC
+              = +2.0 * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
+              + 2.0 * mu2_A * mu2_A * ( 1.0 + mu1_A )
+              - 2.0 * ( 1.0 + mu1_A )
+              + mu1_B * mu1_B * ( 1.0 + mu1_A )
+              + mu2_A * ( 1.0 + mu2_B ) * mu1_B;
+            partsOC[ 0 ][ 0 ] = 2.0 * valueOC;
+            /** mu1, part2*/
+            valueOC
+              = +mu1_B * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
+              + mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu1_A )
+              + 2.0 * mu1_B * mu1_B * mu1_B
+              + 2.0 * mu1_B * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
+              - 2.0 * mu1_B;
+            partsOC[ 0 ][ 1 ] = 2.0 * valueOC;
+            /** mu2, part 1 */
+            valueOC
+              = +2.0 * mu2_A * mu2_A * mu2_A
+              + 2.0 * mu2_A * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
+              - 2.0 * mu2_A
+              + mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
+              + mu1_B * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B );
+            partsOC[ 1 ][ 0 ] = 2.0 * valueOC;
+            /** mu2, part2*/
+            valueOC
+              = +mu2_A * mu2_A * ( 1.0 + mu2_B )
+              + mu1_B * ( 1.0 + mu1_A ) * mu2_A
+              + 2.0 * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
+              + 2.0 * mu1_B * mu1_B * ( 1.0 + mu2_B )
+              - 2.0 * ( 1.0 + mu2_B );
+            partsOC[ 1 ][ 1 ] = 2.0 * valueOC;
+          }
+        } // end if dim == 2
+        else if( ImageDimension == 3 )
+        {
+          /** Calculate the value of the orthonormality condition. */
+          rowValueOC
+            += c * (
+            std::pow(
+            +( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
+            + mu2_A * mu2_A
+            + mu3_A * mu3_A
+            - 1.0,
+            2.0 )
+            + std::pow(
+            +( 1.0 + mu1_A ) * mu1_B
+            + mu2_A * ( 1.0 + mu2_B )
+            + mu3_A * mu3_B,
+            2.0 )
+            + std::pow(
+            +( 1.0 + mu1_A ) * mu1_C
+            + mu2_A * mu2_C
+            + mu3_A * ( 1.0 + mu3_C ),
+            2.0 )
+            + std::pow(
+            +mu1_B * mu1_B
+            + ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
+            + mu3_B * mu3_B
+            - 1.0,
+            2.0 )
+            + std::pow(
+            +mu1_B * mu1_C
+            + ( 1.0 + mu2_B ) * mu2_C
+            + mu3_B * ( 1.0 + mu3_C ),
+            2.0 )
+            + std::pow(
+            +mu1_C * mu1_C
+            + mu2_C * mu2_C
+            + ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+            - 1.0,
+            2.0 ) );
+          if( computeParts )
+          {
+            /** Calculate the derivative of the orthonormality condition. */
+            /** mu1, part 1 */
+            valueOC
+              = +2.0 * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
+              + 2.0 * mu2_A * mu2_A * ( 1.0 + mu1_A )
+              + 2.0 * ( 1.0 + mu1_A ) * mu3_A * mu3_A
+              - 2.0 * ( 1.0 + mu1_A )
+              + mu1_B * mu1_B * ( 1.0 + mu1_A )
+              + mu2_A * ( 1.0 + mu2_B ) * mu1_B
+              + mu1_B * mu3_A * mu3_B
+              + ( 1.0 + mu1_A ) * mu1_C * mu1_C
+              + mu1_C * mu2_A * mu2_C
+              + mu1_C * mu3_A * ( 1.0 + mu3_C );
+            partsOC[ 0 ][ 0 ] = 2.0 * valueOC;
+            /** mu1, part2 */
+            valueOC
+              = +( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * mu1_B
+              + ( 1.0 + mu1_A ) * mu2_A * ( 1.0 + mu2_B )
+              + ( 1.0 + mu1_A ) * mu3_A * mu3_B
+              + 2.0 * mu1_B * mu1_B * mu1_B
+              + 2.0 * mu1_B * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
+              + 2.0 * mu1_B * mu3_B * mu3_B
+              - 2.0 * mu1_B
+              + mu1_B * mu1_C * mu1_C
+              + mu1_C * ( 1.0 + mu2_B ) * mu2_C
+              + mu1_C * mu3_B * ( 1.0 + mu3_C );
+            partsOC[ 0 ][ 1 ] = 2.0 * valueOC;
+            /** mu1, part3 */
+            valueOC
+              = +( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * mu1_C
+              + ( 1.0 + mu1_A ) * mu2_A * mu2_C
+              + ( 1.0 + mu1_A ) * mu3_A * ( 1.0 + mu3_C )
+              + mu1_B * mu1_B * mu1_C
+              + mu1_B * ( 1.0 + mu2_B ) * mu2_C
+              + mu1_B * mu3_B * ( 1.0 + mu3_C )
+              + 2.0 * mu1_C * mu1_C * mu1_C
+              + 2.0 * mu1_C * mu2_C * mu2_C
+              + 2.0 * mu1_C * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+              - 2.0 * mu1_C;
+            partsOC[ 0 ][ 2 ] = 2.0 * valueOC;
+            /** mu2, part 1 */
+            valueOC
+              = +2.0 * mu2_A * mu2_A * mu2_A
+              + 2.0 * mu2_A * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
+              - 2.0 * mu2_A
+              + 2.0 * mu2_A * mu3_A * mu3_A
+              + mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
+              + mu1_B * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B )
+              + ( 1.0 + mu2_B ) * mu3_A * mu3_B
+              + mu2_A * mu2_C * mu2_C
+              + ( 1.0 + mu1_A ) * mu1_C * mu2_C
+              + mu2_C * mu3_A * ( 1.0 + mu3_C );
+            partsOC[ 1 ][ 0 ] = 2.0 * valueOC;
+            /** mu2, part2 */
+            valueOC
+              = +mu2_A * mu2_A * ( 1.0 + mu2_B )
+              + mu1_B * ( 1.0 + mu1_A ) * mu2_A
+              + mu2_A * mu3_A * mu3_B
+              + 2.0 * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B )
+              + 2.0 * mu1_B * mu1_B * ( 1.0 + mu2_B )
+              - 2.0 * ( 1.0 + mu2_B )
+              + 2.0 * ( 1.0 + mu2_B ) * mu3_B * mu3_B
+              + ( 1.0 + mu2_B ) * mu2_C * mu2_C
+              + mu1_B * mu1_C * mu2_C
+              + mu2_C * mu3_B * ( 1.0 + mu3_C );
+            partsOC[ 1 ][ 1 ] = 2.0 * valueOC;
+            /** mu2, part 3 */
+            valueOC
+              = +mu2_A * mu2_A * mu2_C
+              + ( 1.0 + mu1_A ) * mu1_C * mu2_A
+              + mu2_A * mu3_A * ( 1.0 + mu3_C )
+              + ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu2_C
+              + mu1_B * mu1_C * ( 1.0 + mu2_B )
+              + ( 1.0 + mu2_B ) * mu3_B * ( 1.0 + mu3_C )
+              + 2.0 * mu2_C * mu2_C * mu2_C
+              + 2.0 * mu1_C * mu1_C * mu2_C
+              + 2.0 * mu2_C * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+              - 2.0 * mu2_C;
+            partsOC[ 1 ][ 2 ] = 2.0 * valueOC;
+            /** mu3, part 1 */
+            valueOC
+              = +2.0 * mu3_A * mu3_A * mu3_A
+              + 2.0 * mu3_A * ( 1.0 + mu1_A ) * ( 1.0 + mu1_A )
+              - 2.0 * mu3_A
+              + 2.0 * mu2_A * mu2_A * mu3_A
+              + mu3_A * mu3_B * mu3_B
+              + mu1_B * ( 1.0 + mu1_A ) * mu3_B
+              + ( 1.0 + mu2_B ) * mu2_A * mu3_B
+              + mu3_A * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+              + ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu3_C )
+              + mu2_C * mu2_A * ( 1.0 + mu3_C );
+            partsOC[ 2 ][ 0 ] = 2.0 * valueOC;
+            /** mu3, part2 */
+            valueOC
+              = +mu3_A * mu3_A * mu3_B
+              + mu1_B * ( 1.0 + mu1_A ) * mu3_A
+              + mu2_A * mu3_A * ( 1.0 + mu2_B )
+              + 2.0 *  mu3_B *  mu3_B *  mu3_B
+              + 2.0 * mu1_B * mu1_B *  mu3_B
+              - 2.0 *  mu3_B
+              + 2.0 * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_B
+              + mu3_B * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+              + mu1_B * mu1_C * ( 1.0 + mu3_C )
+              + mu2_C * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C );
+            partsOC[ 2 ][ 1 ] = 2.0 * valueOC;
+            /** mu3, part 3 */
+            valueOC
+              = +mu3_A * mu3_A * ( 1.0 + mu3_C )
+              + ( 1.0 + mu1_A ) * mu1_C * mu3_A
+              + mu2_A * mu3_A * mu2_C
+              + mu3_B * mu3_B * ( 1.0 + mu3_C )
+              + mu1_B * mu1_C * mu3_B
+              + ( 1.0 + mu2_B ) * mu3_B * mu2_C
+              + 2.0 * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+              + 2.0 * mu1_C * mu1_C * ( 1.0 + mu3_C )
+              + 2.0 * mu2_C * mu2_C * ( 1.0 + mu3_C )
+              - 2.0 * ( 1.0 + mu3_C );
+            partsOC[ 2 ][ 2 ] = 2.0 * valueOC;
+          }
+        } // end if dim == 3
+
+        if( computeParts )
+        {
+          ScalarType * subpartsOC = subparts + voxel * NumberOfSubparts + SubpartsOffsetOC;
+          for( unsigned int i = 0; i < ImageDimension; i++ )
+          {
+            for( unsigned int j = 0; j < ImageDimension; j++ )
+            {
+              subpartsOC[ i * ImageDimension + j ] = c * partsOC[ i ][ j ];
+            }
+          }
+        }
+      } // end if do orthonormality
+
+      /** Calculate the properness condition and its subparts. */
+      if( calculatePC )
+      {
+        ScalarType partsPC[ 3 ][ 3 ];
+        ScalarType valuePC;
+        if( ImageDimension == 2 )
+        {
+          /** Calculate the value of the properness condition. */
+          rowValuePC
+            += c * (
+            std::pow(
+            +( 1.0 + mu1_A ) * ( 1.0 + mu2_B )
+            - mu2_A * mu1_B
+            - 1.0,
+            2.0 )
+            );
+          if( computeParts )
+          {
+            /** Calculate the derivative of the properness condition. */
+            /** mu1, part 1 */
+            valuePC
+              = +( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu1_A )
+              - mu2_A * ( 1.0 + mu2_B ) * mu1_B
+              - ( 1.0 + mu2_B );
+            partsPC[ 0 ][ 0 ] = 2.0 * valuePC;
+            /** mu1, part 2 */
+            valuePC
+              = +mu2_A
+              + mu2_A * mu2_A * mu1_B
+              - mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu1_A );
+            partsPC[ 0 ][ 1 ] = 2.0 * valuePC;
+            /** mu2, part 1 */
+            valuePC
+              = +mu1_B * mu1_B * mu2_A
+              - mu1_B * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B )
+              + mu1_B;
+            partsPC[ 1 ][ 0 ] = 2.0 * valuePC;
+            /** mu2, part 2 */
+            valuePC
+              = -( 1.0 + mu1_A )
+              + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B )
+              - mu1_B * ( 1.0 + mu1_A ) * mu2_A;
+            partsPC[ 1 ][ 1 ] = 2.0 * valuePC;
+          }
+        } // end if dim == 2
+        else if( ImageDimension == 3 )
+        {
+          /** Calculate the value of the properness condition. */
+          rowValuePC
+            += c * (
+            std::pow(
+            -mu1_C * ( 1.0 + mu2_B ) * mu3_A
+            + mu1_B * mu2_C * mu3_A
+            + mu1_C * mu2_A * mu3_B
+            - ( 1.0 + mu1_A ) * mu2_C * mu3_B
+            - mu1_B * mu2_A * ( 1.0 + mu3_C )
+            + ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
+            - 1.0,
+            2.0 )
+            );
+          if( computeParts )
+          {
+            /** Calculate the derivative of the properness condition. */
+            /** mu1, part 1 */
+            valuePC
+              = +( 1.0 + mu1_A ) * mu2_C * mu2_C * mu3_B * mu3_B
+              + ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+              + mu1_C * ( 1.0 + mu2_B ) * mu2_C * mu3_A * mu3_B
+              - mu1_C * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
+              - mu1_B * mu2_C * mu2_C * mu3_A * mu3_B
+              + mu1_B * ( 1.0 + mu2_B ) * mu2_C * mu3_A * ( 1.0 + mu3_C )
+              - mu1_C * mu2_A * mu2_C * mu3_B * mu3_B
+              + mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_B * ( 1.0 + mu3_C )
+              + mu1_B * mu2_A * mu2_C * mu3_B * ( 1.0 + mu3_C )
+              - 2.0 * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu2_C * mu3_B * ( 1.0 + mu3_C )
+              + mu2_C * mu3_B
+              - mu1_B * mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+              - ( 1.0 + mu2_B ) * ( 1.0 + mu3_C );
+            partsPC[ 0 ][ 0 ] = 2.0 * valuePC;
+            /** mu1, part 2 */
+            valuePC
+              = +mu1_B * mu2_C * mu2_C * mu3_A * mu3_A
+              + mu1_B * mu2_A * mu2_A * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+              - mu1_C * ( 1.0 + mu2_B ) * mu2_C * mu3_A * mu3_A
+              + mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
+              + mu1_C * mu2_A * mu2_C * mu3_A * mu3_B
+              - ( 1.0 + mu1_A ) * mu2_C * mu2_C * mu3_A * mu3_B
+              - 2.0 * mu1_B * mu2_A * mu2_C * mu3_A * ( 1.0 + mu3_C )
+              + ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu2_C * mu3_A * ( 1.0 + mu3_C )
+              - mu2_C * mu3_A
+              - mu1_C * mu2_A * mu2_A * mu3_B * ( 1.0 + mu3_C )
+              + ( 1.0 + mu1_A ) * mu2_A * mu2_C * mu3_B * ( 1.0 + mu3_C )
+              - ( 1.0 + mu1_A ) * mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+              + mu2_A * ( 1.0 + mu3_C );
+            partsPC[ 0 ][ 1 ] = 2.0 * valuePC;
+            /** mu1, part 3 */
+            valuePC
+              = +mu1_C * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_A * mu3_A
+              + mu1_C * mu2_A * mu2_A * mu3_B * mu3_B
+              - mu1_B * ( 1.0 + mu2_B ) * mu2_C * mu3_A * mu3_A
+              - 2.0 * mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_A * mu3_B
+              + ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu2_C * mu3_A * mu3_B
+              + mu1_B * mu2_A * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
+              - ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
+              + ( 1.0 + mu2_B ) * mu3_A
+              + mu1_B * mu2_A * mu2_C * mu3_A * mu3_B
+              - ( 1.0 + mu1_A ) * mu2_A * mu2_C * mu3_B * mu3_B
+              - mu1_B * mu2_A * mu2_A * mu3_B * ( 1.0 + mu3_C )
+              + ( 1.0 + mu1_A ) * mu2_A * ( 1.0 + mu2_B ) * mu3_B * ( 1.0 + mu3_C )
+              - mu2_A * mu3_B;
+            partsPC[ 0 ][ 2 ] = 2.0 * valuePC;
+            /** mu2, part 1 */
+            valuePC
+              = +mu1_C * mu1_C * mu2_A * mu3_B * mu3_B
+              + mu1_B * mu1_B * mu2_A * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+              - mu1_C * mu1_C * ( 1.0 + mu2_B ) * mu3_A * mu3_B
+              + mu1_B * mu1_C * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
+              + mu1_B * mu1_C * mu2_C * mu3_A * mu3_B
+              - mu1_B * mu1_B * mu2_C * mu3_A * ( 1.0 + mu3_C )
+              - ( 1.0 + mu1_A ) * mu1_C * mu2_C * mu3_B * mu3_B
+              - 2.0 * mu1_B * mu1_C * mu2_A * mu3_B * ( 1.0 + mu3_C )
+              + ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * mu3_B * ( 1.0 + mu3_C )
+              - mu1_C * mu3_B
+              + ( 1.0 + mu1_A ) * mu1_B * mu2_C * mu3_B * ( 1.0 + mu3_C )
+              - ( 1.0 + mu1_A ) * mu1_B * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+              + mu1_B * ( 1.0 + mu3_C );
+            partsPC[ 1 ][ 0 ] = 2.0 * valuePC;
+            /** mu2, part 2 */
+            valuePC
+              = +mu1_C * mu1_C * ( 1.0 + mu2_B ) * mu3_A * mu3_A
+              + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+              - mu1_B * mu1_C * mu2_C * mu3_A * mu3_A
+              - mu1_C * mu1_C * mu2_A * mu3_A * mu3_B
+              + ( 1.0 + mu1_A ) * mu1_C * mu2_C * mu3_A * mu3_B
+              + mu1_B * mu1_C * mu2_A * mu3_A * ( 1.0 + mu3_C )
+              - 2.0 * ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
+              + mu1_C * mu3_A
+              + ( 1.0 + mu1_A ) * mu1_B * mu2_C * mu3_A * ( 1.0 + mu3_C )
+              + ( 1.0 + mu1_A ) * mu1_C * mu2_A * mu3_B * ( 1.0 + mu3_C )
+              - ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * mu2_C * mu3_B * ( 1.0 + mu3_C )
+              - ( 1.0 + mu1_A ) * mu1_B * mu2_A * ( 1.0 + mu3_C ) * ( 1.0 + mu3_C )
+              - ( 1.0 + mu1_A ) * ( 1.0 + mu3_C );
+            partsPC[ 1 ][ 1 ] = 2.0 * valuePC;
+            /** mu2, part 3 */
+            valuePC
+              = +mu1_B * mu1_B * mu2_C * mu3_A * mu3_A
+              + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * mu2_C * mu3_B * mu3_B
+              - mu1_B * mu1_C * ( 1.0 + mu2_B ) * mu3_A * mu3_A
+              + ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * mu3_A * mu3_B
+              + mu1_B * mu1_C * mu2_A * mu3_A * mu3_B
+              - 2.0 * ( 1.0 + mu1_A ) * mu1_B * mu2_C * mu3_A * mu3_B
+              - mu1_B * mu1_B * mu2_A * mu3_A * ( 1.0 + mu3_C )
+              + ( 1.0 + mu1_A ) * mu1_B * ( 1.0 + mu2_B ) * mu3_A * ( 1.0 + mu3_C )
+              - mu1_B * mu3_A
+              - ( 1.0 + mu1_A ) * mu1_C * mu2_A * mu3_B * mu3_B
+              + ( 1.0 + mu1_A ) * mu1_B * mu2_A * mu3_B * ( 1.0 + mu3_C )
+              - ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu3_B * ( 1.0 + mu3_C )
+              + ( 1.0 + mu1_A ) * mu3_B;
+            partsPC[ 1 ][ 2 ] = 2.0 * valuePC;
+            /** mu3, part 1 */
+            valuePC
+              = +mu1_C * mu1_C * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_A
+              + mu1_B * mu1_B * mu2_C * mu2_C * mu3_A
+              - 2.0 * mu1_B * mu1_C * ( 1.0 + mu2_B ) * mu2_C * mu3_A
+              - mu1_C * mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_B
+              + ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * mu2_C * mu3_B
+              + mu1_B * mu1_C * mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
+              - ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
+              + mu1_C * ( 1.0 + mu2_B )
+              + mu1_B * mu1_C * mu2_A * mu2_C * mu3_B
+              - ( 1.0 + mu1_A ) * mu1_B * mu2_C * mu2_C * mu3_B
+              - mu1_B * mu1_B * mu2_A * mu2_C * ( 1.0 + mu3_C )
+              + ( 1.0 + mu1_A ) * mu1_B * ( 1.0 + mu2_B ) * mu2_C * ( 1.0 + mu3_C )
+              - mu1_B * mu2_C;
+            partsPC[ 2 ][ 0 ] = 2.0 * valuePC;
+            /** mu3, part 2 */
+            valuePC
+              = +mu1_C * mu1_C * mu2_A * mu2_A * mu3_B
+              + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * mu2_C * mu2_C * mu3_B
+              - mu1_C * mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_A
+              + ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * mu2_C * mu3_A
+              + mu1_B * mu1_C * mu2_A * mu2_C * mu3_A
+              - ( 1.0 + mu1_A ) * mu1_B * mu2_C * mu2_C * mu3_A
+              - 2.0 * ( 1.0 + mu1_A ) * mu1_C * mu2_A * mu2_C * mu3_B
+              - mu1_B * mu1_C * mu2_A * mu2_A * ( 1.0 + mu3_C )
+              + ( 1.0 + mu1_A ) * mu1_C * mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
+              - mu1_C * mu2_A
+              + ( 1.0 + mu1_A ) * mu1_B * mu2_A * mu2_C * ( 1.0 + mu3_C )
+              - ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu2_C * ( 1.0 + mu3_C )
+              + ( 1.0 + mu1_A ) * mu2_C;
+            partsPC[ 2 ][ 1 ] = 2.0 * valuePC;
+            /** mu3, part 3 */
+            valuePC
+              = +mu1_B * mu1_B * mu2_A * mu2_A * ( 1.0 + mu3_C )
+              + ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
+              + mu1_B * mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_A
+              - ( 1.0 + mu1_A ) * mu1_C * ( 1.0 + mu2_B ) * ( 1.0 + mu2_B ) * mu3_A
+              - mu1_B * mu1_B * mu2_A * mu2_C * mu3_A
+              + ( 1.0 + mu1_A ) * mu1_B * ( 1.0 + mu2_B ) * mu2_C * mu3_A
+              - mu1_B * mu1_C * mu2_A * mu2_A * mu3_B
+              + ( 1.0 + mu1_A ) * mu1_C * mu2_A * ( 1.0 + mu2_B ) * mu3_B
+              + ( 1.0 + mu1_A ) * mu1_B * mu2_A * mu2_C * mu3_B
+              - ( 1.0 + mu1_A ) * ( 1.0 + mu1_A ) * ( 1.0 + mu2_B ) * mu2_C * mu3_B
+              - 2.0 * ( 1.0 + mu1_A ) * mu1_B * mu2_A * ( 1.0 + mu2_B ) * ( 1.0 + mu3_C )
+              + mu1_B * mu2_A
+              - ( 1.0 + mu1_A ) * ( 1.0 + mu2_B );
+            partsPC[ 2 ][ 2 ] = 2.0 * valuePC;
+          }
+        } // end if dim == 3
+
+        if( computeParts )
+        {
+          ScalarType * subpartsPC = subparts + voxel * NumberOfSubparts + SubpartsOffsetPC;
+          for( unsigned int i = 0; i < ImageDimension; i++ )
+          {
+            for( unsigned int j = 0; j < ImageDimension; j++ )
+            {
+              subpartsPC[ i * ImageDimension + j ] = c * partsPC[ i ][ j ];
+            }
+          }
+        }
+      } // end if do properness
+
+      /** Calculate the linearity condition and its subparts. */
+      if( calculateLC )
+      {
+        ScalarType * subpartsLC = computeParts
+          ? subparts + voxel * NumberOfSubparts + SubpartsOffsetLC : nullptr;
+        for( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+          for( unsigned int j = 0; j < NumberOfLinearityParts; j++ )
+          {
+            const ScalarType mu_ij = mu[ i ][ linearityOperators[ j ] ];
+            rowValueLC += c * mu_ij * mu_ij;
+            if( computeParts )
+            {
+              subpartsLC[ i * NumberOfLinearityParts + j ] = c * 2.0 * mu_ij;
+            }
+          }
+        }
+      } // end if do linearity
+
+    } // end for x
+
+    /** Store the contributions of this row. */
+    this->m_RowSums[ 3 * row ]     = rowValueLC;
+    this->m_RowSums[ 3 * row + 1 ] = rowValueOC;
+    this->m_RowSums[ 3 * row + 2 ] = rowValuePC;
+
+  } // end for rows
+
+} // end ComputeConditionValuesForRows()
+
+
+/**
+ * *********************** ComputeConditionDerivativesForRows ****************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ComputeConditionDerivativesForRows( const SizeValueType rowBegin,
+  const SizeValueType rowEnd, DerivativeValueType * derivative,
+  const ScalarType rigidityCoefficientSum ) const
+{
+  const SizeValueType numberOfVoxels
+    = this->m_RigidityCoefficientImage->GetBufferedRegion().GetNumberOfPixels();
+  const SizeValueType sizeX = this->m_RigidityCoefficientImage->GetBufferedRegion().GetSize()[ 0 ];
+
+  const unsigned int linearityOperators[ 6 ] = {
+    OperatorD, OperatorE, OperatorG, OperatorF, OperatorH, OperatorI };
+  const bool calculateLC = this->m_CalculateLinearityCondition;
+  const bool calculateOC = this->m_CalculateOrthonormalityCondition;
+  const bool calculatePC = this->m_CalculatePropernessCondition;
+
+  const ScalarType * stencils = &this->m_AdjointStencils[ 0 ];
+  const ScalarType * subparts = &this->m_SubpartsWorkspace[ 0 ];
+
+  SizeValueType rowOffsets[ NumberOfNeighbours / 3 ];
+  for( SizeValueType row = rowBegin; row < rowEnd; ++row )
+  {
+    /** Compute the offsets of the neighbouring rows, with clamping at the borders. */
+    this->ComputeRowOffsets( row, rowOffsets );
+
+    MeasureType rowGradMagLC = NumericTraits< MeasureType >::Zero;
+    MeasureType rowGradMagOC = NumericTraits< MeasureType >::Zero;
+    MeasureType rowGradMagPC = NumericTraits< MeasureType >::Zero;
+    for( SizeValueType x = 0; x < sizeX; ++x )
+    {
+      /** The centre row has relative position 0 in all dimensions, see ComputeRowOffsets(). */
+      const SizeValueType voxel = rowOffsets[ NumberOfNeighbours / 6 ] + x;
+
+      /** The subparts of the neighbouring voxels, with clamping at the borders. */
+      const SizeValueType columns[ 3 ] = {
+        x > 0 ? x - 1 : 0, x, x + 1 < sizeX ? x + 1 : x };
+      const ScalarType * neighbours[ NumberOfNeighbours ];
+      for( unsigned int k = 0; k < NumberOfNeighbours; ++k )
+      {
+        neighbours[ k ] = subparts
+          + ( rowOffsets[ k / 3 ] + columns[ k % 3 ] ) * NumberOfSubparts;
+      }
+
+      for( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+        /** The filtered subparts are F_A * {subpart_0} + F_B * {subpart_1}
+         * (+ F_C * {subpart_2}) for the orthonormality and properness conditions,
+         * and sum_j F_{D,E,G,F,H,I} * {subpart_j} for the linearity condition.
+         * The subparts are already multiplied by the rigidity coefficients.
+         */
+        ScalarType filteredLC = NumericTraits< ScalarType >::Zero;
+        ScalarType filteredOC = NumericTraits< ScalarType >::Zero;
+        ScalarType filteredPC = NumericTraits< ScalarType >::Zero;
+        for( unsigned int k = 0; k < NumberOfNeighbours; ++k )
+        {
+          const ScalarType * neighbour = neighbours[ k ];
+          if( calculateOC )
+          {
+            for( unsigned int j = 0; j < ImageDimension; j++ )
+            {
+              filteredOC += stencils[ j * NumberOfNeighbours + k ]
+                * neighbour[ SubpartsOffsetOC + i * ImageDimension + j ];
+            }
+          }
+          if( calculatePC )
+          {
+            for( unsigned int j = 0; j < ImageDimension; j++ )
+            {
+              filteredPC += stencils[ j * NumberOfNeighbours + k ]
+                * neighbour[ SubpartsOffsetPC + i * ImageDimension + j ];
+            }
+          }
+          if( calculateLC )
+          {
+            for( unsigned int j = 0; j < NumberOfLinearityParts; j++ )
+            {
+              filteredLC += stencils[ linearityOperators[ j ] * NumberOfNeighbours + k ]
+                * neighbour[ SubpartsOffsetLC + i * NumberOfLinearityParts + j ];
+            }
+          }
+        } // end loop over neighbourhood
+
+        // NOTE: unlike the values, for the derivatives weight * derivative is returned.
+        const ScalarType tmpLC = this->m_LinearityConditionWeight * filteredLC;
+        const ScalarType tmpOC = this->m_OrthonormalityConditionWeight * filteredOC;
+        const ScalarType tmpPC = this->m_PropernessConditionWeight * filteredPC;
+        rowGradMagLC += tmpLC * tmpLC;
+        rowGradMagOC += tmpOC * tmpOC;
+        rowGradMagPC += tmpPC * tmpPC;
+
+        /** Compute derivative contribution. */
+        ScalarType tmpDIs = NumericTraits< ScalarType >::Zero;
+        if( this->m_UseLinearityCondition )
+        {
+          tmpDIs += tmpLC;
+        }
+        if( this->m_UseOrthonormalityCondition )
+        {
+          tmpDIs += tmpOC;
+        }
+        if( this->m_UsePropernessCondition )
+        {
+          tmpDIs += tmpPC;
+        }
+        derivative[ i * numberOfVoxels + voxel ] = tmpDIs / rigidityCoefficientSum;
+
+      } // end loop over dimension i
+    } // end for x
+
+    /** Store the contributions of this row. */
+    this->m_RowSums[ 3 * row ]     = rowGradMagLC;
+    this->m_RowSums[ 3 * row + 1 ] = rowGradMagOC;
+    this->m_RowSums[ 3 * row + 2 ] = rowGradMagPC;
+
+  } // end for rows
+
+} // end ComputeConditionDerivativesForRows()
+
+
+/**
+ * *********************** ComputeRowOffsets ****************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ComputeRowOffsets( const SizeValueType row, SizeValueType * rowOffsets ) const
+{
+  /** Row offset m, with m = b_1 + 3 b_2 for b_d in { 0, 1, 2 }, is the buffer
+   * offset of the row at relative position b_d - 1 in dimension d. Like the
+   * zero flux Neumann boundary condition of the image filters, positions
+   * outside the image are clamped to the border.
+   */
+  const typename RigidityImageRegionType::SizeType size
+    = this->m_RigidityCoefficientImage->GetBufferedRegion().GetSize();
+
+  SizeValueType position[ ImageDimension ];
+  SizeValueType rest = row;
+  for( unsigned int d = 1; d < ImageDimension; d++ )
+  {
+    position[ d ] = rest % size[ d ];
+    rest         /= size[ d ];
+  }
+
+  for( unsigned int m = 0; m < NumberOfNeighbours / 3; ++m )
+  {
+    SizeValueType offset = 0;
+    SizeValueType stride = size[ 0 ];
+    unsigned int  b      = m;
+    for( unsigned int d = 1; d < ImageDimension; d++ )
+    {
+      SizeValueType p = position[ d ];
+      if( b % 3 == 0 && p > 0 ) { --p; }
+      else if( b % 3 == 2 && p + 1 < size[ d ] ) { ++p; }
+      offset += p * stride;
+      stride *= size[ d ];
+      b      /= 3;
+    }
+    rowOffsets[ m ] = offset;
+  }
+
+} // end ComputeRowOffsets()
+
+
+/**
+ * *********************** InitializeStencils ****************
+ */
+
+template< class TFixedImage, class TScalarType >
+void
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::InitializeStencils( const CoefficientImageSpacingType & spacing ) const
+{
+  /** The stencils only depend on the grid spacing. */
+  if( !this->m_SeparableStencils.empty() && spacing == this->m_StencilSpacing )
+  {
+    return;
+  }
+
+  /** The separable operators are the products of the 1D operators
+   * F?_xi in each dimension. The adjoint operators F? are used to filter
+   * the subparts for the derivative. The operators C, F, H and I only exist in 3D.
+   */
+  const char * separableNames[ NumberOfOperators ] = {
+    "FA_xi", "FB_xi", "FC_xi", "FD_xi", "FE_xi", "FF_xi", "FG_xi", "FH_xi", "FI_xi" };
+  const char * adjointNames[ NumberOfOperators ] = {
+    "FA", "FB", "FC", "FD", "FE", "FF", "FG", "FH", "FI" };
+
+  this->m_SeparableStencils.assign( NumberOfOperators * NumberOfNeighbours, 0.0 );
+  this->m_AdjointStencils.assign( NumberOfOperators * NumberOfNeighbours, 0.0 );
+  for( unsigned int op = 0; op < NumberOfOperators; ++op )
+  {
+    if( ImageDimension == 2 && ( op == OperatorC || op == OperatorF
+      || op == OperatorH || op == OperatorI ) )
+    {
+      continue;
+    }
+
+    std::vector< NeighborhoodType > operators1D( ImageDimension );
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+      this->Create1DOperator( operators1D[ d ], separableNames[ op ], d + 1, spacing );
+    }
+    NeighborhoodType operatorND;
+    this->CreateNDOperator( operatorND, adjointNames[ op ], spacing );
+
+    /** Element k of a 3x3(x3) neighbourhood is at position
+     * ( k mod 3, k / 3 mod 3, k / 9 ), like in the itk::Neighborhood.
+     */
+    for( unsigned int k = 0; k < NumberOfNeighbours; ++k )
+    {
+      ScalarType   weight = 1.0;
+      unsigned int rest   = k;
+      for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+        weight *= operators1D[ d ][ rest % 3 ];
+        rest   /= 3;
+      }
+      this->m_SeparableStencils[ op * NumberOfNeighbours + k ] = weight;
+      this->m_AdjointStencils[ op * NumberOfNeighbours + k ]   = operatorND.GetElement( k );
+    }
+  }
+
+  this->m_StencilSpacing = spacing;
+
+} // end InitializeStencils()
+
+
+/**
+ * **************** ComputeConditionValuesThreaderCallback *******
+ */
+
+template< class TFixedImage, class TScalarType >
+ITK_THREAD_RETURN_TYPE
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ComputeConditionValuesThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadId   = infoStruct->WorkUnitID;
+
+  RigidityPenaltyMultiThreaderParameterType * temp
+    = static_cast< RigidityPenaltyMultiThreaderParameterType * >( infoStruct->UserData );
+
+  /** Process the rows handed out to this thread. */
+  unsigned long rowBegin = 0;
+  unsigned long rowEnd   = 0;
+  while( temp->m_Metric->GetNextSampleRange( threadId, temp->st_NumberOfRows, rowBegin, rowEnd ) )
+  {
+    temp->m_Metric->ComputeConditionValuesForRows( rowBegin, rowEnd, temp->st_ComputeParts );
+  }
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeConditionValuesThreaderCallback()
+
+
+/**
+ * **************** ComputeConditionDerivativesThreaderCallback *******
+ */
+
+template< class TFixedImage, class TScalarType >
+ITK_THREAD_RETURN_TYPE
+TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
+::ComputeConditionDerivativesThreaderCallback( void * arg )
+{
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ThreadIdType     threadId   = infoStruct->WorkUnitID;
+
+  RigidityPenaltyMultiThreaderParameterType * temp
+    = static_cast< RigidityPenaltyMultiThreaderParameterType * >( infoStruct->UserData );
+
+  /** Process the rows handed out to this thread. */
+  unsigned long rowBegin = 0;
+  unsigned long rowEnd   = 0;
+  while( temp->m_Metric->GetNextSampleRange( threadId, temp->st_NumberOfRows, rowBegin, rowEnd ) )
+  {
+    temp->m_Metric->ComputeConditionDerivativesForRows( rowBegin, rowEnd,
+      temp->st_DerivativePointer, temp->st_RigidityCoefficientSum );
+  }
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeConditionDerivativesThreaderCallback()
+
 
 
 /**
@@ -2200,6 +3290,8 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
      << this->m_CalculateOrthonormalityCondition << std::endl;
   os << indent << "CalculatePropernessCondition: "
      << this->m_CalculatePropernessCondition << std::endl;
+  os << indent << "UseFusedPasses: "
+     << this->m_UseFusedPasses << std::endl;
 
 } // end PrintSelf()
 
@@ -2326,15 +3418,15 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   }
   else if( WhichF == "FG_xi" && WhichDimension == 1 )
   {
-    F[ 0 ] = -0.5 / ( s[ 0 ] * s[ 1 ] );
+    F[ 0 ] = -0.5 / s[ 0 ];
     F[ 1 ] = 0.0;
-    F[ 2 ] = 0.5 / ( s[ 0 ] * s[ 1 ] );
+    F[ 2 ] = 0.5 / s[ 0 ];
   }
   else if( WhichF == "FG_xi" && WhichDimension == 2 )
   {
-    F[ 0 ] = -0.5 / ( s[ 0 ] * s[ 1 ] );
+    F[ 0 ] = -0.5 / s[ 1 ];
     F[ 1 ] = 0.0;
-    F[ 2 ] = 0.5 / ( s[ 0 ] * s[ 1 ] );
+    F[ 2 ] = 0.5 / s[ 1 ];
   }
   else if( WhichF == "FG_xi" && WhichDimension == 3 )
   {
@@ -2342,9 +3434,9 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   }
   else if( WhichF == "FH_xi" && WhichDimension == 1 )
   {
-    F[ 0 ] = -0.5 / ( s[ 0 ] * s[ 2 ] );
+    F[ 0 ] = -0.5 / s[ 0 ];
     F[ 1 ] = 0.0;
-    F[ 2 ] = 0.5 / ( s[ 0 ] * s[ 2 ] );
+    F[ 2 ] = 0.5 / s[ 0 ];
   }
   else if( WhichF == "FH_xi" && WhichDimension == 2 )
   {
@@ -2352,9 +3444,9 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   }
   else if( WhichF == "FH_xi" && WhichDimension == 3 )
   {
-    F[ 0 ] = -0.5 / ( s[ 0 ] * s[ 2 ] );
+    F[ 0 ] = -0.5 / s[ 2 ];
     F[ 1 ] = 0.0;
-    F[ 2 ] = 0.5 / ( s[ 0 ] * s[ 2 ] );
+    F[ 2 ] = 0.5 / s[ 2 ];
   }
   else if( WhichF == "FI_xi" && WhichDimension == 1 )
   {
@@ -2362,15 +3454,15 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
   }
   else if( WhichF == "FI_xi" && WhichDimension == 2 )
   {
-    F[ 0 ] = -0.5 / ( s[ 1 ] * s[ 2 ] );
+    F[ 0 ] = -0.5 / s[ 1 ];
     F[ 1 ] = 0.0;
-    F[ 2 ] = 0.5 / ( s[ 1 ] * s[ 2 ] );
+    F[ 2 ] = 0.5 / s[ 1 ];
   }
   else if( WhichF == "FI_xi" && WhichDimension == 3 )
   {
-    F[ 0 ] = -0.5 / ( s[ 1 ] * s[ 2 ] );
+    F[ 0 ] = -0.5 / s[ 2 ];
     F[ 1 ] = 0.0;
-    F[ 2 ] = 0.5 / ( s[ 1 ] * s[ 2 ] );
+    F[ 2 ] = 0.5 / s[ 2 ];
   }
   else
   {
@@ -2381,6 +3473,7 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
 } // end Create1DOperator()
 
 
+
 /**
  * ************************** FilterSeparable ********************
  */
@@ -2581,7 +3674,7 @@ TransformRigidityPenaltyTerm< TFixedImage, TScalarType >
       F[ 3 ] = 1.0 / 18.0 / sp; F[ 4 ] = 2.0 /  9.0 / sp; F[ 5 ] = 1.0 / 18.0 / sp;
       F[ 6 ] = 1.0 / 72.0 / sp; F[ 7 ] = 1.0 / 18.0 / sp; F[ 8 ] = 1.0 / 72.0 / sp;
       /** Second slice. */
-      F[  9 ] = -1.0 / 39.0 / sp; F[ 10 ] = -1.0 / 9.0 / sp;  F[ 11 ] = -1.0 / 36.0 / sp;
+      F[  9 ] = -1.0 / 36.0 / sp; F[ 10 ] = -1.0 / 9.0 / sp;  F[ 11 ] = -1.0 / 36.0 / sp;
       F[ 12 ] = -1.0 /  9.0 / sp; F[ 13 ] = -4.0 / 9.0 / sp;  F[ 14 ] = -1.0 /  9.0 / sp;
       F[ 15 ] = -1.0 / 36.0 / sp; F[ 16 ] = -1.0 / 9.0 / sp;  F[ 17 ] = -1.0 / 36.0 / sp;
       /** Third slice. */
@@ -179,6 +179,16 @@ namespace elastix
  * \parameter RegularizationKappa: Selects for the preconditioner regularization.
  *   The parameter can be specified for each resolution, or for all resolutions at once.\n
  *   example: <tt>(RegularizationKappa 0.9)</tt>\n
+ * \parameter UseDisplacementDistributionCache: Whether the results of the displacement
+ *   distribution estimation are cached, so that repeated registrations with identical
+ *   images, initial transforms and parameter files skip the estimation.
+ *   The cache key contains all images, masks and parameters the estimate depends on.\n
+ *   example: <tt>(UseDisplacementDistributionCache "true")</tt>\n
+ *   Default: false.
+ * \parameter DisplacementDistributionCacheFileName: The file in which the cache is stored,
+ *   to reuse it in subsequent runs. If not given, the cache is only kept in memory.\n
+ *   example: <tt>(DisplacementDistributionCacheFileName "/data/atlas/ddcache.txt")</tt>\n
+ *   Default: "".
  *
  * \todo: this class contains a lot of functional code, which actually does not belong here.
  *
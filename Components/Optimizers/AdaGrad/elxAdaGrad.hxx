@@ -678,6 +678,21 @@ AdaGrad< TElastix >
   computeDisplacementDistribution->SetNumberOfJacobianMeasurements(
     this->m_NumberOfJacobianMeasurements);
 
+  /** Set up the cache of the displacement distribution estimates. */
+  bool useCache = false;
+  this->GetConfiguration()->ReadParameter( useCache,
+    "UseDisplacementDistributionCache", this->GetComponentLabel(), 0, 0 );
+  if( useCache )
+  {
+    std::string cacheFileName = "";
+    this->GetConfiguration()->ReadParameter( cacheFileName,
+      "DisplacementDistributionCacheFileName", this->GetComponentLabel(), 0, 0 );
+    computeDisplacementDistribution->SetUseCache( true );
+    computeDisplacementDistribution->SetCacheFileName( cacheFileName );
+    computeDisplacementDistribution->SetAdditionalCacheKey(
+      ComputeDisplacementDistributionType::ComputeAdditionalCacheKey( this->GetElastix() ) );
+  }
+
 
   std::string maximumDisplacementEstimationMethod = "2sigma";
   this->GetConfiguration()->ReadParameter(maximumDisplacementEstimationMethod,
@@ -159,6 +159,13 @@ namespace elastix
  *   number of transform parameters. This is a rather crude rule of thumb,
  *   which seems to work in practice. In principle, the more the better, but the slower.
  *   The parameter has only influence when AutomaticParameterEstimation is used.
+ * \parameter MaximumNumberOfJacobianMeasurements: An upper bound for the default
+ *   number of Jacobian measurements, useful for transforms with many parameters.
+ *   It is ignored when NumberOfJacobianMeasurements is specified.
+ *   The parameter can be specified for each resolution, or for all resolutions at once.\n
+ *   example: <tt>(MaximumNumberOfJacobianMeasurements 20000)</tt>\n
+ *   Default value: 0, which means no bound.
+ *   The parameter has only influence when AutomaticParameterEstimation is used.
  * \parameter NumberOfSamplesForExactGradient: The number of image samples used to compute
  *   the 'exact' gradient. The samples are chosen on a uniform grid.
  *   The parameter can be specified for each resolution, or for all resolutions at once.\n
@@ -182,6 +189,16 @@ namespace elastix
  *   The parameter can be specified for each resolution, or for all resolutions at once.\n
  *   example: <tt>(NoiseCompensation "true")</tt>\n
  *   Default/recommended: true.
+ * \parameter UseDisplacementDistributionCache: Whether the results of the displacement
+ *   distribution estimation are cached, so that repeated registrations with identical
+ *   images, initial transforms and parameter files skip the estimation.
+ *   The cache key contains all images, masks and parameters the estimate depends on.\n
+ *   example: <tt>(UseDisplacementDistributionCache "true")</tt>\n
+ *   Default: false.
+ * \parameter DisplacementDistributionCacheFileName: The file in which the cache is stored,
+ *   to reuse it in subsequent runs. If not given, the cache is only kept in memory.\n
+ *   example: <tt>(DisplacementDistributionCacheFileName "/data/atlas/ddcache.txt")</tt>\n
+ *   Default: "".
  *
  * \todo: this class contains a lot of functional code, which actually does not belong here.
  *
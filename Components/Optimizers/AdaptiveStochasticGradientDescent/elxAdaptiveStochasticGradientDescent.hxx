@@ -214,6 +214,20 @@ AdaptiveStochasticGradientDescent< TElastix >
      */
     this->m_NumberOfJacobianMeasurements = std::max(
       static_cast< unsigned int >( 1000 ), static_cast< unsigned int >( P ) );
+
+    /** For transforms with many parameters the default M may be bounded,
+     * to limit the time spent in the parameter estimation. Default: no bound.
+     */
+    SizeValueType maximumNumberOfJacobianMeasurements = 0;
+    this->GetConfiguration()->ReadParameter(
+      maximumNumberOfJacobianMeasurements,
+      "MaximumNumberOfJacobianMeasurements",
+      this->GetComponentLabel(), level, 0 );
+    if( maximumNumberOfJacobianMeasurements > 0 )
+    {
+      this->m_NumberOfJacobianMeasurements = std::min(
+        this->m_NumberOfJacobianMeasurements, maximumNumberOfJacobianMeasurements );
+    }
     this->GetConfiguration()->ReadParameter(
       this->m_NumberOfJacobianMeasurements,
       "NumberOfJacobianMeasurements",
@@ -742,6 +756,21 @@ AdaptiveStochasticGradientDescent< TElastix >
     computeDisplacementDistribution->SetUseScales( false );
   }
 
+  /** Set up the cache of the displacement distribution estimates. */
+  bool useCache = false;
+  this->GetConfiguration()->ReadParameter( useCache,
+    "UseDisplacementDistributionCache", this->GetComponentLabel(), 0, 0 );
+  if( useCache )
+  {
+    std::string cacheFileName = "";
+    this->GetConfiguration()->ReadParameter( cacheFileName,
+      "DisplacementDistributionCacheFileName", this->GetComponentLabel(), 0, 0 );
+    computeDisplacementDistribution->SetUseCache( true );
+    computeDisplacementDistribution->SetCacheFileName( cacheFileName );
+    computeDisplacementDistribution->SetAdditionalCacheKey(
+      ComputeDisplacementDistributionType::ComputeAdditionalCacheKey( this->GetElastix() ) );
+  }
+
   double      jacg                                = 0.0;
   std::string maximumDisplacementEstimationMethod = "2sigma";
   this->GetConfiguration()->ReadParameter( maximumDisplacementEstimationMethod,
@@ -107,6 +107,10 @@ namespace elastix
  *    reported back in the elastix.log file. This parameter can be specified for each resolution. \n
  *    example: <tt>(UpdateBDPeriod 0 0 50)</tt> \n
  *    Default: 0 (so, automatically determined).
+ * \parameter NumberOfCostFunctionClones: the number of copies of the metric that evaluate the
+ *    offspring in parallel, see OptimizerBase. This parameter can be specified for each resolution. \n
+ *    example: <tt>(NumberOfCostFunctionClones 8 8 8)</tt> \n
+ *    Default: 0, which means that the offspring are evaluated one by one.
  *
  * \ingroup Optimizers
  */
@@ -157,6 +161,7 @@ public:
   typedef typename Superclass2::ITKBaseType          ITKBaseType;
 
   /** Check if any scales are set, and set the UseScales flag on or off;
+   * create the cost function clones, see OptimizerBase::CreateCostFunctionClones();
    * after that call the superclass' implementation */
   void StartOptimization( void ) override;
 
@@ -49,6 +49,9 @@ CMAEvolutionStrategy< TElastix >::StartOptimization( void )
     }
   }
 
+  /** Evaluate the offspring on copies of the metric, if desired. */
+  this->SetCostFunctionClones( this->CreateCostFunctionClones() );
+
   /** Call the superclass */
   this->Superclass1::StartOptimization();
 
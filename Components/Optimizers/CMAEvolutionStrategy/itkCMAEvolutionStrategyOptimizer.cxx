@@ -21,6 +21,7 @@
 
 #include "itkCMAEvolutionStrategyOptimizer.h"
 #include "itkSymmetricEigenAnalysis.h"
+#include "itkCostFunctionClones.h"
 #include "vnl/vnl_math.h"
 #include <algorithm>
 #include <cmath>
@@ -125,6 +126,7 @@ CMAEvolutionStrategyOptimizer::PrintSelf( std::ostream & os, Indent indent ) con
   os << indent << "m_PositionToleranceMin: " << this->m_PositionToleranceMin << std::endl;
   os << indent << "m_PositionToleranceMax: " << this->m_PositionToleranceMax << std::endl;
   os << indent << "m_ValueTolerance: " << this->m_ValueTolerance << std::endl;
+  os << indent << "m_CostFunctionClones: " << this->m_CostFunctionClones.size() << std::endl;
 
   os << indent << "m_RecombinationWeights: " << this->m_RecombinationWeights << std::endl;
   os << indent << "m_C: " << this->m_C << std::endl;
@@ -492,6 +494,21 @@ CMAEvolutionStrategyOptimizer::InitializeBCD( void )
 } // end InitializeBCD
 
 
+/**
+ * ****************** SetCostFunctionClones *********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::SetCostFunctionClones( const CostFunctionContainerType & clones )
+{
+  itkDebugMacro( "SetCostFunctionClones" );
+
+  this->m_CostFunctionClones = clones;
+  this->Modified();
+
+} // end SetCostFunctionClones
+
+
 /**
  * ****************** GenerateOffspring *********************
  */
@@ -501,76 +518,147 @@ CMAEvolutionStrategyOptimizer::GenerateOffspring( void )
 {
   itkDebugMacro( "GenerateOffspring" );
 
-  /** Get the number of parameters from the cost function */
-  const unsigned int numberOfParameters
-    = this->GetScaledCostFunction()->GetNumberOfParameters();
-
   /** Some casts/aliases: */
-  const unsigned int N      = numberOfParameters;
   const unsigned int lambda = this->m_PopulationSize;
 
   /** Clear the old values */
   this->m_CostFunctionValues.clear();
 
-  /** Fill the m_NormalizedSearchDirs and SearchDirs */
-  unsigned int lam       = 0;
-  unsigned int nrOfFails = 0;
-  while( lam < lambda )
+  /** Fill the m_NormalizedSearchDirs and SearchDirs. All offspring members
+   * are drawn before any of them is evaluated, so that the sequence of random
+   * numbers does not depend on how the evaluations are distributed over threads. */
+  for( unsigned int lam = 0; lam < lambda; ++lam )
   {
-    /** draw from distribution N(0,I) */
-    for( unsigned int par = 0; par < N; ++par )
-    {
-      this->m_NormalizedSearchDirs[ lam ][ par ]
-        = this->m_RandomGenerator->GetNormalVariate();
-    }
-    /** Make like it was drawn from N(0,C) */
-    if( this->GetUseCovarianceMatrixAdaptation() )
-    {
-      this->m_SearchDirs[ lam ] = this->m_B * ( this->m_D * this->m_NormalizedSearchDirs[ lam ] );
-    }
-    else
-    {
-      this->m_SearchDirs[ lam ] = this->m_NormalizedSearchDirs[ lam ];
-    }
-    /** Make like it was drawn from N( 0, sigma^2 C ) */
-    this->m_SearchDirs[ lam ] *= this->m_CurrentSigma;
+    this->GenerateSearchDirection( lam );
+  }
 
-    /** Compute the cost function */
-    MeasureType costFunctionValue = 0.0;
-    /** x_lam = m + d_lam */
-    ParametersType x_lam = this->GetScaledCurrentPosition();
-    x_lam += this->m_SearchDirs[ lam ];
-    try
-    {
-      costFunctionValue = this->GetScaledValue( x_lam );
-    }
-    catch( ExceptionObject & err )
+  /** Compute the cost function for all offspring members */
+  std::vector< MeasureType >   costFunctionValues( lambda, 0.0 );
+  std::vector< unsigned char > failed( lambda, 0 );
+  this->EvaluateOffspring( costFunctionValues, failed );
+
+  /** Replace the offspring members for which the cost function evaluation failed */
+  for( unsigned int lam = 0; lam < lambda; ++lam )
+  {
+    unsigned int nrOfFails = failed[ lam ];
+    while( failed[ lam ] )
     {
-      ++nrOfFails;
       /** try another parameter vector if we haven't tried that for 10 times already */
-      if( nrOfFails <= 10 )
+      this->GenerateSearchDirection( lam );
+      ParametersType x_lam = this->GetScaledCurrentPosition();
+      x_lam += this->m_SearchDirs[ lam ];
+      try
       {
-        continue;
+        costFunctionValues[ lam ] = this->GetScaledValue( x_lam );
+        failed[ lam ]             = 0;
       }
-      else
+      catch( ExceptionObject & err )
       {
-        this->m_StopCondition = MetricError;
-        this->StopOptimization();
-        throw err;
+        ++nrOfFails;
+        if( nrOfFails > 10 )
+        {
+          this->m_StopCondition = MetricError;
+          this->StopOptimization();
+          throw err;
+        }
       }
     }
+
     /** Successfull cost function evaluation */
     this->m_CostFunctionValues.push_back(
-      MeasureIndexPairType( costFunctionValue, lam ) );
+      MeasureIndexPairType( costFunctionValues[ lam ], lam ) );
+  }
+
+} // end GenerateOffspring
 
-    /** Reset the number of failed cost function evaluations */
-    nrOfFails = 0;
 
-    /** next offspring member */
-    ++lam;
+/**
+ * ****************** GenerateSearchDirection *********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::GenerateSearchDirection( unsigned int lam )
+{
+  /** Get the number of parameters from the cost function */
+  const unsigned int N = this->GetScaledCostFunction()->GetNumberOfParameters();
+
+  /** draw from distribution N(0,I) */
+  for( unsigned int par = 0; par < N; ++par )
+  {
+    this->m_NormalizedSearchDirs[ lam ][ par ]
+      = this->m_RandomGenerator->GetNormalVariate();
+  }
+  /** Make like it was drawn from N(0,C) */
+  if( this->GetUseCovarianceMatrixAdaptation() )
+  {
+    this->m_SearchDirs[ lam ] = this->m_B * ( this->m_D * this->m_NormalizedSearchDirs[ lam ] );
   }
+  else
+  {
+    this->m_SearchDirs[ lam ] = this->m_NormalizedSearchDirs[ lam ];
+  }
+  /** Make like it was drawn from N( 0, sigma^2 C ) */
+  this->m_SearchDirs[ lam ] *= this->m_CurrentSigma;
 
-} // end GenerateOffspring
+} // end GenerateSearchDirection
+
+
+/**
+ * ****************** EvaluateOffspring *********************
+ */
+
+void
+CMAEvolutionStrategyOptimizer::EvaluateOffspring(
+  std::vector< MeasureType > & values,
+  std::vector< unsigned char > & failed )
+{
+  const unsigned int     lambda          = this->m_PopulationSize;
+  const ParametersType & currentPosition = this->GetScaledCurrentPosition();
+
+  /** Sequential evaluation by the cost function of the optimizer */
+  if( this->m_CostFunctionClones.empty() )
+  {
+    for( unsigned int lam = 0; lam < lambda; ++lam )
+    {
+      /** x_lam = m + d_lam */
+      ParametersType x_lam = currentPosition;
+      x_lam += this->m_SearchDirs[ lam ];
+      try
+      {
+        values[ lam ] = this->GetScaledValue( x_lam );
+      }
+      catch( ExceptionObject & )
+      {
+        failed[ lam ] = 1;
+      }
+    }
+    return;
+  }
+
+  /** Wrap each clone in a scaled cost function, like the cost function of the optimizer.
+   * Clone c evaluates the offspring members c, c + numberOfClones, etc. */
+  const unsigned int numberOfClones = std::min(
+    static_cast< unsigned int >( this->m_CostFunctionClones.size() ), lambda );
+  const CostFunctionClones::ScaledCostFunctionContainerType scaledClones
+    = CostFunctionClones::CreateScaledClones( this->m_CostFunctionClones,
+    this->GetScaledCostFunction(), numberOfClones );
+
+  CostFunctionClones::Evaluate( numberOfClones, lambda,
+    [ & ]( const std::size_t c, const std::size_t lam )
+  {
+    ParametersType x_lam = currentPosition;
+    x_lam += this->m_SearchDirs[ lam ];
+    try
+    {
+      values[ lam ] = scaledClones[ c ]->GetValue( x_lam );
+    }
+    catch( ExceptionObject & )
+    {
+      failed[ lam ] = 1;
+    }
+  } );
+
+} // end EvaluateOffspring
 
 
 /**
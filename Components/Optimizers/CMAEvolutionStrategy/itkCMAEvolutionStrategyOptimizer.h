@@ -20,6 +20,7 @@
 #define __itkCMAEvolutionStrategyOptimizer_h
 
 #include "itkScaledSingleValuedNonLinearOptimizer.h"
+#include "itkCostFunctionClones.h"
 #include <vector>
 #include <utility>
 #include <deque>
@@ -219,6 +220,22 @@ public:
   itkSetMacro( ValueTolerance, double );
   itkGetConstMacro( ValueTolerance, double );
 
+  /** Type of a container of cost functions. */
+  typedef CostFunctionClones::CostFunctionContainerType CostFunctionContainerType;
+
+  /** Setting: independent copies of the cost function, used to evaluate the
+   * offspring in parallel. Each copy must compute the same value as the cost
+   * function of the optimizer, and may not share any modifiable state (transform,
+   * interpolator, metric buffers) with it or with the other copies.
+   * Offspring member \f$i\f$ is evaluated by copy \f$i \bmod n\f$, each copy
+   * on its own thread of the itk::ThreadPool, so the copies themselves should
+   * run single-threaded. The scales of the optimizer are applied to each copy.
+   * Default: empty, which means that the offspring are evaluated sequentially
+   * by the cost function of the optimizer. */
+  virtual void SetCostFunctionClones( const CostFunctionContainerType & clones );
+  virtual const CostFunctionContainerType & GetCostFunctionClones( void ) const
+  { return this->m_CostFunctionClones; }
+
 protected:
 
   typedef Array< double >               RecombinationWeightsType;
@@ -358,6 +375,15 @@ protected:
    * and m_CostFunctionValues */
   virtual void GenerateOffspring( void );
 
+  /** Fill m_NormalizedSearchDirs[ lam ] and m_SearchDirs[ lam ] with a new random sample */
+  virtual void GenerateSearchDirection( unsigned int lam );
+
+  /** Evaluate the cost function at m + d_lam for all offspring members, using
+   * the cost function clones in parallel if available. Members of which the
+   * evaluation threw an itk::ExceptionObject are marked as failed. */
+  virtual void EvaluateOffspring( std::vector< MeasureType > & values,
+    std::vector< unsigned char > & failed );
+
   /** Sort the m_CostFunctionValues vector and update m_MeasureHistory */
   virtual void SortCostFunctionValues( void );
 
@@ -423,6 +449,8 @@ private:
   double        m_PositionToleranceMin;
   double        m_ValueTolerance;
 
+  CostFunctionContainerType m_CostFunctionClones;
+
 };
 
 } // end namespace itk
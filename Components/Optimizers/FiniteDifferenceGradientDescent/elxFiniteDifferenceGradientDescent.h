@@ -70,6 +70,10 @@ namespace elastix
  *   This flag can NOT be defined for each resolution. \n
  *   example: <tt>(ShowMetricValues "true" )</tt> \n
  *   Default value: "false". Note that turning this flag on increases computation time.
+ * \parameter NumberOfCostFunctionClones: The number of copies of the metric that evaluate
+ *   the perturbed positions of the gradient in parallel, see OptimizerBase.\n
+ *   example: <tt>(NumberOfCostFunctionClones 8 8 8)</tt> \n
+ *   Default value: 0, which means that the perturbed positions are evaluated one by one.
 
  *
  * \ingroup Optimizers
@@ -133,6 +137,7 @@ public:
   void AfterRegistration( void ) override;
 
   /** Check if any scales are set, and set the UseScales flag on or off;
+   * create the cost function clones, see OptimizerBase::CreateCostFunctionClones();
    * after that call the superclass' implementation */
   void StartOptimization( void ) override;
 
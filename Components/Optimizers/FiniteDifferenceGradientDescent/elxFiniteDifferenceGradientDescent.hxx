@@ -243,6 +243,9 @@ FiniteDifferenceGradientDescent< TElastix >
     }
   }
 
+  /** Evaluate the perturbed positions on copies of the metric, if desired. */
+  this->SetCostFunctionClones( this->CreateCostFunctionClones() );
+
   this->Superclass1::StartOptimization();
 
 }   //end StartOptimization
@@ -23,9 +23,11 @@
 #include "itkCommand.h"
 #include "itkEventObject.h"
 #include "itkMacro.h"
+#include "itkCostFunctionClones.h"
 
 #include "math.h"
 #include "vnl/vnl_math.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -77,6 +79,8 @@ FiniteDifferenceGradientDescentOptimizer
      << this->m_Value;
   os << indent << "StopCondition: "
      << this->m_StopCondition;
+  os << indent << "CostFunctionClones: "
+     << this->m_CostFunctionClones.size();
   os << std::endl;
 
 } // end PrintSelf
@@ -126,9 +130,9 @@ FiniteDifferenceGradientDescentOptimizer
   double       ck             = 1.0;
   unsigned int spaceDimension = 1;
 
-  ParametersType param;
-  double         valueplus;
-  double         valuemin;
+  ParametersType             param;
+  std::vector< MeasureType > valuesPlus;
+  std::vector< MeasureType > valuesMin;
 
   InvokeEvent( StartEvent() );
   while( !this->m_Stop )
@@ -168,20 +172,7 @@ FiniteDifferenceGradientDescentOptimizer
     /** Calculate the derivative; this may take a while... */
     try
     {
-      for( unsigned int j = 0; j < spaceDimension; j++ )
-      {
-        param[ j ] += ck;
-        valueplus   = this->GetScaledValue( param );
-        param[ j ] -= 2.0 * ck;
-        valuemin    = this->GetScaledValue( param );
-        param[ j ] += ck;
-
-        const double gradient = ( valueplus - valuemin ) / ( 2.0 * ck );
-        this->m_Gradient[ j ] = gradient;
-
-        sumOfSquaredGradients += ( gradient * gradient );
-
-      }   // for j = 0 .. spaceDimension
+      this->ComputePerturbedValues( param, ck, valuesPlus, valuesMin );
     }
     catch( ExceptionObject & err )
     {
@@ -194,6 +185,16 @@ FiniteDifferenceGradientDescentOptimizer
       throw err;
     }
 
+    /** Assemble the gradient in parameter order. */
+    for( unsigned int j = 0; j < spaceDimension; j++ )
+    {
+      const double gradient = ( valuesPlus[ j ] - valuesMin[ j ] ) / ( 2.0 * ck );
+      this->m_Gradient[ j ] = gradient;
+
+      sumOfSquaredGradients += ( gradient * gradient );
+
+    }   // for j = 0 .. spaceDimension
+
     if( m_Stop )
     {
       break;
@@ -219,6 +220,73 @@ FiniteDifferenceGradientDescentOptimizer
 } // end ResumeOptimization
 
 
+/**
+ * ******************** SetCostFunctionClones *******************
+ */
+
+void
+FiniteDifferenceGradientDescentOptimizer
+::SetCostFunctionClones( const CostFunctionContainerType & clones )
+{
+  itkDebugMacro( "SetCostFunctionClones" );
+
+  this->m_CostFunctionClones = clones;
+  this->Modified();
+
+} // end SetCostFunctionClones
+
+
+/**
+ * ******************* ComputePerturbedValues *******************
+ */
+
+void
+FiniteDifferenceGradientDescentOptimizer
+::ComputePerturbedValues( const ParametersType & param, const double ck,
+  std::vector< MeasureType > & valuesPlus, std::vector< MeasureType > & valuesMin )
+{
+  const unsigned int spaceDimension = param.GetSize();
+  valuesPlus.resize( spaceDimension );
+  valuesMin.resize( spaceDimension );
+
+  /** Sequential evaluation by the cost function of the optimizer. */
+  if( this->m_CostFunctionClones.empty() )
+  {
+    ParametersType perturbed = param;
+    for( unsigned int j = 0; j < spaceDimension; j++ )
+    {
+      perturbed[ j ]  = param[ j ] + ck;
+      valuesPlus[ j ] = this->GetScaledValue( perturbed );
+      perturbed[ j ]  = param[ j ] - ck;
+      valuesMin[ j ]  = this->GetScaledValue( perturbed );
+      perturbed[ j ]  = param[ j ];
+    }
+    return;
+  }
+
+  /** Wrap each clone in a scaled cost function, like the cost function of the optimizer.
+   * Evaluation i is param + ck e_j for i = 2j, and param - ck e_j for i = 2j + 1.
+   * Clone c does the evaluations c, c + numberOfClones, etc. */
+  const unsigned int numberOfEvaluations = 2 * spaceDimension;
+  const unsigned int numberOfClones      = std::min(
+    static_cast< unsigned int >( this->m_CostFunctionClones.size() ), numberOfEvaluations );
+  const CostFunctionClones::ScaledCostFunctionContainerType scaledClones
+    = CostFunctionClones::CreateScaledClones( this->m_CostFunctionClones,
+    this->GetScaledCostFunction(), numberOfClones );
+
+  CostFunctionClones::Evaluate( numberOfClones, numberOfEvaluations,
+    [ & ]( const std::size_t c, const std::size_t i )
+  {
+    const std::size_t j         = i / 2;
+    ParametersType    perturbed = param;
+    perturbed[ j ] = ( i % 2 == 0 ) ? param[ j ] + ck : param[ j ] - ck;
+    const MeasureType value = scaledClones[ c ]->GetValue( perturbed );
+    ( i % 2 == 0 ? valuesPlus : valuesMin )[ j ] = value;
+  } );
+
+} // end ComputePerturbedValues
+
+
 /**
  * ********************** StopOptimization **********************
  */
@@ -20,6 +20,8 @@
 #define __itkFiniteDifferenceGradientDescentOptimizer_h
 
 #include "itkScaledSingleValuedNonLinearOptimizer.h"
+#include "itkCostFunctionClones.h"
+#include <vector>
 
 namespace itk
 {
@@ -48,6 +50,9 @@ namespace itk
  * Note the similarities to the SimultaneousPerturbation optimizer and
  * the StandardGradientDescent optimizer.
  *
+ * The \f$2N\f$ cost function evaluations per iteration can be done in
+ * parallel, see SetCostFunctionClones().
+ *
  * \ingroup Optimizers
  * \sa FiniteDifferenceGradientDescent
  */
@@ -132,6 +137,22 @@ public:
   itkGetConstMacro( GradientMagnitude, double );
   itkGetConstMacro( LearningRate, double );
 
+  /** Type of a container of cost functions. */
+  typedef CostFunctionClones::CostFunctionContainerType CostFunctionContainerType;
+
+  /** Setting: independent copies of the cost function, used to evaluate the
+   * perturbed positions of the finite difference gradient in parallel. Each copy
+   * must compute the same value as the cost function of the optimizer, and may
+   * not share any modifiable state with it or with the other copies. The copies
+   * are run on the threads of the itk::ThreadPool, so they should be
+   * single-threaded themselves. The gradient is assembled in parameter order
+   * afterwards, so the result does not depend on the number of copies.
+   * Default: empty, which means that the perturbed positions are evaluated
+   * sequentially by the cost function of the optimizer. */
+  virtual void SetCostFunctionClones( const CostFunctionContainerType & clones );
+  virtual const CostFunctionContainerType & GetCostFunctionClones( void ) const
+  { return this->m_CostFunctionClones; }
+
 protected:
 
   FiniteDifferenceGradientDescentOptimizer();
@@ -157,6 +178,11 @@ protected:
 
   virtual double Compute_c( unsigned long k ) const;
 
+  /** Compute the cost function values at the positions
+   * param + ck e_j and param - ck e_j, for all parameters j. */
+  virtual void ComputePerturbedValues( const ParametersType & param, const double ck,
+    std::vector< MeasureType > & valuesPlus, std::vector< MeasureType > & valuesMin );
+
 private:
 
   FiniteDifferenceGradientDescentOptimizer( const Self & ); // purposely not implemented
@@ -176,6 +202,8 @@ private:
   double m_Param_alpha;
   double m_Param_gamma;
 
+  CostFunctionContainerType m_CostFunctionClones;
+
 };
 
 } // end namespace itk
@@ -48,6 +48,21 @@ namespace elastix
  *   This varies the second transform parameter in the range [-4.0 3.0] with steps of 1.0
  *   and the third parameter in the range [-1.0 1.0] with steps of 0.5. The names are used
  *   as column headers in the screen output.
+ * \parameter FullSearchNumberOfRefinementCandidates: The number of best grid points that are
+ *   refined after the full search space has been scanned.
+ *   The parameter can be specified for each resolution, or for all resolutions at once.\n
+ *   example: <tt>(FullSearchNumberOfRefinementCandidates 5)</tt> \n
+ *   Default: 0, which means no refinement.
+ * \parameter FullSearchNumberOfRefinementLevels: The number of times the step sizes are
+ *   halved around the best candidates. Each level evaluates the 3^N - 1 neighbours of each
+ *   candidate, with N the dimension of the search space.
+ *   The parameter can be specified for each resolution, or for all resolutions at once.\n
+ *   example: <tt>(FullSearchNumberOfRefinementLevels 3)</tt> \n
+ *   Default: 0, which means no refinement.
+ * \parameter NumberOfCostFunctionClones: The number of copies of the metric that evaluate
+ *   the grid points in parallel, see OptimizerBase.\n
+ *   example: <tt>(NumberOfCostFunctionClones 8)</tt> \n
+ *   Default: 0, which means that the grid points are evaluated one by one.
  *
  * \ingroup Optimizers
  * \sa FullSearchOptimizer
@@ -124,6 +139,10 @@ public:
 
   void AfterRegistration( void ) override;
 
+  /** Create the cost function clones, see OptimizerBase::CreateCostFunctionClones();
+   * after that call the superclass' implementation. */
+  void StartOptimization( void ) override;
+
   /** \todo BeforeAll, checking parameters. */
 
   /** Get a pointer to the image containing the optimization surface. */
@@ -193,6 +193,16 @@ FullSearch< TElastix >
       << "." << resultImageFormat;
     this->m_OptimizationSurface->SetOutputFileName( makeString.str().c_str() );
 
+    /** Read the refinement settings. */
+    unsigned int numberOfRefinementCandidates = 0;
+    unsigned int numberOfRefinementLevels     = 0;
+    this->GetConfiguration()->ReadParameter( numberOfRefinementCandidates,
+      "FullSearchNumberOfRefinementCandidates", this->GetComponentLabel(), level, 0 );
+    this->GetConfiguration()->ReadParameter( numberOfRefinementLevels,
+      "FullSearchNumberOfRefinementLevels", this->GetComponentLabel(), level, 0 );
+    this->SetNumberOfRefinementCandidates( numberOfRefinementCandidates );
+    this->SetNumberOfRefinementLevels( numberOfRefinementLevels );
+
     elxout
       << "Total number of iterations needed in this resolution: "
       << this->GetNumberOfIterations()
@@ -312,12 +322,24 @@ FullSearch< TElastix >
   }
   elxout << "]" << std::endl;
 
+  const SearchSpacePointType bestGridPoint = this->IndexToPoint( bestIndex );
   elxout << "The corresponding parameter values: [ ";
   for( unsigned int dim = 0; dim < nrOfSSDims; dim++ )
   {
-    elxout << bestPoint[ dim ] << " ";
+    elxout << bestGridPoint[ dim ] << " ";
   }
-  elxout << "]\n" << std::endl;
+  elxout << "]" << std::endl;
+
+  if( this->GetNumberOfRefinementCandidates() > 0 && this->GetNumberOfRefinementLevels() > 0 )
+  {
+    elxout << "The parameter values after refinement: [ ";
+    for( unsigned int dim = 0; dim < nrOfSSDims; dim++ )
+    {
+      elxout << bestPoint[ dim ] << " ";
+    }
+    elxout << "]" << std::endl;
+  }
+  elxout << std::endl;
 
   /** Remove the columns from xout["iteration"]. */
   NameIteratorType name_it = this->m_SearchSpaceDimensionNames.begin();
@@ -351,6 +373,24 @@ FullSearch< TElastix >
 } // end AfterRegistration()
 
 
+/**
+ * ******************* StartOptimization ************************
+ */
+
+template< class TElastix >
+void
+FullSearch< TElastix >
+::StartOptimization( void )
+{
+  /** Evaluate the grid points on copies of the metric, if desired. */
+  this->SetCostFunctionClones( this->CreateCostFunctionClones() );
+
+  /** Call the superclass */
+  this->Superclass1::StartOptimization();
+
+} // end StartOptimization()
+
+
 /**
  * ************ CheckSearchSpaceRangeDefinition *****************
  */
@@ -24,6 +24,10 @@
 #include "itkEventObject.h"
 #include "itkMacro.h"
 #include "itkNumericTraits.h"
+#include "itkCostFunctionClones.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace itk
 {
@@ -45,6 +49,8 @@ FullSearchOptimizer
   m_NumberOfSearchSpaceDimensions = 0;
   m_SearchSpace                   = 0;
   m_LastSearchSpaceChanges        = 0;
+  m_NumberOfRefinementCandidates  = 0;
+  m_NumberOfRefinementLevels      = 0;
 
 }   //end constructor
 
@@ -68,6 +74,7 @@ FullSearchOptimizer
 
   m_CurrentPointInSearchSpace = this->IndexToPoint( m_CurrentIndexInSearchSpace );
   m_BestPointInSearchSpace    = m_CurrentPointInSearchSpace;
+  m_RefinementCandidates.clear();
 
   this->SetCurrentPosition( this->PointToPosition( m_CurrentPointInSearchSpace ) );
 
@@ -97,58 +104,289 @@ FullSearchOptimizer
 
   m_Stop = false;
 
+  /** Grid points are evaluated in batches. Without clones a batch is just
+   * the current position, which gives the original point by point search. */
+  const unsigned long numberOfIterations = this->GetNumberOfIterations();
+  const std::size_t   batchSize          = m_CostFunctionClones.empty()
+    ? 1 : 16 * m_CostFunctionClones.size();
+
+  std::vector< ParametersType >       positions;
+  std::vector< SearchSpacePointType > points;
+  std::vector< SearchSpaceIndexType > indices;
+  std::vector< MeasureType >          values;
+
   InvokeEvent( StartEvent() );
   while( !m_Stop )
   {
-
-    try
+    /** Collect the next batch of grid points, starting at the current position. */
+    positions.clear();
+    points.clear();
+    indices.clear();
+    unsigned long iteration = m_CurrentIteration;
+    while( true )
     {
-      m_Value = m_CostFunction->GetValue( this->GetCurrentPosition() );
+      positions.push_back( this->GetCurrentPosition() );
+      points.push_back( m_CurrentPointInSearchSpace );
+      indices.push_back( m_CurrentIndexInSearchSpace );
+      ++iteration;
+      if( positions.size() == batchSize || iteration >= numberOfIterations )
+      {
+        break;
+      }
+      this->UpdateCurrentPosition();
     }
-    catch( ExceptionObject & err )
-    {
-      // An exception has occurred.
-      // Terminate immediately.
-      m_StopCondition = MetricError;
-      StopOptimization();
 
-      // Pass exception to caller
-      throw err;
-    }
+    /** Compute the cost function values. Throws in case of a metric error. */
+    this->EvaluatePositions( positions, values );
 
     if( m_Stop )
     {
       break;
     }
 
-    /** Check if the value is a minimum or maximum */
-    if( ( m_Value < m_BestValue )  ^  m_Maximize )         // ^ = xor, yields true if only one of the expressions is true
+    /** Process the grid points in the original order. */
+    for( std::size_t i = 0; i < positions.size(); ++i )
     {
-      m_BestValue              = m_Value;
-      m_BestPointInSearchSpace = m_CurrentPointInSearchSpace;
-      m_BestIndexInSearchSpace = m_CurrentIndexInSearchSpace;
-    }
+      m_Value                     = values[ i ];
+      m_CurrentPointInSearchSpace = points[ i ];
+      m_CurrentIndexInSearchSpace = indices[ i ];
+      this->SetCurrentPosition( positions[ i ] );
 
-    this->InvokeEvent( IterationEvent() );
+      /** Check if the value is a minimum or maximum */
+      if( this->IsBetter( m_Value, m_BestValue ) )
+      {
+        m_BestValue              = m_Value;
+        m_BestPointInSearchSpace = m_CurrentPointInSearchSpace;
+        m_BestIndexInSearchSpace = m_CurrentIndexInSearchSpace;
+      }
+      this->UpdateRefinementCandidates( m_Value, m_CurrentPointInSearchSpace );
 
-    /** Prepare for next step */
-    m_CurrentIteration++;
+      this->InvokeEvent( IterationEvent() );
 
-    if( m_CurrentIteration >= this->GetNumberOfIterations() )
-    {
-      m_StopCondition = FullRangeSearched;
-      StopOptimization();
-      break;
+      /** Prepare for next step */
+      m_CurrentIteration++;
+
+      if( m_CurrentIteration >= numberOfIterations )
+      {
+        this->RefineBestPoints();
+        m_StopCondition = FullRangeSearched;
+        StopOptimization();
+        break;
+      }
+
+      if( m_Stop )
+      {
+        break;
+      }
     }
 
     /** Set the next position in search space. */
-    this->UpdateCurrentPosition();
+    if( !m_Stop )
+    {
+      this->UpdateCurrentPosition();
+    }
 
   } // end while
 
 }   //end function ResumeOptimization
 
 
+/**
+ * ******************** SetCostFunctionClones ******************
+ */
+void
+FullSearchOptimizer
+::SetCostFunctionClones( const CostFunctionContainerType & clones )
+{
+  itkDebugMacro( "SetCostFunctionClones" );
+
+  this->m_CostFunctionClones = clones;
+  this->Modified();
+
+} // end function SetCostFunctionClones
+
+
+/**
+ * ******************** EvaluatePositions ******************
+ */
+void
+FullSearchOptimizer
+::EvaluatePositions( const std::vector< ParametersType > & positions,
+  std::vector< MeasureType > & values )
+{
+  const std::size_t numberOfPositions = positions.size();
+  values.resize( numberOfPositions );
+
+  /** Clone c evaluates the positions c, c + numberOfClones, etc. Without
+   * clones, the cost function of the optimizer evaluates all positions. */
+  const std::size_t numberOfClones = m_CostFunctionClones.size();
+  try
+  {
+    CostFunctionClones::Evaluate( std::max( numberOfClones, std::size_t( 1 ) ), numberOfPositions,
+      [ & ]( const std::size_t c, const std::size_t i )
+    {
+      const CostFunctionType * costFunction = numberOfClones == 0
+        ? m_CostFunction.GetPointer() : m_CostFunctionClones[ c ].GetPointer();
+      values[ i ] = costFunction->GetValue( positions[ i ] );
+    } );
+  }
+  catch( ExceptionObject & )
+  {
+    /** A metric error: terminate immediately, and pass the exception to the caller. */
+    m_StopCondition = MetricError;
+    StopOptimization();
+    throw;
+  }
+
+} // end function EvaluatePositions
+
+
+/**
+ * ******************** UpdateRefinementCandidates ******************
+ */
+void
+FullSearchOptimizer
+::UpdateRefinementCandidates( const MeasureType value,
+  const SearchSpacePointType & point )
+{
+  if( m_NumberOfRefinementCandidates == 0 || m_NumberOfRefinementLevels == 0 )
+  {
+    return;
+  }
+
+  /** Insert after the candidates that are at least as good, so that
+   * of equal values the first one found stays ahead. */
+  std::vector< CandidateType >::iterator it = m_RefinementCandidates.begin();
+  while( it != m_RefinementCandidates.end() && !this->IsBetter( value, it->first ) )
+  {
+    ++it;
+  }
+  if( static_cast< unsigned int >( it - m_RefinementCandidates.begin() ) < m_NumberOfRefinementCandidates )
+  {
+    m_RefinementCandidates.insert( it, CandidateType( value, point ) );
+    if( m_RefinementCandidates.size() > m_NumberOfRefinementCandidates )
+    {
+      m_RefinementCandidates.pop_back();
+    }
+  }
+
+} // end function UpdateRefinementCandidates
+
+
+/**
+ * ******************** RefineBestPoints ******************
+ */
+void
+FullSearchOptimizer
+::RefineBestPoints( void )
+{
+  if( m_RefinementCandidates.empty() || m_NumberOfRefinementLevels == 0 )
+  {
+    return;
+  }
+
+  /** Get the ranges of the search space. */
+  const unsigned int  searchSpaceDimension = this->GetNumberOfSearchSpaceDimensions();
+  SearchSpacePointType minimum( searchSpaceDimension );
+  SearchSpacePointType maximum( searchSpaceDimension );
+  SearchSpacePointType step( searchSpaceDimension );
+  SearchSpaceIteratorType it( m_SearchSpace->Begin() );
+  for( unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++ )
+  {
+    const RangeType range = it.Value();
+    minimum[ ssdim ] = range[ 0 ];
+    maximum[ ssdim ] = range[ 1 ];
+    step[ ssdim ]    = range[ 2 ];
+    it++;
+  }
+
+  /** The number of neighbours of a point: 3^d - 1. */
+  unsigned int numberOfNeighbours = 1;
+  for( unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++ )
+  {
+    numberOfNeighbours *= 3;
+  }
+  numberOfNeighbours -= 1;
+
+  /** All points of a refinement level lie on a grid with the current step sizes,
+   * so points that differ less than half a step are the same grid point. */
+  std::vector< SearchSpacePointType > knownPoints;
+  auto isKnownPoint = [ & ]( const SearchSpacePointType & point )
+  {
+    for( std::size_t i = 0; i < knownPoints.size(); ++i )
+    {
+      bool equal = true;
+      for( unsigned int ssdim = 0; equal && ssdim < searchSpaceDimension; ssdim++ )
+      {
+        equal = std::abs( knownPoints[ i ][ ssdim ] - point[ ssdim ] ) < 0.5 * step[ ssdim ];
+      }
+      if( equal )
+      {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  std::vector< SearchSpacePointType > points;
+  std::vector< ParametersType >       positions;
+  std::vector< MeasureType >          values;
+  for( unsigned int level = 0; level < m_NumberOfRefinementLevels; ++level )
+  {
+    step /= 2.0;
+
+    /** Collect the neighbours of all candidates, inside the search space.
+     * Neighbouring candidates share neighbours, and a neighbour may be another
+     * candidate, so skip the points that are known already. */
+    points.clear();
+    positions.clear();
+    knownPoints.clear();
+    for( std::size_t c = 0; c < m_RefinementCandidates.size(); ++c )
+    {
+      knownPoints.push_back( m_RefinementCandidates[ c ].second );
+    }
+    for( std::size_t c = 0; c < m_RefinementCandidates.size(); ++c )
+    {
+      for( unsigned int n = 0; n <= numberOfNeighbours; ++n )
+      {
+        /** The digits of n in base 3 give the offsets -1, 0, 1 in each dimension. */
+        SearchSpacePointType point  = m_RefinementCandidates[ c ].second;
+        unsigned int         offset = n;
+        bool                 inside = true;
+        for( unsigned int ssdim = 0; ssdim < searchSpaceDimension; ssdim++ )
+        {
+          point[ ssdim ] += step[ ssdim ] * ( static_cast< double >( offset % 3 ) - 1.0 );
+          offset         /= 3;
+          inside          = inside && point[ ssdim ] >= minimum[ ssdim ] && point[ ssdim ] <= maximum[ ssdim ];
+        }
+        if( inside && !isKnownPoint( point ) )
+        {
+          knownPoints.push_back( point );
+          points.push_back( point );
+          positions.push_back( this->PointToPosition( point ) );
+        }
+      }
+    }
+
+    this->EvaluatePositions( positions, values );
+
+    /** The best of the old candidates and the new points continue. */
+    for( std::size_t i = 0; i < points.size(); ++i )
+    {
+      this->UpdateRefinementCandidates( values[ i ], points[ i ] );
+    }
+  }
+
+  /** The best candidate is the result, if it improved. */
+  if( this->IsBetter( m_RefinementCandidates[ 0 ].first, m_BestValue ) )
+  {
+    m_BestValue              = m_RefinementCandidates[ 0 ].first;
+    m_BestPointInSearchSpace = m_RefinementCandidates[ 0 ].second;
+  }
+
+} // end function RefineBestPoints
+
+
 /**
  * ************************** Stop optimization ******************
  */
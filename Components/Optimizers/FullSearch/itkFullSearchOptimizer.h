@@ -20,11 +20,15 @@
 #define __itkFullSearchOptimizer_h
 
 #include "itkSingleValuedNonLinearOptimizer.h"
+#include "itkCostFunctionClones.h"
 #include "itkMapContainer.h"
 #include "itkImage.h"
 #include "itkArray.h"
 #include "itkFixedArray.h"
 
+#include <utility>
+#include <vector>
+
 namespace itk
 {
 
@@ -35,6 +39,10 @@ namespace itk
  * Optimizer that scans a subspace of the parameter space
  * and searches for the best parameters.
  *
+ * The grid points can be evaluated in parallel, see SetCostFunctionClones().
+ * Afterwards, the search can optionally be refined around the best grid points,
+ * see SetNumberOfRefinementCandidates() and SetNumberOfRefinementLevels().
+ *
  * \todo This optimizer has similar functionality as the recently added
  * itkExhaustiveOptimizer. See if we can replace it by that optimizer,
  * or inherit from it.
@@ -191,6 +199,38 @@ public:
   /** Get Stop condition. */
   itkGetConstMacro( StopCondition, StopConditionType );
 
+  /** Type of a container of cost functions. */
+  typedef CostFunctionClones::CostFunctionContainerType CostFunctionContainerType;
+
+  /** Set/Get independent copies of the cost function, used to evaluate the
+   * grid points in parallel. Each copy must compute the same value as the cost
+   * function of the optimizer, and may not share any modifiable state with it
+   * or with the other copies. The copies are run on the threads of the
+   * itk::ThreadPool, so they should be single-threaded themselves.
+   * The IterationEvent is still invoked for every grid point, in grid order.
+   * Default: empty, which means that the grid points are evaluated sequentially
+   * by the cost function of the optimizer.
+   */
+  virtual void SetCostFunctionClones( const CostFunctionContainerType & clones );
+  virtual const CostFunctionContainerType & GetCostFunctionClones( void ) const
+  { return this->m_CostFunctionClones; }
+
+  /** Set/Get the number of best grid points that are refined after the full
+   * range has been searched. In each refinement level the step sizes are halved,
+   * and the neighbours of the candidates at the new step sizes are evaluated;
+   * the best candidates of all evaluated points continue to the next level.
+   * Refinement points do not invoke an IterationEvent. After refinement, the
+   * BestPointInSearchSpace and BestValue refer to the refined optimum, which is
+   * generally not a grid point, while the BestIndexInSearchSpace keeps the
+   * best grid point. Default: 0, no refinement.
+   */
+  itkSetMacro( NumberOfRefinementCandidates, unsigned int );
+  itkGetConstMacro( NumberOfRefinementCandidates, unsigned int );
+
+  /** Set/Get the number of refinement levels. Default: 0, no refinement. */
+  itkSetMacro( NumberOfRefinementLevels, unsigned int );
+  itkGetConstMacro( NumberOfRefinementLevels, unsigned int );
+
 protected:
 
   FullSearchOptimizer();
@@ -215,6 +255,22 @@ protected:
   unsigned long m_LastSearchSpaceChanges;
   virtual void ProcessSearchSpaceChanges( void );
 
+  /** Evaluate the cost function at a number of positions, using the cost
+   * function clones in parallel if available. */
+  virtual void EvaluatePositions( const std::vector< ParametersType > & positions,
+    std::vector< MeasureType > & values );
+
+  /** Returns true if value1 is better than value2. */
+  bool IsBetter( const MeasureType value1, const MeasureType value2 ) const
+  { return ( value1 < value2 ) ^ this->m_Maximize; }
+
+  /** Keep track of the best grid points, for the refinement. */
+  virtual void UpdateRefinementCandidates( const MeasureType value,
+    const SearchSpacePointType & point );
+
+  /** Refine the best grid points; updates the BestPointInSearchSpace and BestValue. */
+  virtual void RefineBestPoints( void );
+
 private:
 
   FullSearchOptimizer( const Self & ); // purposely not implemented
@@ -222,6 +278,13 @@ private:
 
   unsigned long m_CurrentIteration;
 
+  CostFunctionContainerType m_CostFunctionClones;
+  unsigned int              m_NumberOfRefinementCandidates;
+  unsigned int              m_NumberOfRefinementLevels;
+
+  typedef std::pair< MeasureType, SearchSpacePointType > CandidateType;
+  std::vector< CandidateType > m_RefinementCandidates;
+
 };
 
 } // end namespace itk
@@ -20,6 +20,8 @@
 
 #include "elxIncludes.h" // include first to avoid MSVS warning
 #include "itkSPSAOptimizer.h"
+#include "itkCostFunctionClones.h"
+#include <vector>
 
 namespace elastix
 {
@@ -74,7 +76,13 @@ namespace elastix
  *   This flag can NOT be defined for each resolution. \n
  *   example: <tt>(ShowMetricValues "true" )</tt> \n
  *   Default value: "false". Note that turning this flag on increases computation time.
+ * \parameter NumberOfCostFunctionClones: The number of copies of the metric that evaluate
+ *   the perturbations of a gradient estimate in parallel, see OptimizerBase.\n
+ *   example: <tt>(NumberOfCostFunctionClones 8 8 8)</tt> \n
+ *   Default value: 0, which means that the perturbations are evaluated one by one.
  *
+ * The perturbations of a gradient estimate can be evaluated in parallel,
+ * see SetCostFunctionClones().
  *
  * \ingroup Optimizers
  */
@@ -123,6 +131,11 @@ public:
 
   /** Typedef for the ParametersType. */
   typedef typename Superclass1::ParametersType ParametersType;
+  typedef Superclass1::DerivativeType          DerivativeType;
+  typedef Superclass1::MeasureType             MeasureType;
+
+  /** Type of a container of cost functions. */
+  typedef itk::CostFunctionClones::CostFunctionContainerType CostFunctionContainerType;
 
   /** Methods that take care of setting parameters and printing progress information.*/
   void BeforeRegistration( void ) override;
@@ -141,6 +154,24 @@ public:
    * array have the same size. */
   void SetInitialPosition( const ParametersType & param ) override;
 
+  /** Create the cost function clones, see OptimizerBase::CreateCostFunctionClones();
+   * after that call the superclass' implementation. */
+  void StartOptimization( void ) override;
+
+  /** Setting: independent copies of the cost function, used to evaluate the
+   * perturbed positions of all perturbations of a gradient estimate in parallel.
+   * Each copy must compute the same value as the cost function of the optimizer,
+   * and may not share any modifiable state with it or with the other copies.
+   * The copies are run on the threads of the itk::ThreadPool, so they should
+   * be single-threaded themselves. The perturbation vectors are drawn and the
+   * gradient is accumulated in the same order as in the sequential case, so
+   * the result does not depend on the number of copies.
+   * Default: empty, which means that the itk::SPSAOptimizer evaluates the
+   * perturbations sequentially. */
+  virtual void SetCostFunctionClones( const CostFunctionContainerType & clones );
+  virtual const CostFunctionContainerType & GetCostFunctionClones( void ) const
+  { return this->m_CostFunctionClones; }
+
 protected:
 
   SimultaneousPerturbation();
@@ -148,11 +179,18 @@ protected:
 
   bool m_ShowMetricValues;
 
+  /** Compute the gradient estimate, evaluating the perturbations on the
+   * cost function clones if they are set. */
+  void ComputeGradient( const ParametersType & parameters,
+    DerivativeType & gradient ) override;
+
 private:
 
   SimultaneousPerturbation( const Self & );     // purposely not implemented
   void operator=( const Self & );               // purposely not implemented
 
+  CostFunctionContainerType m_CostFunctionClones;
+
 };
 
 } // end namespace elastix
@@ -23,6 +23,8 @@
 #include <iomanip>
 #include <string>
 #include "vnl/vnl_math.h"
+#include "itkCostFunctionClones.h"
+#include <algorithm>
 
 namespace elastix
 {
@@ -251,6 +253,108 @@ SimultaneousPerturbation< TElastix >
 } // end SetInitialPosition
 
 
+/**
+ * ******************* StartOptimization ************************
+ */
+
+template< class TElastix >
+void
+SimultaneousPerturbation< TElastix >
+::StartOptimization( void )
+{
+  /** Evaluate the perturbations on copies of the metric, if desired. */
+  this->SetCostFunctionClones( this->CreateCostFunctionClones() );
+
+  /** Call the superclass */
+  this->Superclass1::StartOptimization();
+
+} // end StartOptimization()
+
+
+/**
+ * ******************* SetCostFunctionClones ********************
+ */
+
+template< class TElastix >
+void
+SimultaneousPerturbation< TElastix >
+::SetCostFunctionClones( const CostFunctionContainerType & clones )
+{
+  this->m_CostFunctionClones = clones;
+  this->Modified();
+
+} // end SetCostFunctionClones
+
+
+/**
+ * ********************** ComputeGradient ***********************
+ */
+
+template< class TElastix >
+void
+SimultaneousPerturbation< TElastix >
+::ComputeGradient( const ParametersType & parameters, DerivativeType & gradient )
+{
+  /** Sequential evaluation by the cost function of the optimizer. */
+  if( this->m_CostFunctionClones.empty() )
+  {
+    this->Superclass1::ComputeGradient( parameters, gradient );
+    return;
+  }
+
+  const unsigned int spaceDimension        = parameters.GetSize();
+  const unsigned int numberOfPerturbations = this->GetNumberOfPerturbations();
+  const double       ck                    = this->Compute_c( this->GetCurrentIteration() );
+  const ScalesType & scales                = this->GetScales();
+
+  /** Draw all perturbation vectors first, in the same order as the Superclass does. */
+  std::vector< DerivativeType > deltas( numberOfPerturbations );
+  for( unsigned int p = 0; p < numberOfPerturbations; ++p )
+  {
+    this->GenerateDelta( spaceDimension );
+    deltas[ p ] = this->m_Delta;
+  }
+
+  /** Evaluation i is theta + ck delta_p for i = 2p, and theta - ck delta_p for i = 2p + 1.
+   * Clone c does the evaluations c, c + numberOfClones, etc. Any error is thrown as an
+   * itk::ExceptionObject, which the Superclass handles as a metric error. */
+  const unsigned int numberOfEvaluations = 2 * numberOfPerturbations;
+  const unsigned int numberOfClones      = std::min(
+    static_cast< unsigned int >( this->m_CostFunctionClones.size() ), numberOfEvaluations );
+  std::vector< MeasureType > values( numberOfEvaluations );
+  itk::CostFunctionClones::Evaluate( numberOfClones, numberOfEvaluations,
+    [ & ]( const std::size_t c, const std::size_t i )
+  {
+    const double   sign = ( i % 2 == 0 ) ? 1.0 : -1.0;
+    ParametersType theta( spaceDimension );
+    for( unsigned int j = 0; j < spaceDimension; ++j )
+    {
+      theta[ j ] = parameters[ j ] + sign * ck * deltas[ i / 2 ][ j ];
+    }
+    values[ i ] = this->m_CostFunctionClones[ c ]->GetValue( theta );
+  } );
+
+  /** Accumulate the gradient in perturbation order, like the Superclass. */
+  gradient = DerivativeType( spaceDimension );
+  gradient.Fill( 0.0 );
+  for( unsigned int p = 0; p < numberOfPerturbations; ++p )
+  {
+    const double valuediff = ( values[ 2 * p ] - values[ 2 * p + 1 ] ) / ( 2.0 * ck );
+    for( unsigned int j = 0; j < spaceDimension; ++j )
+    {
+      gradient[ j ] += valuediff / deltas[ p ][ j ];
+    }
+  }
+
+  /** Apply the scaling and divide by the number of perturbations. */
+  for( unsigned int j = 0; j < spaceDimension; ++j )
+  {
+    gradient[ j ] /= ( vnl_math::sqr( scales[ j ] ) * static_cast< double >( numberOfPerturbations ) );
+  }
+
+} // end ComputeGradient
+
+
 } // end namespace elastix
 
 #endif // end #ifndef __elxSimultaneousPerturbation_hxx
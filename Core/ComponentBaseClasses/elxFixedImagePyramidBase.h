@@ -49,6 +49,10 @@ namespace elastix
  * \parameter WritePyramidImagesAfterEachResolution: ...\n
  *    example: <tt>(WritePyramidImagesAfterEachResolution "true")</tt>\n
  *    default "false".
+ * \parameter CacheFixedImageData: a flag to determine if the pyramid images are reused
+ *    by a next registration of the same fixed image, with the same pyramid settings.\n
+ *    example: <tt>(CacheFixedImageData "false")</tt>\n
+ *    default "true". See RegistrationBase and FixedImageDataCache.
  *
  * \ingroup ImagePyramids
  * \ingroup ComponentBaseClasses
@@ -73,6 +77,7 @@ public:
   typedef typename Superclass::ConfigurationPointer ConfigurationPointer;
   typedef typename Superclass::RegistrationType     RegistrationType;
   typedef typename Superclass::RegistrationPointer  RegistrationPointer;
+  typedef typename Superclass::FixedImageDataCacheType FixedImageDataCacheType;
 
   /** Typedefs inherited from Elastix. */
   typedef typename ElastixType::FixedImageType InputImageType;
@@ -116,6 +121,24 @@ public:
   virtual void WritePyramidImage( const std::string & filename,
     const unsigned int & level ); // const;
 
+  /** Get a description of the computation of the pyramid images, which identifies
+   * them in the FixedImageDataCache, together with the input image. Contains the
+   * class name, the number of levels, and the schedule. An empty string means
+   * that the pyramid images can not be cached.
+   */
+  virtual std::string GetPyramidImagesCacheKey( void ) const;
+
+  /** Graft the pyramid images of a previous registration onto the outputs, if
+   * they are in the FixedImageDataCache, see the parameter CacheFixedImageData.
+   * Returns false if they are not. To be called by GenerateData().
+   */
+  virtual bool GraftCachedPyramidImages( void );
+
+  /** Add the pyramid images to the FixedImageDataCache, if it is used.
+   * To be called by GenerateData(), after the images are computed.
+   */
+  virtual void AddPyramidImagesToCache( void );
+
 protected:
 
   /** The constructor. */
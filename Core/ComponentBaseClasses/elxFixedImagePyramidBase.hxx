@@ -21,6 +21,9 @@
 #include "elxFixedImagePyramidBase.h"
 #include "itkImageFileCastWriter.h"
 
+#include <sstream>
+#include <vector>
+
 namespace elastix
 {
 
@@ -208,6 +211,105 @@ FixedImagePyramidBase< TElastix >
 } // end WritePyramidImage()
 
 
+/**
+ * ******************* GetPyramidImagesCacheKey ********************
+ */
+
+template< class TElastix >
+std::string
+FixedImagePyramidBase< TElastix >
+::GetPyramidImagesCacheKey( void ) const
+{
+  const ITKBaseType * pyramid = this->GetAsITKBaseType();
+
+  std::ostringstream key;
+  key << "FixedPyramid " << this->elxGetClassName()
+      << " levels " << pyramid->GetNumberOfLevels()
+      << " schedule " << pyramid->GetSchedule()
+      << " maximum error " << pyramid->GetMaximumError()
+      << " shrink " << pyramid->GetUseShrinkImageFilter();
+  return key.str();
+
+} // end GetPyramidImagesCacheKey()
+
+
+/**
+ * ******************* GraftCachedPyramidImages ********************
+ */
+
+template< class TElastix >
+bool
+FixedImagePyramidBase< TElastix >
+::GraftCachedPyramidImages( void )
+{
+  FixedImageDataCacheType * cache = this->GetFixedImageDataCache();
+  const std::string         key   = this->GetPyramidImagesCacheKey();
+  if( !cache || key.empty() )
+  {
+    return false;
+  }
+
+  /** All levels have to be in the cache. */
+  ITKBaseType *                                            pyramid = this->GetAsITKBaseType();
+  const typename FixedImageDataCacheType::SourceVectorType sources( 1, pyramid->GetInput() );
+  const unsigned int                                       numberOfLevels = pyramid->GetNumberOfLevels();
+  std::vector< OutputImageType * >                         cachedImages( numberOfLevels );
+  for( unsigned int level = 0; level < numberOfLevels; ++level )
+  {
+    std::ostringstream levelKey;
+    levelKey << key << " level " << level;
+    cachedImages[ level ] = dynamic_cast< OutputImageType * >(
+      cache->GetData( sources, levelKey.str() ) );
+    if( !cachedImages[ level ] )
+    {
+      return false;
+    }
+  }
+
+  elxout << "Reusing the fixed pyramid images of a previous registration." << std::endl;
+  for( unsigned int level = 0; level < numberOfLevels; ++level )
+  {
+    pyramid->GraftNthOutput( level, cachedImages[ level ] );
+  }
+  return true;
+
+} // end GraftCachedPyramidImages()
+
+
+/**
+ * ******************* AddPyramidImagesToCache ********************
+ */
+
+template< class TElastix >
+void
+FixedImagePyramidBase< TElastix >
+::AddPyramidImagesToCache( void )
+{
+  FixedImageDataCacheType * cache = this->GetFixedImageDataCache();
+  const std::string         key   = this->GetPyramidImagesCacheKey();
+  if( !cache || key.empty() )
+  {
+    return;
+  }
+
+  /** The cache gets its own image objects, which share the pixel buffers
+   * with the outputs, so that it is not affected by a next update.
+   */
+  ITKBaseType *                                            pyramid = this->GetAsITKBaseType();
+  const typename FixedImageDataCacheType::SourceVectorType sources( 1, pyramid->GetInput() );
+  for( unsigned int level = 0; level < pyramid->GetNumberOfLevels(); ++level )
+  {
+    typename OutputImageType::Pointer cachedImage = OutputImageType::New();
+    cachedImage->Graft( pyramid->GetOutput( level ) );
+
+    std::ostringstream levelKey;
+    levelKey << key << " level " << level;
+    cache->AddData( sources, levelKey.str(), cachedImage );
+  }
+
+} // end AddPyramidImagesToCache()
+
+
 } // end namespace elastix
 
 #endif // end #ifndef __elxFixedImagePyramidBase_hxx
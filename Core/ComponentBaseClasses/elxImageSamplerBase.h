@@ -36,6 +36,12 @@ namespace elastix
  *
  * This class contains all the common functionality for ImageSamplers.
  *
+ * \parameter CacheFixedImageData: a flag to determine if the samples of a
+ *    deterministic sampler, such as the Full and Grid sampler, are reused by a next
+ *    registration of the same fixed image and mask, with the same sampler settings.\n
+ *    example: <tt>(CacheFixedImageData "false")</tt>\n
+ *    default "true". See RegistrationBase and FixedImageDataCache.
+ *
  * \ingroup ImageSamplers
  * \ingroup ComponentBaseClasses
  */
@@ -59,12 +65,14 @@ public:
   typedef typename Superclass::ConfigurationPointer ConfigurationPointer;
   typedef typename Superclass::RegistrationType     RegistrationType;
   typedef typename Superclass::RegistrationPointer  RegistrationPointer;
+  typedef typename Superclass::FixedImageDataCacheType FixedImageDataCacheType;
 
   /** Other typedef's. */
   typedef typename ElastixType::FixedImageType InputImageType;
 
   /** ITKBaseType. */
   typedef itk::ImageSamplerBase< InputImageType > ITKBaseType;
+  typedef typename ITKBaseType::ImageSampleContainerType ImageSampleContainerType;
 
   /** Cast to ITKBaseType. */
   virtual ITKBaseType * GetAsITKBaseType( void )
@@ -86,6 +94,24 @@ public:
    */
   void BeforeEachResolutionBase( void ) override;
 
+  /** Get a description of the computation of the samples, which identifies them
+   * in the FixedImageDataCache, together with the input image and the mask image.
+   * Contains the class name and the geometry of the input image and region.
+   * An empty string means that the samples can not be cached.
+   */
+  virtual std::string GetSamplesCacheKey( void ) const;
+
+  /** Copy the samples of a previous registration to the output, if they are in
+   * the FixedImageDataCache, see the parameter CacheFixedImageData. Returns false
+   * if they are not. To be called by the GenerateData() of a deterministic sampler.
+   */
+  virtual bool CopyCachedSamples( void );
+
+  /** Add the samples to the FixedImageDataCache, if it is used. To be called by
+   * the GenerateData() of a deterministic sampler, after the samples are selected.
+   */
+  virtual void AddSamplesToCache( void );
+
 protected:
 
   /** The constructor. */
@@ -95,6 +121,13 @@ protected:
 
 private:
 
+  /** Get the objects that the samples are computed from: the pixel container of
+   * the input image, which is shared by the cached pyramid images, and the mask
+   * image, if any. Returns false if the mask is not an image mask.
+   */
+  bool GetSamplesCacheSources(
+    typename FixedImageDataCacheType::SourceVectorType & sources ) const;
+
   /** The private constructor. */
   ImageSamplerBase( const Self & );   // purposely not implemented
   /** The private copy constructor. */
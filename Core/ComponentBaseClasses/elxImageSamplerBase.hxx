@@ -20,6 +20,9 @@
 #define __elxImageSamplerBase_hxx
 
 #include "elxImageSamplerBase.h"
+#include "itkImageMaskSpatialObject.h"
+
+#include <sstream>
 
 namespace elastix
 {
@@ -67,6 +70,121 @@ ImageSamplerBase< TElastix >
 } // end BeforeEachResolutionBase()
 
 
+/**
+ * ******************* GetSamplesCacheKey ******************
+ */
+
+template< class TElastix >
+std::string
+ImageSamplerBase< TElastix >
+::GetSamplesCacheKey( void ) const
+{
+  const ITKBaseType *    sampler = this->GetAsITKBaseType();
+  const InputImageType * image   = sampler->GetInput();
+
+  std::ostringstream key;
+  key << "ImageSamples " << this->elxGetClassName()
+      << " region " << sampler->GetInputImageRegion().GetIndex()
+      << sampler->GetInputImageRegion().GetSize()
+      << " buffer " << image->GetBufferedRegion().GetIndex()
+      << image->GetBufferedRegion().GetSize()
+      << " origin " << image->GetOrigin()
+      << " spacing " << image->GetSpacing()
+      << " direction " << image->GetDirection();
+  return key.str();
+
+} // end GetSamplesCacheKey()
+
+
+/**
+ * ******************* GetSamplesCacheSources ******************
+ */
+
+template< class TElastix >
+bool
+ImageSamplerBase< TElastix >
+::GetSamplesCacheSources(
+  typename FixedImageDataCacheType::SourceVectorType & sources ) const
+{
+  typedef itk::ImageMaskSpatialObject< InputImageType::ImageDimension > ImageMaskSpatialObjectType;
+
+  const ITKBaseType * sampler = this->GetAsITKBaseType();
+  sources.clear();
+  sources.push_back( sampler->GetInput()->GetPixelContainer() );
+
+  const typename ITKBaseType::MaskType * mask = sampler->GetMask();
+  if( mask )
+  {
+    const ImageMaskSpatialObjectType * imageMask
+      = dynamic_cast< const ImageMaskSpatialObjectType * >( mask );
+    if( !imageMask )
+    {
+      return false;
+    }
+    sources.push_back( imageMask->GetImage() );
+  }
+  return true;
+
+} // end GetSamplesCacheSources()
+
+
+/**
+ * ******************* CopyCachedSamples ******************
+ */
+
+template< class TElastix >
+bool
+ImageSamplerBase< TElastix >
+::CopyCachedSamples( void )
+{
+  FixedImageDataCacheType *                          cache = this->GetFixedImageDataCache();
+  const std::string                                  key   = this->GetSamplesCacheKey();
+  typename FixedImageDataCacheType::SourceVectorType sources;
+  if( !cache || key.empty() || !this->GetSamplesCacheSources( sources ) )
+  {
+    return false;
+  }
+
+  const ImageSampleContainerType * cachedSamples = dynamic_cast< const ImageSampleContainerType * >(
+    cache->GetData( sources, key ) );
+  if( !cachedSamples )
+  {
+    return false;
+  }
+
+  elxout << "  Reusing the image samples of a previous registration." << std::endl;
+  this->GetAsITKBaseType()->GetOutput()->CastToSTLContainer()
+    = cachedSamples->CastToSTLConstContainer();
+  return true;
+
+} // end CopyCachedSamples()
+
+
+/**
+ * ******************* AddSamplesToCache ******************
+ */
+
+template< class TElastix >
+void
+ImageSamplerBase< TElastix >
+::AddSamplesToCache( void )
+{
+  FixedImageDataCacheType *                          cache = this->GetFixedImageDataCache();
+  const std::string                                  key   = this->GetSamplesCacheKey();
+  typename FixedImageDataCacheType::SourceVectorType sources;
+  if( !cache || key.empty() || !this->GetSamplesCacheSources( sources ) )
+  {
+    return;
+  }
+
+  /** The cache gets its own copy, since the output is overwritten by a next update. */
+  typename ImageSampleContainerType::Pointer cachedSamples = ImageSampleContainerType::New();
+  cachedSamples->CastToSTLContainer() = this->GetAsITKBaseType()->GetOutput()->CastToSTLConstContainer();
+  cache->AddData( sources, key, cachedSamples );
+
+} // end AddSamplesToCache()
+
+
 } // end namespace elastix
 
 #endif //#ifndef __elxImageSamplerBase_hxx
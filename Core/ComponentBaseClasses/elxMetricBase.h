@@ -25,6 +25,10 @@
 #include "itkAdvancedImageToImageMetric.h"
 #include "itkImageGridSampler.h"
 #include "itkPointSet.h"
+#include "itkFixedArray.h"
+
+#include <iomanip>
+#include <string>
 
 namespace elastix
 {
@@ -63,6 +67,57 @@ namespace elastix
  *    CheckNumberOfSamples. \n
  *    example: <tt>(RequiredRatioOfValidSamples 0.1)</tt> \n
  *    The default is 0.25.
+ * \parameter UseThreadPoolForMetrics: Whether the multi-threaded metric computations
+ *    are executed by a persistent thread pool, instead of by threads that are created
+ *    and joined at every iteration. The samples are then distributed over the threads
+ *    in small interleaved chunks, which evens out the differences in cost over the image.
+ *    Only used when UseMultiThreadingForMetrics is "true". Can be given for each
+ *    resolution or for all resolutions at once. \n
+ *    example: <tt>(UseThreadPoolForMetrics "true")</tt> \n
+ *    The default is "false".
+ * \parameter UseMixedPrecision: Whether the metric computes and stores the per-sample
+ *    image Jacobians (dM/dx)^T (dT/dmu) in single precision. For the RecursiveBSplineTransform
+ *    the products are computed in float; other transforms compute them in double and
+ *    round them. The metric value and derivative are always accumulated in double precision.
+ *    Used by the multi-threaded AdvancedMeanSquares and AdvancedNormalizedCorrelation
+ *    metrics, and by the low-memory derivative of AdvancedMattesMutualInformation.
+ *    Can be given for each resolution or for all resolutions at once. \n
+ *    example: <tt>(UseMixedPrecision "true")</tt> \n
+ *    The default is "true" when elastix is built with ELASTIX_USE_MIXED_PRECISION,
+ *    and "false" otherwise.
+ * \parameter UseAtomicDerivativeAccumulation: Whether the threads add their
+ *    derivative contributions atomically into one shared buffer, instead of into
+ *    a private derivative per thread that is summed afterwards. This saves memory
+ *    and the reduction pass for transforms with many parameters. Currently only
+ *    used by the AdvancedMeanSquares metric; ignored by the other metrics. The memory
+ *    of the derivative buffers is reported after each resolution; the time of the
+ *    reduction pass is reported with (ShowMetricHotPathTimes "true"). Can be
+ *    given for each resolution or for all resolutions at once. \n
+ *    example: <tt>(UseAtomicDerivativeAccumulation "true")</tt> \n
+ *    The default is "false".
+ * \parameter UseSampleWeightsCache: Whether the B-spline transform computes
+ *    the support index and interpolation weights of each sample once per
+ *    resolution, instead of in every iteration. This only pays off when the
+ *    samples do not change, e.g. with the Full and Grid samplers, or with
+ *    (NewSamplesEveryIteration "false"); otherwise the cache is dropped after
+ *    the first iteration. It costs memory: for a third order 3D B-spline 64 floats
+ *    per sample (12 for the RecursiveBSplineTransform). The weights are stored
+ *    in single precision. Used by the multi-threaded AdvancedMeanSquares and
+ *    AdvancedNormalizedCorrelation metrics.
+ *    Can be given for each resolution or for all resolutions at once. \n
+ *    example: <tt>(UseSampleWeightsCache "true")</tt> \n
+ *    The default is "false".
+ * \parameter ShowMetricHotPathTimes: Whether the time spent in the phases of the
+ *    metric computation is shown in every iteration: updating the sampler, setting
+ *    the transform parameters, the multi-threaded loop over the samples, and the
+ *    accumulation of the results of the threads. Adds the columns
+ *    Sampler<label>[ms], Transform<label>[ms], Threaded<label>[ms] and
+ *    Accumulate<label>[ms] to the iteration info, and prints the totals at the end
+ *    of each resolution. The remainder of Time[ms] is mostly spent in the optimizer.
+ *    Only supported by advanced metrics. Can be given for each resolution or for
+ *    all resolutions at once. \n
+ *    example: <tt>(ShowMetricHotPathTimes "true")</tt> \n
+ *    The default is "false".
  *
  * \ingroup Metrics
  * \ingroup ComponentBaseClasses
@@ -155,6 +210,11 @@ public:
    */
   void AfterEachIterationBase( void ) override;
 
+  /** Execute stuff after each resolution:
+   * \li Print the time spent in the phases of the metric computation.
+   */
+  void AfterEachResolutionBase( void ) override;
+
   /** Force the metric to base its computation on a new subset of image samples.
    * Not every metric may have implemented this.
    */
@@ -213,11 +273,32 @@ protected:
 
   /** \todo the method GetExactDerivative could as well be added here. */
 
+  /** The total time per phase of the metric computation in this resolution. */
+  typedef itk::FixedArray< double,
+    AdvancedMetricType::NumberOfHotPathTimers >                 HotPathTimesType;
+
+  /** Get the name of a phase of the metric computation. */
+  static std::string GetHotPathTimeName( const unsigned int timer )
+  {
+    const char * names[] = { "Sampler", "Transform", "Threaded", "Accumulate" };
+    return names[ timer ];
+  }
+
+
+  /** Get the name of the iteration info column of a phase, e.g. ThreadedMetric0[ms]. */
+  std::string GetHotPathTimeColumn( const unsigned int timer ) const
+  {
+    return GetHotPathTimeName( timer ) + this->GetComponentLabel() + "[ms]";
+  }
+
+
   bool                             m_ShowExactMetricValue;
   ExactMetricImageSamplerPointer   m_ExactMetricSampler;
   MeasureType                      m_CurrentExactMetricValue;
   ExactMetricSampleGridSpacingType m_ExactMetricSampleGridSpacing;
   unsigned int                     m_ExactMetricEachXNumberOfIterations;
+  bool                             m_ShowHotPathTimes;
+  HotPathTimesType                 m_TotalHotPathTimes;
 
 private:
 
@@ -37,6 +37,8 @@ MetricBase< TElastix >
   this->m_CurrentExactMetricValue = 0.0;
   this->m_ExactMetricSampleGridSpacing.Fill( 1 );
   this->m_ExactMetricEachXNumberOfIterations = 1;
+  this->m_ShowHotPathTimes                   = false;
+  this->m_TotalHotPathTimes.Fill( 0.0 );
 
 } // end Constructor
 
@@ -106,9 +108,38 @@ MetricBase< TElastix >
   AdvancedMetricType * thisAsAdvanced
     = dynamic_cast< AdvancedMetricType * >( this );
 
+  /** Remove the hot path timing columns, if they already existed. */
+  for( unsigned int i = 0; i < HotPathTimesType::Dimension; ++i )
+  {
+    xl::xout[ "iteration" ].RemoveTargetCell( this->GetHotPathTimeColumn( i ).c_str() );
+  }
+
+  /** Read the parameter file: Show the time spent in the phases of the metric
+   * computation in every iteration? Only supported by advanced metrics.
+   */
+  bool showHotPathTimes = false;
+  this->GetConfiguration()->ReadParameter( showHotPathTimes,
+    "ShowMetricHotPathTimes", this->GetComponentLabel(), level, 0 );
+  this->m_ShowHotPathTimes = showHotPathTimes && thisAsAdvanced != 0;
+  this->m_TotalHotPathTimes.Fill( 0.0 );
+  if( this->m_ShowHotPathTimes )
+  {
+    /** Create new columns in the iteration info table. */
+    for( unsigned int i = 0; i < HotPathTimesType::Dimension; ++i )
+    {
+      const std::string column = this->GetHotPathTimeColumn( i );
+      xl::xout[ "iteration" ].AddTargetCell( column.c_str() );
+      xl::xout[ "iteration" ][ column.c_str() ]
+        << std::showpoint << std::fixed << std::setprecision( 1 );
+    }
+  }
+
   /** For advanced metrics several other things can be set. */
   if( thisAsAdvanced != 0 )
   {
+    /** Time the phases of the metric computation? */
+    thisAsAdvanced->SetUseHotPathTimers( this->m_ShowHotPathTimes );
+
     /** Should the metric check for enough samples? */
     bool checkNumberOfSamples = true;
     this->GetConfiguration()->ReadParameter( checkNumberOfSamples,
@@ -180,6 +211,32 @@ MetricBase< TElastix >
       }
     }
 
+    /** Should the metric use the persistent thread pool? */
+    bool useThreadPool = false;
+    this->GetConfiguration()->ReadParameter( useThreadPool,
+      "UseThreadPoolForMetrics", this->GetComponentLabel(), level, 0 );
+    thisAsAdvanced->SetUseThreadPool( useThreadPool );
+
+    /** Should the metric store the per-sample image Jacobians in single precision?
+     * The default follows the ELASTIX_USE_MIXED_PRECISION build option.
+     */
+    bool useMixedPrecision = thisAsAdvanced->GetUseMixedPrecision();
+    this->GetConfiguration()->ReadParameter( useMixedPrecision,
+      "UseMixedPrecision", this->GetComponentLabel(), level, 0 );
+    thisAsAdvanced->SetUseMixedPrecision( useMixedPrecision );
+
+    /** Should the threads accumulate the derivative atomically into one shared buffer? */
+    bool useAtomicDerivativeAccumulation = false;
+    this->GetConfiguration()->ReadParameter( useAtomicDerivativeAccumulation,
+      "UseAtomicDerivativeAccumulation", this->GetComponentLabel(), level, 0 );
+    thisAsAdvanced->SetUseAtomicDerivativeAccumulation( useAtomicDerivativeAccumulation );
+
+    /** Should the transform pre-compute its weights for the samples? */
+    bool useSampleWeightsCache = false;
+    this->GetConfiguration()->ReadParameter( useSampleWeightsCache,
+      "UseSampleWeightsCache", this->GetComponentLabel(), level, 0 );
+    thisAsAdvanced->SetUseSampleWeightsCache( useSampleWeightsCache );
+
   } // end advanced metric
 
 } // end BeforeEachResolutionBase()
@@ -212,9 +269,66 @@ MetricBase< TElastix >
       << this->m_CurrentExactMetricValue;
   }
 
+  /** Show the time spent in the phases of the metric computation in this
+   * iteration. The timers are reset afterwards, such that the time of the
+   * exact metric value computation above is not included.
+   */
+  if( this->m_ShowHotPathTimes )
+  {
+    const AdvancedMetricType * thisAsAdvanced
+      = dynamic_cast< const AdvancedMetricType * >( this );
+    for( unsigned int i = 0; i < HotPathTimesType::Dimension; ++i )
+    {
+      const double time = thisAsAdvanced->GetHotPathTime(
+        static_cast< typename AdvancedMetricType::HotPathTimerType >( i ) );
+      this->m_TotalHotPathTimes[ i ] += time;
+      xl::xout[ "iteration" ][ this->GetHotPathTimeColumn( i ).c_str() ]
+        << time * 1000.0;
+    }
+    thisAsAdvanced->ResetHotPathTimes();
+  }
+
 } // end AfterEachIterationBase()
 
 
+/**
+ * ******************* AfterEachResolutionBase ******************
+ */
+
+template< class TElastix >
+void
+MetricBase< TElastix >
+::AfterEachResolutionBase( void )
+{
+  /** Print the total time spent in the phases of the metric computation. */
+  if( this->m_ShowHotPathTimes )
+  {
+    elxout << "Time spent in the phases of " << this->GetComponentLabel()
+           << " in this resolution:\n" << std::setprecision( 3 );
+    for( unsigned int i = 0; i < HotPathTimesType::Dimension; ++i )
+    {
+      elxout << "  " << this->GetHotPathTimeName( i ) << ": "
+             << this->m_TotalHotPathTimes[ i ] << " s\n";
+    }
+    elxout << std::setprecision( this->GetElastix()->GetDefaultOutputPrecision() );
+  }
+
+  /** Report the memory saved by the atomic derivative accumulation mode. */
+  const AdvancedMetricType * thisAsAdvanced
+    = dynamic_cast< const AdvancedMetricType * >( this );
+  if( thisAsAdvanced != 0 && thisAsAdvanced->GetUseAtomicDerivativeAccumulation() )
+  {
+    const double megabyte  = 1024.0 * 1024.0;
+    const double denseSize = static_cast< double >( thisAsAdvanced->GetNumberOfWorkUnits() )
+      * thisAsAdvanced->GetNumberOfParameters() * sizeof( double );
+    elxout << "Memory of the derivative accumulation buffers of " << this->GetComponentLabel()
+           << ": " << thisAsAdvanced->GetDerivativeAccumulationMemorySize() / megabyte
+           << " MB, instead of " << denseSize / megabyte << " MB with a derivative per thread.\n";
+  }
+
+} // end AfterEachResolutionBase()
+
+
 /**
  * ********************* SelectNewSamples ************************
  */
@@ -24,6 +24,9 @@
 
 #include "elxBaseComponentSE.h"
 #include "itkOptimizer.h"
+#include "itkSingleValuedCostFunction.h"
+
+#include <vector>
 
 namespace elastix
 {
@@ -44,6 +47,15 @@ namespace elastix
  *    Choose one from {"true", "false"} for every resolution.\n
  *    example: <tt>(NewSamplesEveryIteration "true" "true" "true")</tt> \n
  *    Default is "false" for every resolution.\n
+ * \parameter NumberOfCostFunctionClones: the optimizers that evaluate several
+ *    positions per iteration (FullSearch, CMAEvolutionStrategy,
+ *    FiniteDifferenceGradientDescent and SimultaneousPerturbation) can evaluate
+ *    them in parallel, on this number of copies of the metric, see
+ *    CreateCostFunctionClones(). The copies give exactly the same values as the
+ *    metric itself, so the result does not depend on this setting. The metric
+ *    should use a fixed set of samples, i.e. NewSamplesEveryIteration "false".\n
+ *    example: <tt>(NumberOfCostFunctionClones 8 8 8)</tt> \n
+ *    Default is 0 for every resolution, which means no copies.\n
  *
  * \ingroup Optimizers
  * \ingroup ComponentBaseClasses
@@ -123,6 +135,22 @@ protected:
   /** Check whether the user asked to select new samples every iteration. */
   virtual bool GetNewSamplesEveryIteration( void ) const;
 
+  /** Type of a container of copies of the cost function. */
+  typedef std::vector< itk::SingleValuedCostFunction::Pointer > CostFunctionClonesType;
+
+  /** Create the number of copies of the metric given by NumberOfCostFunctionClones,
+   * for the optimizers that accept cost function clones. Call it in
+   * StartOptimization(), when the metric is initialized for the current resolution.
+   * Copies are only made of a single metric that supports them, see
+   * itk::AdvancedImageToImageMetric::CreateClone(), and that uses a fixed set of
+   * samples. The copies are single-threaded, because they run in parallel.
+   * Each copy is checked to give the same value as the cost function of the
+   * optimizer at its initial position, up to a relative difference of 1e-8,
+   * which allows for another summation order. Returns an empty
+   * container, and prints a warning, when no copies can be made.
+   */
+  virtual CostFunctionClonesType CreateCostFunctionClones( void );
+
 private:
 
   /** The private constructor. */
@@ -22,6 +22,7 @@
 
 #include "itkSingleValuedNonLinearOptimizer.h"
 #include "itk_zlib.h"
+#include <cmath>
 
 namespace elastix
 {
@@ -151,6 +152,97 @@ OptimizerBase< TElastix >
 } // end GetNewSamplesEveryIteration()
 
 
+/**
+ * ****************** CreateCostFunctionClones ********************
+ */
+
+template< class TElastix >
+typename OptimizerBase< TElastix >::CostFunctionClonesType
+OptimizerBase< TElastix >
+::CreateCostFunctionClones( void )
+{
+  typedef typename ElastixType::MetricBaseType::AdvancedMetricType AdvancedMetricType;
+  typedef typename AdvancedMetricType::AdvancedMetricPointer      AdvancedMetricPointer;
+  typedef itk::SingleValuedNonLinearOptimizer                      SingleValuedOptimizerType;
+  typedef typename SingleValuedOptimizerType::MeasureType          MeasureType;
+
+  CostFunctionClonesType clones;
+
+  /** Get the current resolution level. */
+  unsigned int level
+    = this->GetRegistration()->GetAsITKBaseType()->GetCurrentLevel();
+
+  /** Read the number of clones. */
+  unsigned int numberOfClones = 0;
+  this->GetConfiguration()->ReadParameter( numberOfClones,
+    "NumberOfCostFunctionClones", this->GetComponentLabel(), level, 0 );
+  if( numberOfClones == 0 )
+  {
+    return clones;
+  }
+
+  /** Only a single metric, with a fixed set of samples, can be copied. */
+  const SingleValuedOptimizerType * optimizer
+    = dynamic_cast< const SingleValuedOptimizerType * >( this->GetAsITKBaseType() );
+  const AdvancedMetricType * metric = nullptr;
+  if( this->GetElastix()->GetNumberOfMetrics() == 1 )
+  {
+    metric = dynamic_cast< const AdvancedMetricType * >(
+      this->GetElastix()->GetElxMetricBase()->GetAsITKBaseType() );
+  }
+  if( optimizer == nullptr || optimizer->GetCostFunction() == nullptr
+    || metric == nullptr || this->GetNewSamplesEveryIteration() )
+  {
+    xl::xout[ "warning" ] << "WARNING: NumberOfCostFunctionClones is ignored. "
+                          << "It requires a single metric with a fixed set of samples." << std::endl;
+    return clones;
+  }
+
+  /** Create the clones, and check that they give the same value as the cost
+   * function of the optimizer. The clones are single-threaded, so when the
+   * metric is multi-threaded, the samples are added in a different order, and
+   * the values may differ in the last bits.
+   */
+  const ParametersType & position  = optimizer->GetInitialPosition();
+  const double           tolerance = 1.0e-8;
+  try
+  {
+    const MeasureType value = optimizer->GetCostFunction()->GetValue( position );
+    for( unsigned int c = 0; c < numberOfClones; ++c )
+    {
+      AdvancedMetricPointer clone = metric->CreateClone();
+      if( clone.IsNull()
+        || !( std::abs( clone->GetValue( position ) - value ) <= tolerance * std::abs( value ) ) )
+      {
+        clones.clear();
+        break;
+      }
+      clones.push_back( clone.GetPointer() );
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    xl::xout[ "warning" ] << "WARNING: NumberOfCostFunctionClones is ignored. "
+                          << "Evaluating the clones failed:\n" << excp.GetDescription() << std::endl;
+    return CostFunctionClonesType();
+  }
+
+  if( clones.empty() )
+  {
+    xl::xout[ "warning" ] << "WARNING: NumberOfCostFunctionClones is ignored. "
+                          << "The clones do not reproduce the value of the cost function, "
+                          << "e.g. because of a metric weight other than 1." << std::endl;
+  }
+  else
+  {
+    elxout << "  The cost function is evaluated on " << clones.size() << " clones." << std::endl;
+  }
+
+  return clones;
+
+} // end CreateCostFunctionClones()
+
+
 /**
  * ****************** SetSinusScales ********************
  */
@@ -66,6 +66,16 @@ namespace elastix
  *    from one resolution level to another. Choose from {"true", "false"} \n
  *    example: <tt>(ErodeMovingMask2 "true" "false")</tt>
  *    This setting overrules ErodeMask and ErodeMovingMask.\n
+ * \parameter CacheFixedImageData: a flag to determine if the data that is computed from
+ *    the fixed image(s) and mask(s) is reused by a next registration of the same fixed
+ *    image(s) and mask(s). Choose from {"true", "false"} \n
+ *    example: <tt>(CacheFixedImageData "false")</tt> \n
+ *    The default is "true". Reused are the eroded fixed masks, the fixed pyramid
+ *    images, and the samples of the Full and Grid image samplers, when they are
+ *    computed with the same settings. The data is kept by the caller of elastix: the
+ *    batch mode of the ElastixFilter, or the -jobs mode of the elastix executable.
+ *    Elsewhere nothing is kept, and the parameter has no effect. See also
+ *    FixedImageDataCache.\n
  *
  * \ingroup Registrations
  * \ingroup ComponentBaseClasses
@@ -212,6 +222,21 @@ protected:
 
 private:
 
+  /** The cache of data computed from the fixed images, owned by the caller of elastix. */
+  typedef typename ElastixType::FixedImageDataCacheType FixedImageDataCacheType;
+
+  /** Get the eroded fixed mask from the cache, or erode and cache it,
+   * see the parameter CacheFixedImageData.
+   */
+  FixedMaskImagePointer GetCachedErodedFixedMask( FixedImageDataCacheType * cache,
+    const FixedMaskImageType * maskImage,
+    const FixedImagePyramidType * pyramid, unsigned int level ) const;
+
+  /** Erode the fixed mask for the given resolution level. */
+  FixedMaskImagePointer ErodeFixedMask(
+    const FixedMaskImageType * maskImage,
+    const FixedImagePyramidType * pyramid, unsigned int level ) const;
+
   /** The private constructor. */
   RegistrationBase( const Self & );   // purposely not implemented
   /** The private copy constructor. */
@@ -20,6 +20,8 @@
 
 #include "elxRegistrationBase.h"
 
+#include <sstream>
+
 namespace elastix
 {
 
@@ -119,7 +121,31 @@ RegistrationBase< TElastix >
     return fixedMaskSpatialObject;
   }
 
-  /** Erode, and convert to spatial object. */
+  /** Erode (or reuse the eroded mask), and convert to spatial object. */
+  FixedImageDataCacheType * cache = this->GetFixedImageDataCache();
+  FixedMaskImagePointer erodedFixedMaskAsImage = cache
+    ? this->GetCachedErodedFixedMask( cache, maskImage, pyramid, level )
+    : this->ErodeFixedMask( maskImage, pyramid, level );
+
+  fixedMaskSpatialObject->SetImage( erodedFixedMaskAsImage );
+  fixedMaskSpatialObject->Update();
+  return fixedMaskSpatialObject;
+
+} // end GenerateFixedMaskSpatialObject()
+
+
+/**
+ * ******************* ErodeFixedMask **********************
+ */
+
+template< class TElastix >
+typename RegistrationBase< TElastix >::FixedMaskImagePointer
+RegistrationBase< TElastix >
+::ErodeFixedMask(
+  const FixedMaskImageType * maskImage,
+  const FixedImagePyramidType * pyramid, unsigned int level ) const
+{
+  /** Erode the mask. */
   FixedMaskErodeFilterPointer erosion = FixedMaskErodeFilterType::New();
   erosion->SetInput( maskImage );
   erosion->SetSchedule( pyramid->GetSchedule() );
@@ -147,12 +173,41 @@ RegistrationBase< TElastix >
 
   /** Release some memory. */
   erodedFixedMaskAsImage->DisconnectPipeline();
+  return erodedFixedMaskAsImage;
 
-  fixedMaskSpatialObject->SetImage( erodedFixedMaskAsImage );
-  fixedMaskSpatialObject->Update();
-  return fixedMaskSpatialObject;
+} // end ErodeFixedMask()
 
-} // end GenerateFixedMaskSpatialObject()
+
+/**
+ * ******************* GetCachedErodedFixedMask **********************
+ */
+
+template< class TElastix >
+typename RegistrationBase< TElastix >::FixedMaskImagePointer
+RegistrationBase< TElastix >
+::GetCachedErodedFixedMask( FixedImageDataCacheType * cache,
+  const FixedMaskImageType * maskImage,
+  const FixedImagePyramidType * pyramid, unsigned int level ) const
+{
+  /** The eroded mask depends on the mask, the pyramid schedule and the level. */
+  const typename FixedImageDataCacheType::SourceVectorType sources( 1, maskImage );
+  std::ostringstream key;
+  key << "ErodedFixedMask level " << level << " schedule " << pyramid->GetSchedule();
+
+  FixedMaskImagePointer erodedMask = dynamic_cast< FixedMaskImageType * >(
+    cache->GetData( sources, key.str() ) );
+  if( erodedMask.IsNull() )
+  {
+    erodedMask = this->ErodeFixedMask( maskImage, pyramid, level );
+    cache->AddData( sources, key.str(), erodedMask );
+  }
+  else
+  {
+    elxout << "  Reusing the eroded fixed mask of a previous registration." << std::endl;
+  }
+  return erodedMask;
+
+} // end GetCachedErodedFixedMask()
 
 
 /**
@@ -64,6 +64,18 @@ namespace elastix
  *    of the written image is desired.\n
  *    example: <tt>(CompressResultImage "true")</tt> \n
  *    The default is "false".
+ * \parameter StreamingMemoryBudget: the maximum amount of memory in megabytes that
+ *    is used for the result image. When the result image is larger, it is resampled
+ *    and written in slabs, each of which is resampled multi-threaded. The same budget
+ *    applies to the deformation field that transformix computes with "-def all".
+ *    The budget limits the output memory only: the moving image, and the B-spline
+ *    coefficients of a B-spline resample interpolator (double, or float for the
+ *    FinalBSplineInterpolatorFloat), stay in memory as a whole. Their size is
+ *    subtracted from the budget, and a warning is printed when they do not fit in it.
+ *    Streamed writing requires a file format that supports it, such as mhd or nrrd,
+ *    without compression; otherwise the image is still written as a whole.\n
+ *    example: <tt>(StreamingMemoryBudget 4096)</tt> \n
+ *    The default is 0, which means that the result image is not streamed.
  *
  * \ingroup Resamplers
  * \ingroup ComponentBaseClasses
@@ -191,6 +203,11 @@ protected:
   /** Method that sets the transform, the interpolator and the inputImage. */
   virtual void SetComponents( void );
 
+  /** Get the number of pieces in which the result image is resampled and
+   * written, to stay within the StreamingMemoryBudget.
+   */
+  virtual unsigned int GetNumberOfResultImageStreamDivisions( void ) const;
+
   /** Variable that defines to print the progress or not. */
   bool m_ShowProgress;
 
@@ -23,6 +23,8 @@
 #include "itkImageFileCastWriter.h"
 #include "itkChangeInformationImageFilter.h"
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkReducedDimensionBSplineInterpolateImageFunction.h"
 #include "itkTimeProbe.h"
 
 namespace elastix
@@ -337,21 +339,33 @@ ResamplerBase< TElastix >
   }
 #endif
 
-  /** Do the resampling. */
-  try
+  /** Do the resampling. When streaming, the writer resamples the
+   * image piece by piece instead.
+   */
+  const unsigned int numberOfStreamDivisions
+    = this->GetNumberOfResultImageStreamDivisions();
+  if( numberOfStreamDivisions > 1 )
   {
-    this->GetAsITKBaseType()->Update();
+    elxout << "  The result image is resampled and written in "
+           << numberOfStreamDivisions << " pieces." << std::endl;
   }
-  catch( itk::ExceptionObject & excp )
+  else
   {
-    /** Add information to the exception. */
-    excp.SetLocation( "ResamplerBase - WriteResultImage()" );
-    std::string err_str = excp.GetDescription();
-    err_str += "\nError occurred while resampling the image.\n";
-    excp.SetDescription( err_str );
-
-    /** Pass the exception to an higher level. */
-    throw excp;
+    try
+    {
+      this->GetAsITKBaseType()->Update();
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      /** Add information to the exception. */
+      excp.SetLocation( "ResamplerBase - WriteResultImage()" );
+      std::string err_str = excp.GetDescription();
+      err_str += "\nError occurred while resampling the image.\n";
+      excp.SetDescription( err_str );
+
+      /** Pass the exception to an higher level. */
+      throw excp;
+    }
   }
 
   /** Perform the writing. */
@@ -432,6 +446,7 @@ ResamplerBase< TElastix >
   writer->SetFileName( filename );
   writer->SetOutputComponentType( resultImagePixelType.c_str() );
   writer->SetUseCompression( doCompression );
+  writer->SetNumberOfStreamDivisions( this->GetNumberOfResultImageStreamDivisions() );
 
   /** Do the writing. */
   if( showProgress )
@@ -457,6 +472,63 @@ ResamplerBase< TElastix >
 } // end WriteResultImage()
 
 
+/**
+ * ************* GetNumberOfResultImageStreamDivisions ***************
+ */
+
+template< class TElastix >
+unsigned int
+ResamplerBase< TElastix >
+::GetNumberOfResultImageStreamDivisions( void ) const
+{
+  /** The memory of a piece consists of the resampled pixels, and of
+   * their copy that is casted to the ResultImagePixelType (at most a double).
+   */
+  const SizeType size   = this->GetAsITKBaseType()->GetSize();
+  double numberOfPixels = 1.0;
+  for( unsigned int i = 0; i < ImageDimension; ++i )
+  {
+    numberOfPixels *= static_cast< double >( size[ i ] );
+  }
+
+  /** The moving image is not streamed, and neither are the B-spline
+   * coefficients of a B-spline resample interpolator, which are computed
+   * for the whole moving image, in double or in float.
+   */
+  typedef itk::BSplineInterpolateImageFunction<
+    InputImageType, CoordRepType, double >              BSplineInterpolatorType;
+  typedef itk::BSplineInterpolateImageFunction<
+    InputImageType, CoordRepType, float >               BSplineInterpolatorFloatType;
+  typedef itk::ReducedDimensionBSplineInterpolateImageFunction<
+    InputImageType, CoordRepType, double >              ReducedDimensionBSplineInterpolatorType;
+
+  double numberOfResidentBytes = 0.0;
+  const InputImageType * movingImage = this->GetAsITKBaseType()->GetInput();
+  if( movingImage != 0 )
+  {
+    const double numberOfMovingPixels
+      = static_cast< double >( movingImage->GetLargestPossibleRegion().GetNumberOfPixels() );
+    double bytesPerMovingPixel = sizeof( typename InputImageType::PixelType );
+
+    const InterpolatorType * interpolator = this->GetAsITKBaseType()->GetInterpolator();
+    if( dynamic_cast< const BSplineInterpolatorFloatType * >( interpolator ) != 0 )
+    {
+      bytesPerMovingPixel += sizeof( float );
+    }
+    else if( dynamic_cast< const BSplineInterpolatorType * >( interpolator ) != 0
+      || dynamic_cast< const ReducedDimensionBSplineInterpolatorType * >( interpolator ) != 0 )
+    {
+      bytesPerMovingPixel += sizeof( double );
+    }
+    numberOfResidentBytes = numberOfMovingPixels * bytesPerMovingPixel;
+  }
+
+  return this->GetNumberOfStreamDivisions(
+    numberOfPixels * ( sizeof( OutputPixelType ) + sizeof( double ) ), numberOfResidentBytes );
+
+} // end GetNumberOfResultImageStreamDivisions()
+
+
 /*
  * ******************* CreateItkResultImage ********************
  * \todo: avoid code duplication with WriteResultImage function
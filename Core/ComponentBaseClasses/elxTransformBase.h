@@ -24,11 +24,14 @@
 #include "elxBaseComponentSE.h"
 #include "itkAdvancedTransform.h"
 #include "itkAdvancedCombinationTransform.h"
+#include "itkTransformToDisplacementFieldFilter.h"
+#include "itkChangeInformationImageFilter.h"
 #include "elxComponentDatabase.h"
 #include "elxProgressCommand.h"
 
 #include <fstream>
 #include <iomanip>
+#include <vector>
 
 namespace elastix
 {
@@ -51,6 +54,18 @@ namespace elastix
  *   "Compose" by composition: \f$T(x) = T_1 ( T_0(x) )\f$.\n
  *   example: <tt>(HowToCombineTransforms "Add")</tt>\n
  *   Default: "Add".
+ * \parameter UseBinaryFormatForTransformationParameters: Controls whether the transform
+ *   parameters are written to a separate binary file, next to the transform parameter file.
+ *   Reading and writing a binary file is much faster than parsing a long text line,
+ *   and the values are stored exactly.\n
+ *   example: <tt>(UseBinaryFormatForTransformationParameters "true")</tt>\n
+ *   Default: "false".
+ * \parameter BinaryTransformParametersValueType: The value type of the binary file with the
+ *   transform parameters, "double" or "float". Only used when
+ *   UseBinaryFormatForTransformationParameters is "true". "float" halves the file size,
+ *   at the cost of precision.\n
+ *   example: <tt>(BinaryTransformParametersValueType "float")</tt>\n
+ *   Default: "double".
  *
  * \transformparameter UseDirectionCosines: Controls whether to use or ignore the
  * direction cosines (world matrix, transform matrix) set in the images.
@@ -97,6 +112,17 @@ namespace elastix
  * The number of entries is stored the NumberOfParameters entry.
  * \transformparameter NumberOfParameters: the length of the transform parameter vector.\n
  * example <tt>(NumberOfParameters 722)</tt>\n
+ * \transformparameter UseBinaryFormatForTransformationParameters: When "true", the
+ * TransformParameters entry contains the name of a binary file with the parameters. The file
+ * has a header of 24 bytes: the characters "ELXTPBIN", the format version (uint32), the number
+ * of bytes per value (uint32, 4 or 8) and the number of values (uint64). The values follow
+ * directly. All numbers are little endian, see itk::TransformParametersBinaryFile. Files
+ * without this header, as written by earlier versions, are read as raw values. A relative
+ * file name that does not exist relative to the working directory is searched relative to
+ * the directory of the transform parameter file.\n
+ * example <tt>(UseBinaryFormatForTransformationParameters "true")</tt>\n
+ * example <tt>(TransformParameters "TransformParameters.0.txt.dat")</tt>\n
+ * Default: "false".
  * \transformparameter InitialTransformParametersFileName: The location/name of an initial
  * transform that will be loaded when loading the current transform parameter file. Note
  * that transform parameter file can also contain an initial transform. Recursively all
@@ -105,6 +131,17 @@ namespace elastix
  * The location is relative to the path from where elastix/transformix is started!\n
  * Default: "NoInitialTransform", which (obviously) means that there is no initial transform
  * to be loaded.
+ * \transformparameter ComputeOutputsInSinglePass: Controls whether transformix computes the
+ * deformation field (<tt>-def all</tt>), the spatial Jacobian determinant (<tt>-jac all</tt>),
+ * the spatial Jacobian (<tt>-jacmat all</tt>) and the result image in a single pass over the
+ * output grid, evaluating the transform only once per voxel, see
+ * itk::TransformToMultipleOutputsSource. All requested outputs are then computed at once
+ * and kept in memory at the same time, so the StreamingMemoryBudget does not limit their
+ * memory; it only splits the writing of the computed images. The result image is only included
+ * when the DefaultResampler is used with a resample interpolator other than the
+ * RayCastResampleInterpolator; otherwise it is resampled separately, as usual.\n
+ * example: <tt>(ComputeOutputsInSinglePass "true")</tt>\n
+ * Default: "false".
  *
  * The command line arguments used by this class are:
  * \commandlinearg -t0: optional argument for elastix for specifying an initial transform
@@ -117,6 +154,13 @@ namespace elastix
  *    "point", depending if the user supplies voxel indices or real world coordinates.
  *    The second line should be the number of points that should be transformed. The
  *    third and following lines give the indices or points.\n
+ *    Large point sets can be given as a binary point file instead, see
+ *    itk::TransformixInputPointFileReader. The results are then written to the binary
+ *    file outputpoints.bin, instead of to outputpoints.txt: the characters "ELXOUTPT",
+ *    the dimension (uint32), whether the output indices in the moving image are included
+ *    (uint32, 0 or 1) and the number of points (uint64), followed for every point by the
+ *    InputIndex, InputPoint, OutputIndexFixed, OutputPoint, Deformation and, if included,
+ *    OutputIndexMoving as doubles. All numbers are little endian.\n
  *    It is also possible to deform all points, thereby generating a deformation field
  *    image. This is done by:\n
  *    example: <tt>-def all</tt> \n
@@ -190,11 +234,19 @@ public:
   typedef typename ITKBaseType::InputPointType  InputPointType;
   typedef typename ITKBaseType::OutputPointType OutputPointType;
 
+  /** Typedef's for the image indices of the transformed points. */
+  typedef typename FixedImageType::IndexType  FixedImageIndexType;
+  typedef typename MovingImageType::IndexType MovingImageIndexType;
+
   /** Typedef's for TransformPointsAllPoints. */
   typedef itk::Vector<
     float, FixedImageDimension >                      VectorPixelType;
   typedef itk::Image<
     VectorPixelType, FixedImageDimension >            DeformationFieldImageType;
+  typedef itk::TransformToDisplacementFieldFilter<
+    DeformationFieldImageType, CoordRepType >         DeformationFieldGeneratorType;
+  typedef itk::ChangeInformationImageFilter<
+    DeformationFieldImageType >                       DeformationFieldChangeInfoFilterType;
 
   /** Typedefs needed for AutomaticScalesEstimation function */
   typedef typename RegistrationType::ITKBaseType      ITKRegistrationType;
@@ -296,6 +348,17 @@ public:
   /** Function to transform coordinates from fixed to moving image, given as VTK file. */
   virtual void TransformPointsSomePointsVTK( const std::string filename ) const;
 
+  /** Function to write the results of TransformPointsSomePoints() to the
+   * binary file outputpoints.bin. Pass an empty outputIndicesMoving when no
+   * moving image is available.
+   */
+  virtual void WriteBinaryOutputPoints(
+    const std::vector< FixedImageIndexType > & inputIndices,
+    const std::vector< InputPointType > & inputPoints,
+    const std::vector< FixedImageIndexType > & outputIndicesFixed,
+    const std::vector< OutputPointType > & outputPoints,
+    const std::vector< MovingImageIndexType > & outputIndicesMoving ) const;
+
   /** Deprecation note: The plan is to split all Compute* and TransformPoints* functions
    *  into Generate* and Write* functions, since that would facilitate a proper library
    *  interface. To keep everything functional during the transition period we need to
@@ -306,7 +369,11 @@ public:
   /** Function to transform all coordinates from fixed to moving image. */
   typename DeformationFieldImageType::Pointer GenerateDeformationFieldImage( void ) const;
 
-  void WriteDeformationFieldImage( typename DeformationFieldImageType::Pointer ) const;
+  /** Write the deformation field. If the deformation field is the output of a
+   * pipeline that was not updated yet, it can be written in pieces.
+   */
+  void WriteDeformationFieldImage( typename DeformationFieldImageType::Pointer,
+    const unsigned int numberOfStreamDivisions = 1 ) const;
 
   /** Legacy function that calls GenerateDeformationFieldImage and WriteDeformationFieldImage. */
   virtual void TransformPointsAllPoints(void) const;
@@ -317,6 +384,25 @@ public:
   /** Function to compute the determinant of the spatial Jacobian. */
   virtual void ComputeSpatialJacobian( void ) const;
 
+  /** Function to compute the deformation field, the (determinant of the)
+   * spatial Jacobian and the result image, as requested, in a single pass.
+   * Returns true if the result image has been written.
+   */
+  virtual bool ComputeOutputsInSinglePass( void ) const;
+
+  /** Write the transform parameters to a binary file, see the
+   * UseBinaryFormatForTransformationParameters transform parameter.
+   */
+  void WriteBinaryTransformParameters( const std::string & fileName,
+    const ParametersType & param ) const;
+
+  /** Read the transform parameters from a binary file into param, which
+   * should already have the expected size. Returns the number of parameters
+   * in the file.
+   */
+  std::size_t ReadBinaryTransformParameters( const std::string & fileName,
+    ParametersType & param ) const;
+
   /** Makes sure that the final parameters from the registration components
    * are copied, set, and stored.
    */
@@ -329,6 +415,22 @@ protected:
   /** The destructor. */
   ~TransformBase() override;
 
+  /** Create the filter that generates the deformation field, followed by the
+   * filter that restores the original direction cosines, without updating them.
+   */
+  void CreateDeformationFieldPipeline(
+    typename DeformationFieldGeneratorType::Pointer & defGenerator,
+    typename DeformationFieldChangeInfoFilterType::Pointer & infoChanger ) const;
+
+  /** Restore the original direction cosines of an image that is defined on
+   * the output grid of the resampler, and write it to the file
+   * <tt>baseName.ResultImageFormat</tt> in the output directory. Used by
+   * ComputeOutputsInSinglePass().
+   */
+  template< class TImage >
+  void WriteOutputGridImage( TImage * image, const std::string & baseName,
+    const std::string & description, const bool changePixelType ) const;
+
   /** Estimate a scales vector
    * AutomaticScalesEstimation works like this:
    * \li N=10000 points are sampled on a uniform grid on the fixed image.
@@ -376,6 +478,9 @@ private:
   /** Boolean to decide whether or not the transform parameters are written in binary format. */
   bool m_UseBinaryFormatForTransformationParameters;
 
+  /** Boolean to decide whether or not the binary transform parameters are written as float. */
+  bool m_UseFloatForBinaryTransformParameters;
+
 };
 
 } // end namespace elastix
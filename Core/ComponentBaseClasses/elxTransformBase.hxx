@@ -29,6 +29,8 @@
 #include "itkTransformToDisplacementFieldFilter.h"
 #include "itkTransformToDeterminantOfSpatialJacobianSource.h"
 #include "itkTransformToSpatialJacobianSource.h"
+#include "itkTransformToMultipleOutputsSource.h"
+#include "itkAdvancedRayCastInterpolateImageFunction.h"
 #include "itkImageFileWriter.h"
 #include "itkImageGridSampler.h"
 #include "itkContinuousIndex.h"
@@ -37,6 +39,12 @@
 #include "itkMeshFileReader.h"
 #include "itkMeshFileWriter.h"
 #include "itkTransformMeshFilter.h"
+#include "itkMultiThreaderBase.h"
+#include "itkByteSwapper.h"
+#include "itkTransformParametersBinaryFile.h"
+
+#include <algorithm>
+#include <sstream>
 
 namespace itk
 {
@@ -113,6 +121,7 @@ TransformBase< TElastix >
   this->m_TransformParametersPointer   = 0;
   this->m_ReadWriteTransformParameters = true;
   this->m_UseBinaryFormatForTransformationParameters = false;
+  this->m_UseFloatForBinaryTransformParameters      = false;
 
 } // end Constructor()
 
@@ -165,6 +174,18 @@ TransformBase< TElastix >
     this->m_UseBinaryFormatForTransformationParameters,
     "UseBinaryFormatForTransformationParameters", 0, false );
 
+  /** Check the value type of the binary transform parameter file. */
+  std::string binaryValueType = "double";
+  this->m_Configuration->ReadParameter( binaryValueType,
+    "BinaryTransformParametersValueType", 0, false );
+  if( binaryValueType != "double" && binaryValueType != "float" )
+  {
+    xl::xout[ "error" ] << "ERROR: BinaryTransformParametersValueType should be "
+                        << "\"double\" or \"float\", not \"" << binaryValueType << "\"." << std::endl;
+    return 1;
+  }
+  this->m_UseFloatForBinaryTransformParameters = ( binaryValueType == "float" );
+
   /** Return a value. */
   return 0;
 
@@ -425,10 +446,8 @@ TransformBase< TElastix >
     {
       std::string dataFileName = "";
       this->m_Configuration->ReadParameter( dataFileName, "TransformParameters", 0 );
-      std::ifstream infile( dataFileName.c_str(), std::ios::in | std::ios::binary );
-      infile.read( reinterpret_cast<char *>( this->m_TransformParametersPointer->data_block() ), sizeof( ValueType ) * numberOfParameters );
-      numberOfParametersFound = infile.gcount() / sizeof( ValueType ); // for sanity check
-      infile.close();
+      numberOfParametersFound = this->ReadBinaryTransformParameters(
+        dataFileName, *( this->m_TransformParametersPointer ) );
     }
     else
     {
@@ -657,6 +676,50 @@ TransformBase< TElastix >
 } // end ReadInitialTransformFromFile()
 
 
+/**
+ * ************** WriteBinaryTransformParameters ****************
+ */
+
+template< class TElastix >
+void
+TransformBase< TElastix >
+::WriteBinaryTransformParameters( const std::string & fileName,
+  const ParametersType & param ) const
+{
+  itk::TransformParametersBinaryFile::Write( fileName, param,
+    this->m_UseFloatForBinaryTransformParameters );
+
+} // end WriteBinaryTransformParameters()
+
+
+/**
+ * ************** ReadBinaryTransformParameters *****************
+ */
+
+template< class TElastix >
+std::size_t
+TransformBase< TElastix >
+::ReadBinaryTransformParameters( const std::string & fileName,
+  ParametersType & param ) const
+{
+  /** A relative file name is also searched next to the transform parameter file. */
+  std::string dataFileName = fileName;
+  if( !itksys::SystemTools::FileExists( dataFileName.c_str() )
+    && !itksys::SystemTools::FileIsFullPath( dataFileName.c_str() ) )
+  {
+    const std::string parameterFileDirectory = itksys::SystemTools::GetFilenamePath(
+      this->m_Configuration->GetParameterFileName() );
+    if( !parameterFileDirectory.empty() )
+    {
+      dataFileName = parameterFileDirectory + "/" + dataFileName;
+    }
+  }
+
+  return itk::TransformParametersBinaryFile::Read( dataFileName, param );
+
+} // end ReadBinaryTransformParameters()
+
+
 /**
  * ******************* WriteToFile ******************************
  */
@@ -704,9 +767,7 @@ TransformBase< TElastix >
       dataFileName += ".dat";
       xout[ "transpar" ] << "(TransformParameters \"" << dataFileName << "\")" << std::endl;
 
-      std::ofstream outfile( dataFileName.c_str(), ios::out | ios::binary );
-      outfile.write( reinterpret_cast<const char *>( param.data_block() ), sizeof( ValueType ) * nrP );
-      outfile.close();
+      this->WriteBinaryTransformParameters( dataFileName, param );
     }
     else
     {
@@ -1144,9 +1205,7 @@ TransformBase< TElastix >
   typedef typename FixedImageType::RegionType           FixedImageRegionType;
   typedef typename FixedImageType::PointType            FixedImageOriginType;
   typedef typename FixedImageType::SpacingType          FixedImageSpacingType;
-  typedef typename FixedImageType::IndexType            FixedImageIndexType;
   typedef typename FixedImageIndexType::IndexValueType  FixedImageIndexValueType;
-  typedef typename MovingImageType::IndexType           MovingImageIndexType;
   typedef typename MovingImageIndexType::IndexValueType MovingImageIndexValueType;
   typedef
     itk::ContinuousIndex< double, FixedImageDimension >   FixedImageContinuousIndexType;
@@ -1189,7 +1248,7 @@ TransformBase< TElastix >
   {
     elxout << "  Input points are specified in world coordinates." << std::endl;
   }
-  unsigned int nrofpoints = ippReader->GetNumberOfPoints();
+  const unsigned long nrofpoints = ippReader->GetNumberOfPoints();
   elxout << "  Number of specified input points: " << nrofpoints << std::endl;
 
   /** Get the set of input points. */
@@ -1225,10 +1284,6 @@ TransformBase< TElastix >
   dummyImage->SetSpacing( spacing );
   dummyImage->SetDirection( direction );
 
-  /** Temp vars */
-  FixedImageContinuousIndexType  fixedcindex;
-  MovingImageContinuousIndexType movingcindex;
-
   /** Also output moving image indices if a moving image was supplied. */
   bool alsoMovingIndices = false;
   typename MovingImageType::Pointer movingImage = this->GetElastix()->GetMovingImage();
@@ -1237,74 +1292,100 @@ TransformBase< TElastix >
     alsoMovingIndices = true;
   }
 
+  /** The points are processed in chunks, which are distributed over the threads. */
+  const unsigned long chunkSize      = 4096;
+  const unsigned long numberOfChunks = ( nrofpoints + chunkSize - 1 ) / chunkSize;
+  itk::MultiThreaderBase::Pointer threader = itk::MultiThreaderBase::New();
+
   /** Read the input points, as index or as point. */
-  if( !( ippReader->GetPointsAreIndices() ) )
+  const bool pointsAreIndices = ippReader->GetPointsAreIndices();
+  threader->ParallelizeArray( 0, numberOfChunks, [ & ]( const itk::SizeValueType chunk )
   {
-    for( unsigned int j = 0; j < nrofpoints; j++ )
+    FixedImageContinuousIndexType fixedcindex;
+    const unsigned long           last = std::min< unsigned long >( ( chunk + 1 ) * chunkSize, nrofpoints );
+    for( unsigned long j = chunk * chunkSize; j < last; j++ )
     {
-      /** Compute index of nearest voxel in fixed image. */
       InputPointType point; point.Fill( 0.0f );
       inputPointSet->GetPoint( j, &point );
-      inputpointvec[ j ] = point;
-      dummyImage->TransformPhysicalPointToContinuousIndex(
-        point, fixedcindex );
-      for( unsigned int i = 0; i < FixedImageDimension; i++ )
+      if( !pointsAreIndices )
       {
-        inputindexvec[ j ][ i ] = static_cast< FixedImageIndexValueType >(
-          itk::Math::Round< double >( fixedcindex[ i ] ) );
+        /** Compute index of nearest voxel in fixed image. */
+        inputpointvec[ j ] = point;
+        dummyImage->TransformPhysicalPointToContinuousIndex(
+          point, fixedcindex );
+        for( unsigned int i = 0; i < FixedImageDimension; i++ )
+        {
+          inputindexvec[ j ][ i ] = static_cast< FixedImageIndexValueType >(
+            itk::Math::Round< double >( fixedcindex[ i ] ) );
+        }
       }
-    }
-  }
-  else //so: inputasindex
-  {
-    for( unsigned int j = 0; j < nrofpoints; j++ )
-    {
-      /** The read point from the inutPointSet is actually an index
-       * Cast to the proper type.
-       */
-      InputPointType point; point.Fill( 0.0f );
-      inputPointSet->GetPoint( j, &point );
-      for( unsigned int i = 0; i < FixedImageDimension; i++ )
+      else //so: inputasindex
       {
-        inputindexvec[ j ][ i ] = static_cast< FixedImageIndexValueType >(
-          itk::Math::Round< double >( point[ i ] ) );
+        /** The read point from the inutPointSet is actually an index
+         * Cast to the proper type.
+         */
+        for( unsigned int i = 0; i < FixedImageDimension; i++ )
+        {
+          inputindexvec[ j ][ i ] = static_cast< FixedImageIndexValueType >(
+            itk::Math::Round< double >( point[ i ] ) );
+        }
+        /** Compute the input point in physical coordinates. */
+        dummyImage->TransformIndexToPhysicalPoint(
+          inputindexvec[ j ], inputpointvec[ j ] );
       }
-      /** Compute the input point in physical coordinates. */
-      dummyImage->TransformIndexToPhysicalPoint(
-        inputindexvec[ j ], inputpointvec[ j ] );
     }
-  }
+  }, nullptr );
 
-  /** Apply the transform. */
+  /** Apply the transform. Every chunk of points is transformed by one call
+   * of the batched AdvancedTransform::TransformPoints(), which is const, so
+   * the chunks can be transformed simultaneously.
+   */
   elxout << "  The input points are transformed." << std::endl;
-  for( unsigned int j = 0; j < nrofpoints; j++ )
-  {
-    /** Call TransformPoint. */
-    outputpointvec[ j ] = this->GetAsITKBaseType()->TransformPoint( inputpointvec[ j ] );
-
-    /** Transform back to index in fixed image domain. */
-    dummyImage->TransformPhysicalPointToContinuousIndex(
-      outputpointvec[ j ], fixedcindex );
-    for( unsigned int i = 0; i < FixedImageDimension; i++ )
+  const ITKBaseType * transform = this->GetAsITKBaseType();
+  threader->ParallelizeArray( 0, numberOfChunks, [ & ]( const itk::SizeValueType chunk )
+  {
+    FixedImageContinuousIndexType  fixedcindex;
+    MovingImageContinuousIndexType movingcindex;
+    const unsigned long            first = chunk * chunkSize;
+    const unsigned long            last  = std::min< unsigned long >( first + chunkSize, nrofpoints );
+    transform->TransformPoints( &inputpointvec[ first ], &outputpointvec[ first ], last - first );
+    for( unsigned long j = first; j < last; j++ )
     {
-      outputindexfixedvec[ j ][ i ] = static_cast< FixedImageIndexValueType >(
-        itk::Math::Round< double >( fixedcindex[ i ] ) );
-    }
+      /** Transform back to index in fixed image domain. */
+      dummyImage->TransformPhysicalPointToContinuousIndex(
+        outputpointvec[ j ], fixedcindex );
+      for( unsigned int i = 0; i < FixedImageDimension; i++ )
+      {
+        outputindexfixedvec[ j ][ i ] = static_cast< FixedImageIndexValueType >(
+          itk::Math::Round< double >( fixedcindex[ i ] ) );
+      }
 
-    if( alsoMovingIndices )
-    {
-      /** Transform back to index in moving image domain. */
-      movingImage->TransformPhysicalPointToContinuousIndex(
-        outputpointvec[ j ], movingcindex );
-      for( unsigned int i = 0; i < MovingImageDimension; i++ )
+      if( alsoMovingIndices )
       {
-        outputindexmovingvec[ j ][ i ] = static_cast< MovingImageIndexValueType >(
-          itk::Math::Round< double >( movingcindex[ i ] ) );
+        /** Transform back to index in moving image domain. */
+        movingImage->TransformPhysicalPointToContinuousIndex(
+          outputpointvec[ j ], movingcindex );
+        for( unsigned int i = 0; i < MovingImageDimension; i++ )
+        {
+          outputindexmovingvec[ j ][ i ] = static_cast< MovingImageIndexValueType >(
+            itk::Math::Round< double >( movingcindex[ i ] ) );
+        }
       }
+
+      /** Compute displacement. */
+      deformationvec[ j ].CastFrom( outputpointvec[ j ] - inputpointvec[ j ] );
     }
+  }, nullptr );
 
-    /** Compute displacement. */
-    deformationvec[ j ].CastFrom( outputpointvec[ j ] - inputpointvec[ j ] );
+  /** A binary input point file gives a binary output point file,
+   * with the same fields as the text output.
+   */
+  if( ippReader->GetIsBinaryFile() )
+  {
+    this->WriteBinaryOutputPoints( inputindexvec, inputpointvec,
+      outputindexfixedvec, outputpointvec,
+      alsoMovingIndices ? outputindexmovingvec : std::vector< MovingImageIndexType >() );
+    return;
   }
 
   /** Create filename and file stream. */
@@ -1312,62 +1393,173 @@ TransformBase< TElastix >
     ->GetCommandLineArgument( "-out" );
   outputPointsFileName += "outputpoints.txt";
   std::ofstream outputPointsFile( outputPointsFileName.c_str() );
-  outputPointsFile << std::showpoint << std::fixed;
   elxout << "  The transformed points are saved in: "
          <<  outputPointsFileName << std::endl;
 
-  /** Print the results. */
-  for( unsigned int j = 0; j < nrofpoints; j++ )
+  /** Format the results. Every chunk of points is formatted by one thread
+   * into its own string, which are written in order afterwards.
+   */
+  std::vector< std::string > formattedChunks( numberOfChunks );
+  threader->ParallelizeArray( 0, numberOfChunks, [ & ]( const itk::SizeValueType chunk )
   {
-    /** The input index. */
-    outputPointsFile << "Point\t" << j << "\t; InputIndex = [ ";
-    for( unsigned int i = 0; i < FixedImageDimension; i++ )
+    std::ostringstream  chunkStream;
+    chunkStream << std::showpoint << std::fixed;
+    const unsigned long last = std::min< unsigned long >( ( chunk + 1 ) * chunkSize, nrofpoints );
+    for( unsigned long j = chunk * chunkSize; j < last; j++ )
     {
-      outputPointsFile << inputindexvec[ j ][ i ] << " ";
-    }
+      /** The input index. */
+      chunkStream << "Point\t" << j << "\t; InputIndex = [ ";
+      for( unsigned int i = 0; i < FixedImageDimension; i++ )
+      {
+        chunkStream << inputindexvec[ j ][ i ] << " ";
+      }
 
-    /** The input point. */
-    outputPointsFile << "]\t; InputPoint = [ ";
-    for( unsigned int i = 0; i < FixedImageDimension; i++ )
-    {
-      outputPointsFile << inputpointvec[ j ][ i ] << " ";
-    }
+      /** The input point. */
+      chunkStream << "]\t; InputPoint = [ ";
+      for( unsigned int i = 0; i < FixedImageDimension; i++ )
+      {
+        chunkStream << inputpointvec[ j ][ i ] << " ";
+      }
 
-    /** The output index in fixed image. */
-    outputPointsFile << "]\t; OutputIndexFixed = [ ";
-    for( unsigned int i = 0; i < FixedImageDimension; i++ )
-    {
-      outputPointsFile << outputindexfixedvec[ j ][ i ] << " ";
-    }
+      /** The output index in fixed image. */
+      chunkStream << "]\t; OutputIndexFixed = [ ";
+      for( unsigned int i = 0; i < FixedImageDimension; i++ )
+      {
+        chunkStream << outputindexfixedvec[ j ][ i ] << " ";
+      }
 
-    /** The output point. */
-    outputPointsFile << "]\t; OutputPoint = [ ";
-    for( unsigned int i = 0; i < FixedImageDimension; i++ )
-    {
-      outputPointsFile << outputpointvec[ j ][ i ] << " ";
-    }
+      /** The output point. */
+      chunkStream << "]\t; OutputPoint = [ ";
+      for( unsigned int i = 0; i < FixedImageDimension; i++ )
+      {
+        chunkStream << outputpointvec[ j ][ i ] << " ";
+      }
 
-    /** The output point minus the input point. */
-    outputPointsFile << "]\t; Deformation = [ ";
-    for( unsigned int i = 0; i < MovingImageDimension; i++ )
-    {
-      outputPointsFile << deformationvec[ j ][ i ] << " ";
-    }
+      /** The output point minus the input point. */
+      chunkStream << "]\t; Deformation = [ ";
+      for( unsigned int i = 0; i < MovingImageDimension; i++ )
+      {
+        chunkStream << deformationvec[ j ][ i ] << " ";
+      }
+
+      if( alsoMovingIndices )
+      {
+        /** The output index in moving image. */
+        chunkStream << "]\t; OutputIndexMoving = [ ";
+        for( unsigned int i = 0; i < MovingImageDimension; i++ )
+        {
+          chunkStream << outputindexmovingvec[ j ][ i ] << " ";
+        }
+      }
+
+      chunkStream << "]\n";
+    } // end for points in chunk
+    formattedChunks[ chunk ] = chunkStream.str();
+  }, nullptr );
+
+  /** Print the results. */
+  for( unsigned long chunk = 0; chunk < numberOfChunks; ++chunk )
+  {
+    outputPointsFile << formattedChunks[ chunk ];
+  }
+
+} // end TransformPointsSomePoints()
+
+
+/**
+ * ************** WriteBinaryOutputPoints *********************
+ *
+ * Writes the results of TransformPointsSomePoints() to outputpoints.bin.
+ * The file starts with the 8 characters "ELXOUTPT", followed by the
+ * dimension (uint32), whether the output indices in the moving image are
+ * included (uint32, 0 or 1) and the number of points (uint64). Then, for
+ * every point, the InputIndex, InputPoint, OutputIndexFixed, OutputPoint,
+ * Deformation and, if included, OutputIndexMoving follow as doubles, in the
+ * order of the text output. All numbers are little endian.
+ */
+
+template< class TElastix >
+void
+TransformBase< TElastix >
+::WriteBinaryOutputPoints(
+  const std::vector< FixedImageIndexType > & inputIndices,
+  const std::vector< InputPointType > & inputPoints,
+  const std::vector< FixedImageIndexType > & outputIndicesFixed,
+  const std::vector< OutputPointType > & outputPoints,
+  const std::vector< MovingImageIndexType > & outputIndicesMoving ) const
+{
+  /** Create filename and file stream. */
+  std::string outputPointsFileName = this->m_Configuration
+    ->GetCommandLineArgument( "-out" );
+  outputPointsFileName += "outputpoints.bin";
+  std::ofstream outputPointsFile( outputPointsFileName.c_str(),
+    std::ios::out | std::ios::binary );
+  elxout << "  The transformed points are saved in: "
+         <<  outputPointsFileName << std::endl;
 
-    if( alsoMovingIndices )
+  /** Write the header, in little endian byte order. */
+  const bool    alsoMovingIndices = !outputIndicesMoving.empty();
+  itk::uint32_t dimension         = FixedImageDimension;
+  itk::uint32_t hasMovingIndices  = alsoMovingIndices ? 1 : 0;
+  itk::uint64_t numberOfPoints    = outputPoints.size();
+  itk::ByteSwapper< itk::uint32_t >::SwapFromSystemToLittleEndian( &dimension );
+  itk::ByteSwapper< itk::uint32_t >::SwapFromSystemToLittleEndian( &hasMovingIndices );
+  itk::ByteSwapper< itk::uint64_t >::SwapFromSystemToLittleEndian( &numberOfPoints );
+  outputPointsFile.write( "ELXOUTPT", 8 );
+  outputPointsFile.write( reinterpret_cast< const char * >( &dimension ), sizeof( dimension ) );
+  outputPointsFile.write( reinterpret_cast< const char * >( &hasMovingIndices ), sizeof( hasMovingIndices ) );
+  outputPointsFile.write( reinterpret_cast< const char * >( &numberOfPoints ), sizeof( numberOfPoints ) );
+
+  /** Write the records in blocks, to limit the size of the buffer. */
+  const std::size_t     blockSize       = 65536;
+  const std::size_t     valuesPerRecord = ( alsoMovingIndices ? 6 : 5 ) * FixedImageDimension;
+  std::vector< double > buffer;
+  buffer.reserve( blockSize * valuesPerRecord );
+  for( std::size_t first = 0; first < outputPoints.size(); first += blockSize )
+  {
+    const std::size_t last = std::min( first + blockSize, outputPoints.size() );
+    buffer.clear();
+    for( std::size_t j = first; j < last; ++j )
     {
-      /** The output index in moving image. */
-      outputPointsFile << "]\t; OutputIndexMoving = [ ";
-      for( unsigned int i = 0; i < MovingImageDimension; i++ )
+      for( unsigned int i = 0; i < FixedImageDimension; ++i )
+      {
+        buffer.push_back( static_cast< double >( inputIndices[ j ][ i ] ) );
+      }
+      for( unsigned int i = 0; i < FixedImageDimension; ++i )
       {
-        outputPointsFile << outputindexmovingvec[ j ][ i ] << " ";
+        buffer.push_back( static_cast< double >( inputPoints[ j ][ i ] ) );
+      }
+      for( unsigned int i = 0; i < FixedImageDimension; ++i )
+      {
+        buffer.push_back( static_cast< double >( outputIndicesFixed[ j ][ i ] ) );
+      }
+      for( unsigned int i = 0; i < MovingImageDimension; ++i )
+      {
+        buffer.push_back( static_cast< double >( outputPoints[ j ][ i ] ) );
+      }
+      for( unsigned int i = 0; i < MovingImageDimension; ++i )
+      {
+        buffer.push_back( static_cast< double >( outputPoints[ j ][ i ] - inputPoints[ j ][ i ] ) );
+      }
+      if( alsoMovingIndices )
+      {
+        for( unsigned int i = 0; i < MovingImageDimension; ++i )
+        {
+          buffer.push_back( static_cast< double >( outputIndicesMoving[ j ][ i ] ) );
+        }
       }
     }
+    itk::ByteSwapper< double >::SwapRangeFromSystemToLittleEndian( &buffer[ 0 ], buffer.size() );
+    outputPointsFile.write( reinterpret_cast< const char * >( &buffer[ 0 ] ),
+      buffer.size() * sizeof( double ) );
+  }
 
-    outputPointsFile << "]" << std::endl;
-  } // end for nrofpoints
+  if( !outputPointsFile )
+  {
+    xl::xout[ "error" ] << "  Error while writing the output point file." << std::endl;
+  }
 
-} // end TransformPointsSomePoints()
+} // end WriteBinaryOutputPoints()
 
 
 /**
@@ -1469,6 +1661,38 @@ void
 TransformBase< TElastix >
 ::TransformPointsAllPoints( void ) const
 {
+#ifndef _ELASTIX_BUILD_LIBRARY
+  /** When the deformation field does not fit in the StreamingMemoryBudget,
+   * it is generated and written piece by piece, without keeping it in memory.
+   */
+  const typename FixedImageType::SizeType size
+    = this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetSize();
+  double numberOfPixels = 1.0;
+  for( unsigned int i = 0; i < FixedImageDimension; ++i )
+  {
+    numberOfPixels *= static_cast< double >( size[ i ] );
+  }
+  const unsigned int numberOfStreamDivisions
+    = this->GetNumberOfStreamDivisions( numberOfPixels * sizeof( VectorPixelType ) );
+  if( numberOfStreamDivisions > 1 )
+  {
+    elxout << "  The deformation field is generated and written in "
+           << numberOfStreamDivisions << " pieces." << std::endl;
+    typename DeformationFieldGeneratorType::Pointer        defGenerator;
+    typename DeformationFieldChangeInfoFilterType::Pointer infoChanger;
+    this->CreateDeformationFieldPipeline( defGenerator, infoChanger );
+
+    /** Track the progress of the generation of the deformation field. */
+    typename ProgressCommandType::Pointer progressObserver = ProgressCommandType::New();
+    progressObserver->ConnectObserver( defGenerator );
+    progressObserver->SetStartString( "  Progress: " );
+    progressObserver->SetEndString( "%" );
+
+    this->WriteDeformationFieldImage( infoChanger->GetOutput(), numberOfStreamDivisions );
+    return;
+  }
+#endif
+
   typename DeformationFieldImageType::Pointer deformationfield = this->GenerateDeformationFieldImage();
   //put deformation field in container
   this->m_Elastix->SetResultDeformationField( deformationfield.GetPointer() );
@@ -1481,28 +1705,21 @@ TransformBase< TElastix >
 
 
 /**
- * ************** GenerateDeformationFieldImage **********************
- *
- * This function transforms all indexes to a physical point.
- * The difference vector (= the deformation at that index) is
- * stored in an image of vectors (of floats).
+ * ************** CreateDeformationFieldPipeline **********************
  */
 
 template< class TElastix >
-typename TransformBase< TElastix >::DeformationFieldImageType::Pointer
+void
 TransformBase< TElastix >
-::GenerateDeformationFieldImage( void ) const
+::CreateDeformationFieldPipeline(
+  typename DeformationFieldGeneratorType::Pointer & defGenerator,
+  typename DeformationFieldChangeInfoFilterType::Pointer & infoChanger ) const
 {
   /** Typedef's. */
   typedef typename FixedImageType::DirectionType FixedImageDirectionType;
-  typedef itk::TransformToDisplacementFieldFilter<
-    DeformationFieldImageType, CoordRepType >         DeformationFieldGeneratorType;
-  typedef itk::ChangeInformationImageFilter<
-    DeformationFieldImageType >                       ChangeInfoFilterType;
 
   /** Create an setup deformation field generator. */
-  typename DeformationFieldGeneratorType::Pointer defGenerator
-    = DeformationFieldGeneratorType::New();
+  defGenerator = DeformationFieldGeneratorType::New();
   defGenerator->SetSize(
     this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetSize() );
   defGenerator->SetOutputSpacing(
@@ -1518,13 +1735,34 @@ TransformBase< TElastix >
   /** Possibly change direction cosines to their original value, as specified
    * in the tp-file, or by the fixed image. This is only necessary when
    * the UseDirectionCosines flag was set to false. */
-  typename ChangeInfoFilterType::Pointer infoChanger = ChangeInfoFilterType::New();
+  infoChanger = DeformationFieldChangeInfoFilterType::New();
   FixedImageDirectionType originalDirection;
   bool                    retdc = this->GetElastix()->GetOriginalFixedImageDirection( originalDirection );
   infoChanger->SetOutputDirection( originalDirection );
   infoChanger->SetChangeDirection( retdc & !this->GetElastix()->GetUseDirectionCosines() );
   infoChanger->SetInput( defGenerator->GetOutput() );
 
+} // end CreateDeformationFieldPipeline()
+
+
+/**
+ * ************** GenerateDeformationFieldImage **********************
+ *
+ * This function transforms all indexes to a physical point.
+ * The difference vector (= the deformation at that index) is
+ * stored in an image of vectors (of floats).
+ */
+
+template< class TElastix >
+typename TransformBase< TElastix >::DeformationFieldImageType::Pointer
+TransformBase< TElastix >
+::GenerateDeformationFieldImage( void ) const
+{
+  /** Create the deformation field generator. */
+  typename DeformationFieldGeneratorType::Pointer        defGenerator;
+  typename DeformationFieldChangeInfoFilterType::Pointer infoChanger;
+  this->CreateDeformationFieldPipeline( defGenerator, infoChanger );
+
   /** Track the progress of the generation of the deformation field. */
 #ifndef _ELASTIX_BUILD_LIBRARY
   typename ProgressCommandType::Pointer progressObserver = ProgressCommandType::New();
@@ -1561,7 +1799,8 @@ template< class TElastix >
 void
 TransformBase< TElastix >::
 WriteDeformationFieldImage(
-  typename TransformBase< TElastix >::DeformationFieldImageType::Pointer deformationfield ) const
+  typename TransformBase< TElastix >::DeformationFieldImageType::Pointer deformationfield,
+  const unsigned int numberOfStreamDivisions ) const
 {
   typedef itk::ImageFileWriter<
     DeformationFieldImageType >                       DeformationFieldWriterType;
@@ -1578,6 +1817,7 @@ WriteDeformationFieldImage(
     = DeformationFieldWriterType::New();
   defWriter->SetInput( deformationfield );
   defWriter->SetFileName( makeFileName.str().c_str() );
+  defWriter->SetNumberOfStreamDivisions( numberOfStreamDivisions );
 
   /** Do the writing. */
   elxout << "  Computing and writing the deformation field ..." << std::endl;
@@ -1812,6 +2052,234 @@ TransformBase< TElastix >
 } // end ComputeSpatialJacobian()
 
 
+/**
+ * ************** ComputeOutputsInSinglePass **********************
+ */
+
+template< class TElastix >
+bool
+TransformBase< TElastix >
+::ComputeOutputsInSinglePass( void ) const
+{
+  /** Read the command line arguments. For backwards compatibility def = ipp. */
+  const std::string ipp    = this->GetConfiguration()->GetCommandLineArgument( "-ipp" );
+  std::string       def    = this->GetConfiguration()->GetCommandLineArgument( "-def" );
+  const std::string jac    = this->GetConfiguration()->GetCommandLineArgument( "-jac" );
+  const std::string jacmat = this->GetConfiguration()->GetCommandLineArgument( "-jacmat" );
+  if( def == "" ) { def = ipp; }
+
+  const bool computeDeformationField = ( def == "all" );
+  const bool computeDeterminant      = ( jac == "all" );
+  const bool computeSpatialJacobian  = ( jacmat == "all" );
+
+  /** The result image can only be included when the default resampler
+   * is used, without the RayCastResampleInterpolator, which changes the
+   * transform of the resampler. The library interface stores the result
+   * image with the requested pixel type, so it is resampled as usual.
+   */
+  typename ElastixType::ResamplerBaseType::ITKBaseType * resampler
+    = this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType();
+  bool computeResultImage = false;
+#ifndef _ELASTIX_BUILD_LIBRARY
+  typedef itk::AdvancedRayCastInterpolateImageFunction<
+    MovingImageType, CoordRepType >                   RayCastInterpolatorType;
+  computeResultImage = this->m_Elastix->GetMovingImage() != 0
+    && std::string( this->m_Elastix->GetElxResamplerBase()->elxGetClassName() ) == "DefaultResampler"
+    && dynamic_cast< const RayCastInterpolatorType * >( resampler->GetInterpolator() ) == 0;
+#endif
+
+  /** The outputs that are not computed in the single pass are handled as usual,
+   * e.g. the points in an input point file, and the messages for unused options.
+   */
+  if( !computeDeformationField ) { this->TransformPoints(); }
+  if( !computeDeterminant ) { this->ComputeDeterminantOfSpatialJacobian(); }
+  if( !computeSpatialJacobian ) { this->ComputeSpatialJacobian(); }
+  if( !computeDeformationField && !computeDeterminant
+    && !computeSpatialJacobian && !computeResultImage )
+  {
+    return false;
+  }
+
+  /** Typedef's. */
+  typedef itk::TransformToMultipleOutputsSource<
+    MovingImageType, CoordRepType >                   OutputsGeneratorType;
+
+  /** Create and setup the generator. */
+  typename OutputsGeneratorType::Pointer generator = OutputsGeneratorType::New();
+  generator->SetTransform( const_cast< const ITKBaseType * >(
+      this->GetAsITKBaseType() ) );
+  generator->SetOutputSize( resampler->GetSize() );
+  generator->SetOutputSpacing( resampler->GetOutputSpacing() );
+  generator->SetOutputOrigin( resampler->GetOutputOrigin() );
+  generator->SetOutputIndex( resampler->GetOutputStartIndex() );
+  generator->SetOutputDirection( resampler->GetOutputDirection() );
+  generator->SetComputeDisplacementField( computeDeformationField );
+  generator->SetComputeDeterminantOfSpatialJacobian( computeDeterminant );
+  generator->SetComputeSpatialJacobian( computeSpatialJacobian );
+  generator->SetComputeResampledImage( computeResultImage );
+  if( computeResultImage )
+  {
+    generator->SetInputImage( this->m_Elastix->GetMovingImage() );
+    generator->SetInterpolator( resampler->GetModifiableInterpolator() );
+    generator->SetDefaultPixelValue( resampler->GetDefaultPixelValue() );
+  }
+
+#ifndef _ELASTIX_BUILD_LIBRARY
+  /** Track the progress of the generation of the outputs. */
+  typename ProgressCommandType::Pointer progressObserver = ProgressCommandType::New();
+  progressObserver->ConnectObserver( generator );
+  progressObserver->SetStartString( "  Progress: " );
+  progressObserver->SetEndString( "%" );
+#endif
+
+  /** Do the computation, for all outputs at once. */
+  elxout << "  Computing the requested outputs in a single pass ..." << std::endl;
+  try
+  {
+    generator->Update();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    /** Add information to the exception. */
+    excp.SetLocation( "TransformBase - ComputeOutputsInSinglePass()" );
+    std::string err_str = excp.GetDescription();
+    err_str += "\nError occurred while computing the transform outputs.\n";
+    excp.SetDescription( err_str );
+
+    /** Pass the exception to an higher level. */
+    throw excp;
+  }
+
+  /** Disconnect the outputs from the generator. The writers below may split
+   * the writing into pieces, see the StreamingMemoryBudget, and every piece
+   * would otherwise update the generator, which computes all outputs at once.
+   */
+  typename OutputsGeneratorType::DisplacementFieldImageType::Pointer displacementField
+    = generator->GetDisplacementFieldOutput();
+  typename OutputsGeneratorType::DeterminantImageType::Pointer determinantImage
+    = generator->GetDeterminantOfSpatialJacobianOutput();
+  typename OutputsGeneratorType::SpatialJacobianImageType::Pointer spatialJacobianImage
+    = generator->GetSpatialJacobianOutput();
+  typename OutputsGeneratorType::ResampledImageType::Pointer resampledImage
+    = generator->GetResampledImageOutput();
+  displacementField->DisconnectPipeline();
+  determinantImage->DisconnectPipeline();
+  spatialJacobianImage->DisconnectPipeline();
+  resampledImage->DisconnectPipeline();
+
+  /** Write the outputs. */
+  if( computeDeformationField )
+  {
+    /** Possibly change direction cosines to their original value. */
+    typename DeformationFieldChangeInfoFilterType::Pointer infoChanger
+      = DeformationFieldChangeInfoFilterType::New();
+    typename FixedImageType::DirectionType originalDirection;
+    bool retdc = this->GetElastix()->GetOriginalFixedImageDirection( originalDirection );
+    infoChanger->SetOutputDirection( originalDirection );
+    infoChanger->SetChangeDirection( retdc & !this->GetElastix()->GetUseDirectionCosines() );
+    infoChanger->SetInput( displacementField );
+    infoChanger->Update();
+
+    typename DeformationFieldImageType::Pointer deformationfield = infoChanger->GetOutput();
+    this->m_Elastix->SetResultDeformationField( deformationfield.GetPointer() );
+#ifndef _ELASTIX_BUILD_LIBRARY
+    this->WriteDeformationFieldImage( deformationfield );
+#endif
+  }
+  if( computeDeterminant )
+  {
+    this->WriteOutputGridImage( determinantImage.GetPointer(),
+      "spatialJacobian", "spatial Jacobian determinant", false );
+  }
+  if( computeSpatialJacobian )
+  {
+    std::string resultImageFormat = "mhd";
+    this->m_Configuration->ReadParameter( resultImageFormat, "ResultImageFormat", 0, false );
+    this->WriteOutputGridImage( spatialJacobianImage.GetPointer(),
+      "fullSpatialJacobian", "spatial Jacobian", resultImageFormat != "mhd" );
+  }
+  if( computeResultImage )
+  {
+    std::string resultImageFormat = "mhd";
+    this->m_Configuration->ReadParameter( resultImageFormat, "ResultImageFormat", 0, false );
+    std::ostringstream makeFileName( "" );
+    makeFileName << this->m_Configuration->GetCommandLineArgument( "-out" )
+                 << "result." << resultImageFormat;
+    elxout << "  Writing the result image ..." << std::endl;
+    this->m_Elastix->GetElxResamplerBase()->WriteResultImage(
+      resampledImage, makeFileName.str().c_str(), false );
+  }
+
+  return computeResultImage;
+
+} // end ComputeOutputsInSinglePass()
+
+
+/**
+ * ************** WriteOutputGridImage **********************
+ */
+
+template< class TElastix >
+template< class TImage >
+void
+TransformBase< TElastix >
+::WriteOutputGridImage( TImage * image, const std::string & baseName,
+  const std::string & description, const bool changePixelType ) const
+{
+  /** Typedef's. */
+  typedef itk::ImageFileWriter< TImage >             WriterType;
+  typedef itk::ChangeInformationImageFilter< TImage > ChangeInfoFilterType;
+  typedef itk::PixelTypeChangeCommand< WriterType >  PixelTypeChangeCommandType;
+
+  /** Possibly change direction cosines to their original value, as specified
+   * in the tp-file, or by the fixed image. This is only necessary when
+   * the UseDirectionCosines flag was set to false.
+   */
+  typename ChangeInfoFilterType::Pointer infoChanger = ChangeInfoFilterType::New();
+  typename FixedImageType::DirectionType originalDirection;
+  bool retdc = this->GetElastix()->GetOriginalFixedImageDirection( originalDirection );
+  infoChanger->SetOutputDirection( originalDirection );
+  infoChanger->SetChangeDirection( retdc & !this->GetElastix()->GetUseDirectionCosines() );
+  infoChanger->SetInput( image );
+
+  /** Create a name for the output file. */
+  std::string resultImageFormat = "mhd";
+  this->m_Configuration->ReadParameter( resultImageFormat, "ResultImageFormat", 0, false );
+  std::ostringstream makeFileName( "" );
+  makeFileName << this->m_Configuration->GetCommandLineArgument( "-out" )
+               << baseName << "." << resultImageFormat;
+
+  /** Write the image to disk. */
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( infoChanger->GetOutput() );
+  writer->SetFileName( makeFileName.str().c_str() );
+  typename PixelTypeChangeCommandType::Pointer startWriteCommand
+    = PixelTypeChangeCommandType::New();
+  if( changePixelType )
+  {
+    writer->AddObserver( itk::StartEvent(), startWriteCommand );
+  }
+
+  elxout << "  Writing the " << description << " ..." << std::endl;
+  try
+  {
+    writer->Update();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    /** Add information to the exception. */
+    excp.SetLocation( "TransformBase - WriteOutputGridImage()" );
+    std::string err_str = excp.GetDescription();
+    err_str += "\nError occurred while writing " + description + " image.\n";
+    excp.SetDescription( err_str );
+
+    /** Pass the exception to an higher level. */
+    throw excp;
+  }
+
+} // end WriteOutputGridImage()
+
+
 /**
  * ************** SetTransformParametersFileName ****************
  */
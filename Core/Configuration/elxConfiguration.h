@@ -132,6 +132,13 @@ public:
 
   /** Interface to the ParameterMapInterface. */
 
+  /** Get the parameter map. */
+  const ParameterFileParserType::ParameterMapType & GetParameterMap( void ) const
+  {
+    return this->m_ParameterMapInterface->GetParameterMap();
+  }
+
+
   /** Count the number of parameters. */
   std::size_t CountNumberOfParameterEntries(
     const std::string & parameterName ) const
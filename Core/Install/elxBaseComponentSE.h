@@ -56,6 +56,9 @@ public:
   typedef typename ElastixType::ConfigurationType    ConfigurationType;
   typedef typename ElastixType::ConfigurationPointer ConfigurationPointer;
 
+  /** The cache of data computed from the fixed images. */
+  typedef typename ElastixType::FixedImageDataCacheType FixedImageDataCacheType;
+
   /** RegistrationType; NB: this is the elx::RegistrationBase
    * not an itk::Object or something like that.
    */
@@ -109,6 +112,26 @@ public:
   }
 
 
+  /** Get the number of pieces in which an output image of the given size
+   * should be generated and written, to stay within the memory budget that
+   * is given by the parameter StreamingMemoryBudget, in megabytes. Returns 1
+   * when no budget is given, or when the image fits in the budget.
+   * numberOfResidentBytes is the memory that is needed as a whole while the
+   * output is generated, such as the input image, and is subtracted from the
+   * budget. When it does not fit in the budget, a warning is printed, and
+   * only the output is divided.
+   */
+  virtual unsigned int GetNumberOfStreamDivisions( const double numberOfBytes,
+    const double numberOfResidentBytes = 0.0 ) const;
+
+  /** Get the cache of data computed from the fixed images, which is shared
+   * with the other registrations of the same fixed image(s), see
+   * FixedImageDataCache. Returns null when there is no cache, or when the
+   * parameter CacheFixedImageData is "false".
+   */
+  virtual FixedImageDataCacheType * GetFixedImageDataCache( void ) const;
+
+
 protected:
 
   BaseComponentSE();
@@ -20,6 +20,11 @@
 #define __elxBaseComponentSE_hxx
 
 #include "elxBaseComponentSE.h"
+#include "xoutmain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace elastix
 {
@@ -93,6 +98,66 @@ BaseComponentSE< TElastix >::SetConfiguration( ConfigurationType * _arg )
 } // end SetConfiguration
 
 
+/**
+ * ******************* GetNumberOfStreamDivisions *********************
+ */
+
+template< class TElastix >
+unsigned int
+BaseComponentSE< TElastix >::GetNumberOfStreamDivisions(
+  const double numberOfBytes, const double numberOfResidentBytes ) const
+{
+  /** Read the memory budget in megabytes; 0 means no budget. */
+  double memoryBudget = 0.0;
+  this->m_Configuration->ReadParameter( memoryBudget,
+    "StreamingMemoryBudget", 0, false );
+  if( memoryBudget <= 0.0 )
+  {
+    return 1;
+  }
+
+  /** The memory that is kept as a whole is subtracted from the budget. When
+   * nothing is left, the budget cannot be met: warn, and only divide the output.
+   */
+  const double budget          = memoryBudget * 1024.0 * 1024.0;
+  double       budgetForOutput = budget - numberOfResidentBytes;
+  if( budgetForOutput <= 0.0 )
+  {
+    xl::xout[ "warning" ] << "WARNING: the StreamingMemoryBudget of " << memoryBudget
+                          << " MB cannot be met, because the images that are kept in memory as a whole"
+                          << " already take " << numberOfResidentBytes / ( 1024.0 * 1024.0 ) << " MB.\n";
+    xl::xout[ "warning" ] << "  Only the output is divided, as if it had the whole budget." << std::endl;
+    budgetForOutput = budget;
+  }
+
+  const double numberOfDivisions = std::min( std::ceil( numberOfBytes / budgetForOutput ),
+    static_cast< double >( std::numeric_limits< unsigned int >::max() ) );
+  return static_cast< unsigned int >( std::max( numberOfDivisions, 1.0 ) );
+
+} // end GetNumberOfStreamDivisions()
+
+
+/**
+ * ******************* GetFixedImageDataCache *********************
+ */
+
+template< class TElastix >
+typename BaseComponentSE< TElastix >::FixedImageDataCacheType *
+BaseComponentSE< TElastix >::GetFixedImageDataCache( void ) const
+{
+  if( this->m_Elastix.IsNull() || this->m_Configuration.IsNull() )
+  {
+    return nullptr;
+  }
+
+  bool cacheFixedImageData = true;
+  this->m_Configuration->ReadParameter( cacheFixedImageData,
+    "CacheFixedImageData", 0, false );
+  return cacheFixedImageData ? this->m_Elastix->GetFixedImageDataCache() : nullptr;
+
+} // end GetFixedImageDataCache()
+
+
 } // end namespace elastix
 
 #endif // end #ifndef __elxBaseComponentSE_hxx
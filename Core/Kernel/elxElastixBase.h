@@ -31,6 +31,7 @@
 #include "elxBaseComponent.h"
 #include "elxComponentDatabase.h"
 #include "elxConfiguration.h"
+#include "elxFixedImageDataCache.h"
 #include "itkObject.h"
 #include "itkDataObject.h"
 #include "elxMacro.h"
@@ -133,6 +134,17 @@ namespace elastix
  * \commandlinearg -threads: optional argument for both elastix and transformix to
  *    specify the maximum number of threads used by this process. Default: no maximum. \n
  *    example: <tt>-threads 2</tt> \n
+ * \commandlinearg -jobs: optional argument for elastix to run in batch mode, with
+ *    the name of a job file, or "-" to read the jobs from the standard input. \n
+ *    example: <tt>-jobs jobs.txt</tt> \n
+ *    Each line of the job file holds the command line arguments of one registration,
+ *    e.g. "-m moving1.mhd -out out1/", which add to (or replace) the arguments given
+ *    on the command line. The process, with its loaded components, stays alive until
+ *    all jobs are done, and the fixed image and mask are only read once for the jobs
+ *    with the same fixed image and mask files. Also the eroded fixed masks, the fixed
+ *    pyramid images and the samples of the Full and Grid samplers are computed once,
+ *    for the consecutive jobs with the same settings; see the parameter
+ *    CacheFixedImageData. The jobs run one after the other.
  * \commandlinearg -in: optional argument for transformix with the file name of an input image. \n
  *    example: <tt>-in inputImage.mhd</tt> \n
  *    If this option is skipped, a deformation field of the transform will be generated.
@@ -164,6 +176,8 @@ public:
   typedef itk::VectorContainer<
     unsigned int, std::string >               FileNameContainerType;
   typedef FileNameContainerType::Pointer FileNameContainerPointer;
+  typedef FixedImageDataCache               FixedImageDataCacheType;
+  typedef FixedImageDataCacheType::Pointer FixedImageDataCachePointer;
 
   /** Other typedef's. */
   typedef ComponentDatabase                ComponentDatabaseType;
@@ -248,6 +262,13 @@ public:
   elxSetObjectMacro( FixedMaskContainer, DataObjectContainerType );
   elxSetObjectMacro( MovingMaskContainer, DataObjectContainerType );
 
+  /** Set/Get the cache of data computed from the fixed images, shared with other
+   * registrations of the same fixed images. Null (the default) when there is
+   * nothing to share. Components use BaseComponentSE::GetFixedImageDataCache().
+   */
+  elxGetObjectMacro( FixedImageDataCache, FixedImageDataCacheType );
+  elxSetObjectMacro( FixedImageDataCache, FixedImageDataCacheType );
+
   /** Set/Get the result image container. */
   elxGetObjectMacro( ResultImageContainer, DataObjectContainerType );
   elxSetObjectMacro( ResultImageContainer, DataObjectContainerType );
@@ -527,6 +548,9 @@ private:
   DataObjectContainerPointer m_FixedMaskContainer;
   DataObjectContainerPointer m_MovingMaskContainer;
 
+  /** The cache of data computed from the fixed images, see FixedImageDataCache. */
+  FixedImageDataCachePointer m_FixedImageDataCache;
+
   /** The result image container. These are stored as pointers to itk::DataObject. */
   DataObjectContainerPointer m_ResultImageContainer;
 
@@ -74,7 +74,13 @@ xoutSetup( const char * logfilename, bool setupLogging, bool setupCout )
 
   if( setupLogging )
   {
-    /** Open the logfile for writing. */
+    /** Open the logfile for writing. A logfile of a previous run in
+     * the same process, e.g. in batch mode, is closed first.
+     */
+    if( g_LogFileStream.is_open() )
+    {
+      g_LogFileStream.close();
+    }
     g_LogFileStream.open( logfilename );
     if( !g_LogFileStream.is_open() )
     {
@@ -148,6 +154,8 @@ ElastixMain::ElastixMain()
   this->m_FixedMaskContainer  = 0;
   this->m_MovingMaskContainer = 0;
 
+  this->m_FixedImageDataCache = 0;
+
   this->m_ResultImageContainer = 0;
 
   this->m_FinalTransform   = 0;
@@ -380,6 +388,9 @@ ElastixMain::Run( void )
   this->GetElastixBase()->SetMovingMaskContainer( this->GetModifiableMovingMaskContainer() );
   this->GetElastixBase()->SetResultImageContainer( this->GetModifiableResultImageContainer() );
 
+  /** Share the data computed from the fixed images with other registrations, if a cache is set. */
+  this->GetElastixBase()->SetFixedImageDataCache( this->GetModifiableFixedImageDataCache() );
+
   /** Set the initial transform, if it happens to be there. */
   this->GetElastixBase()->SetInitialTransform( this->GetModifiableInitialTransform() );
 
@@ -128,6 +128,8 @@ public:
   typedef ElastixBase::DataObjectContainerType          DataObjectContainerType;
   typedef ElastixBase::ObjectContainerPointer           ObjectContainerPointer;
   typedef ElastixBase::DataObjectContainerPointer       DataObjectContainerPointer;
+  typedef ElastixBase::FixedImageDataCacheType          FixedImageDataCacheType;
+  typedef ElastixBase::FixedImageDataCachePointer       FixedImageDataCachePointer;
   typedef ElastixBase::FlatDirectionCosinesType         FlatDirectionCosinesType;
 
   /** Typedefs for the database that holds pointers to New() functions.
@@ -176,6 +178,10 @@ public:
   itkGetModifiableObjectMacro( FixedMaskContainer, DataObjectContainerType );
   itkGetModifiableObjectMacro( MovingMaskContainer, DataObjectContainerType );
 
+  /** Set/Get the cache of data computed from the fixed images, which is passed to ElastixBase. */
+  itkSetObjectMacro( FixedImageDataCache, FixedImageDataCacheType );
+  itkGetModifiableObjectMacro( FixedImageDataCache, FixedImageDataCacheType );
+
   /** Set/Get functions for the result images
    * (if these are not used, elastix tries to read them from disk,
    * according to the command line parameters).
@@ -325,6 +331,7 @@ protected:
   DataObjectContainerPointer m_MovingImageContainer;
   DataObjectContainerPointer m_FixedMaskContainer;
   DataObjectContainerPointer m_MovingMaskContainer;
+  FixedImageDataCachePointer m_FixedImageDataCache;
   DataObjectContainerPointer m_ResultImageContainer;
   DataObjectContainerPointer m_ResultDeformationFieldContainer;
 
@@ -424,68 +424,95 @@ ElastixTemplate< TFixedImage, TMovingImage >
          << timer.GetMean()
          << " s" << std::endl;
 
-  /** Call TransformPoints.
-   * Actually we could loop over all transforms.
-   * But for now, there seems to be no use yet for that.
-   */
-  timer.Reset();
-  timer.Start();
-  elxout << "Transforming points ..." << std::endl;
-  try
-  {
-    this->GetElxTransformBase()->TransformPoints();
-  }
-  catch( itk::ExceptionObject & excp )
-  {
-    xout[ "error" ] << excp << std::endl;
-    xout[ "error" ] << "However, transformix continues anyway." << std::endl;
-  }
-  timer.Stop();
-  elxout << "  Transforming points done, it took "
-         << this->ConvertSecondsToDHMS( timer.GetMean(), 2 ) << std::endl;
+  /** Possibly compute all outputs of the transform in a single pass. */
+  bool computeOutputsInSinglePass = false;
+  this->GetConfiguration()->ReadParameter( computeOutputsInSinglePass,
+    "ComputeOutputsInSinglePass", 0, false );
+  bool resultImageWritten = false;
 
-  /** Call ComputeDeterminantOfSpatialJacobian.
-   * Actually we could loop over all transforms.
-   * But for now, there seems to be no use yet for that.
-   */
-  timer.Reset();
-  timer.Start();
-  elxout << "Compute determinant of spatial Jacobian ..." << std::endl;
-  try
+  if( computeOutputsInSinglePass )
   {
-    this->GetElxTransformBase()->ComputeDeterminantOfSpatialJacobian();
+    timer.Reset();
+    timer.Start();
+    elxout << "Computing the transform outputs in a single pass ..." << std::endl;
+    try
+    {
+      resultImageWritten = this->GetElxTransformBase()->ComputeOutputsInSinglePass();
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      xout[ "error" ] << excp << std::endl;
+      xout[ "error" ] << "However, transformix continues anyway." << std::endl;
+    }
+    timer.Stop();
+    elxout << "  Computing the transform outputs done, it took "
+           << this->ConvertSecondsToDHMS( timer.GetMean(), 2 ) << std::endl;
   }
-  catch( itk::ExceptionObject & excp )
+  else
   {
-    xout[ "error" ] << excp << std::endl;
-    xout[ "error" ] << "However, transformix continues anyway." << std::endl;
-  }
-  timer.Stop();
-  elxout << "  Computing determinant of spatial Jacobian done, it took "
-         << this->ConvertSecondsToDHMS( timer.GetMean(), 2 ) << std::endl;
+    /** Call TransformPoints.
+     * Actually we could loop over all transforms.
+     * But for now, there seems to be no use yet for that.
+     */
+    timer.Reset();
+    timer.Start();
+    elxout << "Transforming points ..." << std::endl;
+    try
+    {
+      this->GetElxTransformBase()->TransformPoints();
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      xout[ "error" ] << excp << std::endl;
+      xout[ "error" ] << "However, transformix continues anyway." << std::endl;
+    }
+    timer.Stop();
+    elxout << "  Transforming points done, it took "
+           << this->ConvertSecondsToDHMS( timer.GetMean(), 2 ) << std::endl;
 
-  /** Call ComputeSpatialJacobian.
-   * Actually we could loop over all transforms.
-   * But for now, there seems to be no use yet for that.
-   */
-  timer.Reset();
-  timer.Start();
-  elxout << "Compute spatial Jacobian (full matrix) ..." << std::endl;
-  try
-  {
-    this->GetElxTransformBase()->ComputeSpatialJacobian();
-  }
-  catch( itk::ExceptionObject & excp )
-  {
-    xout[ "error" ] << excp << std::endl;
-    xout[ "error" ] << "However, transformix continues anyway." << std::endl;
+    /** Call ComputeDeterminantOfSpatialJacobian.
+     * Actually we could loop over all transforms.
+     * But for now, there seems to be no use yet for that.
+     */
+    timer.Reset();
+    timer.Start();
+    elxout << "Compute determinant of spatial Jacobian ..." << std::endl;
+    try
+    {
+      this->GetElxTransformBase()->ComputeDeterminantOfSpatialJacobian();
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      xout[ "error" ] << excp << std::endl;
+      xout[ "error" ] << "However, transformix continues anyway." << std::endl;
+    }
+    timer.Stop();
+    elxout << "  Computing determinant of spatial Jacobian done, it took "
+           << this->ConvertSecondsToDHMS( timer.GetMean(), 2 ) << std::endl;
+
+    /** Call ComputeSpatialJacobian.
+     * Actually we could loop over all transforms.
+     * But for now, there seems to be no use yet for that.
+     */
+    timer.Reset();
+    timer.Start();
+    elxout << "Compute spatial Jacobian (full matrix) ..." << std::endl;
+    try
+    {
+      this->GetElxTransformBase()->ComputeSpatialJacobian();
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      xout[ "error" ] << excp << std::endl;
+      xout[ "error" ] << "However, transformix continues anyway." << std::endl;
+    }
+    timer.Stop();
+    elxout << "  Computing spatial Jacobian done, it took "
+           << this->ConvertSecondsToDHMS( timer.GetMean(), 2 ) << std::endl;
   }
-  timer.Stop();
-  elxout << "  Computing spatial Jacobian done, it took "
-         << this->ConvertSecondsToDHMS( timer.GetMean(), 2 ) << std::endl;
 
-  /** Resample the image. */
-  if( this->GetMovingImage() != 0 )
+  /** Resample the image, if not done in the single pass already. */
+  if( this->GetMovingImage() != 0 && !resultImageWritten )
   {
     timer.Reset();
     timer.Start();
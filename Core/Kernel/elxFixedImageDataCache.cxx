@@ -0,0 +1,123 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "elxFixedImageDataCache.h"
+
+namespace elastix
+{
+
+/**
+ * ********************* IsComputedFrom ****************************
+ */
+
+bool
+FixedImageDataCache::IsComputedFrom( const EntryType & entry,
+  const SourceVectorType & sources )
+{
+  if( entry.m_Sources.size() != sources.size() )
+  {
+    return false;
+  }
+  for( std::size_t i = 0; i < sources.size(); ++i )
+  {
+    if( entry.m_Sources[ i ].GetPointer() != sources[ i ]
+      || ( sources[ i ] && entry.m_SourceMTimes[ i ] != sources[ i ]->GetMTime() ) )
+    {
+      return false;
+    }
+  }
+  return true;
+
+} // end IsComputedFrom()
+
+
+/**
+ * ********************* GetData ****************************
+ */
+
+FixedImageDataCache::DataObjectType *
+FixedImageDataCache::GetData( const SourceVectorType & sources,
+  const std::string & key ) const
+{
+  for( std::size_t i = 0; i < this->m_Entries.size(); ++i )
+  {
+    const EntryType & entry = this->m_Entries[ i ];
+    if( entry.m_Key == key && IsComputedFrom( entry, sources ) )
+    {
+      return entry.m_Data.GetPointer();
+    }
+  }
+  return nullptr;
+
+} // end GetData()
+
+
+/**
+ * ********************* AddData ****************************
+ */
+
+void
+FixedImageDataCache::AddData( const SourceVectorType & sources,
+  const std::string & key, DataObjectType * data )
+{
+  /** Forget the data of older versions of the sources. */
+  std::vector< EntryType > entries;
+  for( std::size_t i = 0; i < this->m_Entries.size(); ++i )
+  {
+    const EntryType & entry = this->m_Entries[ i ];
+    bool              isOutdated = false;
+    for( std::size_t j = 0; j < entry.m_Sources.size(); ++j )
+    {
+      const SourceType * source = entry.m_Sources[ j ].GetPointer();
+      isOutdated |= source && source->GetMTime() != entry.m_SourceMTimes[ j ];
+    }
+    if( !isOutdated && !( entry.m_Key == key && IsComputedFrom( entry, sources ) ) )
+    {
+      entries.push_back( entry );
+    }
+  }
+
+  EntryType entry;
+  for( std::size_t i = 0; i < sources.size(); ++i )
+  {
+    entry.m_Sources.push_back( sources[ i ] );
+    entry.m_SourceMTimes.push_back( sources[ i ] ? sources[ i ]->GetMTime() : 0 );
+  }
+  entry.m_Key  = key;
+  entry.m_Data = data;
+  entries.push_back( entry );
+
+  this->m_Entries.swap( entries );
+  this->Modified();
+
+} // end AddData()
+
+
+/**
+ * ********************* Clear ****************************
+ */
+
+void
+FixedImageDataCache::Clear( void )
+{
+  this->m_Entries.clear();
+  this->Modified();
+
+} // end Clear()
+
+
+} // end namespace elastix
@@ -0,0 +1,128 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __elxFixedImageDataCache_h
+#define __elxFixedImageDataCache_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkDataObject.h"
+
+#include <string>
+#include <vector>
+
+namespace elastix
+{
+
+/**
+ * \class FixedImageDataCache
+ * \brief Keeps the data that a series of registrations computes from the
+ * same fixed image(s) and mask(s), so that it is only computed once.
+ *
+ * The cache holds:
+ * \li the eroded fixed masks, see RegistrationBase::GenerateFixedMaskSpatialObject();
+ * \li the fixed pyramid images, see FixedImagePyramidBase::GraftCachedPyramidImages();
+ * \li the samples of the deterministic image samplers, see
+ *   ImageSamplerBase::CopyCachedSamples().
+ *
+ * An entry is identified by the objects it was computed from, their
+ * modification times, and a key that describes the computation, such as the
+ * pyramid schedule and the resolution level. The cache holds a reference to
+ * the source objects, so they can not be replaced by other objects at the
+ * same address while they are in the cache.
+ *
+ * The cache is owned by whoever runs the registrations: the ElastixFilter for
+ * its batch, or the elastix executable for its -jobs. It is passed to each
+ * registration by ElastixMain, like the fixed mask container, and used unless
+ * the parameter CacheFixedImageData is "false". Elsewhere there is no cache, so
+ * a single registration keeps no data longer than before. It is not thread-safe;
+ * the registrations that share it run one after the other.
+ *
+ * \ingroup Kernel
+ */
+
+class FixedImageDataCache : public itk::Object
+{
+public:
+
+  /** Standard itk. */
+  typedef FixedImageDataCache             Self;
+  typedef itk::Object                     Superclass;
+  typedef itk::SmartPointer< Self >       Pointer;
+  typedef itk::SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( FixedImageDataCache, itk::Object );
+
+  /** Typedefs. */
+  typedef itk::Object                       SourceType;
+  typedef std::vector< const SourceType * > SourceVectorType;
+  typedef itk::DataObject                   DataObjectType;
+  typedef DataObjectType::Pointer           DataObjectPointer;
+
+  /** Get the data that was computed from the given sources, as described
+   * by the key. Returns null if it is not in the cache.
+   */
+  DataObjectType * GetData( const SourceVectorType & sources,
+    const std::string & key ) const;
+
+  /** Add data to the cache. */
+  void AddData( const SourceVectorType & sources,
+    const std::string & key, DataObjectType * data );
+
+  /** Remove all data. */
+  void Clear( void );
+
+  /** Get the number of entries in the cache. */
+  std::size_t GetNumberOfEntries( void ) const
+  {
+    return this->m_Entries.size();
+  }
+
+
+protected:
+
+  FixedImageDataCache() {}
+  ~FixedImageDataCache() override {}
+
+private:
+
+  FixedImageDataCache( const Self & ); // purposely not implemented
+  void operator=( const Self & );      // purposely not implemented
+
+  /** One piece of data, and what it was computed from. */
+  struct EntryType
+  {
+    std::vector< SourceType::ConstPointer > m_Sources;
+    std::vector< itk::ModifiedTimeType >    m_SourceMTimes;
+    std::string                             m_Key;
+    DataObjectPointer                       m_Data;
+  };
+
+  /** Check if the entry was computed from the given sources, in their current state. */
+  static bool IsComputedFrom( const EntryType & entry, const SourceVectorType & sources );
+
+  std::vector< EntryType > m_Entries;
+
+};
+
+} // end namespace elastix
+
+#endif // end #ifndef __elxFixedImageDataCache_h
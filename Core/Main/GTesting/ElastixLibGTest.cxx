@@ -29,6 +29,12 @@
 
 #include <algorithm> // For transform.
 #include <array>
+#include <cmath>
+#include <cstdio>  // For remove.
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
 
 
 // Tests registering two small (5x6) binary images, using the example code from
@@ -200,3 +206,92 @@ GTEST_TEST(ElastixLib, ExampleFromManualRunningElastix)
 
   EXPECT_EQ(roundedTranslationOffset, translationOffset);
 }
+
+
+// Tests that the displacement distribution estimate of the ASGD optimizer is
+// taken from its cache when a registration is repeated with the same input,
+// and recomputed when the moving image changes. Each run estimates once per
+// resolution, and each new estimate adds a line to the cache file.
+GTEST_TEST(ElastixLib, DisplacementDistributionCacheHitAndMiss)
+{
+  using elastix::ELASTIX;
+  using ITKImageType = itk::Image<float>;
+  using RegionIteratorType = itk::ImageRegionIterator<ITKImageType>;
+
+  const std::string cacheFileName = "ElastixLibGTest_DisplacementDistributionCache.txt";
+  std::remove(cacheFileName.c_str());
+
+  std::map<std::string, std::vector<std::string>> parameters =
+  {
+    { "ASGDParameterEstimationMethod", { "DisplacementDistribution" } },
+    { "AutomaticParameterEstimation", { "true" } },
+    { "DisplacementDistributionCacheFileName", { cacheFileName } },
+    { "FixedImageDimension", { "2" } },
+    { "FixedImagePyramid", { "FixedSmoothingImagePyramid" } },
+    { "ImageSampler", { "Full" } },
+    { "Interpolator", { "BSplineInterpolator" } },
+    { "MaximumNumberOfIterations", { "2" } },
+    { "Metric", { "AdvancedMeanSquares" } },
+    { "MovingImageDimension", { "2" } },
+    { "MovingImagePyramid", { "MovingSmoothingImagePyramid" } },
+    { "NumberOfResolutions", { "2" } },
+    { "Optimizer", { "AdaptiveStochasticGradientDescent" } },
+    { "Registration", { "MultiResolutionRegistration" } },
+    { "ResampleInterpolator", { "FinalBSplineInterpolator" } },
+    { "Resampler", { "DefaultResampler" } },
+    { "Transform", { "TranslationTransform" } },
+    { "UseDisplacementDistributionCache", { "true" } },
+    { "WriteResultImage", { "false" } },
+  };
+
+  // A smooth blob, centered at the given position.
+  const auto makeImage = [](const double centerX, const double centerY)
+  {
+    const auto image = ITKImageType::New();
+    image->SetRegions(itk::Size<2>{ { 16, 16 } });
+    image->Allocate();
+    for (RegionIteratorType it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+    {
+      const double dx = it.GetIndex()[0] - centerX;
+      const double dy = it.GetIndex()[1] - centerY;
+      it.Set(static_cast<float>(std::exp(-(dx * dx + dy * dy) / 8.0)));
+    }
+    return image;
+  };
+
+  const auto countCacheEntries = [&cacheFileName]
+  {
+    std::ifstream file(cacheFileName.c_str());
+    std::string line;
+    unsigned int numberOfLines = 0;
+    while (std::getline(file, line))
+    {
+      ++numberOfLines;
+    }
+    return numberOfLines;
+  };
+
+  const auto fixedImage = makeImage(7.0, 7.0);
+  const auto register_ = [&](const ITKImageType::Pointer & movingImage)
+  {
+    ELASTIX elastix;
+    ASSERT_EQ(elastix.RegisterImages(
+      static_cast<itk::DataObject::Pointer>(fixedImage.GetPointer()),
+      static_cast<itk::DataObject::Pointer>(movingImage.GetPointer()),
+      parameters, ".", false, false), 0);
+  };
+
+  // The first run computes an estimate for each of the two resolutions.
+  register_(makeImage(8.0, 6.0));
+  EXPECT_EQ(countCacheEntries(), 2);
+
+  // The same input again: all estimates come from the cache.
+  register_(makeImage(8.0, 6.0));
+  EXPECT_EQ(countCacheEntries(), 2);
+
+  // A different moving image: the estimates are computed again.
+  register_(makeImage(6.0, 8.0));
+  EXPECT_EQ(countCacheEntries(), 4);
+
+  std::remove(cacheFileName.c_str());
+}
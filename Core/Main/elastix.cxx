@@ -20,7 +20,47 @@
 #include "elxElastixMain.h"
 
 #include <cstddef> // For size_t.
+#include <fstream>
 #include <limits>
+#include <sstream>
+
+/** The fixed image(s) and mask(s) of a previous registration, and the data that
+ * was computed from them, which are reused by the next job in batch mode, see RunJobs().
+ * The fixed images and masks are identified by their file names (the key), the
+ * computed data by their settings, see FixedImageDataCache. The data cache is
+ * null outside batch mode, where there is no next job to reuse it.
+ */
+struct FixedImageCache
+{
+  std::string                                  m_Key;
+  elx::ElastixMain::DataObjectContainerPointer m_FixedImageContainer;
+  elx::ElastixMain::DataObjectContainerPointer m_FixedMaskContainer;
+  elx::ElastixMain::FlatDirectionCosinesType   m_FixedImageOriginalDirection;
+  elx::ElastixMain::FixedImageDataCachePointer m_FixedImageDataCache;
+};
+
+/** Append a '/' to the output folder, if necessary. */
+std::string MakeOutputFolderName( std::string value );
+
+/** Check that the output folder exists, and setup xout to log to it. */
+int SetupOutputFolder( const std::string & outFolder );
+
+/** Print where elastix was run. */
+void PrintSystemInformation( const char * argv0 );
+
+/** Get a key that identifies the fixed images and masks of a run. */
+std::string GetFixedImageCacheKey( const elx::ElastixMain::ArgumentMapType & argMap );
+
+/** Run the registrations with all parameter files, for one moving image. */
+int RunRegistrations( elx::ElastixMain::ArgumentMapType argMap,
+  std::queue< std::pair< std::string, std::string > > parameterFileList,
+  const unsigned long nrOfParameterFiles,
+  FixedImageCache & fixedImageCache );
+
+/** Run all jobs of the job file given by "-jobs", see PrintHelp(). */
+int RunJobs( const elx::ElastixMain::ArgumentMapType & argMap,
+  const std::queue< std::pair< std::string, std::string > > & parameterFileList,
+  const unsigned long nrOfParameterFiles );
 
 int
 main( int argc, char ** argv )
@@ -99,13 +139,7 @@ main( int argc, char ** argv )
   }
 
   /** Some typedef's. */
-  typedef elx::ElastixMain                            ElastixMainType;
-  typedef ElastixMainType::Pointer                    ElastixMainPointer;
-  typedef std::vector< ElastixMainPointer >           ElastixMainVectorType;
-  typedef ElastixMainType::ObjectPointer              ObjectPointer;
-  typedef ElastixMainType::DataObjectContainerPointer DataObjectContainerPointer;
-  typedef ElastixMainType::FlatDirectionCosinesType   FlatDirectionCosinesType;
-
+  typedef elx::ElastixMain                 ElastixMainType;
   typedef ElastixMainType::ArgumentMapType ArgumentMapType;
   typedef ArgumentMapType::value_type      ArgumentMapEntryType;
 
@@ -117,23 +151,12 @@ main( int argc, char ** argv )
   RegisterMevisDicomTiff();
 
   /** Some declarations and initializations. */
-  ElastixMainVectorType elastices;
-
-  // Note that the following pointers are "smart", so they are defaulted-constructed to null.
-  ObjectPointer              transform;
-  DataObjectContainerPointer fixedImageContainer;
-  DataObjectContainerPointer movingImageContainer;
-  DataObjectContainerPointer fixedMaskContainer;
-  DataObjectContainerPointer movingMaskContainer;
-
-  FlatDirectionCosinesType   fixedImageOriginalDirection;
-  int                        returndummy        = 0;
-  unsigned long              nrOfParameterFiles = 0;
-  ArgumentMapType            argMap;
-  ParameterFileListType      parameterFileList;
-  bool                       outFolderPresent = false;
-  std::string                outFolder        = "";
-  std::string                logFileName      = "";
+  int                   returndummy        = 0;
+  unsigned long         nrOfParameterFiles = 0;
+  ArgumentMapType       argMap;
+  ParameterFileListType parameterFileList;
+  bool                  outFolderPresent = false;
+  std::string           outFolder        = "";
 
   /** Put command line parameters into parameterFileList. */
   for( unsigned int i = 1; static_cast< long >( i ) < ( argc - 1 ); i += 2 )
@@ -159,19 +182,7 @@ main( int argc, char ** argv )
       if( key == "-out" )
       {
         /** Make sure that last character of the output folder equals a '/' or '\'. */
-        const char last = value[ value.size() - 1 ];
-        if( last != '/' && last != '\\' ) { value.append( "/" ); }
-        value = itksys::SystemTools::ConvertToOutputPath( value.c_str() );
-
-        /** Note that on Windows, in case the output folder contains a space,
-         * the path name is double quoted by ConvertToOutputPath, which is undesirable.
-         * So, we remove these quotes again.
-         */
-        if( itksys::SystemTools::StringStartsWith( value.c_str(), "\"" )
-          && itksys::SystemTools::StringEndsWith(   value.c_str(), "\"" ) )
-        {
-          value = value.substr( 1, value.length() - 2 );
-        }
+        value = MakeOutputFolderName( value );
 
         /** Save this information. */
         outFolderPresent = true;
@@ -206,28 +217,24 @@ main( int argc, char ** argv )
     returndummy |= -1;
   }
 
-  /** Check if the -out option is given. */
-  if( outFolderPresent )
+  /** In batch mode, the registrations are given by a job file. */
+  if( argMap.count( "-jobs" ) )
   {
-    /** Check if the output directory exists. */
-    bool outFolderExists = itksys::SystemTools::FileIsDirectory( outFolder.c_str() );
-    if( !outFolderExists )
-    {
-      std::cerr << "ERROR: the output directory \"" << outFolder << "\" does not exist." << std::endl;
-      std::cerr << "You are responsible for creating it." << std::endl;
-      returndummy |= -2;
-    }
-    else
+    if( returndummy )
     {
-      /** Setup xout. */
-      logFileName = outFolder + "elastix.log";
-      int returndummy2 = elx::xoutSetup( logFileName.c_str(), true, true );
-      if( returndummy2 )
-      {
-        std::cerr << "ERROR while setting up xout." << std::endl;
-      }
-      returndummy |= returndummy2;
+      return returndummy;
     }
+    returndummy = RunJobs( argMap, parameterFileList, nrOfParameterFiles );
+
+    /** Close the modules. */
+    ElastixMainType::UnloadComponents();
+    return returndummy;
+  }
+
+  /** Check if the -out option is given. */
+  if( outFolderPresent )
+  {
+    returndummy |= SetupOutputFolder( outFolder );
   }
   else
   {
@@ -249,7 +256,104 @@ main( int argc, char ** argv )
   elxout << "elastix is started at " << GetCurrentDateAndTime() << ".\n" << std::endl;
 
   /** Print where elastix was run. */
-  elxout << "which elastix:   " << argv[ 0 ] << std::endl;
+  PrintSystemInformation( argv[ 0 ] );
+
+  /** Do the (possibly multiple) registration(s). */
+  FixedImageCache fixedImageCache;
+  returndummy = RunRegistrations( argMap, parameterFileList,
+    nrOfParameterFiles, fixedImageCache );
+
+  /** Check for errors. */
+  if( returndummy != 0 )
+  {
+    return returndummy;
+  }
+
+  elxout << "-------------------------------------------------------------------------" << "\n" << std::endl;
+
+  /** Stop totaltimer and print it. */
+  totaltimer.Stop();
+  elxout << "Total time elapsed: "
+         << ConvertSecondsToDHMS( totaltimer.GetMean(), 1 ) << ".\n" << std::endl;
+
+  /**
+   * Make sure all the components that are defined in a Module (.DLL/.so)
+   * are deleted before the modules are closed.
+   */
+  fixedImageCache = FixedImageCache();
+
+  /** Close the modules. */
+  ElastixMainType::UnloadComponents();
+
+  /** Exit and return the error code. */
+  return returndummy;
+
+} // end main
+
+
+/**
+ * ******************* MakeOutputFolderName *********************
+ */
+
+std::string
+MakeOutputFolderName( std::string value )
+{
+  /** Make sure that last character of the output folder equals a '/' or '\'. */
+  const char last = value[ value.size() - 1 ];
+  if( last != '/' && last != '\\' ) { value.append( "/" ); }
+  value = itksys::SystemTools::ConvertToOutputPath( value.c_str() );
+
+  /** Note that on Windows, in case the output folder contains a space,
+   * the path name is double quoted by ConvertToOutputPath, which is undesirable.
+   * So, we remove these quotes again.
+   */
+  if( itksys::SystemTools::StringStartsWith( value.c_str(), "\"" )
+    && itksys::SystemTools::StringEndsWith(   value.c_str(), "\"" ) )
+  {
+    value = value.substr( 1, value.length() - 2 );
+  }
+
+  return value;
+
+} // end MakeOutputFolderName()
+
+
+/**
+ * ******************* SetupOutputFolder ************************
+ */
+
+int
+SetupOutputFolder( const std::string & outFolder )
+{
+  /** Check if the output directory exists. */
+  bool outFolderExists = itksys::SystemTools::FileIsDirectory( outFolder.c_str() );
+  if( !outFolderExists )
+  {
+    std::cerr << "ERROR: the output directory \"" << outFolder << "\" does not exist." << std::endl;
+    std::cerr << "You are responsible for creating it." << std::endl;
+    return -2;
+  }
+
+  /** Setup xout. */
+  const std::string logFileName  = outFolder + "elastix.log";
+  int               returndummy2 = elx::xoutSetup( logFileName.c_str(), true, true );
+  if( returndummy2 )
+  {
+    std::cerr << "ERROR while setting up xout." << std::endl;
+  }
+  return returndummy2;
+
+} // end SetupOutputFolder()
+
+
+/**
+ * ******************* PrintSystemInformation *******************
+ */
+
+void
+PrintSystemInformation( const char * argv0 )
+{
+  elxout << "which elastix:   " << argv0 << std::endl;
   itksys::SystemInformation info;
   info.RunCPUCheck();
   info.RunOSCheck();
@@ -263,6 +367,89 @@ main( int argc, char ** argv )
          << static_cast< unsigned int >( info.GetProcessorClockFrequency() )
          << " MHz." << std::endl;
 
+} // end PrintSystemInformation()
+
+
+/**
+ * ******************* GetFixedImageCacheKey ********************
+ */
+
+std::string
+GetFixedImageCacheKey( const elx::ElastixMain::ArgumentMapType & argMap )
+{
+  /** The fixed images and masks are identified by their file names,
+   * i.e. by the arguments -f, -f0, -f1, ..., -fMask, -fMask0, ...
+   * The direction cosines of the loaded images depend on the first
+   * parameter file, which is the same for all jobs.
+   */
+  std::string key = "";
+  elx::ElastixMain::ArgumentMapType::const_iterator it;
+  for( it = argMap.begin(); it != argMap.end(); ++it )
+  {
+    if( itksys::SystemTools::StringStartsWith( it->first.c_str(), "-f" ) )
+    {
+      key += it->first + "=" + it->second + ";";
+    }
+  }
+  return key;
+
+} // end GetFixedImageCacheKey()
+
+
+/**
+ * ******************* RunRegistrations *************************
+ */
+
+int
+RunRegistrations( elx::ElastixMain::ArgumentMapType argMap,
+  std::queue< std::pair< std::string, std::string > > parameterFileList,
+  const unsigned long nrOfParameterFiles,
+  FixedImageCache & fixedImageCache )
+{
+  /** Some typedef's. */
+  typedef elx::ElastixMain                            ElastixMainType;
+  typedef ElastixMainType::Pointer                    ElastixMainPointer;
+  typedef std::vector< ElastixMainPointer >           ElastixMainVectorType;
+  typedef ElastixMainType::ObjectPointer              ObjectPointer;
+  typedef ElastixMainType::DataObjectContainerPointer DataObjectContainerPointer;
+  typedef ElastixMainType::FixedImageDataCachePointer FixedImageDataCachePointer;
+  typedef ElastixMainType::FlatDirectionCosinesType   FlatDirectionCosinesType;
+  typedef ElastixMainType::ArgumentMapType            ArgumentMapType;
+  typedef ArgumentMapType::value_type                 ArgumentMapEntryType;
+  typedef std::pair< std::string, std::string >       ArgPairType;
+
+  /** Some declarations and initializations. */
+  ElastixMainVectorType elastices;
+
+  // Note that the following pointers are "smart", so they are defaulted-constructed to null.
+  ObjectPointer              transform;
+  DataObjectContainerPointer fixedImageContainer;
+  DataObjectContainerPointer movingImageContainer;
+  DataObjectContainerPointer fixedMaskContainer;
+  DataObjectContainerPointer movingMaskContainer;
+  FixedImageDataCachePointer fixedImageDataCache;
+
+  FlatDirectionCosinesType fixedImageOriginalDirection;
+  int                      returndummy = 0;
+
+  /** Reuse the fixed image and mask of a previous run, if they were
+   * read from the same files, and the data computed from them. Otherwise
+   * that data is of no use anymore.
+   */
+  const std::string fixedImageCacheKey = GetFixedImageCacheKey( argMap );
+  fixedImageDataCache = fixedImageCache.m_FixedImageDataCache;
+  if( fixedImageCache.m_Key == fixedImageCacheKey && fixedImageCache.m_FixedImageContainer )
+  {
+    elxout << "Reusing the fixed image(s) and mask(s) of the previous job.\n" << std::endl;
+    fixedImageContainer         = fixedImageCache.m_FixedImageContainer;
+    fixedMaskContainer          = fixedImageCache.m_FixedMaskContainer;
+    fixedImageOriginalDirection = fixedImageCache.m_FixedImageOriginalDirection;
+  }
+  else if( fixedImageDataCache )
+  {
+    fixedImageDataCache->Clear();
+  }
+
   /**
    * ********************* START REGISTRATION *********************
    *
@@ -280,6 +467,7 @@ main( int argc, char ** argv )
     elastices[ i ]->SetMovingImageContainer( movingImageContainer );
     elastices[ i ]->SetFixedMaskContainer( fixedMaskContainer );
     elastices[ i ]->SetMovingMaskContainer( movingMaskContainer );
+    elastices[ i ]->SetFixedImageDataCache( fixedImageDataCache );
     elastices[ i ]->SetOriginalFixedImageDirectionFlat( fixedImageOriginalDirection );
 
     /** Set the current elastix-level. */
@@ -344,36 +532,150 @@ main( int argc, char ** argv )
 
   } // end loop over registrations
 
-  elxout << "-------------------------------------------------------------------------" << "\n" << std::endl;
+  /** Keep the fixed image and mask for a next job. */
+  fixedImageCache.m_Key                         = fixedImageCacheKey;
+  fixedImageCache.m_FixedImageContainer         = fixedImageContainer;
+  fixedImageCache.m_FixedMaskContainer          = fixedMaskContainer;
+  fixedImageCache.m_FixedImageOriginalDirection = fixedImageOriginalDirection;
 
-  /** Stop totaltimer and print it. */
-  totaltimer.Stop();
-  elxout << "Total time elapsed: "
-         << ConvertSecondsToDHMS( totaltimer.GetMean(), 1 ) << ".\n" << std::endl;
+  return returndummy;
 
-  /**
-   * Make sure all the components that are defined in a Module (.DLL/.so)
-   * are deleted before the modules are closed.
-   */
+} // end RunRegistrations()
 
-  for( unsigned int i = 0; i < nrOfParameterFiles; i++ )
+
+/**
+ * ******************* RunJobs **********************************
+ */
+
+int
+RunJobs( const elx::ElastixMain::ArgumentMapType & argMap,
+  const std::queue< std::pair< std::string, std::string > > & parameterFileList,
+  const unsigned long nrOfParameterFiles )
+{
+  typedef elx::ElastixMain::ArgumentMapType ArgumentMapType;
+
+  /** Open the job file, or read the jobs from the standard input. */
+  const std::string jobFileName = argMap.find( "-jobs" )->second;
+  std::ifstream     jobFile;
+  std::istream *    jobStream = &std::cin;
+  if( jobFileName != "-" )
   {
-    elastices[ i ] = 0;
+    jobFile.open( jobFileName.c_str() );
+    if( !jobFile.is_open() )
+    {
+      std::cerr << "ERROR: the job file \"" << jobFileName << "\" cannot be opened." << std::endl;
+      return -1;
+    }
+    jobStream = &jobFile;
   }
 
-  transform            = 0;
-  fixedImageContainer  = 0;
-  movingImageContainer = 0;
-  fixedMaskContainer   = 0;
-  movingMaskContainer  = 0;
+  /** The fixed image and mask are kept between the jobs, and the
+   * components are only loaded once, for all jobs. The eroded fixed masks,
+   * the fixed pyramid images and the Full/Grid samples are kept as well,
+   * and reused by the jobs with the same settings, unless the parameter
+   * CacheFixedImageData is "false".
+   *
+   * The jobs run one after the other. The log (xout), the component database
+   * and the global number of threads belong to the process, so two jobs in
+   * one process cannot run at the same time. A single job already uses all
+   * threads; start several processes to run jobs at the same time.
+   */
+  FixedImageCache fixedImageCache;
+  unsigned long   jobNumber          = 0;
+  unsigned long   numberOfFailedJobs = 0;
+  std::string     line;
+  fixedImageCache.m_FixedImageDataCache = elx::ElastixMain::FixedImageDataCacheType::New();
+  while( std::getline( *jobStream, line ) )
+  {
+    /** Skip empty lines and comments. */
+    std::istringstream lineStream( line );
+    std::string        key;
+    if( !( lineStream >> key ) || key[ 0 ] == '/' || key[ 0 ] == '#' )
+    {
+      continue;
+    }
+    ++jobNumber;
+
+    /** The arguments of a job add to, or replace, the command line arguments. */
+    ArgumentMapType jobArgMap = argMap;
+    jobArgMap.erase( "-jobs" );
+    bool        validJob = true;
+    std::string value;
+    do
+    {
+      if( !( lineStream >> value ) || key == "-p" || key == "-jobs" )
+      {
+        validJob = false;
+        break;
+      }
+      if( key == "-out" )
+      {
+        value = MakeOutputFolderName( value );
+      }
+      jobArgMap[ key ] = value;
+    }
+    while( lineStream >> key );
 
-  /** Close the modules. */
-  ElastixMainType::UnloadComponents();
+    if( !validJob || jobArgMap.count( "-out" ) == 0 )
+    {
+      std::cerr << "ERROR: job " << jobNumber << " is skipped. A job should consist of pairs of "
+                << "arguments other than \"-p\" and \"-jobs\", including \"-out\":\n  "
+                << line << std::endl;
+      ++numberOfFailedJobs;
+      continue;
+    }
 
-  /** Exit and return the error code. */
-  return returndummy;
+    /** Each job writes its own log file. */
+    if( SetupOutputFolder( jobArgMap[ "-out" ] ) != 0 )
+    {
+      std::cerr << "ERROR: job " << jobNumber << " is skipped." << std::endl;
+      ++numberOfFailedJobs;
+      continue;
+    }
 
-} // end main
+    elxout << std::endl;
+    itk::TimeProbe totaltimer;
+    totaltimer.Start();
+    elxout << "elastix job " << jobNumber << " is started at "
+           << GetCurrentDateAndTime() << ".\n" << std::endl;
+    PrintSystemInformation( jobArgMap[ "-argv0" ].c_str() );
+
+    /** Run the job. An error does not stop the remaining jobs. */
+    int returndummy = 1;
+    try
+    {
+      returndummy = RunRegistrations( jobArgMap, parameterFileList,
+        nrOfParameterFiles, fixedImageCache );
+    }
+    catch( itk::ExceptionObject & excp )
+    {
+      xl::xout[ "error" ] << excp << std::endl;
+    }
+    if( returndummy != 0 )
+    {
+      std::cerr << "ERROR: job " << jobNumber << " failed, see "
+                << jobArgMap[ "-out" ] << "elastix.log." << std::endl;
+      ++numberOfFailedJobs;
+
+      /** Do not reuse possibly incomplete data. */
+      fixedImageCache = FixedImageCache();
+      fixedImageCache.m_FixedImageDataCache = elx::ElastixMain::FixedImageDataCacheType::New();
+      continue;
+    }
+
+    elxout << "-------------------------------------------------------------------------" << "\n" << std::endl;
+    totaltimer.Stop();
+    elxout << "Total time elapsed for job " << jobNumber << ": "
+           << ConvertSecondsToDHMS( totaltimer.GetMean(), 1 ) << ".\n" << std::endl;
+
+  } // end while over jobs
+
+  std::cout << "elastix finished " << jobNumber - numberOfFailedJobs
+            << " of " << jobNumber << " jobs successfully." << std::endl;
+
+  return numberOfFailedJobs == 0 ? 0 : 1;
+
+} // end RunJobs()
 
 
 /**
@@ -411,7 +713,17 @@ PrintHelp( void )
   std::cout << "  -t0       parameter file for initial transform\n";
   std::cout << "  -priority set the process priority to high, abovenormal, normal (default),\n"
             << "            belownormal, or idle (Windows only option)\n";
-  std::cout << "  -threads  set the maximum number of threads of elastix\n"
+  std::cout << "  -threads  set the maximum number of threads of elastix\n";
+  std::cout << "  -jobs     batch mode: run one registration per line of this job file,\n"
+            << "            or per line of the standard input for \"-jobs -\". A line holds\n"
+            << "            the arguments of that job, e.g. \"-m moving1.mhd -out out1/\",\n"
+            << "            which add to the command line arguments. The fixed image and\n"
+            << "            mask are read only once, for all jobs with the same \"-f\".\n"
+            << "            The eroded fixed masks, the fixed pyramid images and the samples\n"
+            << "            of the Full and Grid samplers are computed only once, for the\n"
+            << "            consecutive jobs with the same fixed image, mask and settings;\n"
+            << "            add (CacheFixedImageData \"false\") to the parameter file to\n"
+            << "            compute them for each job. The jobs run one after the other.\n"
             << std::endl;
 
   /** The parameter file.*/
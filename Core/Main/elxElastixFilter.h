@@ -57,6 +57,8 @@ public:
   typedef ElastixMainType::ArgumentMapType          ArgumentMapType;
   typedef ArgumentMapType::value_type               ArgumentMapEntryType;
   typedef ElastixMainType::FlatDirectionCosinesType FlatDirectionCosinesType;
+  typedef ElastixMainType::FixedImageDataCacheType    FixedImageDataCacheType;
+  typedef ElastixMainType::FixedImageDataCachePointer FixedImageDataCachePointer;
 
   typedef ElastixMainType::DataObjectContainerType           DataObjectContainerType;
   typedef ElastixMainType::DataObjectContainerPointer        DataObjectContainerPointer;
@@ -117,6 +119,30 @@ public:
   virtual void RemoveMovingMask( void );
   unsigned int GetNumberOfMovingMasks( void ) const;
 
+  /** Add/NumberOf/Remove batch moving images. Each batch moving image is
+   * registered independently to the fixed image(s), with the same parameter
+   * maps, fixed mask(s) and number of threads. The fixed images and masks are
+   * read once for the whole batch. The eroded fixed masks, the fixed pyramid
+   * images and the samples of the Full and Grid samplers are computed once, see
+   * the parameter CacheFixedImageData. The registrations run one after the other,
+   * each with all threads; see GenerateData(). Adding a batch moving image replaces
+   * the moving image(s); moving masks are not supported in batch mode.
+   *
+   * With an output directory, the output of the i-th registration is written
+   * to its own subdirectory "batch<i>/", which is created if necessary. The
+   * log file stays in the output directory itself.
+   */
+  virtual void AddBatchMovingImage( TMovingImage * movingImage );
+  unsigned int GetNumberOfBatchMovingImages( void ) const;
+  virtual void RemoveBatchMovingImages( void );
+
+  /** Get the result image and the transform parameter object of the
+   * registration of a batch moving image. The primary outputs are those
+   * of the first batch moving image.
+   */
+  TFixedImage * GetBatchResultImage( const unsigned int index ) const;
+  ParameterObjectType * GetBatchTransformParameterObject( const unsigned int index ) const;
+
   /** Set/Get parameter object.*/
   virtual void SetParameterObject( ParameterObjectType * parameterObject );
   ParameterObjectType * GetParameterObject( void );
@@ -188,6 +214,20 @@ private:
   /** RemoveInputsOfType. */
   void RemoveInputsOfType( const DataObjectIdentifierType & inputName );
 
+  /** Run the registrations of all parameter maps, for one (set of) moving image(s).
+   * The fixed image, fixed mask and result image containers are updated.
+   * The data computed from the fixed images is shared through m_FixedImageDataCache.
+   */
+  void RunRegistrations( const ArgumentMapType & argumentMap,
+    const ParameterMapVectorType & parameterMapVector,
+    DataObjectContainerPointer & fixedImageContainer,
+    DataObjectContainerPointer & fixedMaskContainer,
+    FlatDirectionCosinesType & fixedImageOriginalDirection,
+    DataObjectContainerPointer movingImageContainer,
+    DataObjectContainerPointer movingMaskContainer,
+    DataObjectContainerPointer & resultImageContainer,
+    ParameterMapVectorType & transformParameterMapVector );
+
   std::string m_InitialTransformParameterFileName;
   std::string m_FixedPointSetFileName;
   std::string m_MovingPointSetFileName;
@@ -202,6 +242,15 @@ private:
 
   unsigned int m_InputUID;
 
+  std::vector< DataObjectIdentifierType > m_BatchMovingImageNames;
+  std::vector< FixedImagePointer >        m_BatchResultImages;
+  std::vector< ParameterObjectPointer >   m_BatchTransformParameterObjects;
+
+  /** The data computed from the fixed images by the registrations of one batch.
+   * Null outside batch mode.
+   */
+  FixedImageDataCachePointer m_FixedImageDataCache;
+
 };
 
 } // namespace elx
@@ -79,7 +79,6 @@ ElastixFilter< TFixedImage, TMovingImage >
   DataObjectContainerPointer fixedMaskContainer   = nullptr;
   DataObjectContainerPointer movingMaskContainer  = nullptr;
   DataObjectContainerPointer resultImageContainer = nullptr;
-  ElastixMainObjectPointer   transform            = nullptr;
   ParameterMapVectorType     transformParameterMapVector;
   FlatDirectionCosinesType   fixedImageOriginalDirection;
 
@@ -204,10 +203,9 @@ ElastixFilter< TFixedImage, TMovingImage >
     itkExceptionMacro( "Error while setting up xout" );
   }
 
-  // Run the (possibly multiple) registration(s)
+  // Set image dimension from input images (overrides user settings)
   for( unsigned int i = 0; i < parameterMapVector.size(); ++i )
   {
-    // Set image dimension from input images (overrides user settings)
     parameterMapVector[ i ][ "FixedImageDimension" ]
       = ParameterValueVectorType( 1, std::to_string( fixedImageDimension ) ) ;
     parameterMapVector[ i ][ "MovingImageDimension" ]
@@ -220,7 +218,120 @@ ElastixFilter< TFixedImage, TMovingImage >
     {
       parameterMapVector[ i ][ "InitialTransformParametersFileName" ] = ParameterValueVectorType( 1, "NoInitialTransform" );
     }
+  }
+
+  this->m_BatchResultImages.clear();
+  this->m_BatchTransformParameterObjects.clear();
+  this->m_FixedImageDataCache = nullptr;
+  if( this->m_BatchMovingImageNames.empty() )
+  {
+    // A single (possibly multi-image) registration
+    this->RunRegistrations( argumentMap, parameterMapVector,
+      fixedImageContainer, fixedMaskContainer, fixedImageOriginalDirection,
+      movingImageContainer, movingMaskContainer,
+      resultImageContainer, transformParameterMapVector );
+  }
+  else
+  {
+    if( movingMaskContainer.IsNotNull() )
+    {
+      itkExceptionMacro( "Moving masks can not be combined with batch moving images." );
+    }
+
+    // The eroded fixed masks, the fixed pyramid images and the samples of the
+    // deterministic samplers are computed once, for the whole batch
+    this->m_FixedImageDataCache = FixedImageDataCacheType::New();
+
+    // Independent registrations of each batch moving image to the same fixed image(s).
+    // The fixed images, masks and original direction are passed from one registration
+    // to the next, like from one parameter map to the next, and so is the data computed
+    // from them, through m_FixedImageDataCache. The registrations run one after the
+    // other: each of them is multi-threaded already, and the log and the component
+    // database are process-wide, so they can not run side by side.
+    for( unsigned int j = 0; j < this->m_BatchMovingImageNames.size(); ++j )
+    {
+      // Give each registration its own output directory, so that their
+      // result and transform parameter files do not overwrite each other
+      ArgumentMapType batchArgumentMap = argumentMap;
+      if( !this->GetOutputDirectory().empty() )
+      {
+        const std::string batchOutputDirectory
+          = this->GetOutputDirectory() + "batch" + std::to_string( j ) + "/";
+        if( !itksys::SystemTools::MakeDirectory( batchOutputDirectory ) )
+        {
+          itkExceptionMacro( "Output directory \"" << batchOutputDirectory << "\" could not be created." );
+        }
+        batchArgumentMap[ "-out" ] = batchOutputDirectory;
+      }
+
+      DataObjectContainerPointer batchMovingImageContainer = DataObjectContainerType::New();
+      batchMovingImageContainer->push_back( this->GetInput( this->m_BatchMovingImageNames[ j ] ) );
+      DataObjectContainerPointer batchResultImageContainer = nullptr;
+      ParameterMapVectorType     batchTransformParameterMapVector;
+
+      this->RunRegistrations( batchArgumentMap, parameterMapVector,
+        fixedImageContainer, fixedMaskContainer, fixedImageOriginalDirection,
+        batchMovingImageContainer, nullptr,
+        batchResultImageContainer, batchTransformParameterMapVector );
+
+      FixedImagePointer batchResultImage = dynamic_cast< TFixedImage * >(
+        batchResultImageContainer->ElementAt( 0 ).GetPointer() );
+      ParameterObjectPointer batchTransformParameterObject = ParameterObject::New();
+      batchTransformParameterObject->SetParameterMap( batchTransformParameterMapVector );
+      this->m_BatchResultImages.push_back( batchResultImage );
+      this->m_BatchTransformParameterObjects.push_back( batchTransformParameterObject );
+
+      // The primary outputs are those of the first registration of the batch
+      if( j == 0 )
+      {
+        resultImageContainer        = batchResultImageContainer;
+        transformParameterMapVector = batchTransformParameterMapVector;
+      }
+    }
+
+    // Release the data computed from the fixed images
+    this->m_FixedImageDataCache = nullptr;
+  }
+
+  // Save result image
+  if( resultImageContainer.IsNotNull() && resultImageContainer->Size() > 0 && resultImageContainer->ElementAt( 0 ).IsNotNull() )
+  {
+    this->GraftOutput( "ResultImage", resultImageContainer->ElementAt( 0 ) );
+  }
+  else
+  {
+    itkExceptionMacro( "Errors occured during registration: Could not read result image." );
+  }
 
+  // Save parameter map
+  ParameterObject::Pointer transformParameterObject = ParameterObject::New();
+  transformParameterObject->SetParameterMap( transformParameterMapVector );
+  this->SetOutput( "TransformParameterObject", transformParameterObject );
+}
+
+
+/**
+ * ********************* RunRegistrations *********************
+ */
+
+template< typename TFixedImage, typename TMovingImage >
+void
+ElastixFilter< TFixedImage, TMovingImage >
+::RunRegistrations( const ArgumentMapType & argumentMap,
+  const ParameterMapVectorType & parameterMapVector,
+  DataObjectContainerPointer & fixedImageContainer,
+  DataObjectContainerPointer & fixedMaskContainer,
+  FlatDirectionCosinesType & fixedImageOriginalDirection,
+  DataObjectContainerPointer movingImageContainer,
+  DataObjectContainerPointer movingMaskContainer,
+  DataObjectContainerPointer & resultImageContainer,
+  ParameterMapVectorType & transformParameterMapVector )
+{
+  ElastixMainObjectPointer transform = nullptr;
+
+  // Run the (possibly multiple) registration(s)
+  for( unsigned int i = 0; i < parameterMapVector.size(); ++i )
+  {
     // Create new instance of ElastixMain
     ElastixMainPointer elastix = ElastixMainType::New();
 
@@ -234,6 +345,7 @@ ElastixFilter< TFixedImage, TMovingImage >
     elastix->SetMovingImageContainer( movingImageContainer );
     elastix->SetFixedMaskContainer( fixedMaskContainer );
     elastix->SetMovingMaskContainer( movingMaskContainer );
+    elastix->SetFixedImageDataCache( this->m_FixedImageDataCache );
     elastix->SetResultImageContainer( resultImageContainer );
     elastix->SetOriginalFixedImageDirectionFlat( fixedImageOriginalDirection );
 
@@ -270,25 +382,17 @@ ElastixFilter< TFixedImage, TMovingImage >
     }
 
     // TODO: Fix elastix corrupting default pixel value parameter
+    const ParameterMapType::const_iterator defaultPixelValue = parameterMapVector[ i ].find( "DefaultPixelValue" );
     transformParameterMapVector[ transformParameterMapVector.size() - 1 ][ "DefaultPixelValue" ]
-      = parameterMapVector[ i ][ "DefaultPixelValue" ];
+      = defaultPixelValue != parameterMapVector[ i ].end() ? defaultPixelValue->second : ParameterValueVectorType();
   } // End loop over registrations
 
-  // Save result image
-  if( resultImageContainer.IsNotNull() && resultImageContainer->Size() > 0 && resultImageContainer->ElementAt( 0 ).IsNotNull() )
-  {
-    this->GraftOutput( "ResultImage", resultImageContainer->ElementAt( 0 ) );
-  }
-  else
+  if( resultImageContainer.IsNull() || resultImageContainer->Size() == 0 || resultImageContainer->ElementAt( 0 ).IsNull() )
   {
     itkExceptionMacro( "Errors occured during registration: Could not read result image." );
   }
 
-  // Save parameter map
-  ParameterObject::Pointer transformParameterObject = ParameterObject::New();
-  transformParameterObject->SetParameterMap( transformParameterMapVector );
-  this->SetOutput( "TransformParameterObject", transformParameterObject );
-}
+} // end RunRegistrations()
 
 
 /**
@@ -773,6 +877,97 @@ ElastixFilter< TFixedImage, TMovingImage >
 } // end RemoveLogFileName()
 
 
+/**
+ * ********************* AddBatchMovingImage *********************
+ */
+
+template< typename TFixedImage, typename TMovingImage >
+void
+ElastixFilter< TFixedImage, TMovingImage >
+::AddBatchMovingImage( TMovingImage * movingImage )
+{
+  // In batch mode the moving images are given by the batch moving images only
+  if( this->m_BatchMovingImageNames.empty() )
+  {
+    this->RemoveInputsOfType( "MovingImage" );
+    this->RemoveRequiredInputName( "MovingImage" );
+  }
+
+  const DataObjectIdentifierType name = this->MakeUniqueName( "BatchMovingImage" );
+  this->SetInput( name, movingImage );
+  this->m_BatchMovingImageNames.push_back( name );
+} // end AddBatchMovingImage()
+
+
+/**
+ * ********************* GetNumberOfBatchMovingImages *********************
+ */
+
+template< typename TFixedImage, typename TMovingImage >
+unsigned int
+ElastixFilter< TFixedImage, TMovingImage >
+::GetNumberOfBatchMovingImages( void ) const
+{
+  return this->m_BatchMovingImageNames.size();
+} // end GetNumberOfBatchMovingImages()
+
+
+/**
+ * ********************* RemoveBatchMovingImages *********************
+ */
+
+template< typename TFixedImage, typename TMovingImage >
+void
+ElastixFilter< TFixedImage, TMovingImage >
+::RemoveBatchMovingImages( void )
+{
+  for( unsigned int i = 0; i < this->m_BatchMovingImageNames.size(); ++i )
+  {
+    this->RemoveInput( this->m_BatchMovingImageNames[ i ] );
+  }
+  this->m_BatchMovingImageNames.clear();
+  this->m_BatchResultImages.clear();
+  this->m_BatchTransformParameterObjects.clear();
+  this->AddRequiredInputName( "MovingImage" );
+} // end RemoveBatchMovingImages()
+
+
+/**
+ * ********************* GetBatchResultImage *********************
+ */
+
+template< typename TFixedImage, typename TMovingImage >
+TFixedImage *
+ElastixFilter< TFixedImage, TMovingImage >
+::GetBatchResultImage( const unsigned int index ) const
+{
+  if( index >= this->m_BatchResultImages.size() )
+  {
+    itkExceptionMacro( "Batch result image " << index << " has not been generated. Update() ElastixFilter before requesting this output." );
+  }
+
+  return this->m_BatchResultImages[ index ].GetPointer();
+} // end GetBatchResultImage()
+
+
+/**
+ * ********************* GetBatchTransformParameterObject *********************
+ */
+
+template< typename TFixedImage, typename TMovingImage >
+typename ElastixFilter< TFixedImage, TMovingImage >::ParameterObjectType *
+ElastixFilter< TFixedImage, TMovingImage >
+::GetBatchTransformParameterObject( const unsigned int index ) const
+{
+  if( index >= this->m_BatchTransformParameterObjects.size() )
+  {
+    itkExceptionMacro( "Batch transform parameter object " << index << " has not been generated. Update() ElastixFilter before requesting this output." );
+  }
+
+  return this->m_BatchTransformParameterObjects[ index ].GetPointer();
+} // end GetBatchTransformParameterObject()
+
+
 /**
  * ********************* MakeUniqueName *********************
  */
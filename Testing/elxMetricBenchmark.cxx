@@ -0,0 +1,570 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+/** \file
+ \brief Benchmark the metric GetValueAndDerivative() for combinations of
+ metrics, transforms, samplers and interpolators, on synthetic data.
+
+ The results are written as JSON, one record per combination and number
+ of threads, with the time per sample, the throughput and the scaling
+ efficiency relative to the first number of threads.
+
+ The metrics run multi-threaded. After the timed calls, the value and
+ derivative are compared with a single-threaded evaluation on the same
+ samples; the benchmark fails when they differ by more than -tolerance.
+ */
+#include "itkCommandLineArgumentParser.h"
+
+#include "AdvancedMeanSquares/itkAdvancedMeanSquaresImageToImageMetric.h"
+#include "AdvancedNormalizedCorrelation/itkAdvancedNormalizedCorrelationImageToImageMetric.h"
+#include "AdvancedMattesMutualInformation/itkParzenWindowMutualInformationImageToImageMetric.h"
+#include "NormalizedMutualInformation/itkParzenWindowNormalizedMutualInformationImageToImageMetric.h"
+
+#include "itkAdvancedTranslationTransform.h"
+#include "itkAdvancedEuler3DTransform.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkRecursiveBSplineTransform.h"
+
+#include "itkImageFullSampler.h"
+#include "itkImageGridSampler.h"
+#include "itkImageRandomSampler.h"
+
+#include "itkAdvancedLinearInterpolateImageFunction.h"
+#include "itkBSplineInterpolateImageFunction.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTimeProbe.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/** Typedefs. */
+const unsigned int Dimension = 3;
+typedef itk::Image< float, Dimension >                            ImageType;
+typedef itk::AdvancedImageToImageMetric< ImageType, ImageType >   MetricType;
+typedef itk::ParzenWindowHistogramImageToImageMetric<
+  ImageType, ImageType >                                          HistogramMetricType;
+typedef MetricType::AdvancedTransformType                         TransformType;
+typedef MetricType::ImageSamplerType                              SamplerType;
+typedef MetricType::InterpolatorType                              InterpolatorType;
+typedef MetricType::ParametersType                                ParametersType;
+typedef MetricType::DerivativeType                                DerivativeType;
+typedef MetricType::MeasureType                                   MeasureType;
+
+/** The result of one benchmark run. */
+struct BenchmarkResult
+{
+  std::string   Metric;
+  std::string   Transform;
+  std::string   Sampler;
+  std::string   Interpolator;
+  unsigned int  ImageSize;
+  unsigned int  NumberOfThreads;
+  unsigned long NumberOfSamples;
+  double        Seconds;
+  double        ScalingEfficiency;
+  MeasureType   Value;
+  double        MaximumRelativeDifference;
+};
+
+/**
+ * ******************* GetHelpString *******************
+ */
+
+std::string
+GetHelpString( void )
+{
+  std::stringstream ss;
+  ss << "Usage:" << std::endl
+     << "elastix_benchmarks" << std::endl
+     << "  [-out]           output JSON filename, default: standard output\n"
+     << "  [-size]          image size per dimension, default 64\n"
+     << "  [-threads]       numbers of threads, default 1 2 4\n"
+     << "  [-samples]       number of samples of the random and grid samplers, default 10000\n"
+     << "  [-iterations]    number of timed GetValueAndDerivative calls, default 10\n"
+     << "  [-tolerance]     maximum relative difference with the single-threaded result, default 1e-6\n"
+     << "  [-metric]        metrics: AdvancedMeanSquares AdvancedNormalizedCorrelation\n"
+     << "                   AdvancedMattesMutualInformation NormalizedMutualInformation\n"
+     << "  [-transform]     transforms: Translation Euler BSpline RecursiveBSpline\n"
+     << "  [-sampler]       samplers: Full Random Grid\n"
+     << "  [-interpolator]  interpolators: Linear BSpline\n"
+     << "By default all metrics, transforms, samplers and interpolators are benchmarked.";
+  return ss.str();
+
+} // end GetHelpString()
+
+
+/**
+ * ******************* CreateImage *******************
+ */
+
+ImageType::Pointer
+CreateImage( const unsigned int imageSize, const double shift )
+{
+  ImageType::SizeType size;
+  size.Fill( imageSize );
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( ImageType::RegionType( size ) );
+  image->Allocate();
+
+  /** A smooth pattern, such that all metrics are well-defined. */
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType index = it.GetIndex();
+    double                     value = 0.0;
+    for( unsigned int d = 0; d < Dimension; ++d )
+    {
+      value += std::sin( 0.15 * ( static_cast< double >( index[ d ] ) + shift ) * ( d + 1 ) );
+    }
+    it.Set( static_cast< float >( 100.0 * value ) );
+  }
+
+  return image;
+
+} // end CreateImage()
+
+
+/**
+ * ******************* CreateMetric *******************
+ */
+
+MetricType::Pointer
+CreateMetric( const std::string & name )
+{
+  MetricType::Pointer metric;
+  if( name == "AdvancedMeanSquares" )
+  {
+    metric = itk::AdvancedMeanSquaresImageToImageMetric< ImageType, ImageType >::New().GetPointer();
+  }
+  else if( name == "AdvancedNormalizedCorrelation" )
+  {
+    metric = itk::AdvancedNormalizedCorrelationImageToImageMetric< ImageType, ImageType >::New().GetPointer();
+  }
+  else if( name == "AdvancedMattesMutualInformation" )
+  {
+    metric = itk::ParzenWindowMutualInformationImageToImageMetric< ImageType, ImageType >::New().GetPointer();
+  }
+  else if( name == "NormalizedMutualInformation" )
+  {
+    metric = itk::ParzenWindowNormalizedMutualInformationImageToImageMetric< ImageType, ImageType >::New().GetPointer();
+  }
+
+  /** Settings of the histogram based metrics, as in the elastix defaults. */
+  HistogramMetricType * histogramMetric = dynamic_cast< HistogramMetricType * >( metric.GetPointer() );
+  if( histogramMetric )
+  {
+    histogramMetric->SetNumberOfFixedHistogramBins( 32 );
+    histogramMetric->SetNumberOfMovingHistogramBins( 32 );
+    histogramMetric->SetUseDerivative( true );
+    histogramMetric->SetUseExplicitPDFDerivatives( false );
+  }
+
+  return metric;
+
+} // end CreateMetric()
+
+
+/**
+ * ******************* CreateTransform *******************
+ */
+
+template< class TBSplineTransform >
+TransformType::Pointer
+CreateBSplineTransform( const ImageType * image, ParametersType & parameters )
+{
+  typedef typename TBSplineTransform::RegionType    RegionType;
+  typedef typename TBSplineTransform::SizeType      SizeType;
+  typedef typename TBSplineTransform::SpacingType   SpacingType;
+  typedef typename TBSplineTransform::OriginType    OriginType;
+  typedef typename TBSplineTransform::DirectionType DirectionType;
+
+  /** A control point grid with a spacing of 8 voxels that covers the image. */
+  const double              gridSpacingInVoxels = 8.0;
+  const ImageType::SizeType imageSize           = image->GetLargestPossibleRegion().GetSize();
+  SizeType                  gridSize;
+  SpacingType               gridSpacing;
+  OriginType                gridOrigin;
+  for( unsigned int d = 0; d < Dimension; ++d )
+  {
+    gridSize[ d ]    = static_cast< unsigned int >( ( imageSize[ d ] - 1 ) / gridSpacingInVoxels ) + 4;
+    gridSpacing[ d ] = gridSpacingInVoxels * image->GetSpacing()[ d ];
+    gridOrigin[ d ]  = image->GetOrigin()[ d ] - gridSpacing[ d ];
+  }
+  DirectionType gridDirection;
+  gridDirection.SetIdentity();
+
+  typename TBSplineTransform::Pointer transform = TBSplineTransform::New();
+  transform->SetGridRegion( RegionType( gridSize ) );
+  transform->SetGridSpacing( gridSpacing );
+  transform->SetGridOrigin( gridOrigin );
+  transform->SetGridDirection( gridDirection );
+
+  /** A smooth deformation of a few voxels. */
+  parameters.SetSize( transform->GetNumberOfParameters() );
+  for( unsigned int i = 0; i < parameters.GetSize(); ++i )
+  {
+    parameters[ i ] = 2.0 * std::sin( 0.1 * i );
+  }
+
+  return transform.GetPointer();
+
+} // end CreateBSplineTransform()
+
+
+TransformType::Pointer
+CreateTransform( const std::string & name, const ImageType * image, ParametersType & parameters )
+{
+  if( name == "Translation" )
+  {
+    typedef itk::AdvancedTranslationTransform< double, Dimension > TranslationTransformType;
+    TranslationTransformType::Pointer transform = TranslationTransformType::New();
+    parameters.SetSize( transform->GetNumberOfParameters() );
+    parameters[ 0 ] = 1.0; parameters[ 1 ] = 0.5; parameters[ 2 ] = -0.5;
+    return transform.GetPointer();
+  }
+  else if( name == "Euler" )
+  {
+    typedef itk::AdvancedEuler3DTransform< double > EulerTransformType;
+    EulerTransformType::Pointer transform = EulerTransformType::New();
+    EulerTransformType::InputPointType center;
+    for( unsigned int d = 0; d < Dimension; ++d )
+    {
+      center[ d ] = 0.5 * image->GetLargestPossibleRegion().GetSize()[ d ];
+    }
+    transform->SetCenter( center );
+    parameters.SetSize( transform->GetNumberOfParameters() );
+    parameters[ 0 ] = 0.02; parameters[ 1 ] = -0.01; parameters[ 2 ] = 0.03;
+    parameters[ 3 ] = 1.0;  parameters[ 4 ] = 0.5;   parameters[ 5 ] = -0.5;
+    return transform.GetPointer();
+  }
+  else if( name == "BSpline" )
+  {
+    return CreateBSplineTransform< itk::AdvancedBSplineDeformableTransform< double, Dimension, 3 > >(
+      image, parameters );
+  }
+  else if( name == "RecursiveBSpline" )
+  {
+    return CreateBSplineTransform< itk::RecursiveBSplineTransform< double, Dimension, 3 > >(
+      image, parameters );
+  }
+
+  return 0;
+
+} // end CreateTransform()
+
+
+/**
+ * ******************* CreateSampler *******************
+ */
+
+SamplerType::Pointer
+CreateSampler( const std::string & name, const unsigned long numberOfSamples )
+{
+  if( name == "Full" )
+  {
+    return itk::ImageFullSampler< ImageType >::New().GetPointer();
+  }
+  else if( name == "Random" )
+  {
+    itk::ImageRandomSampler< ImageType >::Pointer sampler = itk::ImageRandomSampler< ImageType >::New();
+    sampler->SetNumberOfSamples( numberOfSamples );
+    return sampler.GetPointer();
+  }
+  else if( name == "Grid" )
+  {
+    itk::ImageGridSampler< ImageType >::Pointer sampler = itk::ImageGridSampler< ImageType >::New();
+    sampler->SetNumberOfSamples( numberOfSamples );
+    return sampler.GetPointer();
+  }
+
+  return 0;
+
+} // end CreateSampler()
+
+
+/**
+ * ******************* CreateInterpolator *******************
+ */
+
+InterpolatorType::Pointer
+CreateInterpolator( const std::string & name )
+{
+  if( name == "Linear" )
+  {
+    return itk::AdvancedLinearInterpolateImageFunction< ImageType, double >::New().GetPointer();
+  }
+  else if( name == "BSpline" )
+  {
+    typedef itk::BSplineInterpolateImageFunction< ImageType, double, double > BSplineInterpolatorType;
+    BSplineInterpolatorType::Pointer interpolator = BSplineInterpolatorType::New();
+    interpolator->SetSplineOrder( 3 );
+    return interpolator.GetPointer();
+  }
+
+  return 0;
+
+} // end CreateInterpolator()
+
+
+/**
+ * ******************* WriteResults *******************
+ */
+
+void
+WriteResults( std::ostream & os, const std::vector< BenchmarkResult > & results )
+{
+  os << "{\n  \"benchmarks\": [";
+  for( std::size_t i = 0; i < results.size(); ++i )
+  {
+    const BenchmarkResult & r = results[ i ];
+    const double nsPerSample = 1.0e9 * r.Seconds / static_cast< double >( r.NumberOfSamples );
+    os << ( i == 0 ? "\n" : ",\n" )
+       << "    { \"metric\": \"" << r.Metric << "\""
+       << ", \"transform\": \"" << r.Transform << "\""
+       << ", \"sampler\": \"" << r.Sampler << "\""
+       << ", \"interpolator\": \"" << r.Interpolator << "\""
+       << ", \"image_size\": " << r.ImageSize
+       << ", \"threads\": " << r.NumberOfThreads
+       << ", \"samples\": " << r.NumberOfSamples
+       << ", \"seconds\": " << r.Seconds
+       << ", \"ns_per_sample\": " << nsPerSample
+       << ", \"samples_per_second\": " << r.NumberOfSamples / r.Seconds
+       << ", \"scaling_efficiency\": " << r.ScalingEfficiency
+       << ", \"value\": " << r.Value
+       << ", \"max_relative_difference\": " << r.MaximumRelativeDifference << " }";
+  }
+  os << "\n  ]\n}" << std::endl;
+
+} // end WriteResults()
+
+
+/**
+ * ******************* main *******************
+ */
+
+int
+main( int argc, char ** argv )
+{
+  itk::CommandLineArgumentParser::Pointer parser = itk::CommandLineArgumentParser::New();
+  parser->SetCommandLineArguments( argc, argv );
+  parser->SetProgramHelpText( GetHelpString() );
+
+  itk::CommandLineArgumentParser::ReturnValue validateArguments = parser->CheckForRequiredArguments();
+  if( validateArguments == itk::CommandLineArgumentParser::FAILED )
+  {
+    return EXIT_FAILURE;
+  }
+  else if( validateArguments == itk::CommandLineArgumentParser::HELPREQUESTED )
+  {
+    return EXIT_SUCCESS;
+  }
+
+  /** Get the arguments. */
+  std::string outputFileName = "";
+  parser->GetCommandLineArgument( "-out", outputFileName );
+  unsigned int imageSize = 64;
+  parser->GetCommandLineArgument( "-size", imageSize );
+  unsigned long numberOfSamples = 10000;
+  parser->GetCommandLineArgument( "-samples", numberOfSamples );
+  unsigned int numberOfIterations = 10;
+  parser->GetCommandLineArgument( "-iterations", numberOfIterations );
+  double tolerance = 1e-6;
+  parser->GetCommandLineArgument( "-tolerance", tolerance );
+
+  /** The parser fills a non-empty vector with a single argument, and keeps
+   * the trailing entries of a longer one, so the defaults are set afterwards.
+   */
+  std::vector< unsigned int > threads;
+  std::vector< std::string >  metrics, transforms, samplers, interpolators;
+  parser->GetCommandLineArgument( "-threads", threads );
+  parser->GetCommandLineArgument( "-metric", metrics );
+  parser->GetCommandLineArgument( "-transform", transforms );
+  parser->GetCommandLineArgument( "-sampler", samplers );
+  parser->GetCommandLineArgument( "-interpolator", interpolators );
+  if( threads.empty() )
+  {
+    threads.push_back( 1 );
+    threads.push_back( 2 );
+    threads.push_back( 4 );
+  }
+  if( metrics.empty() )
+  {
+    metrics.push_back( "AdvancedMeanSquares" );
+    metrics.push_back( "AdvancedNormalizedCorrelation" );
+    metrics.push_back( "AdvancedMattesMutualInformation" );
+    metrics.push_back( "NormalizedMutualInformation" );
+  }
+  if( transforms.empty() )
+  {
+    transforms.push_back( "Translation" );
+    transforms.push_back( "Euler" );
+    transforms.push_back( "BSpline" );
+    transforms.push_back( "RecursiveBSpline" );
+  }
+  if( samplers.empty() )
+  {
+    samplers.push_back( "Full" );
+    samplers.push_back( "Random" );
+    samplers.push_back( "Grid" );
+  }
+  if( interpolators.empty() )
+  {
+    interpolators.push_back( "Linear" );
+    interpolators.push_back( "BSpline" );
+  }
+
+  /** Create the synthetic images. */
+  ImageType::Pointer fixedImage  = CreateImage( imageSize, 0.0 );
+  ImageType::Pointer movingImage = CreateImage( imageSize, 1.5 );
+
+  /** Run all combinations. */
+  std::vector< BenchmarkResult > results;
+  for( std::size_t m = 0; m < metrics.size(); ++m )
+  {
+    for( std::size_t t = 0; t < transforms.size(); ++t )
+    {
+      for( std::size_t s = 0; s < samplers.size(); ++s )
+      {
+        for( std::size_t i = 0; i < interpolators.size(); ++i )
+        {
+          ParametersType            parameters;
+          MetricType::Pointer       metric       = CreateMetric( metrics[ m ] );
+          TransformType::Pointer    transform    = CreateTransform( transforms[ t ], fixedImage, parameters );
+          SamplerType::Pointer      sampler      = CreateSampler( samplers[ s ], numberOfSamples );
+          InterpolatorType::Pointer interpolator = CreateInterpolator( interpolators[ i ] );
+          if( metric.IsNull() || transform.IsNull() || sampler.IsNull() || interpolator.IsNull() )
+          {
+            std::cerr << "ERROR: unknown component in " << metrics[ m ] << " / " << transforms[ t ]
+                      << " / " << samplers[ s ] << " / " << interpolators[ i ] << std::endl;
+            return EXIT_FAILURE;
+          }
+          transform->SetParameters( parameters );
+
+          metric->SetFixedImage( fixedImage );
+          metric->SetMovingImage( movingImage );
+          metric->SetFixedImageRegion( fixedImage->GetLargestPossibleRegion() );
+          metric->SetTransform( transform );
+          metric->SetInterpolator( interpolator );
+          metric->SetImageSampler( sampler );
+
+          double referenceTime = 0.0;
+          for( std::size_t n = 0; n < threads.size(); ++n )
+          {
+            BenchmarkResult result;
+            result.Metric          = metrics[ m ];
+            result.Transform       = transforms[ t ];
+            result.Sampler         = samplers[ s ];
+            result.Interpolator    = interpolators[ i ];
+            result.ImageSize       = imageSize;
+            result.NumberOfThreads = threads[ n ];
+
+            DerivativeType derivative, referenceDerivative;
+            MeasureType    referenceValue;
+            itk::TimeProbe timer;
+            try
+            {
+              metric->SetUseMultiThread( true );
+              metric->SetNumberOfWorkUnits( threads[ n ] );
+              metric->Initialize();
+
+              /** A first call, outside the timing, updates the sampler and caches. */
+              metric->GetValueAndDerivative( parameters, result.Value, derivative );
+              for( unsigned int k = 0; k < numberOfIterations; ++k )
+              {
+                timer.Start();
+                metric->GetValueAndDerivative( parameters, result.Value, derivative );
+                timer.Stop();
+              }
+
+              /** The single-threaded reference, on the same samples. */
+              metric->SetUseMultiThread( false );
+              metric->GetValueAndDerivative( parameters, referenceValue, referenceDerivative );
+            }
+            catch( itk::ExceptionObject & err )
+            {
+              std::cerr << "ERROR: " << result.Metric << " / " << result.Transform << " / "
+                        << result.Sampler << " / " << result.Interpolator << ": " << err << std::endl;
+              return EXIT_FAILURE;
+            }
+
+            result.NumberOfSamples = sampler->GetOutput()->Size();
+            result.Seconds         = timer.GetMean();
+
+            /** Check that the threads reproduce the single-threaded result. The
+             * differences stem from the order of summation only.
+             */
+            result.MaximumRelativeDifference = std::abs( result.Value - referenceValue )
+              / std::max( std::abs( referenceValue ), 1e-12 );
+            const double derivativeNorm = std::max( referenceDerivative.inf_norm(), 1e-12 );
+            for( unsigned int p = 0; p < std::min( derivative.GetSize(), referenceDerivative.GetSize() ); ++p )
+            {
+              result.MaximumRelativeDifference = std::max( result.MaximumRelativeDifference,
+                std::abs( derivative[ p ] - referenceDerivative[ p ] ) / derivativeNorm );
+            }
+            if( derivative.GetSize() != referenceDerivative.GetSize()
+              || !( result.MaximumRelativeDifference <= tolerance ) )
+            {
+              std::cerr << "ERROR: " << result.Metric << " / " << result.Transform << " / "
+                        << result.Sampler << " / " << result.Interpolator << " / "
+                        << result.NumberOfThreads << " threads differs from the single-threaded result: "
+                        << result.MaximumRelativeDifference << std::endl;
+              return EXIT_FAILURE;
+            }
+
+            /** The scaling efficiency is relative to the first number of threads. */
+            if( n == 0 )
+            {
+              referenceTime = result.Seconds * threads[ 0 ];
+            }
+            result.ScalingEfficiency = referenceTime / ( result.Seconds * threads[ n ] );
+            results.push_back( result );
+
+            std::cerr << result.Metric << " / " << result.Transform << " / " << result.Sampler
+                      << " / " << result.Interpolator << " / " << result.NumberOfThreads
+                      << " threads: " << result.Seconds << " s" << std::endl;
+          }
+        }
+      }
+    }
+  }
+
+  /** Write the results. */
+  if( outputFileName.empty() )
+  {
+    WriteResults( std::cout, results );
+  }
+  else
+  {
+    std::ofstream output( outputFileName.c_str() );
+    if( !output.is_open() )
+    {
+      std::cerr << "ERROR: could not open " << outputFileName << std::endl;
+      return EXIT_FAILURE;
+    }
+    WriteResults( output, results );
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
@@ -260,6 +260,14 @@ main( int argc, char * argv[] )
   std::vector< InputPointType >  pointList( N );
   std::vector< OutputPointType > transformedPointList1( N );
   std::vector< OutputPointType > transformedPointList2( N );
+  std::vector< OutputPointType > transformedPointList3( N );
+  std::vector< OutputPointType > transformedPointList4( N );
+  std::vector< OutputPointType > transformedPointList5( N );
+  std::vector< SizeValueType >   sampleIndices( N );
+  for( unsigned int i = 0; i < N; ++i )
+  {
+    sampleIndices[ i ] = i;
+  }
 
   IndexType               dummyIndex;
   CoefficientImagePointer coefficientImage = transform->GetCoefficientImages()[ 0 ];
@@ -287,6 +295,22 @@ main( int argc, char * argv[] )
   }
   timeCollector.Stop(  "TransformPoint recursive         " );
 
+  timeCollector.Start( "TransformPoints recursive batched" );
+  recursiveTransform->TransformPoints( &pointList[ 0 ], &transformedPointList3[ 0 ], N );
+  timeCollector.Stop(  "TransformPoints recursive batched" );
+
+  /** Time the transformation with pre-computed sample weights. */
+  transform->PrecomputeSampleWeights( &pointList[ 0 ], N );
+  recursiveTransform->PrecomputeSampleWeights( &pointList[ 0 ], N );
+
+  timeCollector.Start( "TransformSamples elastix         " );
+  transform->TransformSamples( &sampleIndices[ 0 ], &pointList[ 0 ], &transformedPointList4[ 0 ], N );
+  timeCollector.Stop(  "TransformSamples elastix         " );
+
+  timeCollector.Start( "TransformSamples recursive       " );
+  recursiveTransform->TransformSamples( &sampleIndices[ 0 ], &pointList[ 0 ], &transformedPointList5[ 0 ], N );
+  timeCollector.Stop(  "TransformSamples recursive       " );
+
   /** Time the implementation of the Jacobian. */
   timeCollector.Start( "Jacobian elastix                 " );
   for( unsigned int i = 0; i < N; ++i )
@@ -404,6 +428,47 @@ main( int argc, char * argv[] )
     return EXIT_FAILURE;
   }
 
+  /** TransformPoints, the batched version should give exactly the same result. */
+  double differenceNorm2 = 0.0;
+  for( unsigned int i = 0; i < N; ++i )
+  {
+    opp1 = transformedPointList2[ i ];
+    opp2 = transformedPointList3[ i ];
+    for( unsigned int j = 0; j < Dimension; ++j )
+    {
+      differenceNorm2 += ( opp1[ j ] - opp2[ j ] ) * ( opp1[ j ] - opp2[ j ] );
+    }
+  }
+  std::cerr << "Recursive B-spline TransformPoints() difference with TransformPoint(): " << differenceNorm2 << std::endl;
+  if( differenceNorm2 > 0.0 )
+  {
+    std::cerr << "ERROR: Recursive B-spline TransformPoints() returning incorrect result." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** TransformSamples, the weights are stored in single precision. */
+  double differenceNorm3 = 0.0;
+  double differenceNorm4 = 0.0;
+  for( unsigned int i = 0; i < N; ++i )
+  {
+    for( unsigned int j = 0; j < Dimension; ++j )
+    {
+      const double diff3 = transformedPointList1[ i ][ j ] - transformedPointList4[ i ][ j ];
+      const double diff4 = transformedPointList2[ i ][ j ] - transformedPointList5[ i ][ j ];
+      differenceNorm3 += diff3 * diff3;
+      differenceNorm4 += diff4 * diff4;
+    }
+  }
+  differenceNorm3 = std::sqrt( differenceNorm3 ) / N;
+  differenceNorm4 = std::sqrt( differenceNorm4 ) / N;
+  std::cerr << "B-spline TransformSamples() MSD with TransformPoint(): " << differenceNorm3 << std::endl;
+  std::cerr << "Recursive B-spline TransformSamples() MSD with TransformPoint(): " << differenceNorm4 << std::endl;
+  if( differenceNorm3 > 1e-5 || differenceNorm4 > 1e-5 )
+  {
+    std::cerr << "ERROR: B-spline TransformSamples() returning incorrect result." << std::endl;
+    return EXIT_FAILURE;
+  }
+
   /** Jacobian. */
   JacobianType jacobianElastix; jacobianElastix.SetSize( Dimension, nzji.size() ); jacobianElastix.Fill( 0.0 );
   transform->GetJacobian( inputPoint, jacobianElastix, nzjiElastix );
@@ -0,0 +1,461 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkCostFunctionClones.h"
+#include "CMAEvolutionStrategy/itkCMAEvolutionStrategyOptimizer.h"
+#include "FullSearch/itkFullSearchOptimizer.h"
+#include "FiniteDifferenceGradientDescent/itkFiniteDifferenceGradientDescentOptimizer.h"
+
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// This test checks the evaluation of a batch of positions on copies ("clones")
+// of the cost function.
+//
+// The optimizers promise that the clones only change who computes the values,
+// not the values themselves: an optimization with clones should give exactly
+// the same result as one without, with the same number of evaluations.
+// This is checked on a small synthetic cost function, with scales, for
+// several numbers of clones.
+//
+// For the FullSearchOptimizer it also checks that the refinement of the best
+// grid points improves on the grid, and that it evaluates no point twice.
+//
+// It also checks that CostFunctionClones::Evaluate stops a clone at its first
+// error, and rethrows the error of the lowest evaluation, as an ExceptionObject,
+// so that an optimizer stops with a metric error, also for non-ITK exceptions.
+
+namespace
+{
+
+/** A smooth cost function with several local minima, which keeps its evaluated positions. */
+class TestCostFunction : public itk::SingleValuedCostFunction
+{
+public:
+
+  typedef TestCostFunction                Self;
+  typedef itk::SingleValuedCostFunction   Superclass;
+  typedef itk::SmartPointer< Self >       Pointer;
+  typedef itk::SmartPointer< const Self > ConstPointer;
+
+  itkNewMacro( Self );
+  itkTypeMacro( TestCostFunction, SingleValuedCostFunction );
+
+  static const unsigned int NumberOfParameters = 4;
+
+  MeasureType GetValue( const ParametersType & parameters ) const override
+  {
+    this->m_EvaluatedPositions.push_back( parameters );
+    if( this->m_ThrowStandardException )
+    {
+      throw std::runtime_error( "TestCostFunction failed" );
+    }
+    MeasureType value = 0.0;
+    for( unsigned int i = 0; i < NumberOfParameters; ++i )
+    {
+      const double d = parameters[ i ] - ( 0.5 + 0.25 * i );
+      value += ( 1.0 + i ) * d * d + 0.1 * std::cos( 3.0 * parameters[ i ] );
+    }
+    return value;
+  }
+
+
+  void GetDerivative( const ParametersType &, DerivativeType & ) const override
+  {
+    itkExceptionMacro( << "The derivative is not implemented." );
+  }
+
+
+  unsigned int GetNumberOfParameters( void ) const override
+  {
+    return NumberOfParameters;
+  }
+
+
+  mutable std::vector< ParametersType > m_EvaluatedPositions;
+  bool                                  m_ThrowStandardException = false;
+
+protected:
+
+  TestCostFunction() {}
+  ~TestCostFunction() override {}
+
+};
+
+typedef itk::CostFunctionClones::CostFunctionContainerType CostFunctionContainerType;
+
+/** Create clones of the test cost function. */
+CostFunctionContainerType
+CreateClones( const unsigned int numberOfClones )
+{
+  CostFunctionContainerType clones;
+  for( unsigned int c = 0; c < numberOfClones; ++c )
+  {
+    clones.push_back( TestCostFunction::New().GetPointer() );
+  }
+  return clones;
+} // end CreateClones()
+
+
+/** All positions evaluated by the cost function and its clones. */
+std::vector< itk::OptimizerParameters< double > >
+GetEvaluatedPositions( const TestCostFunction * costFunction, const CostFunctionContainerType & clones )
+{
+  std::vector< itk::OptimizerParameters< double > > positions = costFunction->m_EvaluatedPositions;
+  for( std::size_t c = 0; c < clones.size(); ++c )
+  {
+    const TestCostFunction * clone = static_cast< const TestCostFunction * >( clones[ c ].GetPointer() );
+    positions.insert( positions.end(), clone->m_EvaluatedPositions.begin(), clone->m_EvaluatedPositions.end() );
+  }
+  return positions;
+} // end GetEvaluatedPositions()
+
+
+/** The initial position and the scales of the optimizations. */
+itk::OptimizerParameters< double >
+GetInitialPosition( void )
+{
+  itk::OptimizerParameters< double > position( TestCostFunction::NumberOfParameters );
+  for( unsigned int i = 0; i < position.GetSize(); ++i )
+  {
+    position[ i ] = -1.0 + 0.3 * i;
+  }
+  return position;
+} // end GetInitialPosition()
+
+
+itk::ScaledSingleValuedNonLinearOptimizer::ScalesType
+GetScales( void )
+{
+  itk::ScaledSingleValuedNonLinearOptimizer::ScalesType scales( TestCostFunction::NumberOfParameters );
+  for( unsigned int i = 0; i < scales.GetSize(); ++i )
+  {
+    scales[ i ] = 1.0 + 0.5 * i;
+  }
+  return scales;
+} // end GetScales()
+
+
+/** The result of an optimization. */
+struct ResultType
+{
+  itk::OptimizerParameters< double > m_Position;
+  double                             m_Value;
+  unsigned long                      m_NumberOfIterations;
+  unsigned long                      m_NumberOfEvaluations;
+};
+
+/** Compare the result with clones to the result without. */
+bool
+CompareResults( const std::string & name, const unsigned int numberOfClones,
+  const ResultType & expected, const ResultType & actual )
+{
+  std::cout << "  " << name << " with " << numberOfClones << " clones: value " << actual.m_Value
+            << ", " << actual.m_NumberOfIterations << " iterations, "
+            << actual.m_NumberOfEvaluations << " evaluations" << std::endl;
+
+  /** Exact comparisons: the results should be bit-identical. */
+  if( actual.m_Position != expected.m_Position || actual.m_Value != expected.m_Value
+    || actual.m_NumberOfIterations != expected.m_NumberOfIterations
+    || actual.m_NumberOfEvaluations != expected.m_NumberOfEvaluations )
+  {
+    std::cerr << "ERROR: " << name << " with " << numberOfClones
+              << " clones differs from the result without clones." << std::endl;
+    return false;
+  }
+  return true;
+} // end CompareResults()
+
+
+/** Run the CMAEvolutionStrategyOptimizer. */
+ResultType
+RunCMAEvolutionStrategy( const unsigned int numberOfClones )
+{
+  typedef itk::CMAEvolutionStrategyOptimizer OptimizerType;
+
+  /** The offspring are random, so use the same seed for each run. */
+  itk::Statistics::MersenneTwisterRandomVariateGenerator::GetInstance()->SetSeed( 1234 );
+
+  TestCostFunction::Pointer       costFunction = TestCostFunction::New();
+  const CostFunctionContainerType clones       = CreateClones( numberOfClones );
+
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  optimizer->SetCostFunction( costFunction );
+  optimizer->SetInitialPosition( GetInitialPosition() );
+  optimizer->SetScales( GetScales() );
+  optimizer->SetUseScales( true );
+  optimizer->SetMaximumNumberOfIterations( 40 );
+  optimizer->SetPopulationSize( 10 );
+  optimizer->SetInitialSigma( 0.5 );
+  optimizer->SetCostFunctionClones( clones );
+  optimizer->StartOptimization();
+
+  ResultType result;
+  result.m_Position            = optimizer->GetCurrentPosition();
+  result.m_Value               = optimizer->GetCurrentValue();
+  result.m_NumberOfIterations  = optimizer->GetCurrentIteration();
+  result.m_NumberOfEvaluations = GetEvaluatedPositions( costFunction, clones ).size();
+  return result;
+} // end RunCMAEvolutionStrategy()
+
+/** Run the FullSearchOptimizer over the first two parameters. Optionally
+ * returns the evaluated positions.
+ */
+ResultType
+RunFullSearch( const unsigned int numberOfClones, const unsigned int numberOfRefinementLevels,
+  std::vector< itk::OptimizerParameters< double > > * evaluatedPositions = nullptr )
+{
+  typedef itk::FullSearchOptimizer OptimizerType;
+
+  TestCostFunction::Pointer       costFunction = TestCostFunction::New();
+  const CostFunctionContainerType clones       = CreateClones( numberOfClones );
+
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  optimizer->SetCostFunction( costFunction );
+  optimizer->SetInitialPosition( GetInitialPosition() );
+  optimizer->AddSearchDimension( 0, -2.0, 2.0, 1.0 );
+  optimizer->AddSearchDimension( 1, -2.0, 3.0, 1.0 );
+  optimizer->SetNumberOfRefinementCandidates( numberOfRefinementLevels > 0 ? 3 : 0 );
+  optimizer->SetNumberOfRefinementLevels( numberOfRefinementLevels );
+  optimizer->SetCostFunctionClones( clones );
+  optimizer->StartOptimization();
+
+  ResultType result;
+  result.m_Position            = optimizer->PointToPosition( optimizer->GetBestPointInSearchSpace() );
+  result.m_Value               = optimizer->GetBestValue();
+  result.m_NumberOfIterations  = optimizer->GetCurrentIteration();
+  result.m_NumberOfEvaluations = GetEvaluatedPositions( costFunction, clones ).size();
+  if( evaluatedPositions != nullptr )
+  {
+    *evaluatedPositions = GetEvaluatedPositions( costFunction, clones );
+  }
+  return result;
+} // end RunFullSearch()
+
+
+/** Test the refinement of the FullSearchOptimizer. */
+bool
+TestFullSearchRefinement( void )
+{
+  const ResultType                                  grid = RunFullSearch( 0, 0 );
+  std::vector< itk::OptimizerParameters< double > > positions;
+  const ResultType                                  refined = RunFullSearch( 0, 4, &positions );
+  std::cout << "  Grid: value " << grid.m_Value << ", " << grid.m_NumberOfEvaluations << " evaluations\n"
+            << "  Refined: value " << refined.m_Value << ", " << refined.m_NumberOfEvaluations
+            << " evaluations" << std::endl;
+
+  /** The optimum is not a grid point, so the refinement should improve on the grid. */
+  bool passed = true;
+  if( !( refined.m_Value < grid.m_Value ) )
+  {
+    std::cerr << "ERROR: the refinement did not improve on the best grid point." << std::endl;
+    passed = false;
+  }
+
+  /** The refinement points of neighbouring candidates coincide, and should be
+   * evaluated only once. The smallest step is 1/16, so any two positions differ
+   * by much more than the tolerance.
+   */
+  for( std::size_t i = 0; i < positions.size(); ++i )
+  {
+    for( std::size_t j = 0; j < i; ++j )
+    {
+      bool equal = true;
+      for( unsigned int k = 0; k < positions[ i ].GetSize(); ++k )
+      {
+        equal = equal && std::abs( positions[ i ][ k ] - positions[ j ][ k ] ) < 1e-6;
+      }
+      if( equal )
+      {
+        std::cerr << "ERROR: the position " << positions[ i ] << " was evaluated twice." << std::endl;
+        passed = false;
+      }
+    }
+  }
+  return passed;
+} // end TestFullSearchRefinement()
+
+/** Run the FiniteDifferenceGradientDescentOptimizer. */
+ResultType
+RunFiniteDifferenceGradientDescent( const unsigned int numberOfClones )
+{
+  typedef itk::FiniteDifferenceGradientDescentOptimizer OptimizerType;
+
+  TestCostFunction::Pointer       costFunction = TestCostFunction::New();
+  const CostFunctionContainerType clones       = CreateClones( numberOfClones );
+
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  optimizer->SetCostFunction( costFunction );
+  optimizer->SetInitialPosition( GetInitialPosition() );
+  optimizer->SetScales( GetScales() );
+  optimizer->SetUseScales( true );
+  optimizer->SetNumberOfIterations( 50 );
+  optimizer->SetParam_a( 0.2 );
+  optimizer->SetParam_c( 0.1 );
+  optimizer->SetComputeCurrentValue( true );
+  optimizer->SetCostFunctionClones( clones );
+  optimizer->StartOptimization();
+
+  ResultType result;
+  result.m_Position            = optimizer->GetCurrentPosition();
+  result.m_Value               = optimizer->GetValue();
+  result.m_NumberOfIterations  = optimizer->GetCurrentIteration();
+  result.m_NumberOfEvaluations = GetEvaluatedPositions( costFunction, clones ).size();
+  return result;
+} // end RunFiniteDifferenceGradientDescent()
+
+
+/** Test that a non-ITK exception in a clone stops the
+ * FiniteDifferenceGradientDescentOptimizer with a metric error.
+ */
+bool
+TestFiniteDifferenceGradientDescentMetricError( void )
+{
+  typedef itk::FiniteDifferenceGradientDescentOptimizer OptimizerType;
+
+  const CostFunctionContainerType clones = CreateClones( 3 );
+  static_cast< TestCostFunction * >( clones[ 1 ].GetPointer() )->m_ThrowStandardException = true;
+
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  optimizer->SetCostFunction( TestCostFunction::New() );
+  optimizer->SetInitialPosition( GetInitialPosition() );
+  optimizer->SetNumberOfIterations( 10 );
+  optimizer->SetCostFunctionClones( clones );
+
+  bool caught = false;
+  try
+  {
+    optimizer->StartOptimization();
+  }
+  catch( itk::ExceptionObject & )
+  {
+    caught = true;
+  }
+
+  if( !caught || optimizer->GetStopCondition() != OptimizerType::MetricError )
+  {
+    std::cerr << "ERROR: a std::exception in a clone did not stop the "
+              << "FiniteDifferenceGradientDescentOptimizer with a metric error." << std::endl;
+    return false;
+  }
+  return true;
+} // end TestFiniteDifferenceGradientDescentMetricError()
+
+
+/** Test the error handling of CostFunctionClones::Evaluate. */
+bool
+TestEvaluateErrors( void )
+{
+  /** Three clones: clone 2 does the evaluations 2, 5 and 8. Evaluation 5 throws a
+   * non-ITK exception, evaluation 7 an ExceptionObject. */
+  const std::size_t   numberOfClones      = 3;
+  const std::size_t   numberOfEvaluations = 10;
+  std::vector< char > evaluated( numberOfEvaluations, 0 );
+  std::string         description;
+  try
+  {
+    itk::CostFunctionClones::Evaluate( numberOfClones, numberOfEvaluations,
+      [ & ]( const std::size_t c, const std::size_t i )
+    {
+      if( c != i % numberOfClones )
+      {
+        throw std::logic_error( "wrong clone" );
+      }
+      evaluated[ i ] = 1;
+      if( i == 5 )
+      {
+        throw std::runtime_error( "error in evaluation 5" );
+      }
+      if( i == 7 )
+      {
+        itkGenericExceptionMacro( << "error in evaluation 7" );
+      }
+    } );
+  }
+  catch( itk::ExceptionObject & e )
+  {
+    description = e.GetDescription();
+  }
+
+  bool passed = true;
+  if( description.find( "error in evaluation 5" ) == std::string::npos )
+  {
+    std::cerr << "ERROR: Evaluate() did not rethrow the first error as an ExceptionObject, but: \""
+              << description << "\"" << std::endl;
+    passed = false;
+  }
+  for( std::size_t i = 0; i < numberOfEvaluations; ++i )
+  {
+    /** Only the evaluations after the error of their clone are skipped. */
+    const bool expected = i != 8;
+    if( ( evaluated[ i ] != 0 ) != expected )
+    {
+      std::cerr << "ERROR: evaluation " << i << " was " << ( evaluated[ i ] ? "" : "not " )
+                << "done." << std::endl;
+      passed = false;
+    }
+  }
+  return passed;
+} // end TestEvaluateErrors()
+
+
+} // end namespace
+
+int
+main( int argc, char * argv[] )
+{
+  bool passed = TestEvaluateErrors();
+
+  /** Compare the optimizations with clones to the ones without. */
+  const unsigned int numberOfClonesToTest[] = { 1, 2, 3, 16 };
+
+  std::cout << "CMAEvolutionStrategyOptimizer:" << std::endl;
+  const ResultType expectedCMA = RunCMAEvolutionStrategy( 0 );
+  for( const unsigned int numberOfClones : numberOfClonesToTest )
+  {
+    passed &= CompareResults( "CMAEvolutionStrategy", numberOfClones,
+      expectedCMA, RunCMAEvolutionStrategy( numberOfClones ) );
+  }
+
+  std::cout << "FullSearchOptimizer:" << std::endl;
+  passed &= TestFullSearchRefinement();
+  const ResultType expectedFullSearch = RunFullSearch( 0, 3 );
+  for( const unsigned int numberOfClones : numberOfClonesToTest )
+  {
+    passed &= CompareResults( "FullSearch", numberOfClones,
+      expectedFullSearch, RunFullSearch( numberOfClones, 3 ) );
+  }
+
+  std::cout << "FiniteDifferenceGradientDescentOptimizer:" << std::endl;
+  passed &= TestFiniteDifferenceGradientDescentMetricError();
+  const ResultType expectedFiniteDifference = RunFiniteDifferenceGradientDescent( 0 );
+  for( const unsigned int numberOfClones : numberOfClonesToTest )
+  {
+    passed &= CompareResults( "FiniteDifferenceGradientDescent", numberOfClones,
+      expectedFiniteDifference, RunFiniteDifferenceGradientDescent( numberOfClones ) );
+  }
+
+  /** Return a value. */
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+
+} // end main
@@ -0,0 +1,209 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkGenericMultiResolutionPyramidImageFilter.h"
+
+#include "itkImage.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTimeProbe.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+// This test compares the incremental computation of the pyramid levels, where
+// each level is computed from the next finer level, with the default
+// computation, where each level is computed from the full resolution input.
+//
+// With the default smoothing schedule the additional smoothing of each level
+// is less than one pixel of the finer level, so the incremental mode should
+// fall back to the default computation, and give identical results.
+//
+// With sigma equal to the shrink factor the levels are computed incrementally.
+// Due to the intermediate interpolation and the recursive Gaussian the results
+// are not identical. Away from the border the mean and maximum difference,
+// relative to the intensity range, should be small. At the border the
+// smoothing of the finer level is extrapolated differently, so only the
+// maximum difference over the whole image is checked, more loosely.
+// The computation times of both modes are printed.
+
+namespace
+{
+
+const unsigned int Dimension = 3;
+typedef itk::Image< float, Dimension > ImageType;
+typedef itk::GenericMultiResolutionPyramidImageFilter<
+  ImageType, ImageType >               PyramidType;
+
+/** Compare the levels of two pyramids. The border is the number of
+ * pixels at each side that is excluded from the "interior" differences.
+ */
+bool
+CompareLevels( const PyramidType * defaultPyramid, const PyramidType * incrementalPyramid,
+  const double maxInteriorMeanRel, const double maxInteriorMaxRel,
+  const double maxMaxRel, const unsigned int border )
+{
+  typedef itk::ImageRegionConstIteratorWithIndex< ImageType > ConstIteratorType;
+
+  bool passed = true;
+  for( unsigned int level = 0; level < defaultPyramid->GetNumberOfLevels(); ++level )
+  {
+    const ImageType *           defaultImage     = defaultPyramid->GetOutput( level );
+    const ImageType *           incrementalImage = incrementalPyramid->GetOutput( level );
+    const ImageType::RegionType region           = defaultImage->GetLargestPossibleRegion();
+    if( region != incrementalImage->GetLargestPossibleRegion()
+      || defaultImage->GetSpacing() != incrementalImage->GetSpacing()
+      || defaultImage->GetOrigin() != incrementalImage->GetOrigin() )
+    {
+      std::cerr << "ERROR: the geometry of level " << level << " differs." << std::endl;
+      return false;
+    }
+
+    ConstIteratorType itD( defaultImage, region );
+    ConstIteratorType itI( incrementalImage, region );
+    double            minValue               = itD.Get();
+    double            maxValue               = itD.Get();
+    double            maxDiff                = 0.0;
+    double            sumInteriorDiff        = 0.0;
+    double            maxInteriorDiff        = 0.0;
+    std::size_t       numberOfInteriorPixels = 0;
+    for( ; !itD.IsAtEnd(); ++itD, ++itI )
+    {
+      const double diff = std::abs( static_cast< double >( itD.Get() ) - itI.Get() );
+      minValue = std::min( minValue, static_cast< double >( itD.Get() ) );
+      maxValue = std::max( maxValue, static_cast< double >( itD.Get() ) );
+      maxDiff  = std::max( maxDiff, diff );
+
+      bool isInterior = true;
+      for( unsigned int dim = 0; dim < Dimension; ++dim )
+      {
+        const itk::IndexValueType i = itD.GetIndex()[ dim ] - region.GetIndex()[ dim ];
+        isInterior &= i >= static_cast< itk::IndexValueType >( border )
+          && i + static_cast< itk::IndexValueType >( border )
+          < static_cast< itk::IndexValueType >( region.GetSize()[ dim ] );
+      }
+      if( isInterior )
+      {
+        sumInteriorDiff += diff;
+        maxInteriorDiff  = std::max( maxInteriorDiff, diff );
+        ++numberOfInteriorPixels;
+      }
+    }
+
+    const double range           = std::max( maxValue - minValue, 1e-10 );
+    const double interiorMeanRel = sumInteriorDiff / std::max< std::size_t >( numberOfInteriorPixels, 1 ) / range;
+    const double interiorMaxRel  = maxInteriorDiff / range;
+    const double maxRel          = maxDiff / range;
+    std::cout << "  Level " << level
+              << ": interior mean relative difference " << interiorMeanRel
+              << ", interior max relative difference " << interiorMaxRel
+              << ", max relative difference " << maxRel << std::endl;
+
+    if( interiorMeanRel > maxInteriorMeanRel || interiorMaxRel > maxInteriorMaxRel || maxRel > maxMaxRel )
+    {
+      std::cerr << "ERROR: level " << level << " differs too much." << std::endl;
+      passed = false;
+    }
+  }
+
+  return passed;
+
+} // end CompareLevels()
+
+} // end namespace
+
+int
+main( int argc, char * argv[] )
+{
+  /** Create a smooth image. */
+  ImageType::SizeType size;
+  size.Fill( 128 );
+  ImageType::RegionType region( size );
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+
+  typedef itk::ImageRegionIteratorWithIndex< ImageType > IteratorType;
+  IteratorType it( image, region );
+  for( ; !it.IsAtEnd(); ++it )
+  {
+    const ImageType::IndexType index = it.GetIndex();
+    const double               x     = static_cast< double >( index[ 0 ] );
+    const double               y     = static_cast< double >( index[ 1 ] );
+    const double               z     = static_cast< double >( index[ 2 ] );
+    it.Set( static_cast< float >( 100.0 * std::sin( 0.13 * x ) * std::cos( 0.11 * y )
+      + 50.0 * std::cos( 0.09 * z ) ) );
+  }
+
+  /** The schedules: the default one, and one with sigma equal to the shrink factor. */
+  const unsigned int numberOfLevels = 4;
+  PyramidType::SmoothingScheduleType wideSchedule( numberOfLevels, Dimension );
+  for( unsigned int level = 0; level < numberOfLevels; ++level )
+  {
+    wideSchedule.set_row( level, static_cast< double >( 1u << ( numberOfLevels - 1 - level ) ) );
+  }
+
+  bool passed = true;
+  for( unsigned int s = 0; s < 2; ++s )
+  {
+    const bool useWideSchedule = s == 1;
+    std::cout << ( useWideSchedule ? "Sigma equal to the shrink factor:" : "Default smoothing schedule:" )
+              << std::endl;
+
+    /** Compute the pyramid in the default and in the incremental way. */
+    PyramidType::Pointer pyramids[ 2 ];
+    itk::TimeProbe       timers[ 2 ];
+    for( unsigned int i = 0; i < 2; ++i )
+    {
+      pyramids[ i ] = PyramidType::New();
+      pyramids[ i ]->SetNumberOfLevels( numberOfLevels );
+      if( useWideSchedule )
+      {
+        pyramids[ i ]->SetSmoothingSchedule( wideSchedule );
+      }
+      pyramids[ i ]->SetUseIncrementalSmoothing( i == 1 );
+      pyramids[ i ]->SetInput( image );
+
+      timers[ i ].Start();
+      pyramids[ i ]->Update();
+      timers[ i ].Stop();
+    }
+
+    std::cout << "  Default computation:     " << std::setprecision( 4 )
+              << timers[ 0 ].GetMean() << " s" << std::endl;
+    std::cout << "  Incremental computation: " << std::setprecision( 4 )
+              << timers[ 1 ].GetMean() << " s" << std::endl;
+
+    /** Compare the levels. */
+    if( useWideSchedule )
+    {
+      passed &= CompareLevels( pyramids[ 0 ], pyramids[ 1 ], 2e-3, 5e-3, 0.05, 2 );
+    }
+    else
+    {
+      passed &= CompareLevels( pyramids[ 0 ], pyramids[ 1 ], 0.0, 0.0, 0.0, 0 );
+    }
+  }
+
+  /** Return a value. */
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+
+} // end main
@@ -0,0 +1,145 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "AdvancedMattesMutualInformation/itkParzenWindowMutualInformationImageToImageMetric.h"
+#include "itkAdvancedTranslationTransform.h"
+#include "itkAdvancedLinearInterpolateImageFunction.h"
+#include "itkImageFullSampler.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMultiThreaderBase.h"
+#include "itkTimeProbe.h"
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+// This test measures the throughput of the Mattes mutual information value
+// computation, i.e. of the joint histogram construction, as a function of the
+// number of threads. The metric values should not depend on the number of
+// threads, and should equal the value of the single-threaded implementation.
+
+int
+main( int argc, char * argv[] )
+{
+  /** Typedefs. */
+  const unsigned int Dimension = 3;
+  typedef itk::Image< float, Dimension > ImageType;
+  typedef itk::ParzenWindowMutualInformationImageToImageMetric<
+    ImageType, ImageType >                                    MetricType;
+  typedef itk::AdvancedTranslationTransform< double, Dimension > TransformType;
+  typedef itk::AdvancedLinearInterpolateImageFunction<
+    ImageType, double >                                       InterpolatorType;
+  typedef itk::ImageFullSampler< ImageType >                  SamplerType;
+  typedef MetricType::ParametersType                          ParametersType;
+  typedef MetricType::MeasureType                             MeasureType;
+
+  /** Create two smooth, shifted images. */
+  ImageType::SizeType size;
+  size.Fill( 64 );
+  ImageType::RegionType region( size );
+
+  ImageType::Pointer fixedImage  = ImageType::New();
+  ImageType::Pointer movingImage = ImageType::New();
+  fixedImage->SetRegions( region );
+  fixedImage->Allocate();
+  movingImage->SetRegions( region );
+  movingImage->Allocate();
+
+  typedef itk::ImageRegionIteratorWithIndex< ImageType > IteratorType;
+  IteratorType itF( fixedImage, region );
+  IteratorType itM( movingImage, region );
+  for( ; !itF.IsAtEnd(); ++itF, ++itM )
+  {
+    const ImageType::IndexType index = itF.GetIndex();
+    const double               x     = static_cast< double >( index[ 0 ] );
+    const double               y     = static_cast< double >( index[ 1 ] );
+    const double               z     = static_cast< double >( index[ 2 ] );
+    itF.Set( static_cast< float >( 100.0 * std::sin( 0.1 * x ) * std::cos( 0.07 * y ) + z ) );
+    itM.Set( static_cast< float >( 100.0 * std::sin( 0.1 * ( x + 2.0 ) ) * std::cos( 0.07 * y ) + 0.5 * z ) );
+  }
+
+  /** Create the registration components. */
+  TransformType::Pointer transform = TransformType::New();
+  ParametersType         parameters( transform->GetNumberOfParameters() );
+  parameters.Fill( 0.5 );
+
+  MetricType::Pointer metric = MetricType::New();
+  metric->SetFixedImage( fixedImage );
+  metric->SetMovingImage( movingImage );
+  metric->SetFixedImageRegion( region );
+  metric->SetTransform( transform );
+  metric->SetInterpolator( InterpolatorType::New() );
+  metric->SetImageSampler( SamplerType::New() );
+  metric->SetNumberOfFixedHistogramBins( 32 );
+  metric->SetNumberOfMovingHistogramBins( 32 );
+
+  /** The reference: the single-threaded implementation. */
+  metric->SetUseMultiThread( false );
+  metric->Initialize();
+  const MeasureType referenceValue = metric->GetValue( parameters );
+  metric->SetUseMultiThread( true );
+
+  const unsigned int numberOfSamples   = region.GetNumberOfPixels();
+  const unsigned int numberOfRepeats   = argc > 1 ? 2 : 10;
+  const unsigned int maxNumberOfThreads
+    = itk::MultiThreaderBase::GetGlobalDefaultNumberOfThreads();
+
+  std::cout << "Reference (single-threaded) value: "
+            << std::setprecision( 12 ) << referenceValue << std::endl;
+  std::cout << std::setw( 10 ) << "threads"
+            << std::setw( 20 ) << "value"
+            << std::setw( 16 ) << "time [s]"
+            << std::setw( 16 ) << "samples/s" << std::endl;
+
+  for( unsigned int threads = 1; threads <= maxNumberOfThreads; threads *= 2 )
+  {
+    metric->SetNumberOfWorkUnits( threads );
+    metric->Initialize();
+
+    itk::TimeProbe timer;
+    MeasureType    value = 0.0;
+    for( unsigned int i = 0; i < numberOfRepeats; ++i )
+    {
+      timer.Start();
+      value = metric->GetValue( parameters );
+      timer.Stop();
+    }
+
+    const double time = timer.GetMean();
+    std::cout << std::setw( 10 ) << threads
+              << std::setw( 20 ) << std::setprecision( 12 ) << value
+              << std::setw( 16 ) << std::setprecision( 4 ) << time
+              << std::setw( 16 ) << numberOfSamples / time << std::endl;
+
+    /** The summation order over the samples differs per thread count,
+     * so only a small relative difference is allowed.
+     */
+    if( std::abs( value - referenceValue ) > 1e-10 * std::abs( referenceValue ) )
+    {
+      std::cerr << "ERROR: the value with " << threads
+                << " threads differs from the single-threaded value." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  /** Return a value. */
+  return EXIT_SUCCESS;
+
+} // end main
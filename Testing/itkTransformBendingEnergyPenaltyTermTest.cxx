@@ -0,0 +1,246 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "BendingEnergyPenalty/itkTransformBendingEnergyPenaltyTerm.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkAdvancedLinearInterpolateImageFunction.h"
+#include "itkImageFullSampler.h"
+
+#include "itkImage.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+// This test checks the analytic bending energy of a cubic B-spline transform,
+// in 2D and 3D.
+//
+// The analytic value and derivative are compared with the bending energy that
+// is sampled densely on the fixed image, i.e. with the midpoint rule. Only the
+// inner control points have nonzero coefficients, so that the bending energy
+// vanishes outside the region where the transform is valid, which is exactly
+// covered by the fixed image. The midpoint rule with 8 samples per grid cell
+// is accurate to about 0.5%.
+//
+// The analytic derivative is also compared with central finite differences of
+// the analytic value, which are exact up to rounding, since the value is a
+// quadratic form. The multi-threaded value and derivative should be
+// bit-identical to the single-threaded ones.
+
+namespace
+{
+
+/** Check the analytic bending energy on a B-spline grid of gridSize^Dimension control points. */
+template< unsigned int Dimension >
+bool
+TestBendingEnergyPenaltyTerm( const unsigned int gridSize )
+{
+  /** Typedefs. */
+  typedef itk::Image< short, Dimension >                            ImageType;
+  typedef itk::TransformBendingEnergyPenaltyTerm< ImageType, double > MetricType;
+  typedef itk::AdvancedBSplineDeformableTransform<
+    double, Dimension, 3 >                                          TransformType;
+  typedef itk::AdvancedLinearInterpolateImageFunction<
+    ImageType, double >                                             InterpolatorType;
+  typedef itk::ImageFullSampler< ImageType >                        SamplerType;
+  typedef typename MetricType::ParametersType                       ParametersType;
+  typedef typename MetricType::DerivativeType                       DerivativeType;
+  typedef typename MetricType::MeasureType                          MeasureType;
+
+  /** A B-spline grid with a different, non-unit spacing in each dimension.
+   * The transform is valid from grid point 1 to grid point gridSize - 2,
+   * which starts at the origin.
+   */
+  typename TransformType::SizeType gridRegionSize;
+  gridRegionSize.Fill( gridSize );
+  typename TransformType::RegionType    gridRegion( gridRegionSize );
+  typename TransformType::SpacingType   gridSpacing;
+  typename TransformType::OriginType    gridOrigin;
+  typename TransformType::DirectionType gridDirection;
+  gridDirection.SetIdentity();
+  for( unsigned int d = 0; d < Dimension; d++ )
+  {
+    gridSpacing[ d ] = 2.5 + 0.75 * d;
+    gridOrigin[ d ]  = -gridSpacing[ d ];
+  }
+
+  typename TransformType::Pointer transform = TransformType::New();
+  transform->SetGridOrigin( gridOrigin );
+  transform->SetGridSpacing( gridSpacing );
+  transform->SetGridRegion( gridRegion );
+  transform->SetGridDirection( gridDirection );
+
+  /** A fixed image with 8 pixels per grid cell, that covers the valid region. */
+  const unsigned int             samplesPerCell = 8;
+  typename ImageType::SizeType    size;
+  typename ImageType::SpacingType spacing;
+  typename ImageType::PointType   origin;
+  for( unsigned int d = 0; d < Dimension; d++ )
+  {
+    size[ d ]    = ( gridSize - 3 ) * samplesPerCell;
+    spacing[ d ] = gridSpacing[ d ] / samplesPerCell;
+    origin[ d ]  = 0.5 * spacing[ d ];
+  }
+  typename ImageType::RegionType region( size );
+  typename ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->SetSpacing( spacing );
+  image->SetOrigin( origin );
+  image->Allocate();
+  image->FillBuffer( 0 );
+
+  /** A smooth bump on the inner control points, at least 3 from the border. */
+  const unsigned int numberOfControlPoints = gridRegion.GetNumberOfPixels();
+  const unsigned int numberOfParameters    = transform->GetNumberOfParameters();
+  const double       pi                    = 3.14159265358979323846;
+  ParametersType     parameters( numberOfParameters );
+  for( unsigned int i = 0; i < numberOfParameters; ++i )
+  {
+    const unsigned int k    = i / numberOfControlPoints;
+    unsigned int       rest = i % numberOfControlPoints;
+    double             bump = 0.8 + 0.3 * k;
+    for( unsigned int d = 0; d < Dimension; d++ )
+    {
+      const unsigned int position = rest % gridSize;
+      bump *= position >= 3 && position + 4 <= gridSize
+        ? std::sin( pi * ( position - 2.0 ) / ( gridSize - 5.0 ) ) : 0.0;
+      rest /= gridSize;
+    }
+    parameters[ i ] = bump;
+  }
+  transform->SetParameters( parameters );
+
+  /** Create the penalty term. */
+  typename MetricType::Pointer metric = MetricType::New();
+  metric->SetFixedImage( image );
+  metric->SetMovingImage( image );
+  metric->SetFixedImageRegion( region );
+  metric->SetTransform( transform );
+  metric->SetInterpolator( InterpolatorType::New() );
+  metric->SetImageSampler( SamplerType::New() );
+  metric->SetUseMultiThread( false );
+
+  /** The densely sampled value and derivative. */
+  metric->SetUseAnalyticBendingEnergy( false );
+  metric->Initialize();
+  MeasureType    sampledValue = 0.0;
+  DerivativeType sampledDerivative;
+  metric->GetValueAndDerivative( parameters, sampledValue, sampledDerivative );
+
+  /** The analytic value and derivative. */
+  metric->SetUseAnalyticBendingEnergy( true );
+  metric->Initialize();
+  MeasureType    value = 0.0;
+  DerivativeType derivative;
+  metric->GetValueAndDerivative( parameters, value, derivative );
+  std::cout << "  " << Dimension << "D: analytic value " << value
+            << ", sampled value " << sampledValue << std::endl;
+
+  bool passed = true;
+  if( !( std::abs( value - sampledValue ) <= 1e-2 * value ) )
+  {
+    std::cerr << "ERROR: the " << Dimension
+              << "D analytic value differs from the sampled value." << std::endl;
+    passed = false;
+  }
+  if( metric->GetValue( parameters ) != value )
+  {
+    std::cerr << "ERROR: GetValue() differs from the value of GetValueAndDerivative()." << std::endl;
+    passed = false;
+  }
+
+  double maxDerivative    = 0.0;
+  double maxSampledError  = 0.0;
+  for( unsigned int i = 0; i < numberOfParameters; ++i )
+  {
+    maxDerivative   = std::max( maxDerivative, std::abs( derivative[ i ] ) );
+    maxSampledError = std::max( maxSampledError, std::abs( derivative[ i ] - sampledDerivative[ i ] ) );
+  }
+  std::cout << "  " << Dimension << "D: maximum derivative " << maxDerivative
+            << ", maximum difference with the sampled derivative " << maxSampledError << std::endl;
+  if( !( maxDerivative > 0.0 ) || !( maxSampledError <= 1e-2 * maxDerivative ) )
+  {
+    std::cerr << "ERROR: the " << Dimension
+              << "D analytic derivative differs from the sampled derivative." << std::endl;
+    passed = false;
+  }
+
+  /** Compare the derivative with central differences, at smooth coefficients
+   * on the whole grid, including its border.
+   */
+  for( unsigned int i = 0; i < numberOfParameters; ++i )
+  {
+    parameters[ i ] += 0.4 * std::sin( 0.37 * i + 0.5 ) + 0.2 * std::cos( 0.11 * i );
+  }
+  metric->GetValueAndDerivative( parameters, value, derivative );
+
+  const double h = 1e-3;
+  maxDerivative = 0.0;
+  double maxError = 0.0;
+  for( unsigned int i = 0; i < numberOfParameters; ++i )
+  {
+    ParametersType plus( parameters );
+    ParametersType minus( parameters );
+    plus[ i ]  += h;
+    minus[ i ] -= h;
+    const MeasureType valuePlus  = metric->GetValue( plus );
+    const MeasureType valueMinus = metric->GetValue( minus );
+    maxDerivative = std::max( maxDerivative, std::abs( derivative[ i ] ) );
+    maxError      = std::max( maxError,
+      std::abs( ( valuePlus - valueMinus ) / ( 2.0 * h ) - derivative[ i ] ) );
+  }
+  std::cout << "  " << Dimension << "D: maximum finite difference error " << maxError << std::endl;
+  if( !( maxDerivative > 0.0 ) || !( maxError <= 1e-8 * maxDerivative ) )
+  {
+    std::cerr << "ERROR: the " << Dimension
+              << "D analytic derivative differs from the finite difference derivative." << std::endl;
+    passed = false;
+  }
+
+  /** The multi-threaded value and derivative should be bit-identical. */
+  metric->SetUseMultiThread( true );
+  metric->SetNumberOfWorkUnits( 4 );
+  metric->Initialize();
+  MeasureType    valueMT = 0.0;
+  DerivativeType derivativeMT;
+  metric->GetValueAndDerivative( parameters, valueMT, derivativeMT );
+  if( valueMT != value || derivativeMT != derivative )
+  {
+    std::cerr << "ERROR: the multi-threaded " << Dimension
+              << "D value or derivative differs from the single-threaded one." << std::endl;
+    passed = false;
+  }
+
+  return passed;
+
+} // end TestBendingEnergyPenaltyTerm()
+
+
+} // end namespace
+
+int
+main( int argc, char * argv[] )
+{
+  std::cout << "TransformBendingEnergyPenaltyTerm:" << std::endl;
+  bool passed = TestBendingEnergyPenaltyTerm< 2 >( 12 );
+  passed &= TestBendingEnergyPenaltyTerm< 3 >( 9 );
+
+  /** Return a value. */
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+
+} // end main
@@ -0,0 +1,266 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "RigidityPenalty/itkTransformRigidityPenaltyTerm.h"
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkAdvancedLinearInterpolateImageFunction.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+// This test checks the value and the derivative of the rigidity penalty term,
+// in 2D and 3D, with all three conditions and a spatially varying rigidity
+// coefficient image, on an anisotropic B-spline grid.
+//
+// The analytic derivative of the filter chains is compared with central finite
+// differences of the value. Like the zero flux Neumann boundary condition of
+// the image filters, the penalty clamps the neighbourhoods at the border of the
+// grid, which the derivative does not account for, so only the control points
+// that are not on the border are compared.
+//
+// The fused passes should agree with the filter chains up to rounding. The
+// multi-threaded fused value and derivative should be bit-identical to the
+// single-threaded ones, and GetValue() should return the same value as
+// GetValueAndDerivative().
+
+namespace
+{
+
+/** Check the rigidity penalty term on a B-spline grid of gridSize^Dimension control points. */
+template< unsigned int Dimension >
+bool
+TestRigidityPenaltyTerm( const unsigned int gridSize )
+{
+  /** Typedefs. */
+  typedef itk::Image< short, Dimension >                       ImageType;
+  typedef itk::TransformRigidityPenaltyTerm< ImageType, double > MetricType;
+  typedef itk::AdvancedBSplineDeformableTransform<
+    double, Dimension, 3 >                                     TransformType;
+  typedef itk::AdvancedLinearInterpolateImageFunction<
+    ImageType, double >                                        InterpolatorType;
+  typedef typename MetricType::RigidityImageType               RigidityImageType;
+  typedef typename MetricType::ParametersType                  ParametersType;
+  typedef typename MetricType::DerivativeType                  DerivativeType;
+  typedef typename MetricType::MeasureType                     MeasureType;
+
+  /** The fixed and moving images only define the region of the metric. */
+  typename ImageType::SizeType size;
+  size.Fill( 16 );
+  typename ImageType::RegionType region( size );
+  typename ImageType::Pointer image = ImageType::New();
+  image->SetRegions( region );
+  image->Allocate();
+  image->FillBuffer( 0 );
+
+  /** A B-spline grid with a different, non-unit spacing in each dimension. */
+  typename TransformType::SizeType gridRegionSize;
+  gridRegionSize.Fill( gridSize );
+  typename TransformType::RegionType    gridRegion( gridRegionSize );
+  typename TransformType::SpacingType   gridSpacing;
+  typename TransformType::OriginType    gridOrigin;
+  typename TransformType::DirectionType gridDirection;
+  gridDirection.SetIdentity();
+  for( unsigned int d = 0; d < Dimension; d++ )
+  {
+    gridSpacing[ d ] = 2.5 + 0.75 * d;
+    gridOrigin[ d ]  = -gridSpacing[ d ];
+  }
+
+  typename TransformType::Pointer transform = TransformType::New();
+  transform->SetGridOrigin( gridOrigin );
+  transform->SetGridSpacing( gridSpacing );
+  transform->SetGridRegion( gridRegion );
+  transform->SetGridDirection( gridDirection );
+
+  /** Smooth, deterministic coefficients, large enough for the nonlinear terms to matter. */
+  const unsigned int numberOfControlPoints = gridRegion.GetNumberOfPixels();
+  const unsigned int numberOfParameters    = transform->GetNumberOfParameters();
+  ParametersType     parameters( numberOfParameters );
+  for( unsigned int i = 0; i < numberOfParameters; ++i )
+  {
+    parameters[ i ] = 0.4 * std::sin( 0.37 * i + 0.5 ) + 0.2 * std::cos( 0.11 * i );
+  }
+  transform->SetParameters( parameters );
+
+  /** A rigidity coefficient image on the B-spline grid, with values between 0.2 and 1. */
+  typename RigidityImageType::Pointer rigidityImage = RigidityImageType::New();
+  rigidityImage->SetRegions( gridRegion );
+  rigidityImage->SetSpacing( gridSpacing );
+  rigidityImage->SetOrigin( gridOrigin );
+  rigidityImage->SetDirection( gridDirection );
+  rigidityImage->Allocate();
+  itk::ImageRegionIteratorWithIndex< RigidityImageType > it( rigidityImage, gridRegion );
+  for( ; !it.IsAtEnd(); ++it )
+  {
+    double value = 0.6;
+    for( unsigned int d = 0; d < Dimension; d++ )
+    {
+      value += 0.4 / Dimension * std::sin( 0.9 * it.GetIndex()[ d ] + d );
+    }
+    it.Set( value );
+  }
+
+  /** Create the penalty term. */
+  typename MetricType::Pointer metric = MetricType::New();
+  metric->SetFixedImage( image );
+  metric->SetMovingImage( image );
+  metric->SetFixedImageRegion( region );
+  metric->SetTransform( transform );
+  metric->SetInterpolator( InterpolatorType::New() );
+  metric->SetFixedRigidityImage( rigidityImage );
+  metric->SetUseFixedRigidityImage( true );
+  metric->SetUseMovingRigidityImage( false );
+  metric->SetDilateRigidityImages( false );
+  metric->SetLinearityConditionWeight( 1.0 );
+  metric->SetOrthonormalityConditionWeight( 2.0 );
+  metric->SetPropernessConditionWeight( 3.0 );
+
+  /** The value and derivative of the filter chains. */
+  metric->SetUseFusedPasses( false );
+  metric->SetUseMultiThread( false );
+  metric->Initialize();
+  MeasureType    valueFilters = 0.0;
+  DerivativeType derivativeFilters;
+  metric->GetValueAndDerivative( parameters, valueFilters, derivativeFilters );
+  std::cout << "  " << Dimension << "D: value " << valueFilters << std::endl;
+
+  bool passed = true;
+  if( !( std::abs( metric->GetValue( parameters ) - valueFilters ) <= 1e-12 * std::abs( valueFilters ) ) )
+  {
+    std::cerr << "ERROR: GetValue() differs from the value of GetValueAndDerivative()." << std::endl;
+    passed = false;
+  }
+
+  /** Compare the derivative with central differences, for the control points that
+   * are not on the border of the grid.
+   */
+  const double h = 1e-5;
+  double maxDerivative = 0.0;
+  for( unsigned int i = 0; i < numberOfParameters; ++i )
+  {
+    maxDerivative = std::max( maxDerivative, std::abs( derivativeFilters[ i ] ) );
+  }
+
+  double maxError = 0.0;
+  for( unsigned int i = 0; i < numberOfParameters; ++i )
+  {
+    bool               isOnBorder = false;
+    const unsigned int index      = i % numberOfControlPoints;
+    unsigned int       rest       = index;
+    for( unsigned int d = 0; d < Dimension; d++ )
+    {
+      const unsigned int position = rest % gridSize;
+      isOnBorder |= position == 0 || position + 1 == gridSize;
+      rest       /= gridSize;
+    }
+    if( isOnBorder )
+    {
+      continue;
+    }
+
+    ParametersType plus( parameters );
+    ParametersType minus( parameters );
+    plus[ i ]  += h;
+    minus[ i ] -= h;
+    const MeasureType valuePlus  = metric->GetValue( plus );
+    const MeasureType valueMinus = metric->GetValue( minus );
+    const double      error      = std::abs( ( valuePlus - valueMinus ) / ( 2.0 * h ) - derivativeFilters[ i ] );
+    maxError = std::max( maxError, error );
+  }
+  std::cout << "  " << Dimension << "D: maximum derivative " << maxDerivative
+            << ", maximum finite difference error " << maxError << std::endl;
+  if( !( maxDerivative > 0.0 ) || !( maxError <= 1e-5 * maxDerivative ) )
+  {
+    std::cerr << "ERROR: the " << Dimension
+              << "D derivative differs from the finite difference derivative." << std::endl;
+    passed = false;
+  }
+
+  /** The single-threaded value and derivative of the fused passes. */
+  metric->SetUseFusedPasses( true );
+  metric->Initialize();
+  MeasureType    value = 0.0;
+  DerivativeType derivative;
+  metric->GetValueAndDerivative( parameters, value, derivative );
+  if( metric->GetValue( parameters ) != value )
+  {
+    std::cerr << "ERROR: the fused GetValue() differs from the value of GetValueAndDerivative()." << std::endl;
+    passed = false;
+  }
+
+  /** The fused passes add up the same terms in another order, so they agree
+   * with the filter chains up to rounding.
+   */
+  double maxDifference = 0.0;
+  for( unsigned int i = 0; i < numberOfParameters; ++i )
+  {
+    maxDifference = std::max( maxDifference, std::abs( derivative[ i ] - derivativeFilters[ i ] ) );
+  }
+  const double valueDifference = std::abs( value - valueFilters );
+  std::cout << "  " << Dimension << "D: fused minus filter chains: value " << valueDifference
+            << ", maximum derivative " << maxDifference << " (of " << maxDerivative << ")" << std::endl;
+  if( !( valueDifference <= 1e-12 * std::abs( valueFilters ) )
+    || !( maxDifference <= 1e-12 * maxDerivative ) )
+  {
+    std::cerr << "ERROR: the fused " << Dimension
+              << "D value or derivative differs from the one of the filter chains." << std::endl;
+    passed = false;
+  }
+
+  /** The multi-threaded value and derivative should be bit-identical. */
+  metric->SetUseMultiThread( true );
+  metric->SetNumberOfWorkUnits( 4 );
+  metric->Initialize();
+  MeasureType    valueMT = 0.0;
+  DerivativeType derivativeMT;
+  metric->GetValueAndDerivative( parameters, valueMT, derivativeMT );
+  if( valueMT != value || derivativeMT != derivative )
+  {
+    std::cerr << "ERROR: the multi-threaded " << Dimension
+              << "D value or derivative differs from the single-threaded one." << std::endl;
+    passed = false;
+  }
+  if( metric->GetValue( parameters ) != value )
+  {
+    std::cerr << "ERROR: the multi-threaded " << Dimension
+              << "D GetValue() differs from the single-threaded value." << std::endl;
+    passed = false;
+  }
+
+  return passed;
+
+} // end TestRigidityPenaltyTerm()
+
+
+} // end namespace
+
+int
+main( int argc, char * argv[] )
+{
+  std::cout << "TransformRigidityPenaltyTerm:" << std::endl;
+  bool passed = TestRigidityPenaltyTerm< 2 >( 9 );
+  passed &= TestRigidityPenaltyTerm< 3 >( 7 );
+
+  /** Return a value. */
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+
+} // end main